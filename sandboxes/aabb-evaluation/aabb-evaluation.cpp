@@ -1,3 +1,4 @@
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -93,6 +94,9 @@ void profile(const TriangleMesh &mesh)
     }
 
     Eigen::MatrixXd occlusion_output1;
+    Eigen::MatrixXd occlusion_output1_packets;
+    double          t_single  = 0.;
+    double          t_packets = 0.;
     {
         std::vector<Vec3d> vertices;
         std::vector<Vec3i> triangles;
@@ -108,6 +112,7 @@ void profile(const TriangleMesh &mesh)
 
         {
             PROFILE_BLOCK(EigenMesh3D_AABBIndirectD_AmbientOcclusion);
+            auto t_start = std::chrono::steady_clock::now();
             occlusion_output1.resize(num_vertices, 1);
             for (int ivertex = 0; ivertex < num_vertices; ++ ivertex) {
                 const Eigen::Vector3d origin = V.row(ivertex).template cast<double>();
@@ -125,7 +130,46 @@ void profile(const TriangleMesh &mesh)
                 }
                 occlusion_output1(ivertex) = (double)num_hits/(double)num_samples;
             }
+            t_single = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
         }
+
+        {
+            PROFILE_BLOCK(EigenMesh3D_AABBIndirectD_AmbientOcclusionRayPackets);
+            auto t_start = std::chrono::steady_clock::now();
+            occlusion_output1_packets.resize(num_vertices, 1);
+            std::vector<Eigen::Vector3d> origins(num_samples);
+            std::vector<Eigen::Vector3d> ray_dirs(num_samples);
+            std::vector<igl::Hit>        hits;
+            for (int ivertex = 0; ivertex < num_vertices; ++ ivertex) {
+                const Eigen::Vector3d origin = V.row(ivertex).template cast<double>();
+                const Eigen::Vector3d normal = vertex_normals.row(ivertex).template cast<double>();
+                for (int s = 0; s < num_samples; s++) {
+                    Eigen::Vector3d d = dirs.row(s);
+                    if(d.dot(normal) < 0) {
+                        // reverse ray
+                        d *= -1;
+                    }
+                    origins[s]  = origin + 1e-4 * d;
+                    ray_dirs[s] = d;
+                }
+                size_t num_hits = AABBTreeIndirect::intersect_rays_first_hit(vertices, triangles, tree, origins, ray_dirs, hits);
+                occlusion_output1_packets(ivertex) = (double)num_hits/(double)num_samples;
+            }
+            t_packets = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        }
+    }
+
+    {
+        // The ray packets shall hit exactly as the single rays.
+        int num_mismatches = 0;
+        for (int ivertex = 0; ivertex < num_vertices; ++ ivertex)
+            if (occlusion_output1(ivertex) != occlusion_output1_packets(ivertex))
+                ++ num_mismatches;
+        const double num_rays = double(num_vertices) * double(num_samples);
+        std::cout << "AABBIndirectD single rays: " << num_rays / t_single << " rays/s" << std::endl;
+        std::cout << "AABBIndirectD ray packets: " << num_rays / t_packets << " rays/s" << std::endl;
+        if (num_mismatches > 0)
+            std::cout << "MISMATCH: ray packets differ from single rays at " << num_mismatches << " of " << num_vertices << " vertices" << std::endl;
     }
 
     // Build the AABB accelaration tree
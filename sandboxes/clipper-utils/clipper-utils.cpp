@@ -0,0 +1,116 @@
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+
+#include <libnest2d/tools/benchmark.h>
+
+const std::string USAGE_STR = {
+    "Usage: clipper-utils stlfilename.stl [layer_height] [repeats]"
+};
+
+using namespace Slic3r;
+
+// Total number of points, used to verify that the variants of an operation produced the same result.
+static size_t num_points(const Polygons &polygons)
+{
+    size_t n = 0;
+    for (const Polygon &polygon : polygons)
+        n += polygon.points.size();
+    return n;
+}
+
+static size_t num_points(const ExPolygons &expolygons)
+{
+    return num_points(to_polygons(expolygons));
+}
+
+struct Case {
+    const char                                           *name;
+    // Runs the operation over a layer, returns the number of points of the result.
+    std::function<size_t(const ExPolygons &layer)>        run;
+};
+
+int main(const int argc, const char *argv[])
+{
+    if (argc < 2) {
+        std::cout << USAGE_STR << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    TriangleMesh mesh;
+    if (! mesh.ReadSTLFile(argv[1])) {
+        std::cerr << "Error loading " << argv[1] << std::endl;
+        return -1;
+    }
+    mesh.repair();
+    if (mesh.facets_count() == 0) {
+        std::cerr << "Error loading " << argv[1] << " . It is empty." << std::endl;
+        return -1;
+    }
+
+    const float layer_height = argc > 2 ? std::stof(argv[2]) : 0.2f;
+    const int   repeats      = argc > 3 ? std::max(1, std::stoi(argv[3])) : 5;
+    BoundingBoxf3 bbox = mesh.bounding_box();
+    std::vector<float> z;
+    for (double slice_z = bbox.min.z() + 0.5 * layer_height; slice_z < bbox.max.z(); slice_z += layer_height)
+        z.emplace_back(float(slice_z));
+    std::vector<ExPolygons> layers;
+    TriangleMeshSlicer(&mesh).slice(z, SlicingMode::Regular, &layers, []() {});
+    std::cout << mesh.facets_count() << " facets, " << layers.size() << " layers" << std::endl;
+
+    // Perimeter like offsets and a support like chain of operations, in Slic3r types and in Clipper space.
+    const double delta = scale_(0.45);
+    const Case cases[] = {
+        { "offset_ex", [delta](const ExPolygons &layer) {
+            return num_points(offset_ex(layer, - delta));
+        } },
+        { "offset2_ex", [delta](const ExPolygons &layer) {
+            return num_points(offset2_ex(layer, - 1.5 * delta, 0.5 * delta));
+        } },
+        { "diff_ex", [delta](const ExPolygons &layer) {
+            return num_points(diff_ex(to_polygons(layer), offset(layer, - delta)));
+        } },
+        { "union_ex", [delta](const ExPolygons &layer) {
+            return num_points(union_ex(offset(layer, 0.5 * delta)));
+        } },
+        { "chain slic3r", [delta](const ExPolygons &layer) {
+            Polygons polygons = to_polygons(layer);
+            return num_points(diff(intersection(offset(polygons, delta), polygons), offset(polygons, - delta)));
+        } },
+        { "chain clipper", [delta](const ExPolygons &layer) {
+            Polygons polygons = to_polygons(layer);
+            return num_points(ClipperPaths_to_Slic3rPolygons(_clipper_paths(ClipperLib::ctDifference,
+                _clipper_paths(ClipperLib::ctIntersection,
+                    _offset(Slic3rMultiPoints_to_ClipperPaths(polygons), ClipperLib::etClosedPolygon, delta, jtMiter, 3.),
+                    polygons),
+                _offset(Slic3rMultiPoints_to_ClipperPaths(polygons), ClipperLib::etClosedPolygon, - delta, jtMiter, 3.))));
+        } },
+    };
+
+    size_t chain_points = 0;
+    for (const Case &c : cases) {
+        size_t points = 0;
+        Benchmark bench;
+        bench.start();
+        for (int i = 0; i < repeats; ++ i) {
+            points = 0;
+            for (const ExPolygons &layer : layers)
+                points += c.run(layer);
+        }
+        bench.stop();
+        std::cout << c.name << " duration: " << bench.getElapsedSec() / repeats << " s, points: " << points;
+        if (std::string(c.name).compare(0, 5, "chain") == 0) {
+            if (chain_points == 0)
+                chain_points = points;
+            else if (chain_points != points)
+                std::cout << " MISMATCH";
+        }
+        std::cout << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
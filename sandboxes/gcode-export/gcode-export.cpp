@@ -0,0 +1,95 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include <libslic3r/GCode.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/PrintConfig.hpp>
+
+#include <libnest2d/tools/benchmark.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include <tbb/task_arena.h>
+
+const std::string USAGE_STR = {
+    "Usage: gcode-export projectfile.3mf [repeats]"
+};
+
+using namespace Slic3r;
+
+// Read the exported G-code, dropping the lines which differ between two runs (time stamps).
+static std::string read_gcode(const std::string &path)
+{
+    std::ifstream     in(path);
+    std::stringstream out;
+    for (std::string line; std::getline(in, line);)
+        if (line.find("generated by") == std::string::npos)
+            out << line << '\n';
+    return out.str();
+}
+
+int main(const int argc, const char *argv[])
+{
+    if (argc < 2) {
+        std::cout << USAGE_STR << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    ConfigSubstitutionContext config_substitutions(ForwardCompatibilitySubstitutionRule::EnableSilent);
+    Model model;
+    try {
+        model = Model::read_from_file(argv[1], &config, &config_substitutions, Model::LoadAttribute::AddDefaultInstances);
+    } catch (const std::exception &ex) {
+        std::cerr << "Error loading " << argv[1] << ": " << ex.what() << std::endl;
+        return -1;
+    }
+    config.normalize_fdm();
+    const int repeats = argc > 2 ? std::max(1, std::stoi(argv[2])) : 3;
+
+    Print print;
+    print.set_status_silent();
+    for (ModelObject *object : model.objects)
+        print.auto_assign_extruders(object);
+    print.apply(model, config);
+    print.process();
+    std::cout << print.objects().size() << " objects" << std::endl;
+
+    // Export the G-code through the serial path first, it is the reference for the pipeline.
+    struct Run {
+        std::string name;
+        bool        pipeline;
+        int         num_threads;
+    };
+    std::string reference;
+    for (const Run &run : { Run{ "serial", false, int(tbb::task_arena::automatic) }, Run{ "pipeline, 1 thread", true, 1 }, Run{ "pipeline", true, int(tbb::task_arena::automatic) } }) {
+        double duration = 0.;
+        for (int i = 0; i < repeats; ++ i) {
+            boost::filesystem::path temp = boost::filesystem::unique_path();
+            Benchmark bench;
+            tbb::task_arena arena(run.num_threads);
+            arena.execute([&print, &run, &temp, &bench]() {
+                GCode gcode;
+                gcode.set_pipeline_layers(run.pipeline);
+                bench.start();
+                gcode.do_export(&print, temp.string().c_str());
+                bench.stop();
+            });
+            duration += bench.getElapsedSec();
+            std::string gcode = read_gcode(temp.string());
+            boost::nowide::remove(temp.string().c_str());
+            if (reference.empty())
+                reference = std::move(gcode);
+            else if (gcode != reference)
+                std::cout << run.name << ": G-code MISMATCH" << std::endl;
+        }
+        std::cout << run.name << " duration: " << duration / repeats << " s" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
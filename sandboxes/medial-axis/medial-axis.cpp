@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/ExPolygon.hpp>
+#include <libslic3r/MedialAxis.hpp>
+
+#include <libnest2d/tools/benchmark.h>
+
+const std::string USAGE_STR = {
+    "Usage: medial-axis [repeats]"
+};
+
+using namespace Slic3r;
+
+// Thin wall shapes of tests/superslicerlibslic3r/test_thin.cpp.
+struct Case {
+    const char *name;
+    ExPolygon   expolygon;
+    // Bounds of the extrusion, the expolygon itself if empty.
+    ExPolygon   anchor;
+    coord_t     max_width;
+    coord_t     min_width;
+    coord_t     height;
+    coord_t     nozzle_diameter;
+    coord_t     taper_size;
+};
+
+static ExPolygon make_expolygon(Points contour, Points hole = {})
+{
+    ExPolygon expolygon;
+    expolygon.contour = Slic3r::Polygon{ std::move(contour) };
+    expolygon.contour.make_counter_clockwise();
+    if (! hole.empty())
+        expolygon.holes.emplace_back(Slic3r::Polygon{ std::move(hole) });
+    return expolygon;
+}
+
+// Same parameters as ExPolygon::medial_axis().
+static Case make_case(const char *name, ExPolygon expolygon, double max_width, double min_width)
+{
+    return Case{ name, std::move(expolygon), ExPolygon(), coord_t(max_width), coord_t(min_width), coord_t(max_width / 2.0), coord_t(min_width), 0 };
+}
+
+static std::vector<Case> thin_wall_cases()
+{
+    std::vector<Case> cases;
+    cases.emplace_back(make_case("square", make_expolygon(
+        { Point::new_scale(100, 100), Point::new_scale(200, 100), Point::new_scale(200, 200), Point::new_scale(100, 200) },
+        { Point::new_scale(140, 140), Point::new_scale(140, 160), Point::new_scale(160, 160), Point::new_scale(160, 140) }),
+        scale_(40), scale_(0.5)));
+    cases.emplace_back(make_case("narrow rectangle", make_expolygon(
+        { Point::new_scale(100, 100), Point::new_scale(120, 100), Point::new_scale(120, 200), Point::new_scale(105, 200), Point::new_scale(100, 200) }),
+        scale_(20), scale_(0.5)));
+    cases.emplace_back(make_case("semicircumference", make_expolygon({
+        Point{ 1185881, 829367 }, Point{ 1421988, 1578184 }, Point{ 1722442, 2303558 }, Point{ 2084981, 2999998 }, Point{ 2506843, 3662186 }, Point{ 2984809, 4285086 }, Point{ 3515250, 4863959 }, Point{ 4094122, 5394400 }, Point{ 4717018, 5872368 },
+        Point{ 5379210, 6294226 }, Point{ 6075653, 6656769 }, Point{ 6801033, 6957229 }, Point{ 7549842, 7193328 }, Point{ 8316383, 7363266 }, Point{ 9094809, 7465751 }, Point{ 9879211, 7500000 }, Point{ 10663611, 7465750 }, Point{ 11442038, 7363265 },
+        Point{ 12208580, 7193327 }, Point{ 12957389, 6957228 }, Point{ 13682769, 6656768 }, Point{ 14379209, 6294227 }, Point{ 15041405, 5872366 }, Point{ 15664297, 5394401 }, Point{ 16243171, 4863960 }, Point{ 16758641, 4301424 }, Point{ 17251579, 3662185 },
+        Point{ 17673439, 3000000 }, Point{ 18035980, 2303556 }, Point{ 18336441, 1578177 }, Point{ 18572539, 829368 }, Point{ 18750748, 0 }, Point{ 19758422, 0 }, Point{ 19727293, 236479 }, Point{ 19538467, 1088188 }, Point{ 19276136, 1920196 },
+        Point{ 18942292, 2726179 }, Point{ 18539460, 3499999 }, Point{ 18070731, 4235755 }, Point{ 17539650, 4927877 }, Point{ 16950279, 5571067 }, Point{ 16307090, 6160437 }, Point{ 15614974, 6691519 }, Point{ 14879209, 7160248 }, Point{ 14105392, 7563079 },
+        Point{ 13299407, 7896927 }, Point{ 12467399, 8159255 }, Point{ 11615691, 8348082 }, Point{ 10750769, 8461952 }, Point{ 9879211, 8500000 }, Point{ 9007652, 8461952 }, Point{ 8142729, 8348082 }, Point{ 7291022, 8159255 }, Point{ 6459015, 7896927 },
+        Point{ 5653029, 7563079 }, Point{ 4879210, 7160247 }, Point{ 4143447, 6691519 }, Point{ 3451331, 6160437 }, Point{ 2808141, 5571066 }, Point{ 2218773, 4927878 }, Point{ 1687689, 4235755 }, Point{ 1218962, 3499999 }, Point{ 827499, 2748020 },
+        Point{ 482284, 1920196 }, Point{ 219954, 1088186 }, Point{ 31126, 236479 }, Point{ 0, 0 }, Point{ 1005754, 0 } }),
+        scale_(1.324888), scale_(0.25)));
+    cases.emplace_back(make_case("round", make_expolygon({
+        Point::new_scale(15.181601,-2.389639), Point::new_scale(15.112616,-1.320034), Point::new_scale(14.024491,-0.644338), Point::new_scale(13.978982,-0.624495), Point::new_scale(9.993299,0.855584), Point::new_scale(9.941970,0.871195), Point::new_scale(5.796743,1.872643),
+        Point::new_scale(5.743826,1.882168), Point::new_scale(1.509170,2.386464), Point::new_scale(1.455460,2.389639), Point::new_scale(-2.809359,2.389639), Point::new_scale(-2.862805,2.386464), Point::new_scale(-7.097726,1.882168), Point::new_scale(-7.150378,1.872643), Point::new_scale(-11.286344,0.873576),
+        Point::new_scale(-11.335028,0.858759), Point::new_scale(-14.348632,-0.237938), Point::new_scale(-14.360538,-0.242436), Point::new_scale(-15.181601,-0.737570), Point::new_scale(-15.171309,-2.388509) }, {
+        Point::new_scale( -11.023311,-1.034226 ), Point::new_scale( -6.920984,-0.042941 ), Point::new_scale( -2.768613,0.463207 ), Point::new_scale( 1.414714,0.463207 ), Point::new_scale( 5.567085,-0.042941 ), Point::new_scale( 9.627910,-1.047563 ) }),
+        scale_(2.5), scale_(0.5)));
+    cases.emplace_back(make_case("french cross", make_expolygon({
+        Point::new_scale(4.3, 4), Point::new_scale(4.3, 0), Point::new_scale(4, 0), Point::new_scale(4, 4), Point::new_scale(0, 4), Point::new_scale(0, 4.5), Point::new_scale(4, 4.5), Point::new_scale(4, 10), Point::new_scale(4.3, 10), Point::new_scale(4.3, 4.5),
+        Point::new_scale(6, 4.5), Point::new_scale(6, 10), Point::new_scale(6.2, 10), Point::new_scale(6.2, 4.5), Point::new_scale(10, 4.5), Point::new_scale(10, 4), Point::new_scale(6.2, 4), Point::new_scale(6.2, 0), Point::new_scale(6, 0), Point::new_scale(6, 4) }),
+        scale_(0.55), scale_(0.25)));
+    {
+        // Anchor & tapers, 1 nozzle, 0.2 layer height.
+        const coord_t nozzle_diam = scale_(1);
+        ExPolygon tooth     = make_expolygon({ Point::new_scale(0,0), Point::new_scale(10,0), Point::new_scale(10,1.2), Point::new_scale(0,1.2) });
+        ExPolygon base_part = make_expolygon({ Point::new_scale(0,-3), Point::new_scale(0,3), Point::new_scale(-2,3), Point::new_scale(-2,-3) });
+        ExPolygon anchor    = union_ex(ExPolygons{ tooth }, intersection_ex(ExPolygons{ base_part }, offset_ex(tooth, nozzle_diam / 2)), true)[0];
+        cases.push_back(Case{ "anchor & tapers", tooth, anchor, nozzle_diam * 2, nozzle_diam / 3, scale_(0.2), nozzle_diam, coord_t(0.25 * nozzle_diam) });
+    }
+    cases.emplace_back(make_case("narrow trapezoid", make_expolygon(
+        { Point::new_scale(100, 100), Point::new_scale(120, 100), Point::new_scale(112, 200), Point::new_scale(108, 200) }),
+        scale_(20), scale_(0.5)));
+    cases.emplace_back(make_case("L shape", make_expolygon(
+        { Point::new_scale(100, 100), Point::new_scale(120, 100), Point::new_scale(120, 180), Point::new_scale(200, 180), Point::new_scale(200, 200), Point::new_scale(100, 200) }),
+        scale_(20), scale_(0.5)));
+    cases.emplace_back(make_case("shape", make_expolygon({
+        Point{ -203064906, -51459966 }, Point{ -219312231, -51459966 }, Point{ -219335477, -51459962 }, Point{ -219376095, -51459962 }, Point{ -219412047, -51459966 },
+        Point{ -219572094, -51459966 }, Point{ -219624814, -51459962 }, Point{ -219642183, -51459962 }, Point{ -219656665, -51459966 }, Point{ -220815482, -51459966 },
+        Point{ -220815482, -37738966 }, Point{ -221117540, -37738966 }, Point{ -221117540, -51762024 }, Point{ -203064906, -51762024 } }),
+        819998, 102499.75));
+    cases.emplace_back(make_case("narrow triangle", make_expolygon(
+        { Point::new_scale(50, 100), Point::new_scale(1000, 102), Point::new_scale(50, 104) }),
+        scale_(4), scale_(0.5)));
+    cases.emplace_back(make_case("GH #2474", make_expolygon(
+        { Point{91294454, 31032190}, Point{11294481, 31032190}, Point{11294481, 29967810}, Point{44969182, 29967810}, Point{89909960, 29967808}, Point{91294454, 29967808} }),
+        1871238, 500000));
+    return cases;
+}
+
+int main(const int argc, const char *argv[])
+{
+    const int repeats = argc > 1 ? std::max(1, std::stoi(argv[1])) : 100;
+    if (argc > 2) {
+        std::cout << USAGE_STR << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    double total = 0;
+    for (const Case &c : thin_wall_cases()) {
+        ThickPolylines result;
+        Benchmark bench;
+        bench.start();
+        for (int i = 0; i < repeats; ++ i) {
+            result.clear();
+            MedialAxis ma(c.expolygon, c.max_width, c.min_width, c.height);
+            if (! c.anchor.contour.empty())
+                ma.use_bounds(c.anchor)
+                  .use_min_real_width(c.nozzle_diameter)
+                  .use_tapers(c.taper_size);
+            ma.build(result);
+        }
+        bench.stop();
+        total += bench.getElapsedSec();
+        // Print a digest of the result to compare it between implementations.
+        size_t points = 0;
+        double length = 0.;
+        double width  = 0.;
+        for (const ThickPolyline &polyline : result) {
+            points += polyline.points.size();
+            length += polyline.length();
+            for (coordf_t w : polyline.width)
+                width += w;
+        }
+        std::cout << c.name << " duration: " << bench.getElapsedSec() * 1000. / repeats << " ms, polylines: " << result.size()
+            << ", points: " << points << ", length: " << size_t(length) << ", width sum: " << size_t(width) << std::endl;
+    }
+    std::cout << "total duration: " << total * 1000. / repeats << " ms" << std::endl;
+
+    return EXIT_SUCCESS;
+}
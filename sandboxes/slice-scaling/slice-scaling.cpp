@@ -0,0 +1,91 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libslic3r/TriangleMesh.hpp>
+
+#include <libnest2d/tools/benchmark.h>
+
+#include <tbb/task_arena.h>
+
+const std::string USAGE_STR = {
+    "Usage: slice-scaling stlfilename.stl [layer_height]"
+};
+
+using namespace Slic3r;
+
+struct EngineDesc {
+    SlicingEngine engine;
+    const char   *name;
+};
+
+static const EngineDesc engines[] = {
+    { SlicingEngine::Locked,    "locked"    },
+    { SlicingEngine::Buckets,   "buckets"   },
+    { SlicingEngine::SweepLine, "sweepline" },
+};
+
+// Total number of points of all the layers, used to verify that all the engines produced the same loops.
+static size_t num_points(const std::vector<Polygons> &layers)
+{
+    size_t n = 0;
+    for (const Polygons &polygons : layers)
+        for (const Polygon &polygon : polygons)
+            n += polygon.points.size();
+    return n;
+}
+
+int main(const int argc, const char *argv[])
+{
+    if (argc < 2) {
+        std::cout << USAGE_STR << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    TriangleMesh mesh;
+    if (! mesh.ReadSTLFile(argv[1])) {
+        std::cerr << "Error loading " << argv[1] << std::endl;
+        return -1;
+    }
+    mesh.repair();
+    if (mesh.facets_count() == 0) {
+        std::cerr << "Error loading " << argv[1] << " . It is empty." << std::endl;
+        return -1;
+    }
+
+    const float layer_height = argc > 2 ? std::stof(argv[2]) : 0.05f;
+    BoundingBoxf3 bbox = mesh.bounding_box();
+    std::vector<float> z;
+    for (double slice_z = bbox.min.z() + 0.5 * layer_height; slice_z < bbox.max.z(); slice_z += layer_height)
+        z.emplace_back(float(slice_z));
+    std::cout << mesh.facets_count() << " facets, " << z.size() << " layers" << std::endl;
+
+    TriangleMeshSlicer slicer(&mesh);
+    std::vector<size_t> thread_counts;
+    for (size_t n = 1; n < std::thread::hardware_concurrency(); n *= 2)
+        thread_counts.emplace_back(n);
+    thread_counts.emplace_back(std::max(1u, std::thread::hardware_concurrency()));
+
+    size_t reference_points = 0;
+    for (const EngineDesc &desc : engines) {
+        slicer.engine = desc.engine;
+        for (size_t num_threads : thread_counts) {
+            std::vector<Polygons> layers;
+            Benchmark bench;
+            tbb::task_arena arena(int(num_threads));
+            arena.execute([&slicer, &z, &layers, &bench]() {
+                bench.start();
+                slicer.slice(z, SlicingMode::Regular, &layers, []() {});
+                bench.stop();
+            });
+            size_t points = num_points(layers);
+            if (reference_points == 0)
+                reference_points = points;
+            std::cout << desc.name << " threads: " << num_threads << " duration: " << bench.getElapsedSec() << " s"
+                << (points == reference_points ? "" : " MISMATCH") << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <libslic3r/TriangleMesh.hpp>
+
+#include <libnest2d/tools/benchmark.h>
+
+const std::string USAGE_STR = {
+    "Usage: stl-load [stlfilename.stl ...]\n"
+    "Without arguments, spheres of several sizes are written to the temp directory in the binary and ASCII formats and loaded."
+};
+
+using namespace Slic3r;
+
+// Load the file, returns false on error.
+static bool load(const std::string &path)
+{
+    TriangleMesh mesh;
+    Benchmark bench;
+    bench.start();
+    bool ok = mesh.ReadSTLFile(path.c_str());
+    bench.stop();
+    if (! ok) {
+        std::cerr << "Error loading " << path << std::endl;
+        return false;
+    }
+    std::cout << path << " (" << boost::filesystem::file_size(path) / (1024 * 1024) << " MB, " << mesh.facets_count() << " facets) loaded in "
+        << bench.getElapsedSec() * 1000. << " ms" << std::endl;
+    return true;
+}
+
+int main(const int argc, const char *argv[])
+{
+    if (argc > 1) {
+        if (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
+            std::cout << USAGE_STR << std::endl;
+            return EXIT_SUCCESS;
+        }
+        for (int i = 1; i < argc; ++ i)
+            if (! load(argv[i]))
+                return -1;
+        return EXIT_SUCCESS;
+    }
+
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("stl-load-%%%%-%%%%");
+    boost::filesystem::create_directories(dir);
+    bool ok = true;
+    // Number of the segments around the sphere, roughly square root of the number of facets.
+    for (int segments : { 100, 400, 1600 }) {
+        TriangleMesh sphere = make_sphere(10., 2. * PI / segments);
+        std::string name = "sphere" + std::to_string(segments);
+        std::string binary = (dir / (name + "-binary.stl")).string();
+        std::string ascii  = (dir / (name + "-ascii.stl")).string();
+        sphere.write_binary(binary.c_str());
+        sphere.write_ascii(ascii.c_str());
+        ok = ok && load(binary) && load(ascii);
+    }
+    boost::filesystem::remove_all(dir);
+
+    return ok ? EXIT_SUCCESS : -1;
+}
@@ -466,6 +466,8 @@ int CLI::run(int argc, char **argv)
                 Print       fff_print;
                 SLAPrint    sla_print;
                 std::shared_ptr<SLAArchive> sla_archive = Slic3r::get_output_format(m_print_config);
+                // The layers are exported right after slicing, rasterize them into the archive on the fly.
+                sla_archive->set_streaming(true);
 
                 sla_print.set_printer(sla_archive);
                 sla_print.set_status_callback(
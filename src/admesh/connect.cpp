@@ -26,6 +26,8 @@
 #include <math.h>
 
 #include <algorithm>
+#include <array>
+#include <limits>
 #include <vector>
 
 #include <boost/predef/other/endian.h>
@@ -34,6 +36,9 @@
 #define BOOST_POOL_NO_MT
 #include <boost/pool/object_pool.hpp>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
 #include "stl.h"
 
 struct HashEdge {
@@ -43,6 +48,16 @@ struct HashEdge {
 	bool operator==(const HashEdge &rhs) const { return memcmp(key, rhs.key, sizeof(key)) == 0; }
 	bool operator!=(const HashEdge &rhs) const { return ! (*this == rhs); }
 	int  hash(int M) const { return ((key[0] / 11 + key[1] / 7 + key[2] / 3) ^ (key[3] / 11  + key[4] / 7 + key[5] / 3)) % M; }
+	// Well distributed 32 bit hash for sorting the edges.
+	uint32_t hash32() const {
+		uint64_t h = 0x9E3779B97F4A7C15ull;
+		for (size_t i = 0; i < 6; ++ i) {
+			h ^= key[i];
+			h *= 0xFF51AFD7ED558CCDull;
+			h ^= h >> 32;
+		}
+		return uint32_t(h);
+	}
 
 	// Index of a facet owning this edge.
 	int        facet_number;
@@ -53,12 +68,19 @@ struct HashEdge {
 
 	void load_exact(stl_file *stl, const stl_vertex *a, const stl_vertex *b)
 	{
-		{
-	    	stl_vertex diff = (*a - *b).cwiseAbs();
-	    	float max_diff = std::max(diff(0), std::max(diff(1), diff(2)));
-	    	stl->stats.shortest_edge = std::min(max_diff, stl->stats.shortest_edge);
-	  	}
+		stl->stats.shortest_edge = std::min(edge_length(*a, *b), stl->stats.shortest_edge);
+		this->load_exact_key(a, b);
+	}
+
+	static float edge_length(const stl_vertex &a, const stl_vertex &b)
+	{
+		stl_vertex diff = (a - b).cwiseAbs();
+		return std::max(diff(0), std::max(diff(1), diff(2)));
+	}
 
+	// Fill in the key of an edge, not touching the mesh statistics, thus safe to be called in parallel.
+	void load_exact_key(const stl_vertex *a, const stl_vertex *b)
+	{
 	  	// Ensure identical vertex ordering of equal edges.
 	  	// This method is numerically robust.
 	  	if (vertex_lower(*a, *b)) {
@@ -239,22 +261,10 @@ private:
 	    return edge_a.facet_number != edge_b.facet_number && edge_a == edge_b;
 	}
 
+public:
 	static void record_neighbors(stl_file *stl, const HashEdge &edge_a, const HashEdge &edge_b)
 	{
-		// Facet a's neighbor is facet b
-		stl->neighbors_start[edge_a.facet_number].neighbor[edge_a.which_edge % 3] = edge_b.facet_number;	/* sets the .neighbor part */
-		stl->neighbors_start[edge_a.facet_number].which_vertex_not[edge_a.which_edge % 3] = (edge_b.which_edge + 2) % 3; /* sets the .which_vertex_not part */
-
-		// Facet b's neighbor is facet a
-		stl->neighbors_start[edge_b.facet_number].neighbor[edge_b.which_edge % 3] = edge_a.facet_number;	/* sets the .neighbor part */
-		stl->neighbors_start[edge_b.facet_number].which_vertex_not[edge_b.which_edge % 3] = (edge_a.which_edge + 2) % 3; /* sets the .which_vertex_not part */
-
-		if (((edge_a.which_edge < 3) && (edge_b.which_edge < 3)) || ((edge_a.which_edge > 2) && (edge_b.which_edge > 2))) {
-			// These facets are oriented in opposite directions, their normals are probably messed up.
-			stl->neighbors_start[edge_a.facet_number].which_vertex_not[edge_a.which_edge % 3] += 3;
-			stl->neighbors_start[edge_b.facet_number].which_vertex_not[edge_b.which_edge % 3] += 3;
-		}
-
+		record_neighbors_link(stl, edge_a, edge_b);
 		// Count successful connects:
 		// Total connects:
 		stl->stats.connected_edges += 2;
@@ -273,7 +283,27 @@ private:
 		}
 	}
 
-	static void match_neighbors_nearby(stl_file *stl, const HashEdge &edge_a, const HashEdge &edge_b)
+	// Link the two facets without updating the statistics. Only the neighbor slots of the two edges are written,
+	// thus distinct pairs of edges may be linked in parallel.
+	static void record_neighbors_link(stl_file *stl, const HashEdge &edge_a, const HashEdge &edge_b)
+	{
+		// Facet a's neighbor is facet b
+		stl->neighbors_start[edge_a.facet_number].neighbor[edge_a.which_edge % 3] = edge_b.facet_number;	/* sets the .neighbor part */
+		stl->neighbors_start[edge_a.facet_number].which_vertex_not[edge_a.which_edge % 3] = (edge_b.which_edge + 2) % 3; /* sets the .which_vertex_not part */
+
+		// Facet b's neighbor is facet a
+		stl->neighbors_start[edge_b.facet_number].neighbor[edge_b.which_edge % 3] = edge_a.facet_number;	/* sets the .neighbor part */
+		stl->neighbors_start[edge_b.facet_number].which_vertex_not[edge_b.which_edge % 3] = (edge_a.which_edge + 2) % 3; /* sets the .which_vertex_not part */
+
+		if (((edge_a.which_edge < 3) && (edge_b.which_edge < 3)) || ((edge_a.which_edge > 2) && (edge_b.which_edge > 2))) {
+			// These facets are oriented in opposite directions, their normals are probably messed up.
+			stl->neighbors_start[edge_a.facet_number].which_vertex_not[edge_a.which_edge % 3] += 3;
+			stl->neighbors_start[edge_b.facet_number].which_vertex_not[edge_b.which_edge % 3] += 3;
+		}
+	}
+
+	// If facets_moved is not null, the facets which vertices were moved are marked there.
+	static void match_neighbors_nearby(stl_file *stl, const HashEdge &edge_a, const HashEdge &edge_b, std::vector<char> *facets_moved = nullptr)
 	{
 		record_neighbors(stl, edge_a, edge_b);
 
@@ -336,7 +366,7 @@ private:
 			}
 		}
 
-		auto change_vertices = [stl](int facet_num, int vnot, stl_vertex new_vertex)
+		auto change_vertices = [stl, facets_moved](int facet_num, int vnot, stl_vertex new_vertex)
 		{
 			int first_facet = facet_num;
 			bool direction = false;
@@ -392,6 +422,8 @@ private:
 				}
 	#endif
 				stl->facet_start[facet_num].vertex[pivot_vertex] = new_vertex;
+				if (facets_moved != nullptr)
+					(*facets_moved)[facet_num] = true;
 				vnot = stl->neighbors_start[facet_num].which_vertex_not[next_edge];
 				facet_num = stl->neighbors_start[facet_num].neighbor[next_edge];
 				if (facet_num == -1)
@@ -425,6 +457,87 @@ private:
 	}
 };
 
+// Stable parallel LSD radix sort of 64 bit values by their upper 32 bits.
+static void radix_sort_by_upper_32bits(std::vector<uint64_t> &data)
+{
+	static constexpr size_t block_size = 65536;
+	const size_t 			num_blocks = (data.size() + block_size - 1) / block_size;
+	std::vector<uint64_t> 	sorted(data.size());
+	std::vector<std::array<size_t, 256>> offsets(num_blocks);
+	for (int shift = 32; shift < 64; shift += 8) {
+		// Histogram of the digits of each block.
+		tbb::parallel_for(size_t(0), num_blocks, [&data, &offsets, shift](size_t block) {
+			std::array<size_t, 256> &histogram = offsets[block];
+			histogram.fill(0);
+			for (size_t i = block * block_size; i < std::min(data.size(), (block + 1) * block_size); ++ i)
+				++ histogram[(data[i] >> shift) & 0x0ff];
+		});
+		// Where each block starts writing each digit.
+		size_t offset = 0;
+		for (size_t digit = 0; digit < 256; ++ digit)
+			for (std::array<size_t, 256> &block_offsets : offsets) {
+				size_t cnt = block_offsets[digit];
+				block_offsets[digit] = offset;
+				offset += cnt;
+			}
+		tbb::parallel_for(size_t(0), num_blocks, [&data, &sorted, &offsets, shift](size_t block) {
+			std::array<size_t, 256> &block_offsets = offsets[block];
+			for (size_t i = block * block_size; i < std::min(data.size(), (block + 1) * block_size); ++ i)
+				sorted[block_offsets[(data[i] >> shift) & 0x0ff] ++] = data[i];
+		});
+		data.swap(sorted);
+	}
+}
+
+// Match the edges the same way HashTableEdges matches them when inserted in their order:
+// An edge is matched with the first preceding unmatched edge of an equal key and of a different facet.
+// The edges are sorted by a hash of their keys, then the runs of equal hashes are matched in parallel.
+// Returns the index of the matching edge for each edge, or -1 if the edge was not matched.
+static std::vector<int> match_edges_sorted(const std::vector<HashEdge> &edges)
+{
+	// Hash in the upper 32 bits, index of the edge in the lower 32 bits.
+	std::vector<uint64_t> sorted(edges.size());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, edges.size()), [&edges, &sorted](const tbb::blocked_range<size_t> &range) {
+		for (size_t i = range.begin(); i < range.end(); ++ i)
+			sorted[i] = (uint64_t(edges[i].hash32()) << 32) | uint64_t(i);
+	});
+	// The edges are already sorted by their indices, the stable sort keeps them sorted inside the runs of equal hashes.
+	radix_sort_by_upper_32bits(sorted);
+
+	std::vector<int> match(edges.size(), -1);
+	auto same_hash = [&sorted](size_t i, size_t j) { return (sorted[i] >> 32) == (sorted[j] >> 32); };
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, sorted.size(), 4096), [&edges, &sorted, &match, &same_hash](const tbb::blocked_range<size_t> &range) {
+		// Process the runs starting inside this range.
+		size_t run_begin = range.begin();
+		while (run_begin > 0 && run_begin < range.end() && same_hash(run_begin - 1, run_begin))
+			++ run_begin;
+		std::vector<int> unmatched;
+		while (run_begin < range.end()) {
+			size_t run_end = run_begin + 1;
+			while (run_end < sorted.size() && same_hash(run_begin, run_end))
+				++ run_end;
+			if (run_end - run_begin > 1) {
+				unmatched.clear();
+				for (size_t i = run_begin; i < run_end; ++ i) {
+					int             idx  = int(uint32_t(sorted[i]));
+					const HashEdge &edge = edges[idx];
+					auto it = std::find_if(unmatched.begin(), unmatched.end(),
+						[&edges, &edge](int other) { return edges[other].facet_number != edge.facet_number && edges[other] == edge; });
+					if (it == unmatched.end())
+						unmatched.emplace_back(idx);
+					else {
+						match[idx]  = *it;
+						match[*it]  = idx;
+						unmatched.erase(it);
+					}
+				}
+			}
+			run_begin = run_end;
+		}
+	});
+	return match;
+}
+
 // This function builds the neighbors list.  No modifications are made
 // to any of the facets.  The edges are said to match only if all six
 // floats of the first edge matches all six floats of the second edge.
@@ -453,12 +566,177 @@ void stl_check_facets_exact(stl_file *stl)
 		  	++ i;
   	}
 
-  	// Initialize hash table.
+	for (auto &neighbor : stl->neighbors_start)
+		neighbor.reset();
+
+	// Load the edges in the order they would be inserted into a hash table.
+	std::vector<HashEdge> edges(size_t(stl->stats.number_of_facets) * 3);
+	stl->stats.shortest_edge = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, stl->stats.number_of_facets), stl->stats.shortest_edge,
+		[stl, &edges](const tbb::blocked_range<size_t> &range, float shortest_edge) {
+			for (size_t i = range.begin(); i < range.end(); ++ i) {
+				const stl_facet &facet = stl->facet_start[i];
+				for (int j = 0; j < 3; ++ j) {
+					HashEdge &edge = edges[i * 3 + j];
+					edge.facet_number = int(i);
+					edge.which_edge = j;
+					edge.load_exact_key(&facet.vertex[j], &facet.vertex[(j + 1) % 3]);
+					shortest_edge = std::min(shortest_edge, HashEdge::edge_length(facet.vertex[j], facet.vertex[(j + 1) % 3]));
+				}
+			}
+			return shortest_edge;
+		},
+		[](float a, float b) { return std::min(a, b); });
+
+  	// Connect neighbor edges. Each edge is matched at most once, thus each neighbor slot is written by a single thread.
+	std::vector<int> match = match_edges_sorted(edges);
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, edges.size()), [stl, &edges, &match](const tbb::blocked_range<size_t> &range) {
+		for (size_t i = range.begin(); i < range.end(); ++ i)
+			if (match[i] > int(i))
+				HashTableEdges::record_neighbors_link(stl, edges[match[i]], edges[i]);
+	});
+
+	// Count the connects. A facet with N neighbors was counted once into each of the first N counters when connecting incrementally.
+	std::array<int, 4> num_facets_connected = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, stl->stats.number_of_facets), std::array<int, 4>{ 0, 0, 0, 0 },
+		[stl](const tbb::blocked_range<size_t> &range, std::array<int, 4> counts) {
+			for (size_t i = range.begin(); i < range.end(); ++ i)
+				++ counts[stl->neighbors_start[i].num_neighbors()];
+			return counts;
+		},
+		[](std::array<int, 4> a, const std::array<int, 4> &b) {
+			for (size_t i = 0; i < 4; ++ i)
+				a[i] += b[i];
+			return a;
+		});
+	stl->stats.connected_facets_3_edge = num_facets_connected[3];
+	stl->stats.connected_facets_2_edge = stl->stats.connected_facets_3_edge + num_facets_connected[2];
+	stl->stats.connected_facets_1_edge = stl->stats.connected_facets_2_edge + num_facets_connected[1];
+	stl->stats.connected_edges         = num_facets_connected[1] + 2 * num_facets_connected[2] + 3 * num_facets_connected[3];
+
+#if 0
+	printf("Number of faces: %d, number of manifold edges: %d, number of connected edges: %d, number of unconnected edges: %d\r\n", 
+    	stl->stats.number_of_facets, stl->stats.number_of_facets * 3, 
+    	stl->stats.connected_edges, stl->stats.number_of_facets * 3 - stl->stats.connected_edges);
+#endif
+}
+
+void stl_check_facets_nearby(stl_file *stl, float tolerance)
+{
+	stl_check_facets_nearby(stl, tolerance, std::numeric_limits<uint32_t>::max());
+}
+
+void stl_check_facets_nearby(stl_file *stl, float tolerance, uint32_t hash_table_from_facet)
+{
+  	if (  (stl->stats.connected_facets_1_edge == stl->stats.number_of_facets)
+       && (stl->stats.connected_facets_2_edge == stl->stats.number_of_facets)
+       && (stl->stats.connected_facets_3_edge == stl->stats.number_of_facets)) {
+    	// No need to check any further.  All facets are connected.
+    	return;
+  	}
+
+  	// Edges left unconnected by stl_check_facets_exact() in the order they would be inserted into a hash table.
+  	// Connecting two edges only fills in the neighbor slots of these two edges, thus the set of unconnected edges does not change.
+  	std::vector<HashEdge> unconnected;
+  	for (uint32_t i = 0; i < stl->stats.number_of_facets; ++ i)
+    	for (int j = 0; j < 3; ++ j)
+      		if (stl->neighbors_start[i].neighbor[j] == -1) {
+        		HashEdge edge;
+        		edge.facet_number = i;
+        		edge.which_edge = j;
+        		unconnected.emplace_back(edge);
+      		}
+  	std::vector<char> valid(unconnected.size());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, unconnected.size()), [stl, tolerance, &unconnected, &valid](const tbb::blocked_range<size_t> &range) {
+		for (size_t i = range.begin(); i < range.end(); ++ i) {
+			HashEdge        &edge  = unconnected[i];
+			const stl_facet &facet = stl->facet_start[edge.facet_number];
+			valid[i] = edge.load_nearby(stl, facet.vertex[edge.which_edge], facet.vertex[(edge.which_edge + 1) % 3], tolerance);
+		}
+	});
+	// Only match edges that have different keys.
+	std::vector<HashEdge> edges;
+	for (size_t i = 0; i < unconnected.size(); ++ i)
+		if (valid[i])
+			edges.emplace_back(unconnected[i]);
+	std::vector<int> match = match_edges_sorted(edges);
+
+	// Connecting the edges moves vertices, thus the edges are connected in their order. The keys were calculated before any vertex was moved,
+	// they remain valid unless the vertices of a facet not processed yet were moved into other grid cells.
+	std::vector<char> facets_moved(stl->stats.number_of_facets, false);
+	for (size_t i = 0, i_edge = 0; i < unconnected.size();) {
+		int    facet_idx = unconnected[i].facet_number;
+		size_t i_end     = i;
+		for (; i_end < unconnected.size() && unconnected[i_end].facet_number == facet_idx; ++ i_end) ;
+		bool keys_valid = uint32_t(facet_idx) < hash_table_from_facet;
+		if (keys_valid && facets_moved[facet_idx]) {
+			const stl_facet &moved_facet = stl->facet_start[facet_idx];
+			for (size_t j = i; keys_valid && j < i_end; ++ j) {
+				HashEdge edge;
+				edge.facet_number = facet_idx;
+				edge.which_edge = unconnected[j].which_edge % 3;
+				keys_valid = edge.load_nearby(stl, moved_facet.vertex[edge.which_edge], moved_facet.vertex[(edge.which_edge + 1) % 3], tolerance) == bool(valid[j]) &&
+					(! valid[j] || (edge == unconnected[j] && edge.which_edge == unconnected[j].which_edge));
+			}
+		}
+		if (! keys_valid) {
+			// Continue with the hash table filled with the edges not matched yet.
+			// These never match each other, as edges of an equal key were only left unmatched if they belong to the same facet.
+		  	HashTableEdges hash_table(stl->stats.number_of_facets);
+		  	for (size_t j = 0; j < i_edge; ++ j)
+		  		if (match[j] == -1 || match[j] >= int(i_edge))
+		  			hash_table.insert_edge_nearby(stl, edges[j]);
+		  	for (uint32_t k = uint32_t(facet_idx); k < stl->stats.number_of_facets; ++ k) {
+		    	//FIXME is the copy necessary?
+		    	stl_facet facet = stl->facet_start[k];
+		    	for (int j = 0; j < 3; j++) {
+		      		if (stl->neighbors_start[k].neighbor[j] == -1) {
+		        		HashEdge edge;
+		        		edge.facet_number = k;
+		        		edge.which_edge = j;
+		        		if (edge.load_nearby(stl, facet.vertex[j], facet.vertex[(j + 1) % 3], tolerance))
+		          			// Only insert edges that have different keys.
+		          			hash_table.insert_edge_nearby(stl, edge);
+		      		}
+		    	}
+		  	}
+		  	break;
+		}
+		for (; i < i_end; ++ i)
+			if (valid[i]) {
+				if (match[i_edge] != -1 && match[i_edge] < int(i_edge))
+					HashTableEdges::match_neighbors_nearby(stl, edges[i_edge], edges[match[i_edge]], &facets_moved);
+				++ i_edge;
+			}
+	}
+}
+
+// Reference implementations of stl_check_facets_exact() and stl_check_facets_nearby(), inserting the edges into the hash table one by one.
+// stl_check_facets_exact() and stl_check_facets_nearby() produce the same neighbors, vertices and statistics, the tests verify them against these.
+void stl_check_facets_exact_hash_table(stl_file *stl)
+{
+	assert(stl->facet_start.size() == stl->neighbors_start.size());
+
+  	stl->stats.connected_edges         = 0;
+  	stl->stats.connected_facets_1_edge = 0;
+  	stl->stats.connected_facets_2_edge = 0;
+  	stl->stats.connected_facets_3_edge = 0;
+
+  	for (uint32_t i = 0; i < stl->stats.number_of_facets;) {
+		stl_facet &facet = stl->facet_start[i];
+	  	if (facet.vertex[0] == facet.vertex[1] || facet.vertex[1] == facet.vertex[2] || facet.vertex[0] == facet.vertex[2]) {
+		  	// Remove the degenerate facet.
+		  	facet = stl->facet_start[-- stl->stats.number_of_facets];
+			stl->facet_start.pop_back();
+			stl->neighbors_start.pop_back();
+		  	stl->stats.facets_removed += 1;
+		  	stl->stats.degenerate_facets += 1;
+	  	} else
+		  	++ i;
+  	}
+
   	HashTableEdges hash_table(stl->stats.number_of_facets);
 	for (auto &neighbor : stl->neighbors_start)
 		neighbor.reset();
 
-  	// Connect neighbor edges.
 	for (uint32_t i = 0; i < stl->stats.number_of_facets; ++ i) {
 		const stl_facet &facet = stl->facet_start[i];
 		for (int j = 0; j < 3; ++ j) {
@@ -469,26 +747,17 @@ void stl_check_facets_exact(stl_file *stl)
 			hash_table.insert_edge_exact(stl, edge);
 		}
 	}
-
-#if 0
-	printf("Number of faces: %d, number of manifold edges: %d, number of connected edges: %d, number of unconnected edges: %d\r\n", 
-    	stl->stats.number_of_facets, stl->stats.number_of_facets * 3, 
-    	stl->stats.connected_edges, stl->stats.number_of_facets * 3 - stl->stats.connected_edges);
-#endif
 }
 
-void stl_check_facets_nearby(stl_file *stl, float tolerance)
+void stl_check_facets_nearby_hash_table(stl_file *stl, float tolerance)
 {
   	if (  (stl->stats.connected_facets_1_edge == stl->stats.number_of_facets)
        && (stl->stats.connected_facets_2_edge == stl->stats.number_of_facets)
-       && (stl->stats.connected_facets_3_edge == stl->stats.number_of_facets)) {
-    	// No need to check any further.  All facets are connected.
+       && (stl->stats.connected_facets_3_edge == stl->stats.number_of_facets))
     	return;
-  	}
 
   	HashTableEdges hash_table(stl->stats.number_of_facets);
   	for (uint32_t i = 0; i < stl->stats.number_of_facets; ++ i) {
-    	//FIXME is the copy necessary?
     	stl_facet facet = stl->facet_start[i];
     	for (int j = 0; j < 3; j++) {
       		if (stl->neighbors_start[i].neighbor[j] == -1) {
@@ -496,7 +765,6 @@ void stl_check_facets_nearby(stl_file *stl, float tolerance)
         		edge.facet_number = i;
         		edge.which_edge = j;
         		if (edge.load_nearby(stl, facet.vertex[j], facet.vertex[(j + 1) % 3], tolerance))
-          			// Only insert edges that have different keys.
           			hash_table.insert_edge_nearby(stl, edge);
       		}
     	}
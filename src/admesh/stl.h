@@ -154,13 +154,22 @@ struct indexed_triangle_set
 	//std::vector<stl_normal> 					normals
 };
 
-extern bool stl_open(stl_file *stl, const char *file);
+// Size of the pieces of an ASCII STL file parsed in parallel by stl_open(), split at the facet boundaries.
+#define STL_ASCII_CHUNK_SIZE   (size_t(4 * 1024 * 1024))
+
+extern bool stl_open(stl_file *stl, const char *file, size_t ascii_chunk_size = STL_ASCII_CHUNK_SIZE);
 extern void stl_stats_out(stl_file *stl, FILE *file, char *input_file);
 extern bool stl_print_neighbors(stl_file *stl, char *file);
 extern bool stl_write_ascii(stl_file *stl, const char *file, const char *label);
 extern bool stl_write_binary(stl_file *stl, const char *file, const char *label);
 extern void stl_check_facets_exact(stl_file *stl);
 extern void stl_check_facets_nearby(stl_file *stl, float tolerance);
+// Continue with the hash table from the first facet of index hash_table_from_facet or higher with unconnected edges,
+// as stl_check_facets_nearby() does when the vertices of a facet were moved into other grid cells. For the tests.
+extern void stl_check_facets_nearby(stl_file *stl, float tolerance, uint32_t hash_table_from_facet);
+// Sequential versions of the two above connecting the edges through a hash table, kept as a reference for the tests.
+extern void stl_check_facets_exact_hash_table(stl_file *stl);
+extern void stl_check_facets_nearby_hash_table(stl_file *stl, float tolerance);
 extern void stl_remove_unconnected_facets(stl_file *stl);
 extern void stl_write_vertex(stl_file *stl, int facet, int vertex);
 extern void stl_write_facet(stl_file *stl, char *label, int facet);
@@ -26,10 +26,24 @@
 #include <math.h>
 #include <assert.h>
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/predef/other/endian.h>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
 #include "stl.h"
 
 #ifndef SEEK_SET
@@ -230,8 +244,283 @@ static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
   	return true;
 }
 
-bool stl_open(stl_file *stl, const char *file)
+// Bounding box of the facets, reduced in parallel by the memory mapped loader.
+struct StlMinMax {
+	stl_vertex min = stl_vertex::Constant(  std::numeric_limits<float>::max());
+	stl_vertex max = stl_vertex::Constant(- std::numeric_limits<float>::max());
+	void merge(const StlMinMax &rhs) { min = min.cwiseMin(rhs.min); max = max.cwiseMax(rhs.max); }
+};
+
+static StlMinMax stl_facets_min_max(const stl_facet *facets, size_t num_facets)
+{
+	return tbb::parallel_reduce(tbb::blocked_range<size_t>(0, num_facets, 4096), StlMinMax(),
+		[facets](const tbb::blocked_range<size_t> &range, StlMinMax acc) {
+			for (size_t i = range.begin(); i < range.end(); ++ i)
+				for (size_t j = 0; j < 3; ++ j) {
+					acc.min = acc.min.cwiseMin(facets[i].vertex[j]);
+					acc.max = acc.max.cwiseMax(facets[i].vertex[j]);
+				}
+			return acc;
+		},
+		[](StlMinMax a, const StlMinMax &b) { a.merge(b); return a; });
+}
+
+// Fill in the statistics the same way stl_read() does with stl_facet_stats().
+static void stl_mapped_update_stats(stl_file *stl)
+{
+	if (stl->facet_start.empty())
+		return;
+	const stl_facet &first = stl->facet_start.front();
+	stl_vertex diff = (first.vertex[1] - first.vertex[0]).cwiseAbs();
+	stl->stats.shortest_edge = std::max(diff(0), std::max(diff(1), diff(2)));
+	StlMinMax bbox = stl_facets_min_max(stl->facet_start.data(), stl->facet_start.size());
+	stl->stats.min = bbox.min;
+	stl->stats.max = bbox.max;
+	stl->stats.size = stl->stats.max - stl->stats.min;
+	stl->stats.bounding_diameter = stl->stats.size.norm();
+}
+
+static bool stl_read_mapped_binary(stl_file *stl, const char *data, size_t size, const char *file)
+{
+	if (((size - HEADER_SIZE) % SIZEOF_STL_FACET != 0) || (size < STL_MIN_FILE_SIZE)) {
+		BOOST_LOG_TRIVIAL(error) << "stl_open: The file " << file << " has the wrong size.";
+		return false;
+	}
+	uint32_t num_facets = uint32_t((size - HEADER_SIZE) / SIZEOF_STL_FACET);
+	memcpy(stl->stats.header, data, LABEL_SIZE);
+	stl->stats.header[80] = '\0';
+	uint32_t header_num_facets;
+	memcpy(&header_num_facets, data + LABEL_SIZE, sizeof(uint32_t));
+#if BOOST_ENDIAN_BIG_BYTE
+	stl_internal_reverse_quads((char*)&header_num_facets, 4);
+#endif /* BOOST_ENDIAN_BIG_BYTE */
+	if (num_facets != header_num_facets)
+		BOOST_LOG_TRIVIAL(info) << "stl_open: Warning: File size doesn't match number of facets in the header: " << file;
+
+	stl->stats.number_of_facets = num_facets;
+	stl->stats.original_num_facets = num_facets;
+	stl_allocate(stl);
+	// The facets are packed to 50 bytes in the file, while stl_facet is padded.
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, num_facets, 4096),
+		[stl, src = data + HEADER_SIZE](const tbb::blocked_range<size_t> &range) {
+			for (size_t i = range.begin(); i < range.end(); ++ i) {
+				stl_facet &facet = stl->facet_start[i];
+				memcpy(&facet, src + i * SIZEOF_STL_FACET, SIZEOF_STL_FACET);
+#if BOOST_ENDIAN_BIG_BYTE
+				stl_internal_reverse_quads((char*)&facet, 48);
+#endif /* BOOST_ENDIAN_BIG_BYTE */
+			}
+		});
+	return true;
+}
+
+// Parser of the ASCII STL tokens, reading up to the end of the mapped file.
+class StlAsciiParser
 {
+public:
+	StlAsciiParser(const char *begin, const char *end) : m_ptr(begin), m_end(end) {}
+
+	const char* ptr() const { return m_ptr; }
+
+	void skip_whitespaces() { while (m_ptr != m_end && is_whitespace(*m_ptr)) ++ m_ptr; }
+	void skip_line() {
+		while (m_ptr != m_end && *m_ptr != '\n') ++ m_ptr;
+		if (m_ptr != m_end) ++ m_ptr;
+	}
+	// Match a keyword followed by a whitespace or the end of the file.
+	bool keyword(const char *kw) {
+		this->skip_whitespaces();
+		size_t len = strlen(kw);
+		if (size_t(m_end - m_ptr) < len || strncmp(m_ptr, kw, len) != 0 || (m_ptr + len != m_end && ! is_whitespace(m_ptr[len])))
+			return false;
+		m_ptr += len;
+		return true;
+	}
+	bool number(float &out) {
+		this->skip_whitespaces();
+		const char *token = m_ptr;
+		while (m_ptr != m_end && ! is_whitespace(*m_ptr)) ++ m_ptr;
+		return parse_float(token, m_ptr, out);
+	}
+
+	static bool is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+	// Start of the first "facet" keyword at the beginning of a line at or after pos.
+	static const char* find_facet(const char *begin, const char *pos, const char *end) {
+		for (; pos < end; ++ pos) {
+			pos = static_cast<const char*>(memchr(pos, 'f', end - pos));
+			if (pos == nullptr)
+				return end;
+			if (size_t(end - pos) > 5 && strncmp(pos, "facet", 5) == 0 && is_whitespace(pos[5])) {
+				const char *line = pos;
+				while (line != begin && (line[-1] == ' ' || line[-1] == '\t')) -- line;
+				if (line == begin || line[-1] == '\n' || line[-1] == '\r')
+					return pos;
+			}
+		}
+		return end;
+	}
+
+private:
+	static bool parse_float(const char *begin, const char *end, float &out) {
+		if (begin == end)
+			return false;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+		// from_chars() does not accept the leading plus sign written by some exporters.
+		const char *number = (*begin == '+') ? begin + 1 : begin;
+		auto [ptr, ec] = std::from_chars(number, end, out);
+		if (ec == std::errc::result_out_of_range && ptr == end)
+			// Subnormal or overflowing value, which from_chars() rejects. Accept it as fscanf() did,
+			// with the subnormal or zero or the infinity of strtof().
+			return parse_float_strtof(begin, end, out);
+		return ec == std::errc() && ptr == end;
+#else
+		return parse_float_strtof(begin, end, out);
+#endif
+	}
+
+	static bool parse_float_strtof(const char *begin, const char *end, float &out) {
+		// The mapped buffer is not null terminated, thus the token is copied.
+		char buf[64];
+		size_t len = end - begin;
+		if (len >= sizeof(buf))
+			return false;
+		memcpy(buf, begin, len);
+		buf[len] = 0;
+		char *endptr = nullptr;
+		out = strtof(buf, &endptr);
+		return endptr == buf + len;
+	}
+
+	const char *m_ptr;
+	const char *m_end;
+};
+
+// Parse the facets starting in <begin, end). The last facet may extend past end up to file_end.
+static bool stl_parse_ascii_facets(const char *begin, const char *end, const char *file_end, std::vector<stl_facet> &out)
+{
+	StlAsciiParser parser(begin, file_end);
+	for (;;) {
+		parser.skip_whitespaces();
+		if (parser.ptr() >= end)
+			return true;
+		// Skip solid/endsolid, broken STL file generators may put several of them.
+		if (parser.keyword("endsolid") || parser.keyword("solid")) {
+			parser.skip_line();
+			continue;
+		}
+		stl_facet facet;
+		if (! parser.keyword("facet") || ! parser.keyword("normal"))
+			return false;
+		// Normal may be mangled, maybe denormals or "not a number" were stored. Just reset the normal and silently ignore it.
+		bool normal_ok = true;
+		for (size_t i = 0; i < 3; ++ i)
+			normal_ok &= parser.number(facet.normal(i));
+		if (! normal_ok)
+			facet.normal = stl_normal::Zero();
+		if (! parser.keyword("outer") || ! parser.keyword("loop"))
+			return false;
+		for (size_t j = 0; j < 3; ++ j)
+			if (! parser.keyword("vertex") || ! parser.number(facet.vertex[j](0)) || ! parser.number(facet.vertex[j](1)) || ! parser.number(facet.vertex[j](2)))
+				return false;
+		// Some G-code generators tend to produce text after "endloop" and "endfacet". Just ignore it.
+		if (! parser.keyword("endloop"))
+			return false;
+		parser.skip_line();
+		if (! parser.keyword("endfacet"))
+			return false;
+		parser.skip_line();
+		memset(facet.extra, 0, sizeof(facet.extra));
+		out.emplace_back(facet);
+	}
+}
+
+static bool stl_read_mapped_ascii(stl_file *stl, const char *data, size_t size, const char *file, size_t chunk_size)
+{
+	// Get the header.
+	size_t i = 0;
+	for (; i < 80 && i < size && data[i] != '\n'; ++ i)
+		stl->stats.header[i] = data[i];
+	stl->stats.header[i] = '\0';
+
+	// Split the file into chunks at the facet boundaries and parse them in parallel.
+	assert(chunk_size > 0);
+	const char *end = data + size;
+	std::vector<std::vector<stl_facet>> chunks((size + chunk_size - 1) / chunk_size);
+	std::atomic<bool> ok { true };
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1),
+		[data, end, chunk_size, &chunks, &ok](const tbb::blocked_range<size_t> &range) {
+			for (size_t ichunk = range.begin(); ichunk < range.end(); ++ ichunk) {
+				const char *chunk_begin = ichunk == 0 ? data : StlAsciiParser::find_facet(data, data + ichunk * chunk_size, end);
+				const char *chunk_end   = StlAsciiParser::find_facet(data, std::min(data + (ichunk + 1) * chunk_size, end), end);
+				if (chunk_begin < chunk_end) {
+					std::vector<stl_facet> &facets = chunks[ichunk];
+					facets.reserve((chunk_end - chunk_begin) / 256);
+					if (! stl_parse_ascii_facets(chunk_begin, chunk_end, end, facets))
+						ok = false;
+				}
+			}
+		});
+	if (! ok) {
+		BOOST_LOG_TRIVIAL(error) << "Something is syntactically very wrong with this ASCII STL! ";
+		return false;
+	}
+
+	size_t num_facets = 0;
+	for (const std::vector<stl_facet> &facets : chunks)
+		num_facets += facets.size();
+	stl->stats.number_of_facets = uint32_t(num_facets);
+	stl->stats.original_num_facets = stl->stats.number_of_facets;
+	stl_allocate(stl);
+	auto it = stl->facet_start.begin();
+	for (const std::vector<stl_facet> &facets : chunks)
+		it = std::copy(facets.begin(), facets.end(), it);
+	return true;
+}
+
+// Load the STL file memory mapped, parsing it in parallel.
+// Returns false with open_failed set if the file could not be mapped.
+static bool stl_open_mapped(stl_file *stl, const char *file, size_t ascii_chunk_size, bool &open_failed)
+{
+	namespace bip = boost::interprocess;
+	// The narrow file name is not converted from UTF-8 on Windows, such files are read by stl_read() instead.
+	bip::file_mapping  mapping;
+	bip::mapped_region region;
+	try {
+		bip::file_mapping(file, bip::read_only).swap(mapping);
+		bip::mapped_region(mapping, bip::read_only).swap(region);
+	} catch (const bip::interprocess_exception &) {
+		open_failed = true;
+		return false;
+	}
+	open_failed = false;
+	const char *data = static_cast<const char*>(region.get_address());
+	size_t      size = region.get_size();
+
+	// Check for binary or ASCII file.
+	if (size < HEADER_SIZE + 128) {
+		BOOST_LOG_TRIVIAL(error) << "stl_open: The input is an empty file: " << file;
+		return false;
+	}
+	stl->stats.type = std::any_of(data + HEADER_SIZE, data + HEADER_SIZE + 128, [](char c) { return (unsigned char)c > 127; }) ? binary : ascii;
+
+	bool result = stl->stats.type == binary ?
+		stl_read_mapped_binary(stl, data, size, file) :
+		stl_read_mapped_ascii(stl, data, size, file, ascii_chunk_size);
+	if (result)
+		stl_mapped_update_stats(stl);
+	return result;
+}
+
+bool stl_open(stl_file *stl, const char *file, size_t ascii_chunk_size)
+{
+	stl->clear();
+	bool open_failed = false;
+	if (stl_open_mapped(stl, file, ascii_chunk_size, open_failed))
+		return true;
+	if (! open_failed)
+		return false;
+	// The file could not be mapped, read it through stdio.
 	stl->clear();
 	FILE *fp = stl_open_count_facets(stl, file);
 	if (fp == nullptr)
@@ -13,6 +13,7 @@
 namespace libnest2d {
 
 static const constexpr int BIN_ID_UNSET = -1;
+static const constexpr int SHAPE_ID_UNSET = -1;
 
 /**
  * \brief An item to be placed on a bin.
@@ -68,7 +69,7 @@ class _Item {
         BBCache(): valid(false) {}
     } bb_cache_;
     
-    int binid_{BIN_ID_UNSET}, priority_{0};
+    int binid_{BIN_ID_UNSET}, priority_{0}, shapeid_{SHAPE_ID_UNSET};
     bool fixed_{false};
 
 public:
@@ -141,6 +142,14 @@ public:
     inline void priority(int p) { priority_ = p; }
     inline int priority() const noexcept { return priority_; }
 
+    /**
+     * @brief Items with the same shape id carry identical raw shapes, e.g.
+     * the copies of the same object. The placer may reuse the results computed
+     * for one copy for all the others. SHAPE_ID_UNSET disables this.
+     */
+    inline void shapeId(int id) { shapeid_ = id; }
+    inline int shapeId() const noexcept { return shapeid_; }
+
     /**
      * @brief Convert the polygon to string representation. The format depends
      * on the implementation of the polygon.
@@ -8,6 +8,8 @@
 #include <iterator>
 #include <future>
 #include <atomic>
+#include <map>
+#include <tuple>
 
 #ifndef NDEBUG
 #include <iostream>
@@ -139,6 +141,14 @@ struct NfpPConfig {
      */
     bool parallel = true;
 
+    /**
+     * @brief If true, an item with the shape id of an already packed item
+     * (see _Item::shapeId()) is first tried on the points of a lattice next to
+     * its packed copies. The lattice is derived from the nfp of the item with
+     * itself. The general nfp search is only run if none of these points fits.
+     */
+    bool copy_pattern = true;
+
     /**
      * @brief before_packing Callback that is called just before a search for
      * a new item's position is started. You can use this to create various
@@ -491,6 +501,24 @@ private:
     const double norm_;
     Pile merged_pile_;
 
+    // Identifies the transformed shape of an item with a shape id: the shape
+    // id, the rotation and the inflation.
+    using CopyKey = std::tuple<int, double, Coord>;
+
+    // The nfps of the item pairs with a shape id, keyed by the stationary and
+    // the orbiting item. An nfp is stored relative to the translation of the
+    // stationary item, so it is valid for all the copies of the pair.
+    using NfpKey = std::tuple<int, double, Coord, int, double, Coord>;
+    std::map<NfpKey, RawShape> nfp_cache_;
+
+    // The two translations spanning the lattice in which the copies of an item
+    // are packed. An invalid lattice is stored for degenerate shapes.
+    struct Lattice {
+        Vertex a, b;
+        bool valid = false;
+    };
+    std::map<CopyKey, Lattice> lattices_;
+
 public:
 
     inline explicit _NofitPolyPlacer(const BinType& bin):
@@ -589,11 +617,19 @@ private:
 
     using Shapes = TMultiShape<RawShape>;
 
-    Shapes calcnfp(const Item &trsh, Lvl<nfp::NfpLevel::CONVEX_ONLY>)
+    static CopyKey copyKey(const Item &itm)
     {
-        using namespace nfp;
+        return CopyKey{itm.shapeId(), double(itm.rotation()), itm.inflation()};
+    }
 
-        Shapes nfps(items_.size());
+    // Get the nfp of each packed item with trsh relative to the translation
+    // of the packed item. The cached nfps are reused and the missing ones are
+    // calculated in parallel, once for all the copies of a packed item. The
+    // nfps of the items without a shape id are stored in the uncached shapes.
+    std::vector<const RawShape*> relativeNfps(const Item &trsh,
+                                              Shapes &uncached)
+    {
+        using namespace nfp;
 
         // /////////////////////////////////////////////////////////////////////
         // TODO: this is a workaround and should be solved in Item with mutexes
@@ -612,14 +648,77 @@ private:
         }
         // /////////////////////////////////////////////////////////////////////
 
-        __parallel::enumerate(items_.begin(), items_.end(),
-                              [&nfps, &trsh](const Item& sh, size_t n)
+        std::vector<const RawShape*> ret(items_.size(), nullptr);
+        uncached.clear();
+        uncached.resize(items_.size());
+
+        bool cacheable = trsh.shapeId() != SHAPE_ID_UNSET;
+        CopyKey trkey = copyKey(trsh);
+
+        auto nfpkey = [&trkey](const Item &itm) {
+            return std::tuple_cat(copyKey(itm), trkey);
+        };
+
+        auto is_cached = [cacheable](const Item &itm) {
+            return cacheable && itm.shapeId() != SHAPE_ID_UNSET;
+        };
+
+        // Indices of the packed items with an nfp to calculate
+        std::vector<size_t> pending;
+        std::map<NfpKey, size_t> pending_keys;
+        for(size_t n = 0; n < items_.size(); ++n) {
+            const Item& itm = items_[n];
+            if(!is_cached(itm)) { pending.emplace_back(n); continue; }
+
+            NfpKey key = nfpkey(itm);
+            auto it = nfp_cache_.find(key);
+            if(it != nfp_cache_.end()) ret[n] = &it->second;
+            else if(pending_keys.emplace(key, n).second) pending.emplace_back(n);
+        }
+
+        Shapes nfps(pending.size());
+        __parallel::enumerate(pending.begin(), pending.end(),
+                              [this, &nfps, &trsh](size_t idx, size_t n)
         {
+            const Item& sh = items_[idx];
             auto& fixedp = sh.transformedShape();
             auto& orbp = trsh.transformedShape();
             auto subnfp_r = noFitPolygon<NfpLevel::CONVEX_ONLY>(fixedp, orbp);
             correctNfpPosition(subnfp_r, sh, trsh);
-            nfps[n] = subnfp_r.first;
+            sl::translate(subnfp_r.first, -sh.translation());
+            nfps[n] = std::move(subnfp_r.first);
+        });
+
+        for(size_t n = 0; n < pending.size(); ++n) {
+            size_t idx = pending[n];
+            const Item& itm = items_[idx];
+            if(is_cached(itm)) {
+                auto it = nfp_cache_.emplace(nfpkey(itm), std::move(nfps[n]));
+                ret[idx] = &it.first->second;
+            } else {
+                uncached[idx] = std::move(nfps[n]);
+                ret[idx] = &uncached[idx];
+            }
+        }
+
+        // The copies of the items calculated above
+        for(size_t n = 0; n < items_.size(); ++n)
+            if(!ret[n]) ret[n] = &nfp_cache_.at(nfpkey(items_[n]));
+
+        return ret;
+    }
+
+    Shapes calcnfp(const Item &trsh, Lvl<nfp::NfpLevel::CONVEX_ONLY>)
+    {
+        Shapes uncached;
+        std::vector<const RawShape*> rnfps = relativeNfps(trsh, uncached);
+
+        Shapes nfps(items_.size());
+        __parallel::enumerate(items_.begin(), items_.end(),
+                              [&nfps, &rnfps](const Item& sh, size_t n)
+        {
+            nfps[n] = *rnfps[n];
+            sl::translate(nfps[n], sh.translation());
         });
 
         return nfp::merge(nfps);
@@ -656,6 +755,247 @@ private:
 
     using Edges = EdgeCache<RawShape>;
 
+    // The extent of a polygon contour along the line on which the coordinate
+    // of the given axis (0 for X, 1 for Y) equals at. The extent is measured
+    // along the other axis. Returns false if the line misses the contour.
+    static bool contourExtent(const RawShape& sh, int axis, double at,
+                              double& lo, double& hi)
+    {
+        auto fixed = [axis](const Vertex& v) {
+            return double(axis == 0 ? getX(v) : getY(v));
+        };
+        auto along = [axis](const Vertex& v) {
+            return double(axis == 0 ? getY(v) : getX(v));
+        };
+
+        lo = std::numeric_limits<double>::max();
+        hi = std::numeric_limits<double>::lowest();
+
+        auto first = sl::cbegin(sh), last = sl::cend(sh);
+        if(first == last) return false;
+
+        for(auto next = std::next(first); next != last; ++first, ++next) {
+            double f1 = fixed(*first), f2 = fixed(*next);
+            if(at < std::min(f1, f2) || at > std::max(f1, f2)) continue;
+
+            double a1 = along(*first), a2 = along(*next);
+            if(f1 == f2) {
+                lo = std::min(lo, std::min(a1, a2));
+                hi = std::max(hi, std::max(a1, a2));
+            } else {
+                double a = a1 + (a2 - a1) * (at - f1) / (f2 - f1);
+                lo = std::min(lo, a);
+                hi = std::max(hi, a);
+            }
+        }
+
+        return lo <= hi;
+    }
+
+    // Find the lattice for the copies of an item from the nfp of the item with
+    // itself, translated to be the set of the translations between two
+    // overlapping copies. The first lattice vector is the shortest horizontal
+    // translation out of this nfp. The second one is the lowest translation
+    // to the next row, which also clears the copies translated along the first
+    // vector. Both are rounded away from the nfp.
+    static Lattice findLattice(const RawShape& selfnfp)
+    {
+        Lattice ret;
+
+        double lo = 0., hi = 0.;
+        if(!contourExtent(selfnfp, 1, 0., lo, hi) || hi < 1.) return ret;
+
+        Coord dx = Coord(std::ceil(hi));
+        auto bb = sl::boundingBox(selfnfp);
+        double minx = double(getX(bb.minCorner()));
+        double maxx = double(getX(bb.maxCorner()));
+
+        // The height of a row above the row shifted horizontally by sx
+        auto rowHeight = [&selfnfp, dx, minx, maxx](Coord sx) {
+            double h = 1.;
+            auto kmin = std::ceil((minx - sx) / dx);
+            auto kmax = std::floor((maxx - sx) / dx);
+            for(double k = kmin; k <= kmax; k += 1.) {
+                double l = 0., u = 0.;
+                if(contourExtent(selfnfp, 0, sx + k * dx, l, u))
+                    h = std::max(h, u);
+            }
+            return Coord(std::ceil(h));
+        };
+
+        // The row height is the maximum of piecewise linear functions, try
+        // the shifts to the nfp vertices and evenly spaced ones in between.
+        std::vector<Coord> shifts;
+        const int samples = 64;
+        for(int i = 0; i < samples; ++i)
+            shifts.emplace_back(Coord(i * double(dx) / samples));
+
+        for(auto it = sl::cbegin(selfnfp); it != sl::cend(selfnfp); ++it) {
+            auto sx = std::fmod(double(getX(*it)), double(dx));
+            shifts.emplace_back(Coord(sx < 0 ? sx + dx : sx));
+        }
+
+        Coord best_sx = 0, best_dy = std::numeric_limits<Coord>::max();
+        for(Coord sx : shifts) {
+            Coord dy = rowHeight(sx);
+            if(dy < best_dy) { best_dy = dy; best_sx = sx; }
+        }
+
+        ret.a = {dx, 0};
+        ret.b = {best_sx, best_dy};
+        ret.valid = true;
+
+        return ret;
+    }
+
+    // True if the point lies inside the convex polygon, farther than a unit
+    // from its contour.
+    static bool isDeepInside(const RawShape& convex, const Vertex& p)
+    {
+        double mind = std::numeric_limits<double>::max();
+        double maxd = std::numeric_limits<double>::lowest();
+
+        auto first = sl::cbegin(convex), last = sl::cend(convex);
+        if(first == last) return false;
+
+        for(auto next = std::next(first); next != last; ++first, ++next) {
+            double ex = double(getX(*next) - getX(*first));
+            double ey = double(getY(*next) - getY(*first));
+            double len = std::sqrt(ex * ex + ey * ey);
+            if(len <= 0.) continue;
+
+            double px = double(getX(p) - getX(*first));
+            double py = double(getY(p) - getY(*first));
+            double d = (ex * py - ey * px) / len;
+            mind = std::min(mind, d);
+            maxd = std::max(maxd, d);
+        }
+
+        return mind > 1. || maxd < -1.;
+    }
+
+    // Try to pack the item on a lattice point next to one of its packed
+    // copies (see NfpPConfig::copy_pattern). The free lattice points are rated
+    // with the object function and the best one which keeps the pile inside
+    // the bin is taken. Returns false and leaves the item untouched if there is
+    // no such point.
+    bool packCopy(Item& item,
+                  const std::function<double(const Item&)>& objfunc,
+                  const ItemGroup& remlist)
+    {
+        if(MaxNfpLevel::value != nfp::NfpLevel::CONVEX_ONLY) return false;
+
+        auto initial_tr = item.translation();
+        auto initial_rot = item.rotation();
+
+        struct Candidate {
+            double score;
+            Vertex tr;
+            Radians rot;
+        };
+
+        std::vector<Candidate> candidates;
+        Shapes uncached;
+
+        if(config_.before_packing)
+            config_.before_packing(merged_pile_, items_, remlist);
+
+        for(auto rot : config_.rotations) {
+            item.translation(initial_tr);
+            item.rotation(initial_rot + rot);
+
+            CopyKey key = copyKey(item);
+            std::vector<size_t> copies;
+            for(size_t n = 0; n < items_.size(); ++n)
+                if(copyKey(items_[n]) == key) copies.emplace_back(n);
+
+            if(copies.empty()) continue;
+
+            std::vector<const RawShape*> rnfps = relativeNfps(item, uncached);
+
+            // The reference vertex and the bounding box of the untranslated item
+            Vertex rv = item.referenceVertex() - initial_tr;
+            Box ibb = item.boundingBox();
+            Vertex bbmin = ibb.minCorner() - initial_tr;
+            Vertex bbmax = ibb.maxCorner() - initial_tr;
+
+            auto lit = lattices_.find(key);
+            if(lit == lattices_.end()) {
+                RawShape selfnfp = *rnfps[copies.front()];
+                sl::translate(selfnfp, -rv);
+                lit = lattices_.emplace(key, findLattice(selfnfp)).first;
+            }
+
+            const Lattice& lattice = lit->second;
+            if(!lattice.valid) continue;
+
+            const Vertex& a = lattice.a;
+            const Vertex& b = lattice.b;
+            const Vertex steps[] = { a, -a, b, -b, b - a, a - b, a + b, -a - b };
+
+            std::vector<Vertex> trs;
+            trs.reserve(copies.size() * 8);
+            for(size_t n : copies)
+                for(const Vertex& step : steps)
+                    trs.emplace_back(items_[n].get().translation() + step);
+
+            auto vless = [](const Vertex& v1, const Vertex& v2) {
+                return getX(v1) == getX(v2) ? getY(v1) < getY(v2) :
+                                              getX(v1) < getX(v2);
+            };
+            std::sort(trs.begin(), trs.end(), vless);
+            trs.erase(std::unique(trs.begin(), trs.end()), trs.end());
+
+            for(const Vertex& tr : trs) {
+                Vertex cmin = bbmin + tr, cmax = bbmax + tr;
+
+                bool collides = false;
+                for(size_t n = 0; n < items_.size() && !collides; ++n) {
+                    const Item& p = items_[n];
+                    Box pbb = p.boundingBox();
+                    if(getX(pbb.minCorner()) >= getX(cmax) ||
+                       getX(cmin) >= getX(pbb.maxCorner()) ||
+                       getY(pbb.minCorner()) >= getY(cmax) ||
+                       getY(cmin) >= getY(pbb.maxCorner()))
+                        continue;
+
+                    collides = isDeepInside(*rnfps[n], rv + tr - p.translation());
+                }
+
+                if(!collides) {
+                    item.translation(tr);
+                    candidates.push_back({objfunc(item), tr, item.rotation()});
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate& c1, const Candidate& c2) {
+            return c1.score < c2.score;
+        });
+
+        Pile hull_and_item(2);
+        hull_and_item.front() = sl::convexHull(merged_pile_);
+        for(const Candidate& c : candidates) {
+            item.rotation(c.rot);
+            item.translation(c.tr);
+            hull_and_item.back() = item.transformedShape();
+            auto chull = sl::convexHull(hull_and_item);
+
+            double miss = 0;
+            if(config_.alignment == Config::Alignment::DONT_ALIGN)
+                miss = sl::isInside(chull, bin_) ? -1.0 : 1.0;
+            else miss = overfit(chull, bin_);
+
+            if(miss <= 0) return true;
+        }
+
+        item.translation(initial_tr);
+        item.rotation(initial_rot);
+
+        return false;
+    }
+
     template<class Range = ConstItemRange<typename Base::DefaultIter>>
     PackResult _trypack(
             Item& item,
@@ -742,6 +1082,9 @@ private:
             can_pack = best_overfit <= 0;
             item.rotation(best_rot);
             item.translation(best_tr);
+        } else if(config_.copy_pattern && item.shapeId() != SHAPE_ID_UNSET &&
+                  packCopy(item, _objfunc, remlist)) {
+            can_pack = true;
         } else {
 
             Pile merged_pile = merged_pile_;
@@ -7,10 +7,14 @@
 #define slic3r_AABBTreeIndirect_hpp_
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <limits>
 #include <type_traits>
 #include <vector>
 
+#include <tbb/parallel_invoke.h>
+
 #include "Utils.hpp" // for next_highest_power_of_2()
 
 extern "C"
@@ -132,17 +136,99 @@ private:
         BoundingBox bbox(input[left].bbox());
         for (size_t i = left + 1; i <= right; ++ i)
             bbox.extend(input[i].bbox());
-        int dimension = -1;
-        bbox.diagonal().maxCoeff(&dimension);
 
 		// Partition the input to left / right pieces of the same length to produce a balanced tree.
 		size_t center = (left + right) / 2;
+		int dimension = split_dimension(input, bbox, left, right, center);
 		partition_input(input, size_t(dimension), left, right, center);
 		// Insert an inner node into the tree. Inner node does not reference any input entity (triangle, line segment etc).
 		m_nodes[node].idx  = inner;
 		m_nodes[node].bbox = bbox;
-        build_recursive(input, node * 2 + 1, left, center);
-		build_recursive(input, node * 2 + 2, center + 1, right);
+		// The two subtrees write to disjoint nodes and input ranges, build the large ones in parallel.
+		if (right - left >= parallel_build_threshold)
+			tbb::parallel_invoke(
+				[this, &input, node, left, center]() { build_recursive(input, node * 2 + 1, left, center); },
+				[this, &input, node, center, right]() { build_recursive(input, node * 2 + 2, center + 1, right); });
+		else {
+	        build_recursive(input, node * 2 + 1, left, center);
+			build_recursive(input, node * 2 + 2, center + 1, right);
+		}
+	}
+
+	// Input ranges at least this long are split into subtrees built in parallel.
+	static constexpr size_t parallel_build_threshold = 4096;
+	// Input ranges shorter than this are split along the longest dimension of their bounding box,
+	// the surface area heuristic pays off at the upper levels of the tree only.
+	static constexpr size_t sah_threshold = 1024;
+	static constexpr size_t sah_bins = 16;
+
+	// Surface area of a bounding box (perimeter in 2D) up to a constant factor.
+	static CoordType surface_area(const BoundingBox &bbox)
+	{
+		if (bbox.isEmpty())
+			return CoordType(0);
+		VectorType d = bbox.diagonal();
+		if (NumDimensions == 3)
+			return d(0) * d(1) + d(1) * d(2) + d(2) * d(0);
+		return d.sum();
+	}
+
+	// Choose the dimension to split the input <left, right> at the "center" index.
+	// The tree is kept balanced, thus the position of the split is fixed and the surface area heuristic
+	// only chooses the dimension: the centroids are binned along each dimension and the cost
+	// of the split is estimated from the bounding boxes of the bins left and right of the center.
+	// The bin containing the center is accounted for on both sides.
+	template<typename SourceNode>
+	int split_dimension(const std::vector<SourceNode> &input, const BoundingBox &bbox, const size_t left, const size_t right, const size_t center) const
+	{
+		int dimension = -1;
+		bbox.diagonal().maxCoeff(&dimension);
+		if (right - left + 1 < sah_threshold)
+			return dimension;
+
+		BoundingBox centroids(input[left].centroid(), input[left].centroid());
+		for (size_t i = left + 1; i <= right; ++ i)
+			centroids.extend(input[i].centroid());
+
+		// Bin the input along all the dimensions in a single pass.
+		std::array<std::array<size_t, sah_bins>, NumDimensions>      counts {};
+		std::array<std::array<BoundingBox, sah_bins>, NumDimensions> boxes;
+		const VectorType lo    = centroids.min();
+		const VectorType range = centroids.diagonal();
+		VectorType       scale;
+		for (int dim = 0; dim < NumDimensions; ++ dim)
+			scale(dim) = range(dim) > CoordType(0) ? CoordType(sah_bins) / range(dim) : CoordType(0);
+		for (size_t i = left; i <= right; ++ i) {
+			const auto bbox_i     = input[i].bbox();
+			const auto centroid_i = input[i].centroid();
+			for (int dim = 0; dim < NumDimensions; ++ dim) {
+				auto bin = std::min(size_t(scale(dim) * (centroid_i(dim) - lo(dim))), sah_bins - 1);
+				++ counts[dim][bin];
+				boxes[dim][bin].extend(bbox_i);
+			}
+		}
+
+		const size_t num_left  = center - left + 1;
+		const size_t num_right = right - center;
+		CoordType    best_cost = std::numeric_limits<CoordType>::max();
+		for (int dim = 0; dim < NumDimensions; ++ dim) {
+			if (range(dim) <= CoordType(0))
+				continue;
+			// Find the bin holding the center.
+			size_t center_bin = 0;
+			for (size_t cnt = counts[dim][0]; cnt < num_left; cnt += counts[dim][++ center_bin]) ;
+			BoundingBox left_box, right_box;
+			for (size_t bin = 0; bin <= center_bin; ++ bin)
+				left_box.extend(boxes[dim][bin]);
+			for (size_t bin = center_bin; bin < sah_bins; ++ bin)
+				right_box.extend(boxes[dim][bin]);
+			CoordType cost = surface_area(left_box) * CoordType(num_left) + surface_area(right_box) * CoordType(num_right);
+			if (cost < best_cost) {
+				best_cost = cost;
+				dimension = dim;
+			}
+		}
+		return dimension;
 	}
 
 	// Partition the input m_nodes <left, right> at "k" and "dimension" using the QuickSelect method:
@@ -214,6 +300,9 @@ using Tree3f = Tree<3, float>;
 using Tree2d = Tree<2, double>;
 using Tree3d = Tree<3, double>;
 
+// Number of rays traced together by intersect_rays_first_hit().
+static constexpr int RayPacketSize = 4;
+
 namespace detail {
 	template<typename AVertexType, typename AIndexedFaceType, typename ATreeType, typename AVectorType>
 	struct RayIntersector {
@@ -399,6 +488,140 @@ namespace detail {
 		}
 	}
 
+	// Rays traced together by intersect_rays_first_hit(). The origins, directions and the closest hits
+	// of the rays are stored as arrays of RayPacketSize lanes, so that Eigen vectorizes the ray-box
+	// and ray-triangle tests over the rays of a packet.
+	template<typename AVertexType, typename AIndexedFaceType, typename ATreeType, typename AScalar>
+	struct RayPacketIntersector {
+		using VertexType 		= AVertexType;
+		using IndexedFaceType 	= AIndexedFaceType;
+		using TreeType			= ATreeType;
+		using Scalar 			= AScalar;
+		using Lanes 			= Eigen::Array<Scalar, RayPacketSize, 1>;
+		using Mask 				= Eigen::Array<bool, RayPacketSize, 1>;
+
+		const std::vector<VertexType> 		&vertices;
+		const std::vector<IndexedFaceType> 	&faces;
+		const TreeType 						&tree;
+
+		std::array<Lanes, 3>				 origin;
+		std::array<Lanes, 3>				 dir;
+		// Inverse of the ray directions, zero if the ray is parallel to the axis.
+		std::array<Lanes, 3>				 invdir;
+		// Huge if the ray is parallel to the axis, zero otherwise.
+		std::array<Lanes, 3>				 parallel;
+		// Whether any ray of the packet is parallel to any axis.
+		bool 								 any_parallel;
+		// Parameter of the closest hit found so far, rounded to float as igl::Hit::t is.
+		// Lanes not carrying a ray are disabled by min_t == -infinity.
+		Lanes 								 min_t;
+		Lanes 								 u;
+		Lanes 								 v;
+		std::array<int, RayPacketSize> 		 id;
+	};
+
+	// Packet version of ray_box_intersect_invdir() using the slab method without branches and without NaNs.
+	// The test is conservative: a box is never rejected for a ray, for which ray_box_intersect_invdir() accepts it.
+	// Unlike ray_box_intersect_invdir(), a ray parallel to an axis hits a box it touches with its origin on the box boundary.
+	template<typename RayPacketIntersectorType, typename BoxScalar>
+	inline typename RayPacketIntersectorType::Mask ray_packet_box_intersect_invdir(
+		const RayPacketIntersectorType  &packet,
+		const Eigen::AlignedBox<BoxScalar, 3> &box)
+	{
+		using Scalar = typename RayPacketIntersectorType::Scalar;
+		using Lanes  = typename RayPacketIntersectorType::Lanes;
+		Lanes tmin = Lanes::Zero(), tmax = packet.min_t;
+		for (int i = 0; i < 3; ++ i) {
+			Lanes dlo = Scalar(box.min()(i)) - packet.origin[i];
+			Lanes dhi = Scalar(box.max()(i)) - packet.origin[i];
+			Lanes tlo = dlo * packet.invdir[i];
+			Lanes thi = dhi * packet.invdir[i];
+			Lanes tnear = tlo.min(thi);
+			Lanes tfar  = tlo.max(thi);
+			if (packet.any_parallel) {
+				// A parallel ray is not bounded by the slab if its origin is inside the slab, otherwise it misses the box.
+				tnear = tnear.max(dlo * dhi * packet.parallel[i]);
+				tfar += packet.parallel[i];
+			}
+			tmin = tmin.max(tnear);
+			tmax = tmax.min(tfar);
+		}
+		return tmin <= tmax;
+	}
+
+	// Packet version of intersect_triangle1() of igl/raytri.c with the same operations in the same order,
+	// thus producing the same hits. The closest hits of the packet are updated.
+	template<typename RayPacketIntersectorType>
+	inline void intersect_ray_packet_triangle(RayPacketIntersectorType &packet, const typename RayPacketIntersectorType::Mask &mask, size_t face_idx)
+	{
+		using Scalar = typename RayPacketIntersectorType::Scalar;
+		using Lanes  = typename RayPacketIntersectorType::Lanes;
+		using Vector = Eigen::Matrix<Scalar, 3, 1>;
+		const auto &face = packet.faces[face_idx];
+		const Vector v0 = packet.vertices[face(0)].template cast<Scalar>();
+		const Vector e1 = packet.vertices[face(1)].template cast<Scalar>() - v0;
+		const Vector e2 = packet.vertices[face(2)].template cast<Scalar>() - v0;
+		const auto  &d  = packet.dir;
+		Lanes px  = d[1] * e2.z() - d[2] * e2.y();
+		Lanes py  = d[2] * e2.x() - d[0] * e2.z();
+		Lanes pz  = d[0] * e2.y() - d[1] * e2.x();
+		Lanes det = e1.x() * px + e1.y() * py + e1.z() * pz;
+		Lanes tx  = packet.origin[0] - v0.x();
+		Lanes ty  = packet.origin[1] - v0.y();
+		Lanes tz  = packet.origin[2] - v0.z();
+		Lanes u   = tx * px + ty * py + tz * pz;
+		Lanes qx  = ty * e1.z() - tz * e1.y();
+		Lanes qy  = tz * e1.x() - tx * e1.z();
+		Lanes qz  = tx * e1.y() - ty * e1.x();
+		Lanes v   = d[0] * qx + d[1] * qy + d[2] * qz;
+		// Flipping the signs for a negative determinant is exact, the tests are those of intersect_triangle1().
+		Lanes inv_det = Scalar(1) / det;
+		Lanes t = (e2.x() * qx + e2.y() * qy + e2.z() * qz) * inv_det;
+		for (int i = 0; i < RayPacketSize; ++ i) {
+			// Tests of intersect_triangle1(), with the signs flipped for a negative determinant.
+			Scalar sign = det(i) < Scalar(0) ? Scalar(-1) : Scalar(1);
+			Scalar sdet = sign * det(i);
+			Scalar su   = sign * u(i);
+			Scalar sv   = sign * v(i);
+			if (mask(i) && sdet > Scalar(IGL_RAY_TRI_EPSILON) && su >= Scalar(0) && su <= sdet && sv >= Scalar(0) && su + sv <= sdet && t(i) > Scalar(0)) {
+				auto tf = Scalar(float(t(i)));
+				if (tf < packet.min_t(i)) {
+					packet.min_t(i) = tf;
+					packet.u(i)     = u(i) * inv_det(i);
+					packet.v(i)     = v(i) * inv_det(i);
+					packet.id[i]    = int(face_idx);
+				}
+			}
+		}
+	}
+
+	// Traverse the tree with a packet of rays, visiting a node if any of the rays may hit a triangle in it
+	// closer than its closest hit found so far. The nodes are visited in the order of
+	// intersect_ray_recursive_first_hit(), thus each ray finds the same first hit.
+	template<typename RayPacketIntersectorType>
+	inline void intersect_ray_packet_first_hit(RayPacketIntersectorType &packet)
+	{
+		// Depth of the tree is limited by the bit width of the node index.
+		std::array<size_t, 2 * sizeof(size_t) * 8> stack;
+		size_t stack_size = 0;
+		stack[stack_size ++] = 0;
+		while (stack_size > 0) {
+			size_t      node_idx = stack[-- stack_size];
+			const auto &node     = packet.tree.node(node_idx);
+			assert(node.is_valid());
+			auto mask = ray_packet_box_intersect_invdir(packet, node.bbox);
+			if (! mask.any())
+				continue;
+			if (node.is_leaf())
+				intersect_ray_packet_triangle(packet, mask, node.idx);
+			else {
+				// Push the right child first to visit the left one first.
+				stack[stack_size ++] = node_idx * 2 + 2;
+				stack[stack_size ++] = node_idx * 2 + 1;
+			}
+		}
+	}
+
 	// Nothing to do with COVID-19 social distancing.
 	template<typename AVertexType, typename AIndexedFaceType, typename ATreeType, typename AVectorType>
 	struct IndexedTriangleSetDistancer {
@@ -665,6 +888,68 @@ inline bool intersect_ray_all_hits(
 	return ! hits.empty();
 }
 
+// Find the first intersections of a batch of rays with indexed triangle set.
+// The rays are traced through the AABB tree in packets of RayPacketSize rays, which pays off
+// for coherent rays, e.g. rays with close origins and similar directions.
+// Intersection tests are calculated in double precision, each ray gets the same hit
+// as intersect_ray_first_hit() returns for a ray in double precision. The only exception are rays parallel
+// to an axis grazing a bounding box, which may find another triangle at the same distance.
+// Hits of the rays missing the indexed triangle set have id == -1 and t == infinity.
+// Returns the number of rays hitting the indexed triangle set.
+template<typename VertexType, typename IndexedFaceType, typename TreeType, typename VectorType>
+inline size_t intersect_rays_first_hit(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices,
+	// Indexed triangle set - triangular faces, references to vertices.
+	const std::vector<IndexedFaceType> 	&faces,
+	// AABBTreeIndirect::Tree over vertices & faces, bounding boxes built with the accuracy of vertices.
+	const TreeType 						&tree,
+	// Origins of the rays.
+	const std::vector<VectorType>		&origins,
+	// Directions of the rays, one for each origin.
+	const std::vector<VectorType> 		&dirs,
+	// First intersection of each ray with the indexed triangle set.
+	std::vector<igl::Hit> 				&hits)
+{
+	assert(origins.size() == dirs.size());
+	using Packet = detail::RayPacketIntersector<VertexType, IndexedFaceType, TreeType, double>;
+	const auto infty = std::numeric_limits<float>::infinity();
+	hits.assign(origins.size(), igl::Hit { -1, -1, 0.f, 0.f, infty });
+	if (tree.empty())
+		return 0;
+
+	size_t num_hits = 0;
+	for (size_t first = 0; first < origins.size(); first += RayPacketSize) {
+		Packet packet { vertices, faces, tree };
+		packet.any_parallel = false;
+		for (int i = 0; i < RayPacketSize; ++ i) {
+			size_t ray = first + size_t(i);
+			bool   used = ray < origins.size();
+			Eigen::Vector3d origin = used ? Eigen::Vector3d(origins[ray].template cast<double>()) : Eigen::Vector3d::Zero();
+			Eigen::Vector3d dir    = used ? Eigen::Vector3d(dirs[ray].template cast<double>()) : Eigen::Vector3d::Ones();
+			for (int j = 0; j < 3; ++ j) {
+				packet.origin[j](i) = origin(j);
+				packet.dir[j](i)    = dir(j);
+				// The ray-box test handles the rays parallel to an axis separately, so that it does not produce NaNs.
+				double invdir = 1. / dir(j);
+				bool   parallel = ! std::isfinite(invdir);
+				packet.invdir[j](i)   = parallel ? 0. : invdir;
+				packet.parallel[j](i) = parallel ? std::numeric_limits<double>::max() : 0.;
+				packet.any_parallel  |= parallel;
+			}
+			packet.min_t(i) = used ? std::numeric_limits<double>::infinity() : - std::numeric_limits<double>::infinity();
+			packet.id[i]    = -1;
+		}
+		detail::intersect_ray_packet_first_hit(packet);
+		for (int i = 0; i < RayPacketSize; ++ i)
+			if (packet.id[i] >= 0) {
+				hits[first + size_t(i)] = igl::Hit { packet.id[i], -1, float(packet.u(i)), float(packet.v(i)), float(packet.min_t(i)) };
+				++ num_hits;
+			}
+	}
+	return num_hits;
+}
+
 // Finding a closest triangle, its closest point and squared distance to the closest point
 // on a 3D indexed triangle set using a pre-built AABBTreeIndirect::Tree.
 // Closest point to triangle test will be performed with the accuracy of VectorType::Scalar
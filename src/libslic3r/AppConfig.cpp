@@ -50,6 +50,9 @@ void AppConfig::set_defaults()
         // Disable background processing by default as it is not stable.
         if (get("background_processing").empty())
             set("background_processing", "0");
+        // The cache of the repaired meshes of the loaded STL / OBJ files is opt-in, as it grows in the data directory.
+        if (get("mesh_cache").empty())
+            set("mesh_cache", "0");
         // If set, the "Controller" tab for the control of the printer over serial line and the serial port settings are hidden.
         // By default, Prusa has the controller hidden.
         if (get("no_controller").empty())
@@ -10,9 +10,11 @@
 #include <libnest2d/utils/rotcalipers.hpp>
 
 #include <numeric>
+#include <unordered_map>
 #include <ClipperUtils.hpp>
 
 #include <boost/geometry/index/rtree.hpp>
+#include <boost/functional/hash.hpp>
 
 #if defined(_MSC_VER) && defined(__clang__)
 #define BOOST_NO_CXX17_HDR_STRING_VIEW
@@ -560,9 +562,43 @@ static CircleBed to_circle(const Point &center, const Points& points) {
     return ret;
 }
 
+// Assigns the same id to the identical silhouettes, e.g. of the instances of
+// an object. The placer reuses the no-fit polygons of these copies and packs
+// them in a lattice pattern.
+class ShapeIds {
+    std::vector<const Polygon *>         m_shapes;
+    std::unordered_multimap<size_t, int>      m_ids;
+
+    static size_t hash(const Polygon &p)
+    {
+        size_t seed = p.points.size();
+        for (const Point &pt : p.points) {
+            boost::hash_combine(seed, pt.x());
+            boost::hash_combine(seed, pt.y());
+        }
+        return seed;
+    }
+
+public:
+    int operator()(const Polygon &p)
+    {
+        size_t h     = hash(p);
+        auto   range = m_ids.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it)
+            if (m_shapes[it->second]->points == p.points) return it->second;
+
+        int id = int(m_shapes.size());
+        m_shapes.emplace_back(&p);
+        m_ids.emplace(h, id);
+
+        return id;
+    }
+};
+
 // Create Item from Arrangeable
 static void process_arrangeable(const ArrangePolygon &arrpoly,
-                                std::vector<Item> &   outp)
+                                std::vector<Item> &   outp,
+                                ShapeIds &            shape_ids)
 {
     Polygon        p        = arrpoly.poly.contour;
     const Vec2crd &offs     = arrpoly.translation;
@@ -585,6 +621,7 @@ static void process_arrangeable(const ArrangePolygon &arrpoly,
     outp.back().translation({offs.x(), offs.y()});
     outp.back().binId(arrpoly.bed_idx);
     outp.back().priority(arrpoly.priority);
+    outp.back().shapeId(shape_ids(arrpoly.poly.contour));
 }
 
 template<class Fn> auto call_with_bed(const Points &bed, Fn &&fn)
@@ -629,11 +666,12 @@ void arrange(ArrangePolygons &      arrangables,
     std::vector<Item> items, fixeditems;
     items.reserve(arrangables.size());
     
+    ShapeIds shape_ids;
     for (ArrangePolygon &arrangeable : arrangables)
-        process_arrangeable(arrangeable, items);
+        process_arrangeable(arrangeable, items, shape_ids);
     
     for (const ArrangePolygon &fixed: excludes)
-        process_arrangeable(fixed, fixeditems);
+        process_arrangeable(fixed, fixeditems, shape_ids);
     
     for (Item &itm : fixeditems) itm.inflate(scaled(-2. * EPSILON));
     
@@ -128,6 +128,7 @@ ExPolygons PolyTreeToExPolygons(ClipperLib::PolyTree& polytree)
 Slic3r::Polygon ClipperPath_to_Slic3rPolygon(const ClipperLib::Path &input)
 {
     Polygon retval;
+    retval.points.reserve(input.size());
     for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
         retval.points.emplace_back(pit->X, pit->Y);
     return retval;
@@ -136,6 +137,7 @@ Slic3r::Polygon ClipperPath_to_Slic3rPolygon(const ClipperLib::Path &input)
 Slic3r::Polyline ClipperPath_to_Slic3rPolyline(const ClipperLib::Path &input)
 {
     Polyline retval;
+    retval.points.reserve(input.size());
     for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
         retval.points.emplace_back(pit->X, pit->Y);
     return retval;
@@ -177,6 +179,7 @@ ExPolygons ClipperPaths_to_Slic3rExPolygons(const ClipperLib::Paths &input)
 ClipperLib::Path Slic3rMultiPoint_to_ClipperPath(const MultiPoint &input)
 {
     ClipperLib::Path retval;
+    retval.reserve(input.points.size());
     for (Points::const_iterator pit = input.points.begin(); pit != input.points.end(); ++pit)
         retval.emplace_back((*pit)(0), (*pit)(1));
     return retval;
@@ -191,35 +194,114 @@ ClipperLib::Path Slic3rMultiPoint_to_ClipperPath_reversed(const Slic3r::MultiPoi
     return output;
 }
 
+// Convert the points of a Slic3r path into an existing Clipper path, reusing its memory.
+static inline void multipoint_to_clipper_path(const MultiPoint &input, ClipperLib::Path &output)
+{
+    output.clear();
+    output.reserve(input.points.size());
+    for (const Point &pt : input.points)
+        output.emplace_back(pt.x(), pt.y());
+}
+
+template<typename TMultiPoints>
+static inline void multipoints_to_clipper_paths(const TMultiPoints &input, ClipperLib::Paths &output)
+{
+    output.resize(input.size());
+    for (size_t i = 0; i < input.size(); ++ i)
+        multipoint_to_clipper_path(input[i], output[i]);
+}
+
+void Slic3rMultiPoints_to_ClipperPaths(const Polygons &input, ClipperLib::Paths &output)
+{
+    multipoints_to_clipper_paths(input, output);
+}
+
+void Slic3rMultiPoints_to_ClipperPaths(const ExPolygons &input, ClipperLib::Paths &output)
+{
+    output.resize(number_polygons(input));
+    size_t idx = 0;
+    for (const ExPolygon &ep : input) {
+        multipoint_to_clipper_path(ep.contour, output[idx ++]);
+        for (const Polygon &h : ep.holes)
+            multipoint_to_clipper_path(h, output[idx ++]);
+    }
+}
+
+void Slic3rMultiPoints_to_ClipperPaths(const Polylines &input, ClipperLib::Paths &output)
+{
+    multipoints_to_clipper_paths(input, output);
+}
+
 ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polygons &input)
 {
     ClipperLib::Paths retval;
-    for (Polygons::const_iterator it = input.begin(); it != input.end(); ++it)
-        retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(*it));
+    Slic3rMultiPoints_to_ClipperPaths(input, retval);
     return retval;
 }
 
 ClipperLib::Paths  Slic3rMultiPoints_to_ClipperPaths(const ExPolygons &input)
 {
     ClipperLib::Paths retval;
-    for (auto &ep : input) {
-        retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(ep.contour));
-        
-        for (auto &h : ep.holes)
-            retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(h));
-    }
-        
+    Slic3rMultiPoints_to_ClipperPaths(input, retval);
     return retval;
 }
 
 ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polylines &input)
 {
     ClipperLib::Paths retval;
-    for (Polylines::const_iterator it = input.begin(); it != input.end(); ++it)
-        retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(*it));
+    Slic3rMultiPoints_to_ClipperPaths(input, retval);
     return retval;
 }
 
+// Buffers for the conversion of the inputs of the Clipper boolean operations. They are reused by the operations
+// running on the same thread to avoid allocating the paths on each call. The boolean operations do not nest,
+// thus a thread never uses the buffers for two operations at once.
+struct ClipperInputBuffers
+{
+    ClipperLib::Paths subject;
+    ClipperLib::Paths clip;
+
+    // Frees the buffers after an unusually large operation, so that a thread does not keep its peak memory
+    // until it exits. To be called once the input has been passed to Clipper.
+    void release_large()
+    {
+        release_large(subject);
+        release_large(clip);
+    }
+
+private:
+    // Number of points (and paths) a buffer keeps allocated between the operations, 4MB of points.
+    static constexpr size_t max_kept_points = 1 << 18;
+
+    static void release_large(ClipperLib::Paths &paths)
+    {
+        size_t num_points = paths.capacity();
+        for (const ClipperLib::Path &path : paths)
+            num_points += path.capacity();
+        if (num_points > max_kept_points)
+            ClipperLib::Paths().swap(paths);
+    }
+};
+
+static ClipperInputBuffers& clipper_input_buffers()
+{
+    static thread_local ClipperInputBuffers buffers;
+    return buffers;
+}
+
+// Input of a Clipper operation: Slic3r paths are converted into the buffer, Clipper paths are used as they are.
+template<typename TMultiPoints>
+static inline ClipperLib::Paths& clipper_input(const TMultiPoints &input, ClipperLib::Paths &buffer)
+{
+    Slic3rMultiPoints_to_ClipperPaths(input, buffer);
+    return buffer;
+}
+
+static inline ClipperLib::Paths& clipper_input(ClipperLib::Paths &&input, ClipperLib::Paths & /* buffer */)
+{
+    return input;
+}
+
 ClipperLib::Paths _offset(ClipperLib::Paths &&input, ClipperLib::EndType endType, const double delta, ClipperLib::JoinType joinType, double miterLimit)
 {
     // scale input
@@ -477,17 +559,14 @@ offset2_ex(const Polygons &polygons, const double delta1, const double delta2,
     return ClipperPaths_to_Slic3rExPolygons(output);
 }
 
-//FIXME Vojtech: This functon may likely be optimized to avoid some of the Slic3r to Clipper 
-// conversions and unnecessary Clipper calls.
+// The second offsets stay in Clipper space until the final union.
 ExPolygons offset2_ex(const ExPolygons &expolygons, const double delta1,
     const double delta2, ClipperLib::JoinType joinType, double miterLimit)
 {
-    Polygons polys;
+    ClipperLib::Paths paths;
     for (const ExPolygon &expoly : expolygons)
-        append(polys, 
-               offset(offset_ex(expoly, delta1, joinType, miterLimit), 
-                      delta2, joinType, miterLimit));
-    return union_ex(polys);
+        append(paths, _offset(offset_ex(expoly, delta1, joinType, miterLimit), delta2, joinType, miterLimit));
+    return _clipper_ex(ClipperLib::ctUnion, std::move(paths), Polygons());
 }
 
 template<class T, class TSubj, class TClip>
@@ -498,8 +577,9 @@ T _clipper_do(const ClipperLib::ClipType     clipType,
               const bool                     safety_offset_)
 {
     // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(std::forward<TSubj>(subject));
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(std::forward<TClip>(clip));
+    ClipperInputBuffers &buffers       = clipper_input_buffers();
+    ClipperLib::Paths   &input_subject = clipper_input(std::forward<TSubj>(subject), buffers.subject);
+    ClipperLib::Paths   &input_clip    = clipper_input(std::forward<TClip>(clip), buffers.clip);
     
     // perform safety offset
     if (safety_offset_) {
@@ -517,6 +597,7 @@ T _clipper_do(const ClipperLib::ClipType     clipType,
     // add polygons
     clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
     clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
+    buffers.release_large();
     
     // perform operation
     T retval;
@@ -547,12 +628,14 @@ bool test_path(const ClipperLib::Path &path) {
 // This function implmenets a following workaround:
 // 1) Peform the Clipper operation with the output to Paths. This method handles overlaps in a reasonable time.
 // 2) Run Clipper Union once again to extract the PolyTree from the result of 1).
-inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, const Polygons &subject, 
-    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+template<class TSubj, class TClip>
+inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, TSubj &&subject, 
+    TClip &&clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
 {
     // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
+    ClipperInputBuffers &buffers       = clipper_input_buffers();
+    ClipperLib::Paths   &input_subject = clipper_input(std::forward<TSubj>(subject), buffers.subject);
+    ClipperLib::Paths   &input_clip    = clipper_input(std::forward<TClip>(clip), buffers.clip);
     
     // perform safety offset
     if (safety_offset_)
@@ -561,13 +644,14 @@ inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType cli
     ClipperLib::Clipper clipper;
     clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
     clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
-    // Perform the operation with the output to input_subject.
+    buffers.release_large();
     // This pass does not generate a PolyTree, which is a very expensive operation with the current Clipper library
     // if there are overapping edges.
-    clipper.Execute(clipType, input_subject, fillType, fillType);
+    ClipperLib::Paths output;
+    clipper.Execute(clipType, output, fillType, fillType);
     // Perform an additional Union operation to generate the PolyTree ordering.
     clipper.Clear();
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
+    clipper.AddPaths(output, ClipperLib::ptSubject, true);
     ClipperLib::PolyTree retval;
     clipper.Execute(ClipperLib::ctUnion, retval, fillType, fillType);
 
@@ -596,8 +680,9 @@ ClipperLib::PolyTree _clipper_do_pl(const ClipperLib::ClipType clipType, const P
     const bool safety_offset_)
 {
     // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
+    ClipperInputBuffers &buffers       = clipper_input_buffers();
+    ClipperLib::Paths   &input_subject = clipper_input(subject, buffers.subject);
+    ClipperLib::Paths   &input_clip    = clipper_input(clip, buffers.clip);
     //scale to have some more precision to do some Y-bugfix
     scaleClipperPolygons(input_subject);
     scaleClipperPolygons(input_clip);
@@ -625,6 +710,7 @@ ClipperLib::PolyTree _clipper_do_pl(const ClipperLib::ClipType clipType, const P
     // add polygons
     clipper.AddPaths(input_subject, ClipperLib::ptSubject, false);
     clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
+    buffers.release_large();
     
     // perform operation
     ClipperLib::PolyTree retval;
@@ -672,6 +758,22 @@ ExPolygons _clipper_ex(ClipperLib::ClipType clipType, const Polygons &subject, c
     return PolyTreeToExPolygons(polytree);
 }
 
+ClipperLib::Paths _clipper_paths(ClipperLib::ClipType clipType, ClipperLib::Paths &&subject, const Polygons &clip, bool safety_offset_)
+{
+    return _clipper_do<ClipperLib::Paths>(clipType, std::move(subject), clip, ClipperLib::pftNonZero, safety_offset_);
+}
+
+ClipperLib::Paths _clipper_paths(ClipperLib::ClipType clipType, ClipperLib::Paths &&subject, ClipperLib::Paths &&clip, bool safety_offset_)
+{
+    return _clipper_do<ClipperLib::Paths>(clipType, std::move(subject), std::move(clip), ClipperLib::pftNonZero, safety_offset_);
+}
+
+ExPolygons _clipper_ex(ClipperLib::ClipType clipType, ClipperLib::Paths &&subject, const Polygons &clip, bool safety_offset_)
+{
+    ClipperLib::PolyTree polytree = _clipper_do_polytree2(clipType, std::move(subject), clip, ClipperLib::pftNonZero, safety_offset_);
+    return PolyTreeToExPolygons(polytree);
+}
+
 Polylines _clipper_pl(ClipperLib::ClipType clipType, const Polylines &subject, const Polygons &clip, bool safety_offset_)
 {
     ClipperLib::Paths output;
@@ -36,6 +36,10 @@ ClipperLib::Path   Slic3rMultiPoint_to_ClipperPath(const Slic3r::MultiPoint &inp
 ClipperLib::Paths  Slic3rMultiPoints_to_ClipperPaths(const Polygons &input);
 ClipperLib::Paths  Slic3rMultiPoints_to_ClipperPaths(const ExPolygons &input);
 ClipperLib::Paths  Slic3rMultiPoints_to_ClipperPaths(const Polylines &input);
+// Conversions into existing paths, reusing the memory of the paths already allocated.
+void               Slic3rMultiPoints_to_ClipperPaths(const Polygons &input, ClipperLib::Paths &output);
+void               Slic3rMultiPoints_to_ClipperPaths(const ExPolygons &input, ClipperLib::Paths &output);
+void               Slic3rMultiPoints_to_ClipperPaths(const Polylines &input, ClipperLib::Paths &output);
 Slic3r::Polygon    ClipperPath_to_Slic3rPolygon(const ClipperLib::Path &input);
 Slic3r::Polyline   ClipperPath_to_Slic3rPolyline(const ClipperLib::Path &input);
 Slic3r::Polygons   ClipperPaths_to_Slic3rPolygons(const ClipperLib::Paths &input);
@@ -96,6 +100,17 @@ Slic3r::Polylines _clipper_pl(ClipperLib::ClipType clipType,
 Slic3r::Lines _clipper_ln(ClipperLib::ClipType clipType,
     const Slic3r::Lines &subject, const Slic3r::Polygons &clip, bool safety_offset_ = false);
 
+// Boolean operations over paths already in Clipper space, for example the result of _offset() or of another _clipper_paths().
+// A chain of offsets and boolean operations is converted back to Slic3r polygons only once, at its end:
+//     ClipperPaths_to_Slic3rPolygons(_clipper_paths(ClipperLib::ctDifference,
+//         _offset(Slic3rMultiPoints_to_ClipperPaths(polygons), ClipperLib::etClosedPolygon, delta, jtMiter, 3.), clip));
+ClipperLib::Paths _clipper_paths(ClipperLib::ClipType clipType,
+    ClipperLib::Paths &&subject, const Slic3r::Polygons &clip, bool safety_offset_ = false);
+ClipperLib::Paths _clipper_paths(ClipperLib::ClipType clipType,
+    ClipperLib::Paths &&subject, ClipperLib::Paths &&clip, bool safety_offset_ = false);
+Slic3r::ExPolygons _clipper_ex(ClipperLib::ClipType clipType,
+    ClipperLib::Paths &&subject, const Slic3r::Polygons &clip, bool safety_offset_ = false);
+
 // diff
 inline Slic3r::Polygons
 diff(const Slic3r::Polygons &subject, const Slic3r::Polygons &clip, bool safety_offset_ = false)
@@ -2,6 +2,7 @@
 #define slic3r_ExtrusionEntity_hpp_
 
 #include "libslic3r.h"
+#include "ExtrusionEntityArena.hpp"
 #include "Polygon.hpp"
 #include "Polyline.hpp"
 
@@ -179,6 +180,10 @@ public:
 class ExtrusionEntity
 {
 public:
+    // Extrusion entities are allocated from the arena of the layer being processed, if any.
+    static void* operator new(size_t size) { return ExtrusionEntityArena::allocate(size); }
+    static void  operator delete(void *ptr) { ExtrusionEntityArena::deallocate(ptr); }
+
     virtual ExtrusionRole role() const = 0;
     virtual bool is_collection() const { return false; }
     virtual bool is_loop() const { return false; }
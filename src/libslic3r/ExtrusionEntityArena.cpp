@@ -0,0 +1,138 @@
+#include "ExtrusionEntityArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <new>
+
+namespace Slic3r {
+
+thread_local ExtrusionEntityArena::ThreadHeap *ExtrusionEntityArena::s_current    = nullptr;
+thread_local ExtrusionEntityArena             *ExtrusionEntityArena::s_bulk_free  = nullptr;
+thread_local size_t                            ExtrusionEntityArena::s_bulk_freed = 0;
+
+void* ExtrusionEntityArena::allocate(size_t size)
+{
+    size_t      slot_size = (size + sizeof(Header) + alignment - 1) & ~(alignment - 1);
+    ThreadHeap *heap      = s_current;
+    Header     *header;
+    if (heap == nullptr || slot_size > max_slot_size) {
+        header = static_cast<Header*>(::operator new(slot_size));
+        header->heap = nullptr;
+    } else {
+        header = heap->allocate_slot(slot_size);
+        header->heap = heap;
+        heap->arena->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    header->slot_size = slot_size;
+    return header + 1;
+}
+
+void ExtrusionEntityArena::deallocate(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    Header *header = static_cast<Header*>(ptr) - 1;
+    if (ThreadHeap *heap = header->heap) {
+        if (heap->arena == s_bulk_free)
+            // The slot is released together with the whole arena.
+            ++ s_bulk_freed;
+        else {
+            heap->free_slot(header);
+            heap->arena->release();
+        }
+    } else
+        ::operator delete(header);
+}
+
+ExtrusionEntityArena::BulkFree::BulkFree(ExtrusionEntityArena *arena)
+{
+    assert(s_bulk_free == nullptr);
+    s_bulk_free  = arena;
+    s_bulk_freed = 0;
+}
+
+ExtrusionEntityArena::BulkFree::~BulkFree()
+{
+    ExtrusionEntityArena *arena = s_bulk_free;
+    size_t                freed = s_bulk_freed;
+    s_bulk_free  = nullptr;
+    s_bulk_freed = 0;
+    if (freed > 0 && arena->m_refs.fetch_sub(freed, std::memory_order_acq_rel) == freed)
+        delete arena;
+}
+
+ExtrusionEntityArena::ThreadHeap* ExtrusionEntityArena::thread_heap()
+{
+    std::thread::id                  id = std::this_thread::get_id();
+    std::lock_guard<tbb::spin_mutex> lock(m_mutex);
+    for (std::unique_ptr<ThreadHeap> &heap : m_heaps)
+        if (heap->owner == id)
+            return heap.get();
+    m_heaps.emplace_back(new ThreadHeap(this));
+    return m_heaps.back().get();
+}
+
+ExtrusionEntityArena::Header* ExtrusionEntityArena::ThreadHeap::allocate_slot(size_t slot_size)
+{
+    assert(slot_size % alignment == 0 && slot_size <= max_slot_size);
+    assert(owner == std::this_thread::get_id());
+    if (remote_free.load(std::memory_order_relaxed) != nullptr) {
+        // Take over the slots freed by the other threads.
+        for (Header *header = remote_free.exchange(nullptr, std::memory_order_acquire); header != nullptr;) {
+            Header *next = next_free(header);
+            Header *&list = this->free[header->slot_size / alignment];
+            next_free(header) = list;
+            list = header;
+            -- live;
+            header = next;
+        }
+    }
+    if (live == 0 && ! blocks.empty()) {
+        // All the slots are free, start again from the first block to lay out the new entities in the order of their creation.
+        this->free.fill(nullptr);
+        current = 0;
+        top     = blocks.front().data.get();
+        end     = top + blocks.front().size;
+    }
+    ++ live;
+    Header *&free_list = this->free[slot_size / alignment];
+    if (free_list != nullptr) {
+        Header *header = free_list;
+        free_list = next_free(header);
+        return header;
+    }
+    if (size_t(end - top) < slot_size) {
+        // The rest of the current block is left unused.
+        if (current + 1 < blocks.size())
+            // Reuse the next block after a restart.
+            ++ current;
+        else {
+            blocks.push_back({ nullptr, blocks.empty() ? min_block_size : std::min(2 * blocks.back().size, max_block_size) });
+            blocks.back().data.reset(new char[blocks.back().size]);
+            current = blocks.size() - 1;
+        }
+        top = blocks[current].data.get();
+        end = top + blocks[current].size;
+    }
+    Header *header = reinterpret_cast<Header*>(top);
+    top += slot_size;
+    return header;
+}
+
+void ExtrusionEntityArena::ThreadHeap::free_slot(Header *header)
+{
+    if (owner == std::this_thread::get_id()) {
+        Header *&free_list = this->free[header->slot_size / alignment];
+        next_free(header) = free_list;
+        free_list = header;
+        -- live;
+    } else {
+        Header *head = remote_free.load(std::memory_order_relaxed);
+        do {
+            next_free(header) = head;
+        } while (! remote_free.compare_exchange_weak(head, header, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+
+} // namespace Slic3r
@@ -0,0 +1,133 @@
+#ifndef slic3r_ExtrusionEntityArena_hpp_
+#define slic3r_ExtrusionEntityArena_hpp_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <tbb/spin_mutex.h>
+
+namespace Slic3r {
+
+// Storage of the extrusion entities of a layer.
+// While an arena is current on a thread (see ExtrusionEntityArena::Scope), the extrusion entities created by that thread
+// are carved from the blocks of the arena, so the entities of a layer are stored next to each other in the order
+// they were created, which is the order the G-code generator reads them in. The slots of deleted entities are reused
+// by the entities created later. Once all the entities of a heap were deleted, for example when a step of the layer
+// is processed again, the heap starts again from its first block to keep the entities in the order of their creation.
+// Each thread allocates from its own heap of the arena, so allocating and freeing does not lock. An entity freed by another
+// thread is handed back to its heap through a lock-free list, which the owning thread drains when it allocates.
+// The blocks of a heap start small and grow geometrically, so that a layer touched by many threads stays small.
+// The arena is reference counted by its owner and by each entity allocated from it. The blocks are released at once
+// when both the owner and the last entity are gone, thus an entity may outlive the layer it was created for.
+// The owner destroying all its entities at once (see ExtrusionEntityArena::BulkFree) skips the per entity bookkeeping.
+class ExtrusionEntityArena
+{
+    struct ThreadHeap;
+
+public:
+    // Create an arena referenced by the caller, who shall release it with release().
+    static ExtrusionEntityArena* create() { return new ExtrusionEntityArena(); }
+    void                         release() { if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
+
+    // Allocate from the arena current for this thread, or from the heap if there is none.
+    static void*                 allocate(size_t size);
+    // Free memory allocated by allocate(), from any thread.
+    static void                  deallocate(void *ptr);
+
+    // Makes an arena current for this thread for the lifetime of the scope. Passing nullptr allocates from the heap.
+    class Scope
+    {
+    public:
+        explicit Scope(ExtrusionEntityArena *arena) : m_previous(s_current) { s_current = arena ? arena->thread_heap() : nullptr; }
+        ~Scope() { s_current = m_previous; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        ThreadHeap *m_previous;
+    };
+
+    // The slots of the arena freed by this thread for the lifetime of the scope are not returned to their heaps
+    // and the arena is released once for all of them at the end of the scope.
+    // To be used by the owner of the arena deleting its entities for good, for example by the destructor of a layer.
+    class BulkFree
+    {
+    public:
+        explicit BulkFree(ExtrusionEntityArena *arena);
+        ~BulkFree();
+        BulkFree(const BulkFree&) = delete;
+        BulkFree& operator=(const BulkFree&) = delete;
+    };
+
+private:
+    ExtrusionEntityArena() = default;
+    ~ExtrusionEntityArena() = default;
+
+    struct alignas(16) Header {
+        // Thread heap the slot was allocated from, nullptr for the heap.
+        ThreadHeap           *heap;
+        size_t                slot_size;
+    };
+    static constexpr size_t alignment      = alignof(Header);
+    // Size of the first block of a heap, each next block is twice as large up to max_block_size.
+    static constexpr size_t min_block_size = 1024;
+    static constexpr size_t max_block_size = 64 * 1024;
+    // Larger entities are allocated from the heap.
+    static constexpr size_t max_slot_size  = 512;
+    static_assert(max_slot_size <= min_block_size, "A slot has to fit into the first block");
+
+    // Blocks and free slots of the arena used by a single thread.
+    struct ThreadHeap
+    {
+        ThreadHeap(ExtrusionEntityArena *arena) : arena(arena), owner(std::this_thread::get_id()) {}
+
+        // Only called by the owner thread.
+        Header*                 allocate_slot(size_t slot_size);
+        // Called by any thread.
+        void                    free_slot(Header *header);
+
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t                  size;
+        };
+
+        ExtrusionEntityArena                   *arena;
+        std::thread::id                         owner;
+        std::vector<Block>                      blocks;
+        // Index of the block being carved, the blocks after it are unused.
+        size_t                                  current { 0 };
+        // Unused space at the end of the current block.
+        char                                   *top { nullptr };
+        char                                   *end { nullptr };
+        // Number of the slots allocated and not freed yet, accessed by the owner thread only.
+        // The slots freed by the other threads are subtracted once the owner takes them over.
+        size_t                                  live { 0 };
+        // Singly linked lists of the freed slots indexed by slot_size / alignment, linked through the slot payload.
+        // Accessed by the owner thread only.
+        std::array<Header*, max_slot_size / alignment + 1> free {};
+        // Slots freed by the other threads, linked through the slot payload.
+        std::atomic<Header*>                    remote_free { nullptr };
+    };
+
+    // Heap of the calling thread, created on the first call from the thread.
+    ThreadHeap*             thread_heap();
+    // Link of a free slot to the next free slot, stored in the slot payload.
+    static Header*&         next_free(Header *header) { return *reinterpret_cast<Header**>(header + 1); }
+
+    std::atomic<size_t>                     m_refs { 1 };
+    // Only guards m_heaps, which is accessed once per Scope.
+    tbb::spin_mutex                         m_mutex;
+    std::vector<std::unique_ptr<ThreadHeap>> m_heaps;
+
+    static thread_local ThreadHeap *s_current;
+    // Arena of the active BulkFree scope of this thread and the number of its slots freed inside the scope.
+    static thread_local ExtrusionEntityArena *s_bulk_free;
+    static thread_local size_t                s_bulk_freed;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ExtrusionEntityArena_hpp_
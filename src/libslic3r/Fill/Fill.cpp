@@ -381,8 +381,9 @@ void export_group_fills_to_svg(const char *path, const std::vector<SurfaceFill>
 #endif
 
 // friend to Layer
-void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree)
+void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree, PlanePathCurveCache* plane_path_curves)
 {
+    ExtrusionEntityArena::Scope arena_scope(m_extrusion_arena);
     for (LayerRegion* layerm : m_regions) {
         layerm->fills.clear();
         layerm->ironings.clear();
@@ -443,6 +444,7 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
         f->z        = this->print_z;
         f->angle    = surface_fill.params.angle;
         f->adapt_fill_octree = (surface_fill.params.pattern == ipSupportCubic) ? support_fill_octree : adaptive_fill_octree;
+        f->plane_path_curves = plane_path_curves;
 
         // calculate flow spacing for infill pattern generation
         bool using_internal_flow = ! surface_fill.surface.has_fill_solid() && ! surface_fill.params.flow.bridge;
@@ -560,6 +562,7 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
 // Create ironing extrusions over top surfaces.
 void Layer::make_ironing()
 {
+    ExtrusionEntityArena::Scope arena_scope(m_extrusion_arena);
     // LayerRegion::slices contains surfaces marked with SurfaceType.
     // Here we want to collect top surfaces extruded with the same extruder.
     // A surface will be ironed with the same extruder to not contaminate the print with another material leaking from the nozzle.
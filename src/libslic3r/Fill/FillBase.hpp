@@ -24,6 +24,8 @@ namespace Slic3r {
 class ExPolygon;
 class Surface;
 
+class PlanePathCurveCache;
+
 namespace FillAdaptive {
     struct Octree;
 };
@@ -106,6 +108,8 @@ public:
 
     // Octree builds on mesh for usage in the adaptive cubic infill
     FillAdaptive::Octree* adapt_fill_octree = nullptr;
+    // Curves of the plane path patterns shared by the layers of the object, generated for each surface if not set.
+    PlanePathCurveCache*  plane_path_curves = nullptr;
 protected:
     // in unscaled coordinates, please use init (after settings all others settings) as some algos want to modify the value
     coordf_t    spacing_priv;
@@ -28,24 +28,36 @@ static inline double f(double x, double z_sin, double z_cos, bool vertical, bool
     }
 }
 
+// Make a wave from the periods <period_begin, period_end) of the infinite wave, or up to the end of the wave
+// if period_end is size_t(-1). The periods of a partial wave are the same as the periods of the full wave.
 static inline Polyline make_wave(
     const std::vector<Vec2d>& one_period, double width, double height, double offset, double scaleFactor,
-    double z_cos, double z_sin, bool vertical, bool flip)
+    double z_cos, double z_sin, bool vertical, bool flip, size_t period_begin = 0, size_t period_end = size_t(-1))
 {
-    std::vector<Vec2d> points = one_period;
-    double period = points.back()(0);
+    std::vector<Vec2d> points;
+    double period = one_period.back()(0);
     if (width != period) // do not extend if already truncated
     {
-        points.reserve(one_period.size() * size_t(floor(width / period)));
-        points.pop_back();
+        // The last point of a period is the first point of the next one.
+        size_t n = one_period.size() - 1;
+        points.reserve(one_period.size() * (std::min(size_t(ceil(width / period)), period_end) - period_begin + 1));
 
-        size_t n = points.size();
-        do {
-            points.emplace_back(points[points.size()-n].x() + period, points[points.size()-n].y());
-        } while (points.back()(0) < width - EPSILON);
+        bool to_width = true;
+        for (size_t i = period_begin * n;; ++ i) {
+            size_t idx_period = i / n;
+            points.emplace_back(one_period[i % n].x() + double(idx_period) * period, one_period[i % n].y());
+            if (i >= n && points.back()(0) >= width - EPSILON)
+                break;
+            if (idx_period == period_end) {
+                to_width = false;
+                break;
+            }
+        }
 
-        points.emplace_back(Vec2d(width, f(width, z_sin, z_cos, vertical, flip)));
-    }
+        if (to_width)
+            points.emplace_back(Vec2d(width, f(width, z_sin, z_cos, vertical, flip)));
+    } else
+        points = one_period;
 
     // and construct the final polyline to return:
     Polyline polyline;
@@ -101,7 +113,86 @@ static std::vector<Vec2d> make_one_period(double width, double scaleFactor, doub
     return points;
 }
 
-static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double line_spacing, double width, double height)
+// One period of the odd and even waves. It only depends on the z phase, on the tolerance and on the truncation of the waves,
+// thus all the islands of a layer filled with the same line spacing share it. The last periods are kept per thread.
+struct GyroidPeriods
+{
+    double             z_sin;
+    double             z_cos;
+    double             tolerance;
+    double             limit;
+    std::vector<Vec2d> odd;
+    std::vector<Vec2d> even;
+};
+
+static const GyroidPeriods& gyroid_periods(double width, double scaleFactor, double z_cos, double z_sin, bool vertical, double tolerance)
+{
+    static constexpr size_t max_cached = 8;
+    static thread_local std::vector<GyroidPeriods> cache;
+    static thread_local size_t                     next_to_replace = 0;
+
+    double limit = std::min(2*M_PI, width);
+    for (const GyroidPeriods &periods : cache)
+        if (periods.z_sin == z_sin && periods.z_cos == z_cos && periods.tolerance == tolerance && periods.limit == limit)
+            return periods;
+
+    // even polylines are a bit shifted
+    bool flip = ! vertical;
+    GyroidPeriods periods { z_sin, z_cos, tolerance, limit,
+        make_one_period(width, scaleFactor, z_cos, z_sin, vertical, flip, tolerance),
+        make_one_period(width, scaleFactor, z_cos, z_sin, vertical, ! flip, tolerance) };
+    if (cache.size() < max_cached) {
+        cache.emplace_back(std::move(periods));
+        return cache.back();
+    }
+    GyroidPeriods &replaced = cache[next_to_replace];
+    next_to_replace = (next_to_replace + 1) % max_cached;
+    replaced = std::move(periods);
+    return replaced;
+}
+
+// Ranges of periods <begin, end) of the waves crossing the area inside the band <v_min, v_max> of wave offsets.
+// Only these periods have to be generated, the other ones would be clipped away. The area is in the coordinates of the waves.
+static std::vector<std::pair<size_t, size_t>> wave_period_ranges(const Polygons &area, double v_min, double v_max, double width, double period, double scaleFactor, bool vertical)
+{
+    const coord_t u_min = - coord_t(scaleFactor);
+    const coord_t u_max = coord_t((width + 1.) * scaleFactor);
+    const coord_t v0    = coord_t(floor(v_min * scaleFactor));
+    const coord_t v1    = coord_t(ceil(v_max * scaleFactor));
+    Polygon band = vertical ?
+        Polygon({ { v0, u_min }, { v1, u_min }, { v1, u_max }, { v0, u_max } }) :
+        Polygon({ { u_min, v0 }, { u_max, v0 }, { u_max, v1 }, { u_min, v1 } });
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (const ExPolygon &expoly : intersection_ex(area, { band })) {
+        BoundingBox bbox = get_extents(expoly.contour);
+        double u0 = double(vertical ? bbox.min.y() : bbox.min.x()) / scaleFactor;
+        double u1 = double(vertical ? bbox.max.y() : bbox.max.x()) / scaleFactor;
+        // Cut the waves strictly outside of the area.
+        size_t begin = size_t(std::max(0., ceil(u0 / period) - 1.));
+        if (double(begin) * period < width - EPSILON)
+            ranges.emplace_back(begin, size_t(std::max(0., floor(u1 / period) + 1.)));
+    }
+    std::sort(ranges.begin(), ranges.end());
+    // Merge the overlapping and touching ranges.
+    size_t j = 0;
+    for (size_t i = 1; i < ranges.size(); ++ i) {
+        if (ranges[i].first <= ranges[j].second)
+            ranges[j].second = std::max(ranges[j].second, ranges[i].second);
+        else
+            ranges[++ j] = ranges[i];
+    }
+    if (! ranges.empty())
+        ranges.erase(ranges.begin() + j + 1, ranges.end());
+    // The last range ends with the wave.
+    for (std::pair<size_t, size_t> &range : ranges)
+        if (double(range.second) * period >= width - EPSILON)
+            range.second = size_t(-1);
+    return ranges;
+}
+
+// If area is not null, only the periods of the waves crossing the area are generated.
+static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double line_spacing, double width, double height, const Polygons *area = nullptr)
 {
     const double scaleFactor = scale_(line_spacing) / density_adjusted;
 
@@ -126,19 +217,27 @@ static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double
         std::swap(width,height);
     }
 
-    std::vector<Vec2d> one_period_odd = make_one_period(width, scaleFactor, z_cos, z_sin, vertical, flip, tolerance); // creates one period of the waves, so it doesn't have to be recalculated all the time
+    // creates one period of the waves, so it doesn't have to be recalculated all the time
+    const GyroidPeriods &periods = gyroid_periods(width, scaleFactor, z_cos, z_sin, vertical, tolerance);
+    const std::vector<Vec2d> &one_period_odd  = periods.odd;
+    const std::vector<Vec2d> &one_period_even = periods.even;
+    const double              period          = one_period_odd.back()(0);
     flip = !flip;                                                                   // even polylines are a bit shifted
-    std::vector<Vec2d> one_period_even = make_one_period(width, scaleFactor, z_cos, z_sin, vertical, flip, tolerance);
     Polylines result;
 
     for (double y0 = lower_bound; y0 < upper_bound + EPSILON; y0 += M_PI) {
-        // creates odd polylines
-        result.emplace_back(make_wave(one_period_odd, width, height, y0, scaleFactor, z_cos, z_sin, vertical, flip));
-        // creates even polylines
-        y0 += M_PI;
-        if (y0 < upper_bound + EPSILON) {
-            result.emplace_back(make_wave(one_period_even, width, height, y0, scaleFactor, z_cos, z_sin, vertical, flip));
+        std::vector<std::pair<size_t, size_t>> ranges { { 0, size_t(-1) } };
+        if (area != nullptr && width != period)
+            // The odd and the even waves of this row stay within <y0 - PI, y0 + 3 PI>.
+            ranges = wave_period_ranges(*area, y0 - M_PI, y0 + 3. * M_PI, width, period, scaleFactor, vertical);
+        for (const std::pair<size_t, size_t> &range : ranges) {
+            // creates odd polylines
+            result.emplace_back(make_wave(one_period_odd, width, height, y0, scaleFactor, z_cos, z_sin, vertical, flip, range.first, range.second));
+            // creates even polylines
+            if (y0 + M_PI < upper_bound + EPSILON)
+                result.emplace_back(make_wave(one_period_even, width, height, y0 + M_PI, scaleFactor, z_cos, z_sin, vertical, flip, range.first, range.second));
         }
+        y0 += M_PI;
     }
 
     return result;
@@ -167,19 +266,30 @@ void FillGyroid::_fill_surface_single(
     // align bounding box to a multiple of our grid module
     bb.merge(_align_to_grid(bb.min, Point(2*M_PI*distance, 2*M_PI*distance)));
 
+    Polygons area = to_polygons(expolygon);
+    // Only generate the waves over the tiles crossing the island if a large part of its bounding box is empty.
+    bool     sparse_area = ! expolygon.holes.empty() || expolygon.area() < 0.5 * double(bb.size()(0)) * double(bb.size()(1));
+    Polygons area_local;
+    if (sparse_area) {
+        area_local = area;
+        for (Polygon &polygon : area_local)
+            polygon.translate(- bb.min);
+    }
+
     // generate pattern
     Polylines polylines = make_gyroid_waves(
         (double)scale_(this->z),
         density_adjusted,
         this->get_spacing(),
         ceil(bb.size()(0) / distance) + 1.,
-        ceil(bb.size()(1) / distance) + 1.);
+        ceil(bb.size()(1) / distance) + 1.,
+        sparse_area ? &area_local : nullptr);
 
     // shift the polyline to the grid origin
     for (Polyline &pl : polylines)
         pl.translate(bb.min);
 
-    polylines = intersection_pl(polylines, to_polygons(expolygon));
+    polylines = intersection_pl(polylines, area);
 
     if (! polylines.empty()) {
         // Remove very small bits, but be careful to not remove infill lines connecting thin walls!
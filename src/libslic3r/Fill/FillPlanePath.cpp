@@ -6,6 +6,52 @@
 
 namespace Slic3r {
 
+// Curve of a plane path pattern in scaled coordinates, cut into chunks of consecutive points sharing their end points.
+// The curve only depends on the pattern, on the line spacing and on the bounding box of the object in the grid coordinates,
+// thus it is shared by all the layers and regions of an object. Only the chunks overlapping an island are clipped.
+struct PlanePathCurve
+{
+    Polylines                chunks;
+    std::vector<BoundingBox> bboxes;
+};
+
+std::shared_ptr<const PlanePathCurve> FillPlanePath::_curve(coord_t distance_between_lines, coord_t min_x, coord_t min_y, coord_t max_x, coord_t max_y) const
+{
+    if (this->plane_path_curves == nullptr)
+        return this->_make_curve(distance_between_lines, min_x, min_y, max_x, max_y);
+    return this->plane_path_curves->curve(
+        PlanePathCurveKey { std::type_index(typeid(*this)), distance_between_lines, min_x, min_y, max_x, max_y },
+        [this, distance_between_lines, min_x, min_y, max_x, max_y]() { return this->_make_curve(distance_between_lines, min_x, min_y, max_x, max_y); });
+}
+
+std::shared_ptr<const PlanePathCurve> FillPlanePath::_make_curve(coord_t distance_between_lines, coord_t min_x, coord_t min_y, coord_t max_x, coord_t max_y) const
+{
+    // Number of points of a chunk of the curve.
+    static constexpr size_t chunk_size = 128;
+
+    Pointfs pts = _generate(min_x, min_y, max_x, max_y);
+    auto curve = std::make_shared<PlanePathCurve>();
+    if (pts.size() >= 2) {
+        size_t num_chunks = (pts.size() - 1 + chunk_size - 1) / chunk_size;
+        curve->chunks.reserve(num_chunks);
+        curve->bboxes.reserve(num_chunks);
+        for (size_t begin = 0; begin + 1 < pts.size(); begin += chunk_size) {
+            // Convert points to a polyline, upscale.
+            size_t end = std::min(begin + chunk_size + 1, pts.size());
+            curve->chunks.emplace_back();
+            Polyline &polyline = curve->chunks.back();
+            polyline.points.reserve(end - begin);
+            for (size_t i = begin; i < end; ++ i)
+                polyline.points.push_back(Point(
+                    coord_t(floor(pts[i].x() * distance_between_lines + 0.5)), 
+                    coord_t(floor(pts[i].y() * distance_between_lines + 0.5))));
+            curve->bboxes.emplace_back(polyline.points);
+        }
+    }
+
+    return curve;
+}
+
 void FillPlanePath::_fill_surface_single(
     const FillParams                &params, 
     unsigned int                     thickness_layers,
@@ -27,22 +73,29 @@ void FillPlanePath::_fill_surface_single(
     expolygon.translate(-double(shift.x()), -double(shift.y()));
     bounding_box.translate(-double(shift.x()), -double(shift.y()));
 
-    Pointfs pts = _generate(
+    std::shared_ptr<const PlanePathCurve> curve = this->_curve(
+        distance_between_lines,
         coord_t(ceil(coordf_t(bounding_box.min.x()) / distance_between_lines)),
         coord_t(ceil(coordf_t(bounding_box.min.y()) / distance_between_lines)),
         coord_t(ceil(coordf_t(bounding_box.max.x()) / distance_between_lines)),
         coord_t(ceil(coordf_t(bounding_box.max.y()) / distance_between_lines)));
 
-    Polylines polylines;
-    if (pts.size() >= 2) {
-        // Convert points to a polyline, upscale.
-        polylines.push_back(Polyline());
-        Polyline &polyline = polylines.back();
-        polyline.points.reserve(pts.size());
-        for (const Vec2d &pt : pts)
-            polyline.points.push_back(Point(
-                coord_t(floor(pt.x() * distance_between_lines + 0.5)), 
-                coord_t(floor(pt.y() * distance_between_lines + 0.5))));
+    if (! curve->chunks.empty()) {
+        // Only clip the runs of chunks overlapping the island, the rest of the curve would be clipped away.
+        BoundingBox bbox_island = get_extents(expolygon.contour);
+        Polylines polylines;
+        bool      last_overlaps = false;
+        for (size_t i = 0; i < curve->chunks.size(); ++ i) {
+            bool overlaps = curve->bboxes[i].overlap(bbox_island);
+            if (overlaps) {
+                const Points &pts = curve->chunks[i].points;
+                if (last_overlaps)
+                    polylines.back().points.insert(polylines.back().points.end(), pts.begin() + 1, pts.end());
+                else
+                    polylines.emplace_back(curve->chunks[i]);
+            }
+            last_overlaps = overlaps;
+        }
 //      intersection(polylines_src, offset((Polygons)expolygon, scale_(0.02)), &polylines);
         polylines = intersection_pl(std::move(polylines), to_polygons(expolygon));
         Polylines chained;
@@ -2,6 +2,10 @@
 #define slic3r_FillPlanePath_hpp_
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
 
 #include "../libslic3r.h"
 
@@ -9,6 +13,55 @@
 
 namespace Slic3r {
 
+struct PlanePathCurve;
+
+struct PlanePathCurveKey
+{
+    std::type_index type;
+    coord_t         distance_between_lines;
+    coord_t         min_x;
+    coord_t         min_y;
+    coord_t         max_x;
+    coord_t         max_y;
+
+    bool operator<(const PlanePathCurveKey &rhs) const {
+        return std::tie(type, distance_between_lines, min_x, min_y, max_x, max_y) <
+            std::tie(rhs.type, rhs.distance_between_lines, rhs.min_x, rhs.min_y, rhs.max_x, rhs.max_y);
+    }
+};
+
+// Curves of the plane path patterns of an object, shared by its layers and regions.
+// Created by PrintObject::infill() and released at the end of the posInfill step.
+class PlanePathCurveCache
+{
+public:
+    // Returns the curve of the key, make_curve() is called once per key, other threads asking for the same key wait for it.
+    template<typename MakeCurve>
+    std::shared_ptr<const PlanePathCurve> curve(const PlanePathCurveKey &key, MakeCurve make_curve)
+    {
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::shared_ptr<Entry> &slot = m_entries[key];
+            if (! slot)
+                slot = std::make_shared<Entry>();
+            entry = slot;
+        }
+        std::call_once(entry->once, [&entry, &make_curve]() { entry->curve = make_curve(); });
+        return entry->curve;
+    }
+
+private:
+    struct Entry
+    {
+        std::once_flag                        once;
+        std::shared_ptr<const PlanePathCurve> curve;
+    };
+
+    std::mutex                                       m_mutex;
+    std::map<PlanePathCurveKey, std::shared_ptr<Entry>> m_entries;
+};
+
 // The original Perl code used path generators from Math::PlanePath library:
 // http://user42.tuxfamily.org/math-planepath/
 // http://user42.tuxfamily.org/math-planepath/gallery.html
@@ -29,6 +82,11 @@ protected:
     float _layer_angle(size_t idx) const override { return 0.f; }
     virtual bool  _centered() const = 0;
     virtual Pointfs _generate(coord_t min_x, coord_t min_y, coord_t max_x, coord_t max_y) const = 0;
+
+private:
+    // Curve generated by _generate() and upscaled, shared across layers and regions through this->plane_path_curves if set.
+    std::shared_ptr<const PlanePathCurve> _curve(coord_t distance_between_lines, coord_t min_x, coord_t min_y, coord_t max_x, coord_t max_y) const;
+    std::shared_ptr<const PlanePathCurve> _make_curve(coord_t distance_between_lines, coord_t min_x, coord_t min_y, coord_t max_x, coord_t max_y) const;
 };
 
 class FillArchimedeanChords : public FillPlanePath
@@ -12,8 +12,10 @@
 
 #include "3mf.hpp"
 
+#include <atomic>
 #include <limits>
 #include <stdexcept>
+#include <string_view>
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -28,6 +30,12 @@
 #include <boost/foreach.hpp>
 namespace pt = boost::property_tree;
 
+#include <tbb/parallel_for.h>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
 #include <expat.h>
 #include <Eigen/Dense>
 #include "miniz_extension.hpp"
@@ -242,6 +250,346 @@ bool is_valid_object_type(const std::string& type)
     return false;
 }
 
+// Fast path for the content of the <vertices> and <triangles> elements of the .model file, which make up nearly all of its bytes.
+// The content is decoded directly from the decompressed buffer, in parallel, and the expat parser only sees the empty elements.
+// The scanner accepts just the plain form of the <vertex> and <triangle> elements, as written by PrusaSlicer and most other exporters.
+// Anything else (comments, entities, unexpected elements or numbers atof() / atoi() would read differently) makes it refuse the whole file,
+// which is then parsed by expat alone.
+
+struct MeshData
+{
+    // Vertex coordinates not scaled by the unit factor yet.
+    std::vector<float>        vertices;
+    std::vector<unsigned int> triangles;
+    std::vector<std::string>  custom_supports;
+    std::vector<std::string>  custom_seam;
+};
+
+struct MeshBlock
+{
+    bool                  triangles;
+    // Content of the element inside the .model buffer, excluding its start and end tags.
+    size_t                begin;
+    size_t                end;
+    // Decoded content, one entry per chunk of the block, in file order.
+    std::vector<MeshData> chunks;
+};
+
+static inline bool is_xml_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline const char* skip_xml_space(const char* p, const char* end)
+{
+    while (p != end && is_xml_space(*p))
+        ++ p;
+    return p;
+}
+
+static inline const char* find_str(const char* begin, const char* end, const char* str)
+{
+    const char* str_end = str + ::strlen(str);
+    const char* p = std::search(begin, end, str, str_end);
+    return (p == end) ? nullptr : p;
+}
+
+// Reads the number as ::atof() would, returns false if atof() would not read the whole string or its result could differ.
+static bool parse_mesh_float(const char* begin, const char* end, float& out)
+{
+    // atof() accepts a leading plus sign, from_chars() does not.
+    if (begin != end && *begin == '+')
+        ++ begin;
+    if (begin == end || *begin == '+')
+        return false;
+    // atof() converts to double, thus the double is rounded to float here, not parsed as float, to get the very same value.
+    double value;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc() || ptr != end)
+        return false;
+#else
+    // The buffer is not null terminated, thus the token is copied.
+    char buf[64];
+    size_t len = end - begin;
+    if (len >= sizeof(buf) || is_xml_space(*begin))
+        return false;
+    ::memcpy(buf, begin, len);
+    buf[len] = 0;
+    char* endptr = nullptr;
+    value = ::strtod(buf, &endptr);
+    if (endptr != buf + len)
+        return false;
+#endif
+    out = (float)value;
+    return true;
+}
+
+// Reads the number as ::atoi() would, returns false if atoi() would not read the whole string or its result could differ.
+static bool parse_mesh_int(const char* begin, const char* end, int& out)
+{
+    if (begin != end && *begin == '+')
+        ++ begin;
+    if (begin == end || *begin == '+')
+        return false;
+#if __has_include(<charconv>)
+    auto [ptr, ec] = std::from_chars(begin, end, out);
+    return ec == std::errc() && ptr == end;
+#else
+    char buf[32];
+    size_t len = end - begin;
+    if (len >= sizeof(buf) || is_xml_space(*begin))
+        return false;
+    ::memcpy(buf, begin, len);
+    buf[len] = 0;
+    char* endptr = nullptr;
+    long value = ::strtol(buf, &endptr, 10);
+    if (endptr != buf + len || value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max())
+        return false;
+    out = (int)value;
+    return true;
+#endif
+}
+
+// Decodes a sequence of <vertex> or <triangle> elements, appending them to out.
+static bool parse_mesh_chunk(const char* p, const char* end, bool triangles, MeshData& out)
+{
+    const char*  tag     = triangles ? TRIANGLE_TAG : VERTEX_TAG;
+    const size_t tag_len = ::strlen(tag);
+    for (;;) {
+        p = skip_xml_space(p, end);
+        if (p == end)
+            return true;
+        if (size_t(end - p) < tag_len + 1 || *p != '<' || ::memcmp(p + 1, tag, tag_len) != 0)
+            return false;
+        p += tag_len + 1;
+
+        // Missing values are set equal to ZERO, as in _handle_start_vertex() / _handle_start_triangle().
+        float        coords[3] = { 0.f, 0.f, 0.f };
+        int          indices[3] = { 0, 0, 0 };
+        const char*  custom_supports[2] = { nullptr, nullptr };
+        const char*  custom_seam[2] = { nullptr, nullptr };
+        unsigned int seen = 0;
+        for (;;) {
+            const char* name = skip_xml_space(p, end);
+            if (name == end)
+                return false;
+            if (*name == '/') {
+                if (++ name == end || *name != '>')
+                    return false;
+                p = name + 1;
+                break;
+            }
+            if (*name == '>') {
+                // An element with an explicit end tag, which may only be preceded by white space.
+                p = skip_xml_space(name + 1, end);
+                if (size_t(end - p) < tag_len + 2 || p[0] != '<' || p[1] != '/' || ::memcmp(p + 2, tag, tag_len) != 0)
+                    return false;
+                p = skip_xml_space(p + tag_len + 2, end);
+                if (p == end || *p != '>')
+                    return false;
+                ++ p;
+                break;
+            }
+            // The attributes have to be separated from the tag name and from each other by white space.
+            if (name == p)
+                return false;
+            p = name;
+            while (p != end && *p != '=' && !is_xml_space(*p) && *p != '/' && *p != '>')
+                ++ p;
+            const std::string_view key(name, p - name);
+            p = skip_xml_space(p, end);
+            if (key.empty() || p == end || *p != '=')
+                return false;
+            p = skip_xml_space(p + 1, end);
+            if (p == end || (*p != '"' && *p != '\''))
+                return false;
+            const char* value     = p + 1;
+            const char* value_end = (const char*)::memchr(value, *p, end - value);
+            if (value_end == nullptr)
+                return false;
+            // Entities and the white space normalized by expat are left to expat.
+            if (std::find_if(value, value_end, [](char c) { return c == '&' || c == '<' || c == '\t' || c == '\n' || c == '\r'; }) != value_end)
+                return false;
+            p = value_end + 1;
+
+            int slot = -1;
+            if (triangles) {
+                if (key == V1_ATTR)
+                    slot = 0;
+                else if (key == V2_ATTR)
+                    slot = 1;
+                else if (key == V3_ATTR)
+                    slot = 2;
+                else if (key == CUSTOM_SUPPORTS_ATTR)
+                    slot = 3;
+                else if (key == CUSTOM_SEAM_ATTR)
+                    slot = 4;
+            } else {
+                if (key == X_ATTR)
+                    slot = 0;
+                else if (key == Y_ATTR)
+                    slot = 1;
+                else if (key == Z_ATTR)
+                    slot = 2;
+            }
+            if (slot == -1)
+                // ignored attribute (p1, p2, p3, pid...)
+                continue;
+            // A repeated attribute is an error reported by expat.
+            if (seen & (1 << slot))
+                return false;
+            seen |= 1 << slot;
+            if (slot == 3) {
+                custom_supports[0] = value;
+                custom_supports[1] = value_end;
+            } else if (slot == 4) {
+                custom_seam[0] = value;
+                custom_seam[1] = value_end;
+            } else if (triangles ? !parse_mesh_int(value, value_end, indices[slot]) : !parse_mesh_float(value, value_end, coords[slot]))
+                return false;
+        }
+
+        if (triangles) {
+            for (int i = 0; i < 3; ++ i)
+                out.triangles.push_back((unsigned int)indices[i]);
+            out.custom_supports.emplace_back(custom_supports[0] == nullptr ? std::string() : std::string(custom_supports[0], custom_supports[1]));
+            out.custom_seam.emplace_back(custom_seam[0] == nullptr ? std::string() : std::string(custom_seam[0], custom_seam[1]));
+        } else {
+            for (int i = 0; i < 3; ++ i)
+                out.vertices.push_back(coords[i]);
+        }
+    }
+}
+
+// Finds the <vertices> and <triangles> elements of the .model file in the same order expat will report them.
+// Returns false if the file uses constructs the scanner does not follow, then expat has to parse the whole file.
+static bool scan_mesh_blocks(const char* data, size_t size, std::vector<MeshBlock>& blocks)
+{
+    const char* end = data + size;
+    const char* p   = data;
+    while ((p = (const char*)::memchr(p, '<', end - p)) != nullptr) {
+        const char* tag = p + 1;
+        if (tag == end)
+            return false;
+        if (*tag == '!') {
+            if (end - tag >= 3 && ::memcmp(tag, "!--", 3) == 0) {
+                if ((p = find_str(tag + 3, end, "-->")) == nullptr)
+                    return false;
+                p += 3;
+            } else if (end - tag >= 8 && ::memcmp(tag, "![CDATA[", 8) == 0) {
+                if ((p = find_str(tag + 8, end, "]]>")) == nullptr)
+                    return false;
+                p += 3;
+            } else
+                // A document type declaration may define entities.
+                return false;
+            continue;
+        }
+        if (*tag == '?') {
+            if ((p = find_str(tag + 1, end, "?>")) == nullptr)
+                return false;
+            p += 2;
+            continue;
+        }
+        if (*tag == '/') {
+            if ((p = (const char*)::memchr(tag, '>', end - tag)) == nullptr)
+                return false;
+            ++ p;
+            continue;
+        }
+        const char* name_end = tag;
+        while (name_end != end && !is_xml_space(*name_end) && *name_end != '/' && *name_end != '>')
+            ++ name_end;
+        // Skip the attributes, which may contain '>' inside their quoted values.
+        p = name_end;
+        for (;;) {
+            if (p == end)
+                return false;
+            if (*p == '"' || *p == '\'') {
+                if ((p = (const char*)::memchr(p + 1, *p, end - p - 1)) == nullptr)
+                    return false;
+            } else if (*p == '>')
+                break;
+            ++ p;
+        }
+        const bool        self_closing = p[-1] == '/';
+        const std::string_view name(tag, name_end - tag);
+        ++ p;
+        const bool triangles = name == TRIANGLES_TAG;
+        if (! triangles && name != VERTICES_TAG)
+            continue;
+        MeshBlock block;
+        block.triangles = triangles;
+        block.begin     = p - data;
+        if (self_closing)
+            block.end = block.begin;
+        else {
+            // The content of an accepted block contains no markup other than the <vertex> / <triangle> elements,
+            // thus the first end tag found is the one closing the block. Otherwise parse_mesh_chunk() rejects the content.
+            const std::string end_tag = std::string("</") + (triangles ? TRIANGLES_TAG : VERTICES_TAG);
+            const char* content_end = p;
+            for (;;) {
+                if ((content_end = find_str(content_end, end, end_tag.c_str())) == nullptr)
+                    return false;
+                const char* c = content_end + end_tag.size();
+                if (c != end && (is_xml_space(*c) || *c == '>'))
+                    break;
+                content_end = c;
+            }
+            block.end = content_end - data;
+            p = content_end;
+        }
+        blocks.emplace_back(std::move(block));
+    }
+    return true;
+}
+
+// Decodes the content of the blocks in parallel, splitting large blocks into chunks.
+// Returns false if any of the blocks is not accepted by the fast path.
+static bool parse_mesh_blocks(const char* data, std::vector<MeshBlock>& blocks)
+{
+    static constexpr const size_t chunk_size = 1 << 20;
+
+    struct Chunk
+    {
+        MeshBlock*  block;
+        size_t      idx;
+        const char* begin;
+        const char* end;
+    };
+    std::vector<Chunk> chunks;
+    for (MeshBlock& block : blocks) {
+        const char* begin = data + block.begin;
+        const char* end   = data + block.end;
+        while (begin != end) {
+            // Split at the start of an element. The content has no markup other than these elements, if it is accepted at all.
+            const char* chunk_end = end;
+            if (size_t(end - begin) > chunk_size) {
+                chunk_end = begin + chunk_size;
+                while ((chunk_end = (const char*)::memchr(chunk_end, '<', end - chunk_end)) != nullptr && chunk_end + 1 != end && chunk_end[1] == '/')
+                    ++ chunk_end;
+                if (chunk_end == nullptr)
+                    chunk_end = end;
+            }
+            chunks.push_back({ &block, block.chunks.size(), begin, chunk_end });
+            block.chunks.emplace_back();
+            begin = chunk_end;
+        }
+    }
+
+    std::atomic<bool> valid(true);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1),
+        [&chunks, &valid](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i < range.end() && valid; ++ i) {
+                const Chunk& chunk = chunks[i];
+                if (! parse_mesh_chunk(chunk.begin, chunk.end, chunk.block->triangles, chunk.block->chunks[chunk.idx]))
+                    valid = false;
+            }
+        });
+    return valid;
+}
+
 namespace Slic3r {
 
 //! macro used to mark string used at localization,
@@ -412,6 +760,10 @@ namespace Slic3r {
         Model* m_model;
         float m_unit_factor;
         CurrentObject m_curr_object;
+        // <vertices> and <triangles> elements decoded by the fast path, in file order. Empty if expat parses the meshes.
+        std::vector<MeshBlock> m_mesh_blocks;
+        size_t m_mesh_blocks_next;
+        MeshBlock* m_curr_mesh_block;
         IdToModelObjectMap m_objects;
         IdToAliasesMap m_objects_aliases;
         InstancesList m_instances;
@@ -490,6 +842,8 @@ namespace Slic3r {
         bool _handle_start_triangle(const char** attributes, unsigned int num_attributes);
         bool _handle_end_triangle();
 
+        bool _start_mesh_block(bool triangles);
+
         bool _handle_start_components(const char** attributes, unsigned int num_attributes);
         bool _handle_end_components();
 
@@ -539,6 +893,8 @@ namespace Slic3r {
         , m_xml_parser(nullptr)
         , m_model(nullptr)   
         , m_unit_factor(1.0f)
+        , m_mesh_blocks_next(0)
+        , m_curr_mesh_block(nullptr)
         , m_curr_metadata_name("")
         , m_curr_characters("")
         , m_name("")
@@ -850,31 +1206,77 @@ namespace Slic3r {
         XML_SetElementHandler(m_xml_parser, _3MF_Importer::_handle_start_model_xml_element, _3MF_Importer::_handle_end_model_xml_element);
         XML_SetCharacterDataHandler(m_xml_parser, _3MF_Importer::_handle_model_xml_characters);
 
-        struct CallbackData
+        // The entry is extracted directly into the buffer of expat, if it fits, so that expat does not copy it again.
+        // The buffer is not zero initialized, it is overwritten by the extraction.
+        const size_t            size        = (size_t)stat.m_uncomp_size;
+        const bool              expat_owned = size <= size_t(std::numeric_limits<int>::max());
+        std::unique_ptr<char[]> heap_buffer;
+        char*                   data        = nullptr;
+        if (expat_owned)
+            data = (char*)XML_GetBuffer(m_xml_parser, (int)size);
+        else {
+            heap_buffer.reset(new char[size]);
+            data = heap_buffer.get();
+        }
+        if (data == nullptr)
         {
-            XML_Parser& parser;
-            _3MF_Importer& importer;
-            const mz_zip_archive_file_stat& stat;
-
-            CallbackData(XML_Parser& parser, _3MF_Importer& importer, const mz_zip_archive_file_stat& stat) : parser(parser), importer(importer), stat(stat) {}
-        };
+            add_error("Unable to create buffer");
+            return false;
+        }
+        mz_bool res = mz_zip_reader_extract_file_to_mem(&archive, stat.m_filename, (void*)data, size, 0);
+        if (res == 0)
+        {
+            add_error("Error while extracting model data from zip archive");
+            return false;
+        }
 
-        CallbackData data(m_xml_parser, *this, stat);
+        // Decode the meshes in parallel, the rest of the file is left to expat.
+        m_mesh_blocks.clear();
+        m_mesh_blocks_next = 0;
+        m_curr_mesh_block = nullptr;
+        if (! scan_mesh_blocks(data, size, m_mesh_blocks) || ! parse_mesh_blocks(data, m_mesh_blocks))
+            m_mesh_blocks.clear();
 
-        mz_bool res = 0;
+        // Expat sees the decoded <vertices> and <triangles> elements empty: Their content is removed from the buffer in place.
+        size_t data_size = 0;
+        {
+            size_t pos = 0;
+            for (const MeshBlock& block : m_mesh_blocks) {
+                ::memmove(data + data_size, data + pos, block.begin - pos);
+                data_size += block.begin - pos;
+                pos = block.end;
+            }
+            ::memmove(data + data_size, data + pos, size - pos);
+            data_size += size - pos;
+        }
 
         try
         {
-            res = mz_zip_reader_extract_file_to_callback(&archive, stat.m_filename, [](void* pOpaque, mz_uint64 file_ofs, const void* pBuf, size_t n)->size_t {
-                CallbackData* data = (CallbackData*)pOpaque;
-                if (!XML_Parse(data->parser, (const char*)pBuf, (int)n, (file_ofs + n == data->stat.m_uncomp_size) ? 1 : 0) || data->importer.parse_error()) {
+            auto check = [this, &stat](bool ok) {
+                if (! ok || parse_error()) {
                     char error_buf[1024];
-                    ::sprintf(error_buf, "Error (%s) while parsing '%s' at line %d", data->importer.parse_error_message(), data->stat.m_filename, (int)XML_GetCurrentLineNumber(data->parser));
+                    ::sprintf(error_buf, "Error (%s) while parsing '%s' at line %d", parse_error_message(), stat.m_filename, (int)XML_GetCurrentLineNumber(m_xml_parser));
                     throw Slic3r::FileIOError(error_buf);
                 }
+            };
+
+            if (expat_owned)
+                check(XML_ParseBuffer(m_xml_parser, (int)data_size, 1) != 0);
+            else {
+                // XML_Parse() takes an int length.
+                static constexpr const size_t max_size = 1 << 26;
+                const char* p = data;
+                size_t      left = data_size;
+                do {
+                    size_t n = std::min(left, max_size);
+                    check(XML_Parse(m_xml_parser, p, (int)n, n == left ? 1 : 0) != 0);
+                    p += n;
+                    left -= n;
+                } while (left > 0);
+            }
 
-                return n;
-                }, &data, 0);
+            if (m_mesh_blocks_next != m_mesh_blocks.size())
+                throw Slic3r::FileIOError("Error (Invalid 3MF format) while parsing '" + std::string(stat.m_filename) + "'");
         }
         catch (const version_error& e)
         {
@@ -887,12 +1289,8 @@ namespace Slic3r {
             return false;
         }
 
-        if (res == 0)
-        {
-            add_error("Error while extracting model data from zip archive");
-            return false;
-        }
-
+        m_mesh_blocks.clear();
+        m_curr_mesh_block = nullptr;
         return true;
     }
 
@@ -1601,12 +1999,27 @@ namespace Slic3r {
     {
         // reset current vertices
         m_curr_object.geometry.vertices.clear();
-        return true;
+        return _start_mesh_block(false);
     }
 
     bool _3MF_Importer::_handle_end_vertices()
     {
-        // do nothing
+        if (m_curr_mesh_block != nullptr)
+        {
+            // appends the vertices decoded by the fast path
+            std::vector<float>& vertices = m_curr_object.geometry.vertices;
+            size_t size = 0;
+            for (const MeshData& chunk : m_curr_mesh_block->chunks)
+                size += chunk.vertices.size();
+            vertices.reserve(size);
+            for (MeshData& chunk : m_curr_mesh_block->chunks)
+            {
+                for (float v : chunk.vertices)
+                    vertices.push_back(m_unit_factor * v);
+                chunk.vertices = std::vector<float>();
+            }
+            m_curr_mesh_block = nullptr;
+        }
         return true;
     }
 
@@ -1630,12 +2043,30 @@ namespace Slic3r {
     {
         // reset current triangles
         m_curr_object.geometry.triangles.clear();
-        return true;
+        return _start_mesh_block(true);
     }
 
     bool _3MF_Importer::_handle_end_triangles()
     {
-        // do nothing
+        if (m_curr_mesh_block != nullptr)
+        {
+            // appends the triangles decoded by the fast path
+            Geometry& geometry = m_curr_object.geometry;
+            size_t size = 0;
+            for (const MeshData& chunk : m_curr_mesh_block->chunks)
+                size += chunk.custom_supports.size();
+            geometry.triangles.reserve(3 * size);
+            geometry.custom_supports.reserve(geometry.custom_supports.size() + size);
+            geometry.custom_seam.reserve(geometry.custom_seam.size() + size);
+            for (MeshData& chunk : m_curr_mesh_block->chunks)
+            {
+                geometry.triangles.insert(geometry.triangles.end(), chunk.triangles.begin(), chunk.triangles.end());
+                std::move(chunk.custom_supports.begin(), chunk.custom_supports.end(), std::back_inserter(geometry.custom_supports));
+                std::move(chunk.custom_seam.begin(), chunk.custom_seam.end(), std::back_inserter(geometry.custom_seam));
+                chunk = MeshData();
+            }
+            m_curr_mesh_block = nullptr;
+        }
         return true;
     }
 
@@ -1665,6 +2096,20 @@ namespace Slic3r {
         return true;
     }
 
+    bool _3MF_Importer::_start_mesh_block(bool triangles)
+    {
+        if (m_mesh_blocks.empty())
+            // expat parses the meshes
+            return true;
+
+        // expat reports the elements in the order scan_mesh_blocks() found them
+        if (m_mesh_blocks_next == m_mesh_blocks.size() || m_mesh_blocks[m_mesh_blocks_next].triangles != triangles)
+            return false;
+
+        m_curr_mesh_block = &m_mesh_blocks[m_mesh_blocks_next++];
+        return true;
+    }
+
     bool _3MF_Importer::_handle_start_components(const char** attributes, unsigned int num_attributes)
     {
         // reset current components
@@ -1,4 +1,5 @@
 #include "../libslic3r.h"
+#include "../MeshCache.hpp"
 #include "../Model.hpp"
 #include "../TriangleMesh.hpp"
 
@@ -9,6 +10,8 @@
 
 #include <boost/log/trivial.hpp>
 
+#include <tbb/parallel_for.h>
+
 #ifdef _WIN32
 #define DIR_SEPARATOR '\\'
 #else
@@ -20,6 +23,11 @@ namespace Slic3r {
 bool load_obj(const char *path, TriangleMesh *meshptr)
 {
     if(meshptr == nullptr) return false;
+
+    // Reuse the repaired mesh of an identical file loaded before, if the mesh cache is enabled.
+    const std::string cache_key = mesh_cache_key(path, "obj");
+    if (load_mesh_cache(cache_key, *meshptr))
+        return true;
     
     // Parse the OBJ file.
     ObjParser::ObjData data;
@@ -28,86 +36,60 @@ bool load_obj(const char *path, TriangleMesh *meshptr)
         return false;
     }
     
-    // Count the faces and verify, that all faces are triangular.
-    size_t num_faces = 0;
-    size_t num_quads = 0;
+    // Build the indexed triangle set of the faces, quads are split into two triangles.
+    indexed_triangle_set its;
+    its.vertices.reserve(data.coordinates.size() / 4);
+    for (size_t i = 0; i + 3 < data.coordinates.size(); i += 4)
+        its.vertices.emplace_back(data.coordinates[i], data.coordinates[i + 1], data.coordinates[i + 2]);
+    const int num_vertices = int(its.vertices.size());
     for (size_t i = 0; i < data.vertices.size(); ) {
         size_t j = i;
         for (; j < data.vertices.size() && data.vertices[j].coordIdx != -1; ++ j) ;
-        if (i == j)
-            continue;
         size_t face_vertices = j - i;
-        if (face_vertices != 3 && face_vertices != 4) {
-            // Non-triangular and non-quad faces are not supported as of now.
-            return false;
+        if (face_vertices != 0) {
+            if (face_vertices != 3 && face_vertices != 4) {
+                // Non-triangular and non-quad faces are not supported as of now.
+                return false;
+            }
+            int idx[4];
+            for (size_t k = 0; k < face_vertices; ++ k) {
+                idx[k] = data.vertices[i + k].coordIdx;
+                if (idx[k] < 0 || idx[k] >= num_vertices) {
+                    BOOST_LOG_TRIVIAL(error) << "load_obj: Face references a non-existing vertex. " << path;
+                    return false;
+                }
+            }
+            its.indices.emplace_back(idx[0], idx[1], idx[2]);
+            if (face_vertices == 4)
+                // This is a quad. Produce the other triangle.
+                its.indices.emplace_back(idx[0], idx[2], idx[3]);
         }
-        if (face_vertices == 4)
-            ++ num_quads;
-        ++ num_faces;
         i = j + 1;
     }
     
-    // Convert ObjData into STL.
+    // Convert the indexed triangle set into STL for the repair.
+    // The normals of the OBJ file are not used, repair() calculates the normals from the vertices.
     TriangleMesh &mesh = *meshptr;
     stl_file &stl = mesh.stl;
     stl.stats.type = inmemory;
-    stl.stats.number_of_facets = uint32_t(num_faces + num_quads);
-    stl.stats.original_num_facets = int(num_faces + num_quads);
+    stl.stats.number_of_facets = uint32_t(its.indices.size());
+    stl.stats.original_num_facets = int(its.indices.size());
     // stl_allocate clears all the allocated data to zero, all normals are set to zeros as well.
     stl_allocate(&stl);
-    size_t i_face = 0;
-    for (size_t i = 0; i < data.vertices.size(); ++ i) {
-        if (data.vertices[i].coordIdx == -1)
-            continue;
-        stl_facet &facet = stl.facet_start[i_face ++];
-        size_t     num_normals = 0;
-        stl_normal normal(stl_normal::Zero());
-        for (unsigned int v = 0; v < 3; ++ v) {
-            const ObjParser::ObjVertex &vertex = data.vertices[i++];
-            memcpy(facet.vertex[v].data(), &data.coordinates[vertex.coordIdx*4], 3 * sizeof(float));
-            if (vertex.normalIdx != -1) {
-                normal(0) += data.normals[vertex.normalIdx*3];
-                normal(1) += data.normals[vertex.normalIdx*3+1];
-                normal(2) += data.normals[vertex.normalIdx*3+2];
-                ++ num_normals;
-            }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, its.indices.size()), [&its, &stl](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            stl_facet &facet = stl.facet_start[i];
+            for (int v = 0; v < 3; ++ v)
+                facet.vertex[v] = its.vertices[its.indices[i](v)];
         }
-        // Result of obj_parseline() call is not checked, thus not all vertices are necessarily finalized with coord_Idx == -1.
-        if (i < data.vertices.size() && data.vertices[i].coordIdx != -1) {
-            // This is a quad. Produce the other triangle.
-            stl_facet &facet2 = stl.facet_start[i_face++];
-            facet2.vertex[0] = facet.vertex[0];
-            facet2.vertex[1] = facet.vertex[2];
-            const ObjParser::ObjVertex &vertex = data.vertices[i++];
-            memcpy(facet2.vertex[2].data(), &data.coordinates[vertex.coordIdx * 4], 3 * sizeof(float));
-            if (vertex.normalIdx != -1) {
-                normal(0) += data.normals[vertex.normalIdx*3];
-                normal(1) += data.normals[vertex.normalIdx*3+1];
-                normal(2) += data.normals[vertex.normalIdx*3+2];
-                ++ num_normals;
-            }
-            if (num_normals == 4) {
-                // Normalize an average normal of a quad.
-                float len = facet.normal.norm();
-                if (len > EPSILON) {
-                    normal /= len;
-                    facet.normal = normal;
-                    facet2.normal = normal;
-                }
-            }
-        } else if (num_normals == 3) {
-            // Normalize an average normal of a triangle.
-            float len = facet.normal.norm();
-            if (len > EPSILON)
-                facet.normal = normal / len;
-        }
-    }
+    });
     stl_get_size(&stl);
     mesh.repair();
     if (mesh.facets_count() == 0) {
         BOOST_LOG_TRIVIAL(error) << "load_obj: This OBJ file couldn't be read because it's empty. " << path;
         return false;
     }
+    store_mesh_cache(cache_key, mesh);
     
     return true;
 }
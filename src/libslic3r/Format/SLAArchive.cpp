@@ -56,4 +56,22 @@ sla::RasterEncoder SLAArchive::get_encoder() const
     return sla::PNGRasterEncoder{};
 }
 
+void SLAArchive::write_layers(const SLAPrint &print,
+                              const std::function<void(const sla::EncodedRaster &rst, size_t lyrid)> &writefn)
+{
+    if (! m_streaming) {
+        for (size_t i = 0; i < m_layers.size(); ++ i)
+            writefn(m_layers[i], i);
+        return;
+    }
+    
+    const std::vector<SLAPrint::PrintLayer> &layers = print.print_layers();
+    stream_layers(layers.size(),
+                  [&layers](sla::RasterBase &raster, size_t idx) {
+                      for (const ClipperLib::Polygon &poly : layers[idx].transformed_slices())
+                          raster.draw(poly);
+                  },
+                  writefn);
+}
+
 } // namespace Slic3r
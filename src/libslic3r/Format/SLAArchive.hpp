@@ -1,6 +1,7 @@
 #ifndef slic3r_FORMAT_SLACOMMON_HPP
 #define slic3r_FORMAT_SLACOMMON_HPP
 
+#include <functional>
 #include <string>
 
 #include "libslic3r/Zipper.hpp"
@@ -17,6 +18,12 @@ protected:
     
     uqptr<sla::RasterBase> create_raster() const override;
     sla::RasterEncoder get_encoder() const override;
+    
+    /// Pass the encoded layers to writefn in the order of the layers. These
+    /// are either the layers rasterized while processing the print or, in the
+    /// streaming mode, the layers of the print rasterized on the fly.
+    void write_layers(const SLAPrint &print,
+                      const std::function<void(const sla::EncodedRaster &rst, size_t lyrid)> &writefn);
 public: 
     SLAArchive() = default;
    
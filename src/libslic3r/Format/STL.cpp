@@ -1,4 +1,5 @@
 #include "../libslic3r.h"
+#include "../MeshCache.hpp"
 #include "../Model.hpp"
 #include "../TriangleMesh.hpp"
 
@@ -17,14 +18,19 @@ namespace Slic3r {
 bool load_stl(const char *path, Model *model, const char *object_name_in)
 {
     TriangleMesh mesh;
-    if (! mesh.ReadSTLFile(path)) {
-//    die "Failed to open $file\n" if !-e $path;
-        return false;
-    }
-    mesh.repair();
-    if (mesh.facets_count() == 0) {
-        // die "This STL file couldn't be read because it's empty.\n"
-        return false;
+    // Reuse the repaired mesh of an identical file loaded before, if the mesh cache is enabled.
+    const std::string cache_key = mesh_cache_key(path, "stl");
+    if (! load_mesh_cache(cache_key, mesh)) {
+        if (! mesh.ReadSTLFile(path)) {
+//        die "Failed to open $file\n" if !-e $path;
+            return false;
+        }
+        mesh.repair();
+        if (mesh.facets_count() == 0) {
+            // die "This STL file couldn't be read because it's empty.\n"
+            return false;
+        }
+        store_mesh_cache(cache_key, mesh);
     }
 
     std::string object_name;
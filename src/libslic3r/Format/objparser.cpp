@@ -1,14 +1,23 @@
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 
+#include <tbb/parallel_for.h>
+
 #include "objparser.hpp"
 
 namespace ObjParser {
 
-static bool obj_parseline(const char *line, ObjData &data)
+// Parse a single line into data. If relative is set, the face vertices with relative (negative) indices are recorded there
+// together with a mask of their relative indices (1: coordinate, 2: texture coordinate, 4: normal), see ObjChunk.
+static bool obj_parseline(const char *line, ObjData &data, std::vector<std::pair<size_t, unsigned char>> *relative = nullptr)
 {
 #define EATWS() while (*line == ' ' || *line == '\t') ++ line
 
@@ -213,18 +222,24 @@ static bool obj_parseline(const char *line, ObjData &data)
 					line = endptr;
 				}
 			}
-			if (vertex.coordIdx < 0)
+			unsigned char relative_mask = 0;
+			if (vertex.coordIdx < 0) {
                 vertex.coordIdx += (int)data.coordinates.size() / 4;
-            else
+				relative_mask |= 1;
+			} else
 				-- vertex.coordIdx;
-			if (vertex.normalIdx < 0)
+			if (vertex.normalIdx < 0) {
                 vertex.normalIdx += (int)data.normals.size() / 3;
-            else
+				relative_mask |= 4;
+			} else
 				-- vertex.normalIdx;
-			if (vertex.textureCoordIdx < 0)
+			if (vertex.textureCoordIdx < 0) {
                 vertex.textureCoordIdx += (int)data.textureCoordinates.size() / 3;
-            else
+				relative_mask |= 2;
+			} else
 				-- vertex.textureCoordIdx;
+			if (relative != nullptr && relative_mask != 0)
+				relative->emplace_back(data.vertices.size(), relative_mask);
 			data.vertices.push_back(vertex);
 			EATWS();
 		}
@@ -320,43 +335,183 @@ static bool obj_parseline(const char *line, ObjData &data)
 	return true;
 }
 
-bool objparse(const char *path, ObjData &data)
+// A piece of the file starting and ending at line boundaries, parsed independently of the other chunks.
+// The indices it references are local to the chunk until the chunks are merged by objparse().
+struct ObjChunk
 {
-	FILE *pFile = boost::nowide::fopen(path, "rt");
-	if (pFile == 0)
-		return false;
+	const char *begin;
+	const char *end;
+	ObjData		data;
+	// Face vertices with relative (negative) indices, which were resolved against the records of this chunk only.
+	std::vector<std::pair<size_t, unsigned char>> relative;
+	bool		excessive_line { false };
+};
+
+static void obj_parsechunk(ObjChunk &chunk)
+{
+	// obj_parseline() expects zero terminated lines, thus the chunk of the read only mapped file is copied
+	// and the line ends are replaced with zeros.
+	std::vector<char> buf(chunk.begin, chunk.end);
+	buf.push_back(0);
+	char *line = buf.data();
+	char *end  = buf.data() + buf.size() - 1;
+	while (line != end) {
+		char *line_end = line;
+		while (line_end != end && *line_end != '\r' && *line_end != '\n')
+			++ line_end;
+		if (line_end - line > 65536) {
+			chunk.excessive_line = true;
+			return;
+		}
+		*line_end = 0;
+		while (*line == ' ' || *line == '\t')
+			++ line;
+		//FIXME check the return value and exit on error?
+		// Will it break parsing of some obj files?
+		obj_parseline(line, chunk.data, &chunk.relative);
+		line = (line_end == end) ? end : line_end + 1;
+	}
+}
 
+template<typename T>
+static void append_named(std::vector<T> &dst, const std::vector<T> &src, int vertex_offset)
+{
+	for (const T &item : src) {
+		dst.emplace_back(item);
+		dst.back().vertexIdxFirst += vertex_offset;
+	}
+}
+
+bool objparse(const char *path, ObjData &data, size_t chunk_size)
+{
+	assert(chunk_size > 0);
+	namespace bip = boost::interprocess;
+	// The narrow file name is not converted from UTF-8 on Windows, such files are read into memory instead.
+	bip::file_mapping  mapping;
+	bip::mapped_region region;
+	std::vector<char>  buffer;
+	const char		  *file_begin = nullptr;
+	size_t			   file_size  = 0;
 	try {
-		char buf[65536 * 2];
+		bip::file_mapping(path, bip::read_only).swap(mapping);
+		bip::mapped_region(mapping, bip::read_only).swap(region);
+		file_begin = static_cast<const char*>(region.get_address());
+		file_size  = region.get_size();
+	} catch (const bip::interprocess_exception &) {
+		FILE *pFile = boost::nowide::fopen(path, "rb");
+		if (pFile == 0)
+			return false;
+		char buf[65536];
 		size_t len = 0;
-		size_t lenPrev = 0;
-		while ((len = ::fread(buf + lenPrev, 1, 65536, pFile)) != 0) {
-			len += lenPrev;
-			size_t lastLine = 0;
-			for (size_t i = 0; i < len; ++ i)
-				if (buf[i] == '\r' || buf[i] == '\n') {
-					buf[i] = 0;
-					char *c = buf + lastLine;
-					while (*c == ' ' || *c == '\t')
-						++ c;
-					//FIXME check the return value and exit on error?
-					// Will it break parsing of some obj files?
-					obj_parseline(c, data);
-					lastLine = i + 1;
-				}
-			lenPrev = len - lastLine;
-			if (lenPrev > 65536) {
+		while ((len = ::fread(buf, 1, sizeof(buf), pFile)) != 0)
+			buffer.insert(buffer.end(), buf, buf + len);
+		::fclose(pFile);
+		file_begin = buffer.data();
+		file_size  = buffer.size();
+	}
+
+	try {
+		// Split the file into chunks at line boundaries and parse them in parallel.
+		const char *file_end = file_begin + file_size;
+		std::vector<ObjChunk> chunks;
+		for (const char *begin = file_begin; begin != file_end;) {
+			const char *end = file_end;
+			if (size_t(file_end - begin) > chunk_size) {
+				end = begin + chunk_size;
+				while (end != file_end && *end != '\r' && *end != '\n')
+					++ end;
+				if (end != file_end)
+					++ end;
+			}
+			chunks.emplace_back();
+			chunks.back().begin = begin;
+			chunks.back().end   = end;
+			begin = end;
+		}
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1), [&chunks](const tbb::blocked_range<size_t> &range) {
+			for (size_t i = range.begin(); i < range.end(); ++ i)
+				obj_parsechunk(chunks[i]);
+		});
+		for (const ObjChunk &chunk : chunks)
+			if (chunk.excessive_line) {
 		    	BOOST_LOG_TRIVIAL(error) << "ObjParser: Excessive line length";
-				::fclose(pFile);
 				return false;
 			}
-			memmove(buf, buf + lastLine, lenPrev);
+
+		if (chunks.size() == 1 && data.coordinates.empty() && data.textureCoordinates.empty() && data.normals.empty() &&
+			data.parameters.empty() && data.vertices.empty() && data.mtllibs.empty() && data.usemtls.empty() &&
+			data.objects.empty() && data.groups.empty() && data.smoothingGroups.empty()) {
+			// A small file, its indices are final already.
+			int version = data.version;
+			data = std::move(chunks.front().data);
+			data.version = version;
+			return true;
 		}
-    }
-    catch (std::bad_alloc&) {
-    	BOOST_LOG_TRIVIAL(error) << "ObjParser: Out of memory";
+
+		// Prefix sums of the records of the preceding chunks.
+		struct Offsets {
+			size_t coordinates { 0 };
+			size_t textureCoordinates { 0 };
+			size_t normals { 0 };
+			size_t parameters { 0 };
+			size_t vertices { 0 };
+		};
+		std::vector<Offsets> offsets(chunks.size() + 1);
+		for (size_t i = 0; i < chunks.size(); ++ i) {
+			const ObjData &src = chunks[i].data;
+			offsets[i + 1].coordinates			= offsets[i].coordinates		+ src.coordinates.size();
+			offsets[i + 1].textureCoordinates	= offsets[i].textureCoordinates	+ src.textureCoordinates.size();
+			offsets[i + 1].normals				= offsets[i].normals			+ src.normals.size();
+			offsets[i + 1].parameters			= offsets[i].parameters			+ src.parameters.size();
+			offsets[i + 1].vertices				= offsets[i].vertices			+ src.vertices.size();
+		}
+		const Offsets &total = offsets.back();
+		data.coordinates.resize(data.coordinates.size() + total.coordinates);
+		data.textureCoordinates.resize(data.textureCoordinates.size() + total.textureCoordinates);
+		data.normals.resize(data.normals.size() + total.normals);
+		data.parameters.resize(data.parameters.size() + total.parameters);
+		data.vertices.resize(data.vertices.size() + total.vertices);
+		const Offsets base {
+			data.coordinates.size() - total.coordinates, data.textureCoordinates.size() - total.textureCoordinates,
+			data.normals.size() - total.normals, data.parameters.size() - total.parameters, data.vertices.size() - total.vertices };
+
+		for (size_t i = 0; i < chunks.size(); ++ i) {
+			const ObjData &src			 = chunks[i].data;
+			const int	   vertex_offset = int(base.vertices + offsets[i].vertices);
+			data.mtllibs.insert(data.mtllibs.end(), src.mtllibs.begin(), src.mtllibs.end());
+			append_named(data.usemtls, src.usemtls, vertex_offset);
+			append_named(data.objects, src.objects, vertex_offset);
+			append_named(data.groups, src.groups, vertex_offset);
+			append_named(data.smoothingGroups, src.smoothingGroups, vertex_offset);
+		}
+
+		// Copy the chunks into their place and shift the relative indices by the records of the preceding chunks.
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1), [&chunks, &offsets, &base, &data](const tbb::blocked_range<size_t> &range) {
+			for (size_t i = range.begin(); i < range.end(); ++ i) {
+				ObjData		  &src = chunks[i].data;
+				const Offsets &off = offsets[i];
+				std::copy(src.coordinates.begin(), src.coordinates.end(), data.coordinates.begin() + base.coordinates + off.coordinates);
+				std::copy(src.textureCoordinates.begin(), src.textureCoordinates.end(), data.textureCoordinates.begin() + base.textureCoordinates + off.textureCoordinates);
+				std::copy(src.normals.begin(), src.normals.end(), data.normals.begin() + base.normals + off.normals);
+				std::copy(src.parameters.begin(), src.parameters.end(), data.parameters.begin() + base.parameters + off.parameters);
+				for (const std::pair<size_t, unsigned char> &rel : chunks[i].relative) {
+					ObjVertex &vertex = src.vertices[rel.first];
+					if (rel.second & 1)
+						vertex.coordIdx += int((base.coordinates + off.coordinates) / 4);
+					if (rel.second & 2)
+						vertex.textureCoordIdx += int((base.textureCoordinates + off.textureCoordinates) / 3);
+					if (rel.second & 4)
+						vertex.normalIdx += int((base.normals + off.normals) / 3);
+				}
+				std::copy(src.vertices.begin(), src.vertices.end(), data.vertices.begin() + base.vertices + off.vertices);
+				src = ObjData();
+			}
+		});
+	}
+	catch (std::bad_alloc&) {
+		BOOST_LOG_TRIVIAL(error) << "ObjParser: Out of memory";
+		return false;
 	}
-	::fclose(pFile);
 
 	// printf("vertices: %d\r\n", data.vertices.size() / 4);
 	// printf("coords: %d\r\n", data.coordinates.size());
@@ -1,6 +1,7 @@
 #ifndef slic3r_Format_objparser_hpp_
 #define slic3r_Format_objparser_hpp_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <istream>
@@ -97,7 +98,10 @@ struct ObjData {
 	std::vector<ObjVertex>			vertices;
 };
 
-extern bool objparse(const char *path, ObjData &data);
+// Size of the pieces of the file parsed in parallel by objparse(path, data), split at line ends.
+static constexpr const size_t objparse_chunk_size = 4 * 1024 * 1024;
+
+extern bool objparse(const char *path, ObjData &data, size_t chunk_size = objparse_chunk_size);
 extern bool objparse(std::istream &stream, ObjData &data);
 
 extern bool objbinsave(const char *path, const ObjData &data);
@@ -34,6 +34,7 @@
 #include "SVG.hpp"
 
 #include <tbb/parallel_for.h>
+#include <tbb/pipeline.h>
 
 #include <Shiny/Shiny.h>
 
@@ -687,6 +688,8 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessor::Result* re
     FILE *file = boost::nowide::fopen(path_tmp.c_str(), "wb");
     if (file == nullptr)
         throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n");
+    // The G-code is written in many small chunks, collect them into large blocks before they hit the disk.
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
 
     try {
         m_placeholder_parser_failed_templates.clear();
@@ -1022,6 +1025,17 @@ namespace DoExport {
 	    }
 	    return filament_stats_string_out;
 	}
+
+    // Create the edge grids of the slices of the objects, if the seam placement or avoid crossing perimeters reads them.
+    static void make_lslices_grids(Print &print)
+    {
+        for (PrintObject *object : print.objects()) {
+            const std::vector<ModelVolume*> &volumes = object->model_object()->volumes;
+            if (print.config().avoid_crossing_perimeters.value || object->config().seam_position.value != spRandom ||
+                std::any_of(volumes.begin(), volumes.end(), [](const ModelVolume *v) { return v->is_seam_position(); }))
+                object->make_lslices_grids();
+        }
+    }
 }
 
 // Sort the PrintObjects by their increasing Z, likely useful for avoiding colisions on Deltas during sequential prints.
@@ -1422,10 +1436,9 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
 
     //flush FanMover buffer to avoid modifying the start gcode if it's manual.
     if (this->config().start_gcode_manual && this->m_fan_mover.get() != nullptr) {
-        std::string to_write = this->m_fan_mover.get()->process_gcode("", true);
-        const char* gcode_to_write = to_write.c_str();
+        const std::string &to_write = this->m_fan_mover.get()->process_gcode("", true, m_writer.tool());
         // writes string to file
-        fwrite(gcode_to_write, 1, ::strlen(gcode_to_write), file);
+        fwrite(to_write.data(), 1, to_write.size(), file);
     }
 
     // Process filament-specific gcode.
@@ -1454,6 +1467,9 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
 
     // Collect custom seam data from all objects.
     m_seam_placer.init(print);
+    // Edge grids of the slices shared by the seam placement and avoid crossing perimeters, created in parallel over the layers.
+    DoExport::make_lslices_grids(print);
+    print.throw_if_canceled();
 
     //activate first extruder is multi-extruder and not in start-gcode
     if ((initial_extruder_id != (uint16_t)-1)) {
@@ -1568,7 +1584,7 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
                 for (LayerToPrint &ltp : layers_to_print) {
                     std::vector<LayerToPrint> lrs;
                     lrs.emplace_back(std::move(ltp));
-                    this->process_layer(file, print, print.m_print_statistics, lrs, tool_ordering.tools_for_layer(ltp.print_z()), nullptr, *print_object_instance_sequential_active - object.instances().data());
+                    this->_write_layer(file, this->process_layer(print, print.m_print_statistics, lrs, tool_ordering.tools_for_layer(ltp.print_z()), nullptr, *print_object_instance_sequential_active - object.instances().data()));
                     print.throw_if_canceled();
                 }
 #ifdef HAS_PRESSURE_EQUALIZER
@@ -1629,12 +1645,38 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
                 print.throw_if_canceled();
             }
             // Extrude the layers.
-            for (auto &layer : layers_to_print) {
-                const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
-                if (m_wipe_tower && layer_tools.has_wipe_tower)
-                    m_wipe_tower->next_layer();
-                this->process_layer(file, print, print.m_print_statistics, layer.second, layer_tools, &print_object_instances_ordering, size_t(-1));
-                print.throw_if_canceled();
+            // The layers are generated in order by the first stage of the pipeline, while the second stage post-processes
+            // and writes the layers generated before. Both stages are serial and keep the order of the layers,
+            // and the post-processing does not touch the state of the G-code generator (see LayerResult),
+            // thus the output is the same as if the layers were generated and written one by one.
+            if (! m_pipeline_layers) {
+                // The serial path, the reference for the pipeline.
+                for (auto &layer : layers_to_print) {
+                    const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
+                    if (m_wipe_tower && layer_tools.has_wipe_tower)
+                        m_wipe_tower->next_layer();
+                    this->_write_layer(file, this->process_layer(print, print.m_print_statistics, layer.second, layer_tools, &print_object_instances_ordering, size_t(-1)));
+                    print.throw_if_canceled();
+                }
+            } else {
+                size_t layer_to_print_idx = 0;
+                tbb::parallel_pipeline(8,
+                    tbb::make_filter<void, LayerResult>(tbb::filter::serial_in_order,
+                        [this, &print, &layers_to_print, &layer_to_print_idx, &tool_ordering, &print_object_instances_ordering](tbb::flow_control &fc) -> LayerResult {
+                            if (layer_to_print_idx == layers_to_print.size()) {
+                                fc.stop();
+                                return LayerResult();
+                            }
+                            auto &layer = layers_to_print[layer_to_print_idx ++];
+                            const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
+                            if (m_wipe_tower && layer_tools.has_wipe_tower)
+                                m_wipe_tower->next_layer();
+                            LayerResult result = this->process_layer(print, print.m_print_statistics, layer.second, layer_tools, &print_object_instances_ordering, size_t(-1));
+                            print.throw_if_canceled();
+                            return result;
+                        }) &
+                    tbb::make_filter<LayerResult, void>(tbb::filter::serial_in_order,
+                        [this, file](const LayerResult &layer_result) { this->_write_layer(file, layer_result); }));
             }
 #ifdef HAS_PRESSURE_EQUALIZER
             if (m_pressure_equalizer)
@@ -2203,9 +2245,7 @@ namespace Skirt {
 // In non-sequential mode, process_layer is called per each print_z height with all object and support layers accumulated.
 // For multi-material prints, this routine minimizes extruder switches by gathering extruder specific extrusion paths
 // and performing the extruder specific extrusions together.
-void GCode::process_layer(
-    // Write into the output file.
-    FILE                                    *file,
+GCode::LayerResult GCode::process_layer(
     const Print                             &print,
     PrintStatistics                         &print_stat,
     // Set of object & print layers of the same PrintObject and with the same print_z.
@@ -2221,9 +2261,10 @@ void GCode::process_layer(
     // Either printing all copies of all objects, or just a single copy of a single object.
     assert(single_object_instance_idx == size_t(-1) || layers.size() == 1);
 
+    LayerResult result;
     if (layer_tools.extruders.empty())
         // Nothing to extrude.
-        return;
+        return result;
 
     // Extract 1st object_layer and support_layer of this set of layers with an equal print_z.
     const Layer         *object_layer  = nullptr;
@@ -2508,7 +2549,6 @@ void GCode::process_layer(
     } // for objects
 
     // Extrude the skirt, brim, support, perimeters, infill ordered by the extruders.
-    std::vector<std::unique_ptr<EdgeGrid::Grid>> lower_layer_edge_grids(layers.size());
     for (uint16_t extruder_id : layer_tools.extruders)
     {
         gcode += (layer_tools.has_wipe_tower && m_wipe_tower) ?
@@ -2663,6 +2703,8 @@ void GCode::process_layer(
                     instance_to_print.object_by_extruder.support->chained_path_from(m_last_pos, instance_to_print.object_by_extruder.support_extrusion_role));
                     m_layer = layers[instance_to_print.layer_id].layer();
                 }
+                // Distance field of the layer below for the seam placement, precomputed by PrintObject::make_lslices_grids().
+                const EdgeGrid::Grid *lower_layer_edge_grid = (m_layer == nullptr || m_layer->lower_layer == nullptr) ? nullptr : m_layer->lower_layer->lslices_grid.get();
                 //FIXME order islands?
                 // Sequential tool path ordering of multiple parts within the same object, aka. perimeter tracking (#5511)
                 for (ObjectByExtruder::Island &island : instance_to_print.object_by_extruder.islands) {
@@ -2674,7 +2716,7 @@ void GCode::process_layer(
                             print_wipe_extrusions != 0) : 
                         island.by_region;
                     gcode += this->extrude_infill(print, by_region_specific, true);
-                    gcode += this->extrude_perimeters(print, by_region_specific, lower_layer_edge_grids[instance_to_print.layer_id]);
+                    gcode += this->extrude_perimeters(print, by_region_specific, lower_layer_edge_grid);
                     gcode += this->extrude_infill(print, by_region_specific, false);
                     gcode += this->extrude_ironing(print, by_region_specific);
                 }
@@ -2793,7 +2835,8 @@ void GCode::process_layer(
     // printf("G-code after filter:\n%s\n", out.c_str());
 #endif /* HAS_PRESSURE_EQUALIZER */
 
-    _write(file, gcode);
+    result.gcode = std::move(gcode);
+    result.tool  = m_writer.tool();
     BOOST_LOG_TRIVIAL(trace) << "Exported layer " << layer.id() << " print_z " << print_z <<
         log_memory_info();
 
@@ -2803,6 +2846,7 @@ void GCode::process_layer(
         m_last_status_update = std::chrono::system_clock::now();
         print.set_status(int((layer.id() * 100) / layer_count()), std::string(L("Generating G-code layer %s / %s")), std::vector<std::string>{ std::to_string(layer.id()), std::to_string(layer_count()) }, PrintBase::SlicingStatus::DEFAULT);
     }
+    return result;
 }
 
 void GCode::apply_print_config(const PrintConfig &print_config)
@@ -2905,7 +2949,7 @@ std::string GCode::change_layer(coordf_t print_z)
 
 
 //like extrude_loop but with varying z and two full round
-std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const std::string &description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const std::string &description, double speed, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
     //don't keep the speed
     speed = -1;
@@ -2913,27 +2957,6 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
     // next copies (if any) would not detect the correct orientation
     ExtrusionLoop loop = original_loop;
 
-    if (m_layer->lower_layer != nullptr && lower_layer_edge_grid != nullptr) {
-        if (!*lower_layer_edge_grid) {
-            // Create the distance field for a layer below.
-            const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
-            *lower_layer_edge_grid = make_unique<EdgeGrid::Grid>();
-            (*lower_layer_edge_grid)->create(m_layer->lower_layer->lslices, distance_field_resolution);
-            (*lower_layer_edge_grid)->calculate_sdf();
-#if 0
-            {
-                static int iRun = 0;
-                BoundingBox bbox = (*lower_layer_edge_grid)->bbox();
-                bbox.min(0) -= scale_(5.f);
-                bbox.min(1) -= scale_(5.f);
-                bbox.max(0) += scale_(5.f);
-                bbox.max(1) += scale_(5.f);
-                EdgeGrid::save_png(*(*lower_layer_edge_grid), bbox, scale_(0.1f), debug_out_path("GCode_extrude_loop_edge_grid-%d.png", iRun++));
-            }
-#endif
-        }
-    }
-
     // extrude all loops ccw
     //no! this was decided in perimeter_generator
     bool is_hole_loop = (loop.loop_role() & ExtrusionLoopRole::elrHole) != 0;// loop.make_counter_clockwise();
@@ -3166,7 +3189,7 @@ std::string GCode::extrude_loop_vase(const ExtrusionLoop &original_loop, const s
     return gcode;
 }
 
-void GCode::split_at_seam_pos(ExtrusionLoop& loop, std::unique_ptr<EdgeGrid::Grid>* lower_layer_edge_grid, bool was_clockwise)
+void GCode::split_at_seam_pos(ExtrusionLoop& loop, const EdgeGrid::Grid* lower_layer_edge_grid, bool was_clockwise)
 {
     if (loop.paths.empty())
         return;
@@ -3181,13 +3204,10 @@ void GCode::split_at_seam_pos(ExtrusionLoop& loop, std::unique_ptr<EdgeGrid::Gri
     if (m_config.spiral_vase) {
         loop.split_at(last_pos, false);
     } else {
-        const EdgeGrid::Grid* edge_grid_ptr = (lower_layer_edge_grid && *lower_layer_edge_grid)
-            ? lower_layer_edge_grid->get()
-            : nullptr;
         Point seam = m_seam_placer.get_seam(*m_layer, seam_position, loop,
             last_pos, EXTRUDER_CONFIG_WITH_DEFAULT(nozzle_diameter, 0),
             (m_layer == NULL ? nullptr : m_layer->object()),
-            was_clockwise, edge_grid_ptr);
+            was_clockwise, lower_layer_edge_grid);
         // Split the loop at the point with a minium penalty.
         if (!loop.split_at_vertex(seam))
             // The point is not in the original loop. Insert it.
@@ -3196,7 +3216,7 @@ void GCode::split_at_seam_pos(ExtrusionLoop& loop, std::unique_ptr<EdgeGrid::Gri
 }
 
 
-std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::string &description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::string &description, double speed, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
 #if DEBUG_EXTRUSION_OUTPUT
     std::cout << "extrude loop_" << (original_loop.polygon().is_counter_clockwise() ? "ccw" : "clw") << ": ";
@@ -3224,27 +3244,6 @@ std::string GCode::extrude_loop(const ExtrusionLoop &original_loop, const std::s
     // next copies (if any) would not detect the correct orientation
     ExtrusionLoop loop = original_loop;
 
-    if (m_layer->lower_layer != nullptr && lower_layer_edge_grid != nullptr) {
-        if (! *lower_layer_edge_grid) {
-            // Create the distance field for a layer below.
-            const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
-            *lower_layer_edge_grid = make_unique<EdgeGrid::Grid>();
-            (*lower_layer_edge_grid)->create(m_layer->lower_layer->lslices, distance_field_resolution);
-            (*lower_layer_edge_grid)->calculate_sdf();
-            #if 0
-            {
-                static int iRun = 0;
-                BoundingBox bbox = (*lower_layer_edge_grid)->bbox();
-                bbox.min(0) -= scale_(5.f);
-                bbox.min(1) -= scale_(5.f);
-                bbox.max(0) += scale_(5.f);
-                bbox.max(1) += scale_(5.f);
-                EdgeGrid::save_png(*(*lower_layer_edge_grid), bbox, scale_(0.1f), debug_out_path("GCode_extrude_loop_edge_grid-%d.png", iRun++));
-            }
-            #endif
-        }
-    }
-
     // extrude all loops ccw
     //no! this was decided in perimeter_generator
     //but we need to know where is "inside", so we will use is_hole_loop. if is_hole_loop, then we need toconsider that the right direction is clockwise, else counter clockwise. 
@@ -3434,7 +3433,7 @@ std::string GCode::extrude_multi_path3D(const ExtrusionMultiPath3D &multipath3D,
     return gcode;
 }
 
-std::string GCode::extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
     this->visitor_gcode.clear();
     this->visitor_comment = description;
@@ -3537,7 +3536,7 @@ std::string GCode::extrude_path_3D(const ExtrusionPath3D &path, const std::strin
 }
 
 // Extrude perimeters: Decide where to put seams (hide or align seams).
-std::string GCode::extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, std::unique_ptr<EdgeGrid::Grid> &lower_layer_edge_grid)
+std::string GCode::extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, const EdgeGrid::Grid *lower_layer_edge_grid)
 {
     std::string gcode;
     for (const ObjectByExtruder::Island::Region &region : by_region)
@@ -3551,7 +3550,7 @@ std::string GCode::extrude_perimeters(const Print &print, const std::vector<Obje
             else if (m_config.temperature.get_at(m_writer.tool()->id()) > 0) // don't set it if disabled
                 gcode += m_writer.set_temperature(m_config.temperature.get_at(m_writer.tool()->id()), false, m_writer.tool()->id());
             for (const ExtrusionEntity *ee : region.perimeters)
-                gcode += this->extrude_entity(*ee, "", -1., &lower_layer_edge_grid);
+                gcode += this->extrude_entity(*ee, "", -1., lower_layer_edge_grid);
         }
     return gcode;
 }
@@ -3634,7 +3633,7 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
 }
 
 
-void GCode::_post_process(std::string& what, bool flush) {
+std::string_view GCode::_post_process(std::string_view what, bool flush, const Tool* tool) {
 
     //if enabled, move the fan startup earlier.
     if (this->config().fan_speedup_time.value != 0 || this->config().fan_kickstart.value > 0) {
@@ -3646,28 +3645,42 @@ void GCode::_post_process(std::string& what, bool flush) {
                 this->config().use_relative_e_distances.value,
                 this->config().fan_speedup_overhangs.value,
                 (float)this->config().fan_kickstart.value));
-        what = this->m_fan_mover->process_gcode(what, flush);
+        // The GCodeReader needs a zero terminated string, reuse the same buffer for all the calls.
+        m_post_process_buffer.assign(what.data(), what.size());
+        return this->m_fan_mover->process_gcode(m_post_process_buffer, flush, tool);
     }
+    // No post-processing enabled, pass the G-code through.
+    return what;
+}
 
+void GCode::_write(FILE* file, std::string_view what, bool flush /*=false*/)
+{
+    // Empty strings are post-processed as well, the first write sets up the FanMover.
+    std::string_view gcode = _post_process(what, flush, m_writer.tool());
+    // writes string to file
+    fwrite(gcode.data(), 1, gcode.size(), file);
 }
 
-void GCode::_write(FILE* file, const char *what, bool flush /*=false*/)
+void GCode::_write_layer(FILE* file, const LayerResult &layer_result)
 {
-    if (what != nullptr) {
-        
-        //const char * gcode_pp = _post_process(what).c_str();
-        std::string str_preproc{ what };
-        _post_process(str_preproc, flush);
-        const char* gcode = str_preproc.c_str();
-        // writes string to file
-        fwrite(gcode, 1, ::strlen(gcode), file);
+    if (! layer_result.gcode.empty()) {
+        std::string_view gcode = _post_process(layer_result.gcode, false, layer_result.tool);
+        fwrite(gcode.data(), 1, gcode.size(), file);
     }
 }
 
 void GCode::_writeln(FILE* file, const std::string &what)
 {
-    if (! what.empty())
-        _write(file, (what.back() == '\n') ? what : (what + '\n'));
+    if (! what.empty()) {
+        if (what.back() == '\n') {
+            _write(file, what);
+        } else {
+            // Append the newline into a reused buffer, so that the post-processing sees a complete line.
+            m_writeln_buffer.assign(what);
+            m_writeln_buffer += '\n';
+            _write(file, m_writeln_buffer);
+        }
+    }
 }
 
 void GCode::_write_format(FILE* file, const char* format, ...)
@@ -3694,7 +3707,7 @@ void GCode::_write_format(FILE* file, const char* format, ...)
     char *bufptr = buffer_dynamic ? (char*)malloc(buflen) : buffer;
     int res = ::vsnprintf(bufptr, buflen, format, args);
     if (res > 0)
-        _write(file, bufptr);
+        _write(file, std::string_view(bufptr, std::min(res, buflen - 1)));
 
     if (buffer_dynamic)
         free(bufptr);
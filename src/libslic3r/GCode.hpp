@@ -23,6 +23,7 @@
 #include <memory>
 #include <map>
 #include <string>
+#include <string_view>
 #include <chrono>
 
 #ifdef HAS_PRESSURE_EQUALIZER
@@ -154,6 +155,9 @@ public:
     // throws std::runtime_exception on error,
     // throws CanceledException through print->throw_if_canceled().
     void            do_export(Print* print, const char* path, GCodeProcessor::Result* result = nullptr, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
+    // Write the layers of a non-sequential print one by one instead of overlapping the generation of a layer
+    // with the post-processing and writing of the previous layers. Used to compare the output of the two paths.
+    void            set_pipeline_layers(bool enable) { m_pipeline_layers = enable; }
 
     // Exported for the helper classes (OozePrevention, Wipe) and for the Perl binding for unit tests.
     const Vec2d&    origin() const { return m_origin; }
@@ -205,9 +209,14 @@ private:
 
     static std::vector<LayerToPrint>        		                   collect_layers_to_print(const PrintObject &object);
     static std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>> collect_layers_to_print(const Print &print);
-    void            process_layer(
-        // Write into the output file.
-        FILE                            *file,
+    // G-code of a single layer, generated by process_layer() and passed to _write_layer().
+    struct LayerResult {
+        std::string  gcode;
+        // Tool active at the end of the layer. The post-processors run while the next layer is being generated,
+        // they must not read the current tool from m_writer.
+        const Tool  *tool { nullptr };
+    };
+    LayerResult     process_layer(
         const Print                     &print,
         PrintStatistics                 &print_stat,
         // Set of object & print layers of the same PrintObject and with the same print_z.
@@ -228,21 +237,21 @@ private:
     std::string     visitor_gcode;
     std::string     visitor_comment;
     double          visitor_speed;
-    std::unique_ptr<EdgeGrid::Grid> *visitor_lower_layer_edge_grid;
+    const EdgeGrid::Grid *visitor_lower_layer_edge_grid;
     virtual void use(const ExtrusionPath &path) override { visitor_gcode += extrude_path(path, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionPath3D &path3D) override { visitor_gcode += extrude_path_3D(path3D, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionMultiPath &multipath) override { visitor_gcode += extrude_multi_path(multipath, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionMultiPath3D &multipath) override { visitor_gcode += extrude_multi_path3D(multipath, visitor_comment, visitor_speed); };
     virtual void use(const ExtrusionLoop &loop) override { visitor_gcode += extrude_loop(loop, visitor_comment, visitor_speed, visitor_lower_layer_edge_grid); };
     virtual void use(const ExtrusionEntityCollection &collection) override;
-    std::string     extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
-    std::string     extrude_loop(const ExtrusionLoop &loop, const std::string &description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
-    std::string     extrude_loop_vase(const ExtrusionLoop &loop, const std::string &description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
+    std::string     extrude_entity(const ExtrusionEntity &entity, const std::string &description, double speed = -1., const EdgeGrid::Grid *lower_layer_edge_grid = nullptr);
+    std::string     extrude_loop(const ExtrusionLoop &loop, const std::string &description, double speed = -1., const EdgeGrid::Grid *lower_layer_edge_grid = nullptr);
+    std::string     extrude_loop_vase(const ExtrusionLoop &loop, const std::string &description, double speed = -1., const EdgeGrid::Grid *lower_layer_edge_grid = nullptr);
     std::string     extrude_multi_path(const ExtrusionMultiPath &multipath, const std::string &description, double speed = -1.);
     std::string     extrude_multi_path3D(const ExtrusionMultiPath3D &multipath, const std::string &description, double speed = -1.);
     std::string     extrude_path(const ExtrusionPath &path, const std::string &description, double speed = -1.);
     std::string     extrude_path_3D(const ExtrusionPath3D &path, const std::string &description, double speed = -1.);
-    void            split_at_seam_pos(ExtrusionLoop &loop, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid, bool was_clockwise);
+    void            split_at_seam_pos(ExtrusionLoop &loop, const EdgeGrid::Grid *lower_layer_edge_grid, bool was_clockwise);
 
     // Extruding multiple objects with soluble / non-soluble / combined supports
     // on a multi-material printer, trying to minimize tool switches.
@@ -311,7 +320,7 @@ private:
 		// For sequential print, the instance of the object to be printing has to be defined.
 		const size_t                     				 single_object_instance_idx);
 
-    std::string     extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, std::unique_ptr<EdgeGrid::Grid> &lower_layer_edge_grid);
+    std::string     extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, const EdgeGrid::Grid *lower_layer_edge_grid);
     std::string     extrude_infill(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region, bool is_infill_first);
     std::string     extrude_ironing(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region);
     std::string     extrude_support(const ExtrusionEntityCollection &support_fills);
@@ -417,6 +426,8 @@ private:
     void _add_object_change_labels(std::string &gcode);
 
     bool m_silent_time_estimator_enabled;
+    // Generate and write the layers of a non-sequential print through a pipeline, see set_pipeline_layers().
+    bool m_pipeline_layers { true };
 
     //for gui status update
     std::chrono::time_point<std::chrono::system_clock> m_last_status_update;
@@ -425,8 +436,12 @@ private:
     GCodeProcessor m_processor;
 
     // Write a string into a file.
-    void _write(FILE* file, const std::string& what, bool flush = false) { this->_write(file, what.c_str(), flush); }
-    void _write(FILE* file, const char *what, bool flush = false);
+    // The string is passed through the post-processing without being copied, unless a post-processor is enabled.
+    void _write(FILE* file, const std::string& what, bool flush = false) { this->_write(file, std::string_view(what), flush); }
+    void _write(FILE* file, const char *what, bool flush = false) { if (what != nullptr) this->_write(file, std::string_view(what), flush); }
+    void _write(FILE* file, std::string_view what, bool flush = false);
+    // Post-process and write the G-code of a layer, may run in parallel with process_layer() of the next layer.
+    void _write_layer(FILE* file, const LayerResult &layer_result);
 
     // Write a string into a file. 
     // Add a newline, if the string does not end with a newline already.
@@ -438,7 +453,12 @@ private:
 
     //some post-processing on the file, with their data class
     std::unique_ptr<FanMover> m_fan_mover;
-    void _post_process(std::string& what, bool flush = true);
+    // Returns the post-processed G-code, either what itself or a view into a buffer owned by the post-processor,
+    // valid until the next call.
+    std::string_view _post_process(std::string_view what, bool flush, const Tool* tool);
+    // Buffers reused between the _write() calls to avoid allocating for each chunk of G-code.
+    std::string m_post_process_buffer;
+    std::string m_writeln_buffer;
 
     std::string _extrude(const ExtrusionPath &path, const std::string &description, double speed = -1);
     std::string _before_extrude(const ExtrusionPath &path, const std::string &description, double speed = -1);
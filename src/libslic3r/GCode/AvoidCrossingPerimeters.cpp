@@ -1077,7 +1077,7 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
     } else if (max_detour_length_exceeded) {
         *could_be_wipe_disabled = false;
     } else
-        *could_be_wipe_disabled = !need_wipe(gcodegen, m_grid_lslice, travel, result_pl, travel_intersection_count);
+        *could_be_wipe_disabled = !need_wipe(gcodegen, *m_grid_lslice, travel, result_pl, travel_intersection_count);
 
     return result_pl;
 }
@@ -1089,12 +1089,18 @@ void AvoidCrossingPerimeters::init_layer(const Layer &layer)
     m_internal.clear();
     m_external.clear();
 
-    BoundingBox bbox_slice(get_extents(layer.lslices));
-    bbox_slice.offset(SCALED_EPSILON);
-
-    m_grid_lslice.set_bbox(bbox_slice);
-    //FIXME 1mm grid?
-    m_grid_lslice.create(layer.lslices, coord_t(scale_(1.)));
+    if (layer.lslices_grid) {
+        m_grid_lslice = layer.lslices_grid.get();
+    } else {
+        // Support layers and the layers of objects not needing the grids have no precomputed grid.
+        BoundingBox bbox_slice(get_extents(layer.lslices));
+        bbox_slice.offset(SCALED_EPSILON);
+
+        m_grid_lslice_data.set_bbox(bbox_slice);
+        //FIXME 1mm grid?
+        m_grid_lslice_data.create(layer.lslices, coord_t(scale_(1.)));
+        m_grid_lslice = &m_grid_lslice_data;
+    }
     m_init = true;
 }
 
@@ -1342,7 +1348,7 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
         result_pl.translate(-scaled_origin);
         *could_be_wipe_disabled = false;
     } else
-        *could_be_wipe_disabled = !need_wipe(gcodegen, m_grid_lslice, travel, result_pl, travel_intersection_count);
+        *could_be_wipe_disabled = !need_wipe(gcodegen, *m_grid_lslice, travel, result_pl, travel_intersection_count);
 
     return result_pl;
 }
@@ -1480,9 +1486,15 @@ void AvoidCrossingPerimeters::init_layer(const Layer &layer)
     m_external.grid.set_bbox(bbox_external);
     //FIX1ME 1mm grid?
     m_external.grid.create(m_external.boundaries, coord_t(scale_(1.)));
-    m_grid_lslice.set_bbox(bbox_slice);
-    //FIX1ME 1mm grid?
-    m_grid_lslice.create(layer.lslices, coord_t(scale_(1.)));
+    if (layer.lslices_grid) {
+        m_grid_lslice = layer.lslices_grid.get();
+    } else {
+        // Support layers and the layers of objects not needing the grids have no precomputed grid.
+        m_grid_lslice_data.set_bbox(bbox_slice);
+        //FIX1ME 1mm grid?
+        m_grid_lslice_data.create(layer.lslices, coord_t(scale_(1.)));
+        m_grid_lslice = &m_grid_lslice_data;
+    }
 
     init_boundary_distances(&m_internal);
     init_boundary_distances(&m_external);
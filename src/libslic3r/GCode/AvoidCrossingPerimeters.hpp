@@ -64,7 +64,9 @@ private:
     bool m_init{ false };
 
     // Used for detection of line or polyline is inside of any polygon.
-    EdgeGrid::Grid m_grid_lslice;
+    // Points to the grid precomputed by PrintObject::make_lslices_grids() if available, otherwise to m_grid_lslice_data.
+    const EdgeGrid::Grid *m_grid_lslice { nullptr };
+    EdgeGrid::Grid        m_grid_lslice_data;
     // Store all needed data for travels inside object
     Boundary m_internal;
     // Store all needed data for travels outside object
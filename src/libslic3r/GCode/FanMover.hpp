@@ -38,7 +38,9 @@ private:
     const float kickstart;
 
     GCodeReader m_parser{};
-    GCodeWriter& m_writer;
+    const GCodeWriter& m_writer;
+    // Tool active when the G-code being processed was generated, its fan offset is applied to the moved fan commands.
+    const Tool* m_tool = nullptr;
 
     //current value (at the back of the buffer), when parsing a new line
     ExtrusionRole current_role = ExtrusionRole::erCustom;
@@ -59,7 +61,7 @@ private:
     std::string m_process_output;
 
 public:
-    FanMover(GCodeWriter& writer, const float nb_seconds_delay, const bool with_D_option, const bool relative_e,
+    FanMover(const GCodeWriter& writer, const float nb_seconds_delay, const bool with_D_option, const bool relative_e,
         const bool only_overhangs, const float kickstart)
         : regex_fan_speed("S[0-9]+"), 
         nb_seconds_delay(nb_seconds_delay>0 ? std::max(0.01f,nb_seconds_delay) : 0),
@@ -67,7 +69,8 @@ public:
         , relative_e(relative_e), only_overhangs(only_overhangs), kickstart(kickstart), m_writer(writer){}
 
     // Adds the gcode contained in the given string to the analysis and returns it after removing the workcodes
-    const std::string& process_gcode(const std::string& gcode, bool flush);
+    // tool is the tool active at the end of the given gcode (null if no toolchange done yet).
+    const std::string& process_gcode(const std::string& gcode, bool flush, const Tool* tool);
 
 private:
     BufferData& put_in_buffer(BufferData&& data) {
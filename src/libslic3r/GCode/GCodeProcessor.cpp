@@ -333,22 +333,23 @@ void GCodeProcessor::TimeProcessor::reset()
 
 void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
 {
-    boost::nowide::ifstream in(filename);
-    if (!in.good())
+    FILE* in = boost::nowide::fopen(filename.c_str(), "rb");
+    if (in == nullptr)
         throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for reading.\n"));
 
     // temporary file to contain modified gcode
     std::string out_path = filename + ".postprocess";
     FILE* out = boost::nowide::fopen(out_path.c_str(), "wb");
-    if (out == nullptr)
+    if (out == nullptr) {
+        fclose(in);
         throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for writing.\n"));
+    }
+    setvbuf(out, nullptr, _IOFBF, 1 << 20);
 
     auto time_in_minutes = [](float time_in_seconds) {
         return int(::roundf(time_in_seconds / 60.0f));
     };
 
-    GCodeReader parser;
-    std::string gcode_line;
     size_t g1_lines_counter = 0;
     // keeps track of last exported pair <percent, remaining time>
     std::array<std::pair<int, int>, static_cast<size_t>(PrintEstimatedTimeStatistics::ETimeMode::Count)> last_exported;
@@ -356,14 +357,11 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
         last_exported[i] = { 0, time_in_minutes(machines[i].time) };
     }
 
-    // buffer line to export only when greater than 64K to reduce writing calls
+    // lines inserted before the current line
     std::string export_line;
 
-    // replace placeholder lines with the proper final value
-    auto process_placeholders = [&](const std::string& gcode_line) {
-        // remove trailing '\n'
-        std::string line = gcode_line.substr(0, gcode_line.length() - 1);
-
+    // replace placeholder lines with the proper final value, returns an empty string if the line is not a placeholder
+    auto process_placeholders = [&](const std::string_view line) {
         std::string ret;
 
         if (export_remaining_time_enabled && (line == First_Line_M73_Placeholder_Tag || line == Last_Line_M73_Placeholder_Tag)) {
@@ -404,15 +402,11 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
             }
         }
 
-        return std::make_pair(!ret.empty(), ret.empty() ? gcode_line : ret);
+        return ret;
     };
 
-    // check for temporary lines
+    // check for temporary lines (without the trailing '\n')
     auto is_temporary_decoration = [](const std::string_view gcode_line) {
-        // remove trailing '\n'
-        assert(! gcode_line.empty());
-        assert(gcode_line.back() == '\n');
-
         // return true for decorations which are used in processing the gcode but that should not be exported into the final gcode
         // i.e.:
         // bool ret = gcode_line.substr(0, gcode_line.length() - 1) == ";" + Layer_Change_Tag;
@@ -462,52 +456,64 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
     };
 
     // helper function to write to disk
-    auto write_string = [&](const std::string& str) {
-        fwrite((const void*)export_line.c_str(), 1, export_line.length(), out);
+    auto write_string = [&](const char* data, size_t length) {
+        fwrite((const void*)data, 1, length, out);
         if (ferror(out)) {
-            in.close();
+            fclose(in);
             fclose(out);
             boost::nowide::remove(out_path.c_str());
             throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nIs the disk full?\n"));
         }
-        export_line.clear();
     };
 
-    while (std::getline(in, gcode_line)) {
-        if (!in.good()) {
-            fclose(out);
-            throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nError while reading from file.\n"));
-        }
-
-        gcode_line += "\n";
-        // replace placeholder lines
-        auto [processed, result] = process_placeholders(gcode_line);
-        gcode_line = result;
-        if (!processed) {
-            // remove temporary lines
-            if (is_temporary_decoration(gcode_line))
-                continue;
-
-            // add lines M73 where needed
-            parser.parse_line(gcode_line,
-                [&](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
-                    if (line.cmd_is("G1")) {
-                        process_line_G1();
-                        ++g1_lines_counter;
-                    }
-                });
+    // The file is read in large blocks of lines. The unmodified lines are written directly from the block,
+    // only the inserted or replaced lines are formatted.
+    bool read_ok = GCodeReader::read_file_blocks(in, [&](const char* begin, const char* end) {
+        // start of the lines not yet written
+        const char* run_begin = begin;
+        for (const char* line_begin = begin; line_begin != end;) {
+            const char* line_end = static_cast<const char*>(memchr(line_begin, '\n', end - line_begin));
+            const char* next_line = (line_end == nullptr) ? end : line_end + 1;
+            if (line_end == nullptr)
+                line_end = end;
+            const std::string_view line(line_begin, line_end - line_begin);
+            // replace placeholder lines
+            std::string replacement = process_placeholders(line);
+            if (! replacement.empty()) {
+                write_string(run_begin, line_begin - run_begin);
+                write_string(replacement.data(), replacement.size());
+                run_begin = next_line;
+            } else if (is_temporary_decoration(line)) {
+                // remove temporary lines
+                write_string(run_begin, line_begin - run_begin);
+                run_begin = next_line;
+            } else if (GCodeReader::cmd_is(line_begin, "G1")) {
+                // add lines M73 where needed
+                process_line_G1();
+                ++g1_lines_counter;
+                if (! export_line.empty()) {
+                    write_string(run_begin, line_begin - run_begin);
+                    write_string(export_line.data(), export_line.size());
+                    export_line.clear();
+                    run_begin = line_begin;
+                }
+            }
+            line_begin = next_line;
         }
-
-        export_line += gcode_line;
-        if (export_line.length() > 65535)
-            write_string(export_line);
+        write_string(run_begin, end - run_begin);
+        // the last line of the file may miss its newline
+        if (run_begin != end && *(end - 1) != '\n')
+            write_string("\n", 1);
+    });
+    if (! read_ok) {
+        fclose(in);
+        fclose(out);
+        boost::nowide::remove(out_path.c_str());
+        throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nError while reading from file.\n"));
     }
 
-    if (!export_line.empty())
-        write_string(export_line);
-
     fclose(out);
-    in.close();
+    fclose(in);
 
     std::error_code err_code;
     if (err_code = rename_file(out_path, filename)) {
@@ -519,6 +525,119 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename)
     }
 }
 
+void GCodeProcessor::MoveVertices::reserve(size_t n)
+{
+    m_types.reserve(n);
+    m_roles.reserve(n);
+    m_extruder_ids.reserve(n);
+    m_cp_color_ids.reserve(n);
+    m_positions.reserve(n);
+    m_delta_extruders.reserve(n);
+    m_feedrates.reserve(n);
+    m_widths.reserve(n);
+    m_heights.reserve(n);
+    m_mm3_per_mms.reserve(n);
+    m_fan_speeds.reserve(n);
+    m_times.reserve(n);
+    m_temperatures.reserve(n);
+    m_layer_ids.reserve(n);
+}
+
+void GCodeProcessor::MoveVertices::clear()
+{
+    *this = MoveVertices();
+}
+
+int64_t GCodeProcessor::MoveVertices::memsize() const
+{
+    return SLIC3R_STDVEC_MEMSIZE(m_types, EMoveType) +
+        SLIC3R_STDVEC_MEMSIZE(m_roles, ExtrusionRole) +
+        SLIC3R_STDVEC_MEMSIZE(m_extruder_ids, unsigned char) +
+        SLIC3R_STDVEC_MEMSIZE(m_cp_color_ids, unsigned char) +
+        SLIC3R_STDVEC_MEMSIZE(m_positions, Vec3f) +
+        SLIC3R_STDVEC_MEMSIZE(m_delta_extruders, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_feedrates, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_widths, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_heights, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_mm3_per_mms, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_fan_speeds, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_times, float) +
+        SLIC3R_STDVEC_MEMSIZE(m_temperatures, CompactFloat) +
+        SLIC3R_STDVEC_MEMSIZE(m_layer_ids, unsigned int) +
+        SLIC3R_STDVEC_MEMSIZE(m_layer_durations, float) +
+        SLIC3R_STDVEC_MEMSIZE(m_layers, LayerRange);
+}
+
+void GCodeProcessor::MoveVertices::push_back(const MoveVertex& move, unsigned int layer_id)
+{
+    size_t idx = m_types.size();
+    m_types.emplace_back(move.type);
+    m_roles.emplace_back(move.extrusion_role);
+    m_extruder_ids.emplace_back(move.extruder_id);
+    m_cp_color_ids.emplace_back(move.cp_color_id);
+    m_positions.emplace_back(move.position);
+    m_delta_extruders.emplace_back(CompactFloat(move.delta_extruder));
+    m_feedrates.emplace_back(CompactFloat(move.feedrate));
+    m_widths.emplace_back(CompactFloat(move.width));
+    m_heights.emplace_back(CompactFloat(move.height));
+    m_mm3_per_mms.emplace_back(CompactFloat(move.mm3_per_mm));
+    m_fan_speeds.emplace_back(CompactFloat(move.fan_speed));
+    m_times.emplace_back(move.time);
+    m_temperatures.emplace_back(CompactFloat(move.temperature));
+    m_layer_ids.emplace_back(layer_id);
+
+    if (layer_id >= m_layers.size())
+        m_layers.resize(layer_id + 1);
+    LayerRange& range = m_layers[layer_id];
+    range.first = std::min(range.first, idx);
+    range.last  = idx;
+
+    // Ranges of the values before they are quantized to CompactFloat.
+    if (idx == 0)
+        return;
+    switch (move.type)
+    {
+    case EMoveType::Extrude:
+    {
+        m_value_ranges.height.update_from(round_to_nearest(move.height, 2));
+        m_value_ranges.width.update_from(round_to_nearest(move.width, 2));
+        m_value_ranges.fan_speed.update_from(move.fan_speed);
+        m_value_ranges.volumetric_rate.update_from(round_to_nearest(move.volumetric_rate(), 2));
+        m_value_ranges.temperature.update_from(move.temperature);
+        m_value_ranges.extrude_feedrate.update_from(move.feedrate);
+        m_value_ranges.feedrate.update_from(move.feedrate);
+        break;
+    }
+    case EMoveType::Travel:
+    {
+        m_value_ranges.travel_feedrate.update_from(move.feedrate);
+        m_value_ranges.feedrate.update_from(move.feedrate);
+        break;
+    }
+    default: { break; }
+    }
+}
+
+GCodeProcessor::MoveVertex GCodeProcessor::MoveVertices::operator[](size_t idx) const
+{
+    return {
+        m_types[idx],
+        m_roles[idx],
+        m_extruder_ids[idx],
+        m_cp_color_ids[idx],
+        m_positions[idx],
+        this->delta_extruder(idx),
+        this->feedrate(idx),
+        this->width(idx),
+        this->height(idx),
+        this->mm3_per_mm(idx),
+        this->fan_speed(idx),
+        this->layer_duration(idx),
+        m_times[idx],
+        this->temperature(idx)
+    };
+}
+
 const std::vector<std::pair<GCodeProcessor::EProducer, std::string>> GCodeProcessor::Producers = {
     { EProducer::PrusaSlicer, "PrusaSlicer" },
     { EProducer::SuperSlicer, "SuperSlicer" },
@@ -922,7 +1041,7 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
     // process gcode
     m_result.id = ++s_result_id;
     // 1st move must be a dummy move
-    m_result.moves.emplace_back(MoveVertex());
+    m_result.moves.push_back(MoveVertex(), 0);
     m_parser.parse_file(filename, [this, cancel_callback, &last_cancel_callback_time](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
         if (cancel_callback != nullptr) {
             // call the cancel callback every 100 ms
@@ -936,10 +1055,10 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
         });
 
     // update width/height of wipe moves
-    for (MoveVertex& move : m_result.moves) {
-        if (move.type == EMoveType::Wipe) {
-            move.width = Wipe_Width;
-            move.height = Wipe_Height;
+    for (size_t i = 0; i < m_result.moves.size(); ++i) {
+        if (m_result.moves.type(i) == EMoveType::Wipe) {
+            m_result.moves.set_width(i, Wipe_Width);
+            m_result.moves.set_height(i, Wipe_Height);
         }
     }
 
@@ -959,15 +1078,7 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
         m_time_processor.post_process(filename);
 
     //update times for results
-    for (size_t i = 0; i < m_result.moves.size(); i++) {
-        //field layer_duration contains the layer id for the move in which the layer_duration has to be set.
-        size_t layer_id = size_t(m_result.moves[i].layer_duration);
-        std::vector<float>& layer_times = m_result.time_statistics.modes[0].layers_times;
-        if (layer_times.size() > layer_id - 1 && layer_id > 0)
-            m_result.moves[i].layer_duration = layer_times[layer_id - 1];
-        else
-            m_result.moves[i].layer_duration = 0;
-}
+    m_result.moves.set_layer_durations(m_result.time_statistics.modes[0].layers_times);
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
     m_mm3_per_mm_compare.output();
     m_height_compare.output();
@@ -2694,11 +2805,11 @@ void GCodeProcessor::store_move_vertex(EMoveType type)
         m_height,
         m_mm3_per_mm,
         m_fan_speed,
-        float(m_layer_id), //layer_duration: set later
+        0.0f, //layer_duration: stored per layer
         m_time_processor.machines[0].time, //time: set later
         m_temperature
     };
-    m_result.moves.emplace_back(vertex);
+    m_result.moves.push_back(vertex, m_layer_id);
 }
 
 float GCodeProcessor::minimum_feedrate(PrintEstimatedTimeStatistics::ETimeMode mode, float feedrate) const
@@ -6,9 +6,11 @@
 #include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/PrintConfig.hpp"
 #include "libslic3r/CustomGCode.hpp"
+#include "libslic3r/GCode/ValueRange.hpp"
 
 #include <cstdint>
 #include <array>
+#include <limits>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -278,6 +280,110 @@ namespace Slic3r {
             float volumetric_rate() const { return feedrate * mm3_per_mm; }
         };
 
+        // Moves stored column by column (structure of arrays), so that a pass over the moves reads only the columns it needs.
+        // The layer duration is stored once per layer, the moves keep the id of their layer.
+        class MoveVertices
+        {
+        public:
+#if ENABLE_GCODE_MOVES_HALF_PRECISION
+            // Values used for coloring and for the legend only, 3 significant digits are enough.
+            using CompactFloat = Eigen::half;
+#else
+            using CompactFloat = float;
+#endif // ENABLE_GCODE_MOVES_HALF_PRECISION
+
+            // Range of the moves of a layer, last is inclusive.
+            struct LayerRange
+            {
+                size_t first{ std::numeric_limits<size_t>::max() };
+                size_t last{ 0 };
+
+                bool empty() const { return first > last; }
+            };
+
+            // Ranges of the quantized columns of the extrusion moves (the first dummy move excluded), accumulated in full precision,
+            // height, width and volumetric rate rounded to 2 significant digits.
+            struct ValueRanges
+            {
+                ValueRange height;
+                ValueRange width;
+                ValueRange fan_speed;
+                ValueRange volumetric_rate;
+                ValueRange temperature;
+                // Feedrates of the extrusion moves, of the travel moves and of both, in the order of the moves.
+                ValueRange extrude_feedrate;
+                ValueRange travel_feedrate;
+                ValueRange feedrate;
+            };
+
+            size_t size() const { return m_types.size(); }
+            bool   empty() const { return m_types.empty(); }
+            void   reserve(size_t n);
+            // Release the memory of all the columns.
+            void   clear();
+            // Size of the allocated memory in bytes.
+            int64_t memsize() const;
+
+            // Move vertex with the given layer id, the layer id is expected to be nondecreasing.
+            void   push_back(const MoveVertex& move, unsigned int layer_id);
+            // Gathers all the columns of a move, prefer the columns accessors in loops over all the moves.
+            MoveVertex operator[](size_t idx) const;
+
+            const std::vector<EMoveType>&     types() const     { return m_types; }
+            const std::vector<ExtrusionRole>& roles() const     { return m_roles; }
+            const std::vector<unsigned char>& extruder_ids() const { return m_extruder_ids; }
+            const std::vector<Vec3f>&         positions() const { return m_positions; }
+            const std::vector<float>&         times() const     { return m_times; }
+            const std::vector<unsigned int>&  layer_ids() const { return m_layer_ids; }
+
+            EMoveType      type(size_t idx) const           { return m_types[idx]; }
+            ExtrusionRole  extrusion_role(size_t idx) const { return m_roles[idx]; }
+            unsigned char  extruder_id(size_t idx) const    { return m_extruder_ids[idx]; }
+            unsigned char  cp_color_id(size_t idx) const    { return m_cp_color_ids[idx]; }
+            const Vec3f&   position(size_t idx) const       { return m_positions[idx]; }
+            float          delta_extruder(size_t idx) const { return float(m_delta_extruders[idx]); }
+            float          feedrate(size_t idx) const       { return float(m_feedrates[idx]); }
+            float          width(size_t idx) const          { return float(m_widths[idx]); }
+            float          height(size_t idx) const         { return float(m_heights[idx]); }
+            float          mm3_per_mm(size_t idx) const     { return float(m_mm3_per_mms[idx]); }
+            float          fan_speed(size_t idx) const      { return float(m_fan_speeds[idx]); }
+            float          time(size_t idx) const           { return m_times[idx]; }
+            float          temperature(size_t idx) const    { return float(m_temperatures[idx]); }
+            float          volumetric_rate(size_t idx) const { return this->feedrate(idx) * this->mm3_per_mm(idx); }
+            float          layer_duration(size_t idx) const {
+                unsigned int layer_id = m_layer_ids[idx];
+                return (layer_id > 0 && layer_id <= m_layer_durations.size()) ? m_layer_durations[layer_id - 1] : 0.0f;
+            }
+
+            void set_width(size_t idx, float width)   { m_widths[idx] = CompactFloat(width); }
+            void set_height(size_t idx, float height) { m_heights[idx] = CompactFloat(height); }
+            // Durations of the layers, indexed by layer id - 1.
+            void set_layer_durations(std::vector<float> durations) { m_layer_durations = std::move(durations); }
+
+            // Ranges of the moves of each layer, indexed by layer id. Layers without any move have an empty range.
+            const std::vector<LayerRange>& layers() const { return m_layers; }
+            const ValueRanges&             value_ranges() const { return m_value_ranges; }
+
+        private:
+            std::vector<EMoveType>     m_types;
+            std::vector<ExtrusionRole> m_roles;
+            std::vector<unsigned char> m_extruder_ids;
+            std::vector<unsigned char> m_cp_color_ids;
+            std::vector<Vec3f>         m_positions;
+            std::vector<CompactFloat>  m_delta_extruders;
+            std::vector<CompactFloat>  m_feedrates;
+            std::vector<CompactFloat>  m_widths;
+            std::vector<CompactFloat>  m_heights;
+            std::vector<CompactFloat>  m_mm3_per_mms;
+            std::vector<CompactFloat>  m_fan_speeds;
+            std::vector<float>         m_times;
+            std::vector<CompactFloat>  m_temperatures;
+            std::vector<unsigned int>  m_layer_ids;
+            std::vector<float>         m_layer_durations;
+            std::vector<LayerRange>    m_layers;
+            ValueRanges                m_value_ranges;
+        };
+
         struct Result
         {
             struct SettingsIds
@@ -294,7 +400,7 @@ namespace Slic3r {
                 }
             };
             unsigned int id;
-            std::vector<MoveVertex> moves;
+            MoveVertices moves;
             Pointfs bed_shape;
             SettingsIds settings_ids;
             size_t extruders_count;
@@ -307,7 +413,7 @@ namespace Slic3r {
             void reset()
             {
                 time = 0;
-                moves = std::vector<MoveVertex>();
+                moves.clear();
                 bed_shape = Pointfs();
                 extruder_colors = std::vector<std::string>();
                 extruders_count = 0;
@@ -316,7 +422,7 @@ namespace Slic3r {
 #else
             void reset()
             {
-                moves = std::vector<MoveVertex>();
+                moves.clear();
                 bed_shape = Pointfs();
                 extruder_colors = std::vector<std::string>();
                 extruders_count = 0;
@@ -0,0 +1,46 @@
+// Ranges of the values of the G-code moves, shared by the GCodeProcessor and the preview.
+
+#ifndef slic3r_ValueRange_hpp_
+#define slic3r_ValueRange_hpp_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+namespace Slic3r {
+
+// Rounds the value to the given number of significant digits, to the nearest integer if decimals is zero.
+inline float round_to_nearest(float value, unsigned int decimals)
+{
+    float res = 0.0f;
+    if (decimals == 0)
+        res = std::round(value);
+    else {
+        char buf[64];
+        sprintf(buf, "%.*g", decimals, value);
+        res = std::stof(buf);
+    }
+    return res;
+}
+
+// Min / max of a sequence of values, count is the number of values which extended the range.
+struct ValueRange
+{
+    float min{ std::numeric_limits<float>::max() };
+    float max{ -std::numeric_limits<float>::max() };
+    unsigned int count{ 0 };
+
+    void update_from(const float value) {
+        if (value != max && value != min)
+            ++count;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    void reset() { *this = ValueRange(); }
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ValueRange_hpp_
@@ -1,10 +1,16 @@
 #include "GCodeReader.hpp"
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/nowide/cstdio.hpp>
 #include <boost/nowide/fstream.hpp>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+
+#include <tbb/pipeline.h>
 
 #include <Shiny/Shiny.h>
 
@@ -22,7 +28,7 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
     m_extrusion_axis = m_config.get_extrusion_axis()[0];
 }
 
-const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command)
+const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command) const
 {
     PROFILE_FUNC();
     
@@ -74,9 +80,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline,
         }
     }
     
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
-
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
 
@@ -112,13 +115,107 @@ void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, co
     }
 }
 
+// Size of the blocks the G-code files are read in.
+static constexpr size_t GCODE_FILE_BLOCK_SIZE = 1 << 20;
+
+// Read the next block of complete lines into block, keeping the incomplete last line in carry for the next call.
+// The last block of the file may end without a newline. The block is followed by a zero terminator, which is not
+// counted in its size. Returns false at the end of the file.
+static bool read_lines_block(FILE *f, std::vector<char> &carry, std::vector<char> &block)
+{
+    block.swap(carry);
+    carry.clear();
+    size_t size = block.size();
+    for (;;) {
+        block.resize(size + GCODE_FILE_BLOCK_SIZE + 1);
+        size_t num_read = fread(block.data() + size, 1, GCODE_FILE_BLOCK_SIZE, f);
+        if (num_read == 0) {
+            // End of the file, the carried over text is the last line.
+            block.resize(size + 1);
+            block.back() = 0;
+            return size > 0;
+        }
+        // Only the newly read data may contain a newline.
+        const char *begin = block.data() + size;
+        size += num_read;
+        const char *end   = block.data() + size;
+        for (const char *c = end; c != begin; -- c)
+            if (*(c - 1) == '\n') {
+                carry.assign(c, end);
+                block.resize(c - block.data() + 1);
+                block.back() = 0;
+                return true;
+            }
+        // No newline yet, the line is longer than a block.
+    }
+}
+
+bool GCodeReader::read_file_blocks(FILE *f, const std::function<void(const char *begin, const char *end)> &callback)
+{
+    std::vector<char> carry;
+    std::vector<char> block;
+    while (read_lines_block(f, carry, block))
+        callback(block.data(), block.data() + block.size() - 1);
+    return ! ferror(f);
+}
+
 void GCodeReader::parse_file(const std::string &file, callback_t callback)
 {
-    boost::nowide::ifstream f(file);
-    std::string line;
+    FILE *f = boost::nowide::fopen(file.c_str(), "rb");
+    if (f == nullptr)
+        return;
+
+    // Block of lines passed through the pipeline: read, split into parsed lines in parallel, then passed to the callback in order.
+    struct Block {
+        std::vector<char>                                 text;
+        std::vector<GCodeLine>                            lines;
+        // Command of each line, pointing into text.
+        std::vector<std::pair<const char*, const char*>>  commands;
+    };
+    std::vector<char> carry;
+    // Set by the last stage once the callback stops the parsing, so that the first stage does not read the rest of the file.
+    std::atomic<bool> stop { false };
     m_parsing_file = true;
-    while (m_parsing_file && std::getline(f, line))
-        this->parse_line(line, callback);
+    try {
+        tbb::parallel_pipeline(8,
+            tbb::make_filter<void, std::shared_ptr<Block>>(tbb::filter::serial_in_order,
+                [f, &carry, &stop](tbb::flow_control &fc) -> std::shared_ptr<Block> {
+                    auto block = std::make_shared<Block>();
+                    if (stop || ! read_lines_block(f, carry, block->text)) {
+                        fc.stop();
+                        return nullptr;
+                    }
+                    return block;
+                }) &
+            tbb::make_filter<std::shared_ptr<Block>, std::shared_ptr<Block>>(tbb::filter::parallel,
+                [this](std::shared_ptr<Block> block) {
+                    const char *c   = block->text.data();
+                    const char *end = c + block->text.size() - 1;
+                    while (c != end) {
+                        const char *line_end = static_cast<const char*>(memchr(c, '\n', end - c));
+                        block->lines.emplace_back();
+                        block->commands.emplace_back();
+                        this->parse_line_internal(c, block->lines.back(), block->commands.back());
+                        c = (line_end == nullptr) ? end : line_end + 1;
+                    }
+                    return block;
+                }) &
+            tbb::make_filter<std::shared_ptr<Block>, void>(tbb::filter::serial_in_order,
+                [this, &callback, &stop](std::shared_ptr<Block> block) {
+                    for (size_t i = 0; i < block->lines.size() && m_parsing_file; ++ i) {
+                        GCodeLine &gline = block->lines[i];
+                        this->reset_relative_e(gline);
+                        callback(*this, gline);
+                        this->update_coordinates(gline, block->commands[i]);
+                    }
+                    if (! m_parsing_file)
+                        stop = true;
+                }));
+    } catch (...) {
+        fclose(f);
+        throw;
+    }
+    fclose(f);
 }
 
 bool GCodeReader::GCodeLine::has(char axis) const
@@ -3,6 +3,7 @@
 
 #include "libslic3r.h"
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <functional>
 #include <string>
@@ -44,11 +45,7 @@ public:
             float y = this->has(Y) ? (this->y() - reader.y()) : 0;
             return sqrt(x*x + y*y);
         }
-        bool cmd_is(const char *cmd_test) const {
-            const char *cmd = GCodeReader::skip_whitespaces(m_raw.c_str());
-            size_t len = strlen(cmd_test); 
-            return strncmp(cmd, cmd_test, len) == 0 && GCodeReader::is_end_of_word(cmd[len]);
-        }
+        bool cmd_is(const char *cmd_test) const { return GCodeReader::cmd_is(m_raw.c_str(), cmd_test); }
         bool extruding(const GCodeReader &reader)  const { return this->cmd_is("G1") && this->dist_E(reader) > 0; }
         bool retracting(const GCodeReader &reader) const { return this->cmd_is("G1") && this->dist_E(reader) < 0; }
         bool travel()     const { return this->cmd_is("G1") && ! this->has(E); }
@@ -106,6 +103,7 @@ public:
     {
         std::pair<const char*, const char*> cmd;
         const char *end = parse_line_internal(ptr, gline, cmd);
+        reset_relative_e(gline);
         callback(*this, gline);
         update_coordinates(gline, cmd);
         return end;
@@ -115,9 +113,22 @@ public:
     void parse_line(const std::string &line, Callback callback)
         { GCodeLine gline; this->parse_line(line.c_str(), gline, callback); }
 
+    // Parse the file read in large blocks. The lines of a block are split and parsed in parallel with the callback
+    // being called on the lines of the previous blocks, the callback is called in the order of the lines.
     void parse_file(const std::string &file, callback_t callback);
     void quit_parsing_file() { m_parsing_file = false; }
 
+    // Read the file in large blocks and call the callback for each block. A block contains complete lines only,
+    // with the exception of the last line of the file, which may miss its trailing newline.
+    // Returns false if the file could not be read.
+    static bool read_file_blocks(FILE *f, const std::function<void(const char *begin, const char *end)> &callback);
+    // Test the command of a raw G-code line, which is terminated by a newline or zero.
+    static bool cmd_is(const char *line, const char *cmd_test) {
+        const char *cmd = skip_whitespaces(line);
+        size_t len = strlen(cmd_test);
+        return strncmp(cmd, cmd_test, len) == 0 && is_end_of_word(cmd[len]);
+    }
+
     float& x()       { return m_position[X]; }
     float  x() const { return m_position[X]; }
     float& y()       { return m_position[Y]; }
@@ -133,8 +144,10 @@ public:
     void   set_extrusion_axis(char axis) { m_extrusion_axis = axis; }
 
 private:
-    const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command) const;
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // With relative E distances, the E coordinate is reset before each line with an E axis.
+    void        reset_relative_e(const GCodeLine &gline) { if (gline.has(E) && m_config.use_relative_e_distances) m_position[E] = 0; }
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
     static bool         is_end_of_line(char c)          { return c == '\r' || c == '\n' || c == 0; }
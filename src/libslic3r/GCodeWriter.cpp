@@ -1,50 +1,122 @@
 #include "GCodeWriter.hpp"
 #include "CustomGCode.hpp"
 #include <algorithm>
-#include <iomanip>
-#include <iostream>
+#include <cmath>
+#include <cstdio>
 #include <map>
+#include <type_traits>
 #include <assert.h>
 
+#if __has_include(<charconv>)
+    #include <charconv>
+    #include <utility>
+#endif
+
 #define FLAVOR_IS(val) this->config.gcode_flavor.value == val
 #define FLAVOR_IS_NOT(val) this->config.gcode_flavor.value != val
 #define COMMENT(comment) if (this->config.gcode_comments.value && !comment.empty()) gcode << " ; " << comment;
-#define PRECISION(val, precision) to_string_nozero(val, precision)
+#define PRECISION(val, precision) NoZeroNum{ double(val), int32_t(precision) }
 #define XYZ_NUM(val) PRECISION(val, this->config.gcode_precision_xyz.value)
-#define FLOAT_PRECISION(val, precision) std::defaultfloat << std::setprecision(precision) << (val)
+#define FLOAT_PRECISION(val, precision) SignificantNum{ double(val), int(precision) }
 #define F_NUM(val) FLOAT_PRECISION(val, 8)
 #define E_NUM(val) PRECISION(val, this->config.gcode_precision_e.value)
 
 namespace Slic3r {
 
-std::string to_string_nozero(double value, int32_t max_precision) {
+#if __has_include(<charconv>)
+    template <typename T, typename = void>
+    struct is_to_chars_convertible : std::false_type {};
+    template <typename T>
+    struct is_to_chars_convertible<T, std::void_t<decltype(std::to_chars(std::declval<char*>(), std::declval<char*>(), std::declval<T>(), std::chars_format::fixed, 0))>> : std::true_type {};
+#endif
+
+// Writes value with precision decimals (fixed) or precision significant digits (!fixed) into buf,
+// with the same output as printf("%.*f") / printf("%.*g"). Returns the end of the written characters.
+template<typename T>
+static inline char* number_to_chars(char *buf, char *buf_end, T value, bool fixed, int precision)
+{
+#if __has_include(<charconv>)
+    // Visual Studio and GCC 11 support to_chars for floating point numbers, it doesn't depend on the locale.
+    if constexpr (is_to_chars_convertible<T>::value) {
+        return std::to_chars(buf, buf_end, value, fixed ? std::chars_format::fixed : std::chars_format::general, precision).ptr;
+    }
+    else
+#endif
+    {
+        int len = ::snprintf(buf, buf_end - buf, fixed ? "%.*f" : "%.*g", precision, value);
+        return buf + std::max(0, std::min(len, int(buf_end - buf) - 1));
+    }
+}
+
+// Writes value with at most max_precision decimals, without the trailing zeros. Returns the end of the written characters.
+static char* nozero_to_chars(char *buf, char *buf_end, double value, int32_t max_precision)
+{
     double intpart;
     if (modf(value, &intpart) == 0.0) {
-        //shortcut for int
-        return boost::lexical_cast<std::string>(intpart);
-    } else {
-        std::stringstream ss;
-        //first, get the int part, to see how many digit it takes
-        int long10 = 0;
-        if (intpart > 9)
-            long10 = (int)std::floor(std::log10(std::abs(intpart)));
-        //set the usable precision: there is only 15-16 decimal digit in a double
-        ss << std::fixed << std::setprecision(int(std::min(15 - long10, int(max_precision)))) << value;
-        std::string ret = ss.str();
-        uint8_t nb_del = 0;
-        for (uint8_t i = uint8_t(ss.tellp()) - 1; i > 0; i--) {
-            if (ret[i] == '0')
-                nb_del++;
-            else
-                break;
-        }
-        if (nb_del > 0)
-            return ret.substr(0, ret.size() - nb_del);
-        else
-            return ret;
+        //shortcut for int, 17 significant digits as boost::lexical_cast<std::string>(intpart)
+        return number_to_chars(buf, buf_end, intpart, false, 17);
     }
+    //first, get the int part, to see how many digit it takes
+    int long10 = 0;
+    if (intpart > 9)
+        long10 = (int)std::floor(std::log10(std::abs(intpart)));
+    //set the usable precision: there is only 15-16 decimal digit in a double
+    char *end = number_to_chars(buf, buf_end, value, true, int(std::min(15 - long10, int(max_precision))));
+    // remove the trailing zeros (but never the first character)
+    while (end - buf > 1 && *(end - 1) == '0')
+        -- end;
+    return end;
 }
 
+std::string to_string_nozero(double value, int32_t max_precision) {
+    char buf[512];
+    return std::string(buf, nozero_to_chars(buf, buf + sizeof(buf), value, max_precision));
+}
+
+// Numbers to be written by the GCodeFormatter, see the PRECISION and FLOAT_PRECISION macros.
+struct NoZeroNum      { double value; int32_t precision; };
+struct SignificantNum { double value; int     precision; };
+
+// Builds the G-code of a command with the interface of the std::ostringstream it replaces, but without
+// the locale aware iostreams: the numbers are formatted into a stack buffer and appended to a single string.
+class GCodeFormatter {
+public:
+    GCodeFormatter() { m_gcode.reserve(64); }
+
+    GCodeFormatter& operator<<(const std::string &s) { m_gcode += s; return *this; }
+    GCodeFormatter& operator<<(const char *s) { m_gcode += s; return *this; }
+    GCodeFormatter& operator<<(char c) { m_gcode += c; return *this; }
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    GCodeFormatter& operator<<(T value) {
+#if __has_include(<charconv>)
+        char buf[24];
+        m_gcode.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+#else
+        m_gcode += std::to_string(value);
+#endif
+        return *this;
+    }
+    // Default precision of a std::ostream.
+    GCodeFormatter& operator<<(double value) { return this->append(value, false, 6); }
+    GCodeFormatter& operator<<(const SignificantNum &num) { return this->append(num.value, false, num.precision); }
+    GCodeFormatter& operator<<(const NoZeroNum &num) {
+        char buf[512];
+        m_gcode.append(buf, nozero_to_chars(buf, buf + sizeof(buf), num.value, num.precision));
+        return *this;
+    }
+
+    std::string str() { return std::move(m_gcode); }
+
+private:
+    GCodeFormatter& append(double value, bool fixed, int precision) {
+        char buf[512];
+        m_gcode.append(buf, number_to_chars(buf, buf + sizeof(buf), value, fixed, precision));
+        return *this;
+    }
+
+    std::string m_gcode;
+};
+
     std::string GCodeWriter::PausePrintCode = "M601";
 
 void GCodeWriter::apply_print_config(const PrintConfig &print_config)
@@ -127,7 +199,7 @@ void GCodeWriter::set_mills(std::vector<uint16_t> mill_ids)
 
 std::string GCodeWriter::preamble()
 {
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     
     if (FLAVOR_IS_NOT(gcfMakerWare)) {
         gcode << "G21 ; set units to millimeters\n";
@@ -148,7 +220,7 @@ std::string GCodeWriter::preamble()
 
 std::string GCodeWriter::postamble() const
 {
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     if (FLAVOR_IS(gcfMachinekit))
           gcode << "M2 ; end of program\n";
     return gcode.str();
@@ -184,7 +256,7 @@ std::string GCodeWriter::set_temperature(const int16_t temperature, bool wait, i
         comment = "set temperature";
     }
     
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << code << " ";
     if (FLAVOR_IS(gcfMach3) || FLAVOR_IS(gcfMachinekit)) {
         gcode << "P";
@@ -230,7 +302,7 @@ std::string GCodeWriter::set_bed_temperature(uint32_t temperature, bool wait)
         comment = "set bed temperature";
     }
     
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << code << " ";
     if (FLAVOR_IS(gcfMach3) || FLAVOR_IS(gcfMachinekit)) {
         gcode << "P";
@@ -247,15 +319,12 @@ std::string GCodeWriter::set_bed_temperature(uint32_t temperature, bool wait)
 
 std::string GCodeWriter::set_fan(const uint8_t speed, bool dont_save, uint16_t default_tool)
 {
-    std::ostringstream gcode;
-
     const Tool *tool = m_tool == nullptr ? get_tool(default_tool) : m_tool;
     //add fan_offset
     int8_t fan_speed = int8_t(std::min(uint8_t(100), speed));
     if (tool != nullptr)
         fan_speed += tool->fan_offset();
     fan_speed = std::max(int8_t(0), std::min(int8_t(100), fan_speed));
-    const auto fan_baseline = (this->config.fan_percentage.value ? 100.0 : 255.0);
 
     // fan_speed has an effective minimum value of 0, so this cast is safe.
     //test if it's useful to write it
@@ -265,33 +334,47 @@ std::string GCodeWriter::set_fan(const uint8_t speed, bool dont_save, uint16_t d
             m_last_fan_speed = speed;
             m_last_fan_speed_with_offset = uint8_t(fan_speed);
         }
-        
         // write it
-        if (fan_speed == 0) {
-            if (FLAVOR_IS(gcfTeacup)) {
-                gcode << "M106 S0";
-            } else if (FLAVOR_IS(gcfMakerWare) || FLAVOR_IS(gcfSailfish)) {
-                gcode << "M127";
-            } else {
-                gcode << "M107";
-            }
-            if (this->config.gcode_comments) gcode << " ; disable fan";
-            gcode << "\n";
+        return this->fan_gcode(speed, tool);
+    }
+    return std::string();
+}
+
+std::string GCodeWriter::fan_gcode(const uint8_t speed, const Tool *tool) const
+{
+    GCodeFormatter gcode;
+
+    //add fan_offset
+    int8_t fan_speed = int8_t(std::min(uint8_t(100), speed));
+    if (tool != nullptr)
+        fan_speed += tool->fan_offset();
+    fan_speed = std::max(int8_t(0), std::min(int8_t(100), fan_speed));
+    const auto fan_baseline = (this->config.fan_percentage.value ? 100.0 : 255.0);
+
+    if (fan_speed == 0) {
+        if (FLAVOR_IS(gcfTeacup)) {
+            gcode << "M106 S0";
+        } else if (FLAVOR_IS(gcfMakerWare) || FLAVOR_IS(gcfSailfish)) {
+            gcode << "M127";
         } else {
-            if (FLAVOR_IS(gcfMakerWare) || FLAVOR_IS(gcfSailfish)) {
-                gcode << "M126 T";
+            gcode << "M107";
+        }
+        if (this->config.gcode_comments) gcode << " ; disable fan";
+        gcode << "\n";
+    } else {
+        if (FLAVOR_IS(gcfMakerWare) || FLAVOR_IS(gcfSailfish)) {
+            gcode << "M126 T";
+        } else {
+            gcode << "M106 ";
+            if (FLAVOR_IS(gcfMach3) || FLAVOR_IS(gcfMachinekit)) {
+                gcode << "P";
             } else {
-                gcode << "M106 ";
-                if (FLAVOR_IS(gcfMach3) || FLAVOR_IS(gcfMachinekit)) {
-                    gcode << "P";
-                } else {
-                    gcode << "S";
-                }
-                gcode << (fan_baseline * (fan_speed / 100.0));
+                gcode << "S";
             }
-            if (this->config.gcode_comments) gcode << " ; enable fan";
-            gcode << "\n";
+            gcode << (fan_baseline * (fan_speed / 100.0));
         }
+        if (this->config.gcode_comments) gcode << " ; enable fan";
+        gcode << "\n";
     }
     return gcode.str();
 }
@@ -315,7 +398,7 @@ std::string GCodeWriter::write_acceleration(){
 
     m_last_acceleration = m_current_acceleration;
 
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
 	//try to set only printing acceleration, travel should be untouched if possible
     if (FLAVOR_IS(gcfRepetier)) {
         // M201: Set max printing acceleration
@@ -350,7 +433,7 @@ std::string GCodeWriter::reset_e(bool force)
     }
 
     if (! m_extrusion_axis.empty() && ! this->config.use_relative_e_distances) {
-        std::ostringstream gcode;
+        GCodeFormatter gcode;
         gcode << "G92 " << m_extrusion_axis << "0";
         if (this->config.gcode_comments) gcode << " ; reset extrusion distance";
         gcode << "\n";
@@ -368,7 +451,7 @@ std::string GCodeWriter::update_progress(uint32_t num, uint32_t tot, bool allow_
     uint8_t percent = (uint32_t)floor(100.0 * num / tot + 0.5);
     if (!allow_100) percent = std::min(percent, (uint8_t)99);
     
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << "M73 P" << int(percent);
     if (this->config.gcode_comments) gcode << " ; update progress";
     gcode << "\n";
@@ -409,7 +492,7 @@ std::string GCodeWriter::toolchange(uint16_t tool_id)
 
     // return the toolchange command
     // if we are running a single-extruder setup, just set the extruder and return nothing
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     if (this->multiple_extruders) {
         if (FLAVOR_IS(gcfKlipper)) {
             //check if we can use the tool_name field or not
@@ -438,7 +521,7 @@ std::string GCodeWriter::set_speed(double F, const std::string &comment, const s
 {
     assert(F > 0.);
     assert(F < 100000.);
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << "G1 F" << F_NUM(F);
     COMMENT(comment);
     gcode << cooling_marker;
@@ -448,7 +531,7 @@ std::string GCodeWriter::set_speed(double F, const std::string &comment, const s
 
 std::string GCodeWriter::travel_to_xy(const Vec2d &point, double F, const std::string &comment)
 {
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << write_acceleration();
 
     double speed = this->config.travel_speed.value * 60.0;
@@ -491,7 +574,7 @@ std::string GCodeWriter::travel_to_xyz(const Vec3d &point, double F, const std::
     if ((F > 0) & (F < speed))
         speed = F;
 
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << write_acceleration();
     gcode << "G1 X" << XYZ_NUM(point.x())
           << " Y" << XYZ_NUM(point.y());
@@ -529,7 +612,7 @@ std::string GCodeWriter::_travel_to_z(double z, const std::string &comment)
 {
     m_pos.z() = z;
 
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
 
     gcode << write_acceleration();    if (config.z_step > SCALING_FACTOR)
         gcode << "G1 Z" << PRECISION(z, 6);
@@ -562,7 +645,7 @@ std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std:
     m_pos.y() = point.y();
     bool is_extrude = m_tool->extrude(dE) != 0;
 
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << write_acceleration();
     gcode << "G1 X" << XYZ_NUM(point.x())
         << " Y" << XYZ_NUM(point.y());
@@ -581,7 +664,7 @@ std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std
     m_lifted = 0;
     bool is_extrude = m_tool->extrude(dE) != 0;
 
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     gcode << write_acceleration();
     gcode << "G1 X" << XYZ_NUM(point.x())
         << " Y" << XYZ_NUM(point.y())
@@ -628,7 +711,7 @@ std::string GCodeWriter::retract_for_toolchange(bool before_wipe)
 
 std::string GCodeWriter::_retract(double length, double restart_extra, double restart_extra_toolchange, const std::string &comment)
 {
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     
     /*  If firmware retraction is enabled, we use a fake value of 1
         since we ignore the actual configured retract_length which 
@@ -669,7 +752,7 @@ std::string GCodeWriter::_retract(double length, double restart_extra, double re
 
 std::string GCodeWriter::unretract()
 {
-    std::ostringstream gcode;
+    GCodeFormatter gcode;
     
     if (FLAVOR_IS(gcfMakerWare))
         gcode << "M101 ; extruder on\n";
@@ -49,6 +49,9 @@ public:
     uint8_t get_fan() { return m_last_fan_speed; }
     /// set fan at speed. Save it as current fan speed if !dont_save, and use tool default_tool if the internal m_tool is null (no toolchange done yet).
     std::string set_fan(uint8_t speed, bool dont_save = false, uint16_t default_tool = 0);
+    /// fan command at speed with the fan offset of the given tool (if not null), doesn't touch the current fan speed.
+    /// Used by the post-processors, which may run while this writer is already generating the next layer.
+    std::string fan_gcode(uint8_t speed, const Tool *tool) const;
     void        set_acceleration(uint32_t acceleration);
     uint32_t    get_acceleration() const;
     std::string write_acceleration();
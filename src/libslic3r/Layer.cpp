@@ -12,9 +12,15 @@ namespace Slic3r {
 Layer::~Layer()
 {
     this->lower_layer = this->upper_layer = nullptr;
-    for (LayerRegion *region : m_regions)
-        delete region;
+    {
+        // The entities of the layer are deleted for good, their slots are released with the arena.
+        ExtrusionEntityArena::BulkFree bulk_free(m_extrusion_arena);
+        for (LayerRegion *region : m_regions)
+            delete region;
+    }
     m_regions.clear();
+    // The arena is freed once the extrusion entities still referencing it are deleted.
+    m_extrusion_arena->release();
 }
 
 // Test whether whether there are any slices assigned to this layer.
@@ -119,6 +125,7 @@ ExPolygons Layer::merged(float offset_scaled) const
 void Layer::make_perimeters()
 {
     BOOST_LOG_TRIVIAL(trace) << "Generating perimeters for layer " << this->id();
+    ExtrusionEntityArena::Scope arena_scope(m_extrusion_arena);
     
     // keep track of regions whose perimeters we have already generated
     std::vector<unsigned char> done(m_regions.size(), false);
@@ -249,6 +256,7 @@ void Layer::make_milling_post_process() {
     if (this->object()->print()->config().milling_diameter.empty()) return;
 
     BOOST_LOG_TRIVIAL(trace) << "Generating milling_post_process for layer " << this->id();
+    ExtrusionEntityArena::Scope arena_scope(m_extrusion_arena);
 
     // keep track of regions whose perimeters we have already generated
     std::vector<unsigned char> done(m_regions.size(), false);
@@ -6,12 +6,14 @@
 #include "SurfaceCollection.hpp"
 #include "ExtrusionEntityCollection.hpp"
 #include "ExPolygonCollection.hpp"
+#include "EdgeGrid.hpp"
 
 namespace Slic3r {
 
 class Layer;
 class PrintRegion;
 class PrintObject;
+class PlanePathCurveCache;
 
 namespace FillAdaptive {
     struct Octree;
@@ -128,6 +130,10 @@ public:
     // that the 1st lslice is not compensated by the Elephant foot compensation algorithm.
     ExPolygons 				 lslices;
     std::vector<BoundingBox> lslices_bboxes;
+    // Edge grid of the lslices with its signed distance field, created in parallel by PrintObject::make_lslices_grids()
+    // before the G-code export if the seam placement or avoid crossing perimeters needs it, and released with the layer.
+    // Used by the G-code generator to place seams on the layer above (including vase mode) and to test travels for avoid crossing perimeters.
+    std::unique_ptr<EdgeGrid::Grid> lslices_grid;
 
     size_t                  region_count() const { return m_regions.size(); }
     const LayerRegion*      get_region(size_t idx) const { return m_regions.at(idx); }
@@ -145,8 +151,8 @@ public:
     ExPolygons              merged(float offset) const;
     void                    make_perimeters();
 
-    void                    make_milling_post_process();    void                    make_fills() { this->make_fills(nullptr, nullptr); };
-    void                    make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree);
+    void                    make_milling_post_process();    void                    make_fills() { this->make_fills(nullptr, nullptr, nullptr); };
+    void                    make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree, PlanePathCurveCache* plane_path_curves);
     void                    make_ironing();
 
     void                    export_region_slices_to_svg(const char *path) const;
@@ -158,13 +164,16 @@ public:
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool            has_extrusions() const { for (auto layerm : m_regions) if (layerm->has_extrusions()) return true; return false; }
 
+    // Storage of the extrusion entities generated for this layer, to be made current with ExtrusionEntityArena::Scope.
+    ExtrusionEntityArena*   extrusion_arena() const { return m_extrusion_arena; }
+
 protected:
     friend class PrintObject;
 
     Layer(size_t id, PrintObject *object, coordf_t height, coordf_t print_z, coordf_t slice_z) :
         upper_layer(nullptr), lower_layer(nullptr), slicing_errors(false),
         slice_z(slice_z), print_z(print_z), height(height),
-        m_id(id), m_object(object) {}
+        m_id(id), m_object(object), m_extrusion_arena(ExtrusionEntityArena::create()) {}
     virtual ~Layer();
 
 private:
@@ -172,6 +181,7 @@ private:
     size_t              m_id;
     PrintObject        *m_object;
     LayerRegionPtrs     m_regions;
+    ExtrusionEntityArena *m_extrusion_arena;
 };
 
 class SupportLayer : public Layer 
@@ -193,7 +203,11 @@ protected:
     // between the raft and the object first layer.
     SupportLayer(size_t id, PrintObject *object, coordf_t height, coordf_t print_z, coordf_t slice_z) :
         Layer(id, object, height, print_z, slice_z) {}
-    virtual ~SupportLayer() {}
+    virtual ~SupportLayer() {
+        // The support extrusions are deleted for good, their slots are released with the arena.
+        ExtrusionEntityArena::BulkFree bulk_free(this->extrusion_arena());
+        support_fills.clear();
+    }
 };
 
 }
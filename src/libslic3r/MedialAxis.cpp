@@ -41,12 +41,15 @@ MedialAxis::build(Polylines &polylines)
 void
 MedialAxis::polyline_from_voronoi(const Lines& voronoi_edges, ThickPolylines* polylines)
 {
-    std::map<const VD::edge_type*, std::pair<coordf_t, coordf_t> > thickness;
     Lines lines = voronoi_edges;
     VD vd;
     construct_voronoi(lines.begin(), lines.end(), &vd);
 
     typedef const VD::edge_type   edge_t;
+    // Per edge state, indexed by the position of the edge in vd.edges().
+    const edge_t           *edges_begin = vd.edges().empty() ? nullptr : &vd.edges().front();
+    std::vector<EdgeState>  edge_states(vd.edges().size());
+    auto                    state = [edges_begin, &edge_states](const edge_t *edge) -> EdgeState& { return edge_states[edge - edges_begin]; };
     
     // DEBUG: dump all Voronoi edges
     //{
@@ -59,8 +62,8 @@ MedialAxis::polyline_from_voronoi(const Lines& voronoi_edges, ThickPolylines* po
     //        ThickPolyline polyline;
     //        polyline.points.push_back(Point( edge->vertex0()->x(), edge->vertex0()->y() ));
     //        polyline.points.push_back(Point( edge->vertex1()->x(), edge->vertex1()->y() ));
-    //        polyline.width.push_back(thickness[edgeptr].first);
-    //        polyline.width.push_back(thickness[edgeptr].second);
+    //        polyline.width.push_back(state(edgeptr).thickness.first);
+    //        polyline.width.push_back(state(edgeptr).thickness.second);
     //        //polylines->push_back(polyline);
     //        svg.draw(polyline, "red");
     //    }
@@ -71,38 +74,41 @@ MedialAxis::polyline_from_voronoi(const Lines& voronoi_edges, ThickPolylines* po
     
     
     // collect valid edges (i.e. prune those not belonging to MAT)
-    // note: this keeps twins, so it inserts twice the number of the valid edges
-    std::set<const VD::edge_type*> valid_edges;
-    {
-        std::set<const edge_t*> seen_edges;
-        for (VD::const_edge_iterator edge = vd.edges().begin(); edge != vd.edges().end(); ++edge) {
-            // if we only process segments representing closed loops, none if the
-            // infinite edges (if any) would be part of our MAT anyway
-            if (edge->is_secondary() || edge->is_infinite()) continue;
+    // note: this keeps twins, so it marks twice the number of the valid edges
+    for (VD::const_edge_iterator edge = vd.edges().begin(); edge != vd.edges().end(); ++edge) {
+        // if we only process segments representing closed loops, none if the
+        // infinite edges (if any) would be part of our MAT anyway
+        if (edge->is_secondary() || edge->is_infinite()) continue;
         
-            // don't re-validate twins
-            if (seen_edges.find(&*edge) != seen_edges.end()) continue;  // TODO: is this needed?
-            seen_edges.insert(&*edge);
-            seen_edges.insert(edge->twin());
-            
-            if (!this->validate_edge(&*edge, lines, thickness)) continue;
-            valid_edges.insert(&*edge);
-            valid_edges.insert(edge->twin());
-        }
+        // don't re-validate twins
+        if (state(&*edge).seen) continue;  // TODO: is this needed?
+        state(&*edge).seen = true;
+        state(edge->twin()).seen = true;
+        
+        std::pair<coordf_t, coordf_t> thickness;
+        if (!this->validate_edge(&*edge, lines, thickness)) continue;
+        EdgeState &edge_state = state(&*edge);
+        EdgeState &twin_state = state(edge->twin());
+        edge_state.thickness = thickness;
+        twin_state.thickness = std::make_pair(thickness.second, thickness.first);
+        // the valid edges are all unused before building the polylines
+        edge_state.valid = edge_state.unused = true;
+        twin_state.valid = twin_state.unused = true;
     }
-    std::set<const VD::edge_type*> edges = valid_edges;
     
-    // iterate through the valid edges to build polylines
-    while (!edges.empty()) {
-        const edge_t* edge = *edges.begin();
-        if (thickness[edge].first > this->max_width*1.001) {
-            //std::cerr << "Error, edge.first has a thickness of " << unscaled(this->thickness[edge].first) << " > " << unscaled(this->max_width) << "\n";
+    // iterate through the valid edges to build polylines, in the order of vd.edges()
+    for (size_t edge_idx = 0; edge_idx < edge_states.size(); ++ edge_idx) {
+        if (! edge_states[edge_idx].unused) continue;
+        const edge_t* edge = edges_begin + edge_idx;
+        const std::pair<coordf_t, coordf_t> &thickness = edge_states[edge_idx].thickness;
+        if (thickness.first > this->max_width*1.001) {
+            //std::cerr << "Error, edge.first has a thickness of " << unscaled(thickness.first) << " > " << unscaled(this->max_width) << "\n";
             //(void)this->edges.erase(edge);
             //(void)this->edges.erase(edge->twin());
             //continue;
         }
-        if (thickness[edge].second > this->max_width*1.001) {
-            //std::cerr << "Error, edge.second has a thickness of " << unscaled(this->thickness[edge].second) << " > " << unscaled(this->max_width) << "\n";
+        if (thickness.second > this->max_width*1.001) {
+            //std::cerr << "Error, edge.second has a thickness of " << unscaled(thickness.second) << " > " << unscaled(this->max_width) << "\n";
             //(void)this->edges.erase(edge);
             //(void)this->edges.erase(edge->twin());
             //continue;
@@ -112,20 +118,20 @@ MedialAxis::polyline_from_voronoi(const Lines& voronoi_edges, ThickPolylines* po
         ThickPolyline polyline;
         polyline.points.push_back(Point( edge->vertex0()->x(), edge->vertex0()->y() ));
         polyline.points.push_back(Point( edge->vertex1()->x(), edge->vertex1()->y() ));
-        polyline.width.push_back(thickness[edge].first);
-        polyline.width.push_back(thickness[edge].second);
+        polyline.width.push_back(thickness.first);
+        polyline.width.push_back(thickness.second);
         
         // remove this edge and its twin from the available edges
-        (void)edges.erase(edge);
-        (void)edges.erase(edge->twin());
+        state(edge).unused = false;
+        state(edge->twin()).unused = false;
         
         // get next points
-        this->process_edge_neighbors(edge, &polyline, edges, valid_edges, thickness);
+        this->process_edge_neighbors(edge, &polyline, edges_begin, edge_states);
         
         // get previous points
         {
             ThickPolyline rpolyline;
-            this->process_edge_neighbors(edge->twin(), &rpolyline, edges, valid_edges, thickness);
+            this->process_edge_neighbors(edge->twin(), &rpolyline, edges_begin, edge_states);
             polyline.points.insert(polyline.points.begin(), rpolyline.points.rbegin(), rpolyline.points.rend());
             polyline.width.insert(polyline.width.begin(), rpolyline.width.rbegin(), rpolyline.width.rend());
             polyline.endpoints.first = rpolyline.endpoints.second;
@@ -161,7 +167,7 @@ MedialAxis::polyline_from_voronoi(const Lines& voronoi_edges, ThickPolylines* po
 }
 
 void
-MedialAxis::process_edge_neighbors(const VD::edge_type* edge, ThickPolyline* polyline, std::set<const VD::edge_type*> &edges, std::set<const VD::edge_type*> &valid_edges, std::map<const VD::edge_type*, std::pair<coordf_t, coordf_t> > &thickness)
+MedialAxis::process_edge_neighbors(const VD::edge_type* edge, ThickPolyline* polyline, const VD::edge_type* edges_begin, std::vector<EdgeState> &edge_states)
 {
     while (true) {
         // Since rot_next() works on the edge starting point but we want
@@ -170,27 +176,31 @@ MedialAxis::process_edge_neighbors(const VD::edge_type* edge, ThickPolyline* pol
         const VD::edge_type* twin = edge->twin();
     
         // count neighbors for this edge
-        std::vector<const VD::edge_type*> neighbors;
-        for (const VD::edge_type* neighbor = twin->rot_next(); neighbor != twin;
-            neighbor = neighbor->rot_next()) {
-            if (valid_edges.count(neighbor) > 0) neighbors.push_back(neighbor);
+        const VD::edge_type* neighbor = nullptr;
+        size_t num_neighbors = 0;
+        for (const VD::edge_type* next = twin->rot_next(); next != twin;
+            next = next->rot_next()) {
+            if (edge_states[next - edges_begin].valid) {
+                neighbor = next;
+                ++num_neighbors;
+            }
         }
     
         // if we have a single neighbor then we can continue recursively
-        if (neighbors.size() == 1) {
-            const VD::edge_type* neighbor = neighbors.front();
+        if (num_neighbors == 1) {
+            EdgeState &neighbor_state = edge_states[neighbor - edges_begin];
             
             // break if this is a closed loop
-            if (edges.count(neighbor) == 0) return;
+            if (! neighbor_state.unused) return;
             
             Point new_point(neighbor->vertex1()->x(), neighbor->vertex1()->y());
             polyline->points.push_back(new_point);
-            polyline->width.push_back(thickness[neighbor].second);
+            polyline->width.push_back(neighbor_state.thickness.second);
             
-            (void)edges.erase(neighbor);
-            (void)edges.erase(neighbor->twin());
+            neighbor_state.unused = false;
+            edge_states[neighbor->twin() - edges_begin].unused = false;
             edge = neighbor;
-        } else if (neighbors.size() == 0) {
+        } else if (num_neighbors == 0) {
             polyline->endpoints.second = true;
             return;
         } else {
@@ -201,7 +211,7 @@ MedialAxis::process_edge_neighbors(const VD::edge_type* edge, ThickPolyline* pol
 }
 
 bool
-MedialAxis::validate_edge(const VD::edge_type* edge, Lines &lines, std::map<const VD::edge_type*, std::pair<coordf_t, coordf_t> > &thickness)
+MedialAxis::validate_edge(const VD::edge_type* edge, Lines &lines, std::pair<coordf_t, coordf_t> &thickness)
 {
     // prevent overflows and detect almost-infinite edges
     if (std::abs(edge->vertex0()->x()) > double(CLIPPER_MAX_COORD_UNSCALED) ||
@@ -319,8 +329,7 @@ MedialAxis::validate_edge(const VD::edge_type* edge, Lines &lines, std::map<cons
     if (w0 > this->max_width*1.05 && w1 > this->max_width*1.05)
         return false;
     
-    thickness[edge]         = std::make_pair(w0, w1);
-    thickness[edge->twin()] = std::make_pair(w1, w0);
+    thickness = std::make_pair(w0, w1);
     
     return true;
 }
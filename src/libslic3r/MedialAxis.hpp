@@ -74,8 +74,19 @@ class MedialAxis {
             typedef boost::polygon::segment_data<coordinate_type>   segment_type;
             typedef boost::polygon::rectangle_data<coordinate_type> rect_type;
         };
-        void process_edge_neighbors(const VD::edge_type* edge, ThickPolyline* polyline, std::set<const VD::edge_type*> &edges, std::set<const VD::edge_type*> &valid_edges, std::map<const VD::edge_type*, std::pair<coordf_t, coordf_t> > &thickness);
-        bool validate_edge(const VD::edge_type* edge, Lines &lines, std::map<const VD::edge_type*, std::pair<coordf_t, coordf_t> > &thickness);
+        /// state of a voronoi edge while building the polylines, indexed by the position of the edge in vd.edges()
+        struct EdgeState {
+            /// thickness at the start and at the end of a valid edge
+            std::pair<coordf_t, coordf_t> thickness { 0, 0 };
+            /// the edge or its twin was already validated
+            bool seen   = false;
+            /// the edge belongs to the medial axis
+            bool valid  = false;
+            /// the edge is valid and not yet added to a polyline
+            bool unused = false;
+        };
+        void process_edge_neighbors(const VD::edge_type* edge, ThickPolyline* polyline, const VD::edge_type* edges_begin, std::vector<EdgeState> &edge_states);
+        bool validate_edge(const VD::edge_type* edge, Lines &lines, std::pair<coordf_t, coordf_t> &thickness);
         const Line& retrieve_segment(const VD::cell_type* cell, Lines& lines) const;
         const Point& retrieve_endpoint(const VD::cell_type* cell, Lines& lines) const;
         void polyline_from_voronoi(const Lines& voronoi_edges, ThickPolylines* polylines_out);
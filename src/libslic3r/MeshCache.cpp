@@ -0,0 +1,378 @@
+#include "MeshCache.hpp"
+#include "TriangleMesh.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+//FIXME replace with <boost/md5.hpp> after it becomes mainstream, see AppConfig.cpp.
+#include <boost/uuid/detail/md5.hpp>
+
+#include <tbb/parallel_for.h>
+
+namespace Slic3r {
+
+struct MeshCacheSettings
+{
+    std::string dir;
+    size_t      min_source_size { 1 << 20 };
+    size_t      max_size        { size_t(1) << 30 };
+};
+
+// The settings are changed by the UI thread while the meshes are loaded by the background threads.
+// Each function works with a copy of the settings taken at its start.
+static std::mutex        g_mesh_cache_mutex;
+static MeshCacheSettings g_mesh_cache_settings;
+
+static MeshCacheSettings mesh_cache_settings()
+{
+    std::lock_guard<std::mutex> lock(g_mesh_cache_mutex);
+    return g_mesh_cache_settings;
+}
+
+void set_mesh_cache_dir(const std::string &dir, size_t min_source_size, size_t max_size)
+{
+    std::lock_guard<std::mutex> lock(g_mesh_cache_mutex);
+    g_mesh_cache_settings.dir             = dir;
+    g_mesh_cache_settings.min_source_size = min_source_size;
+    g_mesh_cache_settings.max_size        = max_size;
+}
+
+std::string mesh_cache_dir()
+{
+    return mesh_cache_settings().dir;
+}
+
+// Bump the version whenever the layout or the result of TriangleMesh::repair() changes. Entries of other versions are ignored.
+static constexpr const uint32_t MESH_CACHE_VERSION    = 1;
+static constexpr const char     MESH_CACHE_MAGIC[8]   = { 'S', 'L', '3', 'R', 'M', 'E', 'S', 'H' };
+static constexpr const uint32_t MESH_CACHE_BYTE_ORDER = 0x01020304;
+// The arrays are aligned, so that they may be accessed in place in a mapped file.
+static constexpr const size_t   MESH_CACHE_ALIGNMENT  = 16;
+// The source file is hashed in blocks of this size in parallel.
+static constexpr const size_t   MESH_CACHE_HASH_BLOCK = 16 << 20;
+
+// An entry is the header followed by the arrays at the offsets stored in the header.
+// The sizes of the stored structures reject entries written by an incompatible build.
+struct MeshCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t sizeof_facet;
+    uint32_t sizeof_neighbors;
+    uint32_t sizeof_stats;
+    uint32_t sizeof_its_indices;
+    uint32_t sizeof_its_vertex;
+    uint32_t reserved;
+    uint64_t num_facets;
+    uint64_t num_its_indices;
+    uint64_t num_its_vertices;
+    uint64_t offset_facets;
+    uint64_t offset_neighbors;
+    uint64_t offset_stats;
+    uint64_t offset_its_indices;
+    uint64_t offset_its_vertices;
+    uint64_t file_size;
+};
+
+// Read only view of a whole file. The file is mapped if possible,
+// otherwise (for example a non-ASCII path on Windows) it is read into memory.
+class MeshCacheFile
+{
+public:
+    bool open(const std::string &path)
+    {
+        namespace bip = boost::interprocess;
+        try {
+            bip::file_mapping(path.c_str(), bip::read_only).swap(m_mapping);
+            bip::mapped_region(m_mapping, bip::read_only).swap(m_region);
+            m_data = static_cast<const char*>(m_region.get_address());
+            m_size = m_region.get_size();
+            return true;
+        } catch (const bip::interprocess_exception &) {
+        }
+        FILE *file = boost::nowide::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+        static constexpr const size_t chunk = 1 << 20;
+        for (;;) {
+            size_t old_size = m_buffer.size();
+            m_buffer.resize(old_size + chunk);
+            size_t n = ::fread(m_buffer.data() + old_size, 1, chunk, file);
+            m_buffer.resize(old_size + n);
+            if (n < chunk)
+                break;
+        }
+        bool ok = ::ferror(file) == 0;
+        ::fclose(file);
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        return ok;
+    }
+
+    void close()
+    {
+        boost::interprocess::mapped_region().swap(m_region);
+        boost::interprocess::file_mapping().swap(m_mapping);
+        m_buffer = std::vector<char>();
+        m_data   = nullptr;
+        m_size   = 0;
+    }
+
+    const char* data() const { return m_data; }
+    size_t      size() const { return m_size; }
+
+private:
+    boost::interprocess::file_mapping  m_mapping;
+    boost::interprocess::mapped_region m_region;
+    std::vector<char>                  m_buffer;
+    const char                        *m_data { nullptr };
+    size_t                             m_size { 0 };
+};
+
+static const char *MESH_CACHE_EXTENSION = ".mesh";
+
+static std::string mesh_cache_entry_path(const std::string &dir, const std::string &key)
+{
+    return (boost::filesystem::path(dir) / (key + MESH_CACHE_EXTENSION)).string();
+}
+
+// Entries of the cache directory, sorted from the least recently used one. Loading an entry touches its modification time.
+static std::vector<std::pair<boost::filesystem::path, uintmax_t>> mesh_cache_entries(const std::string &dir)
+{
+    namespace fs = boost::filesystem;
+    std::vector<std::pair<fs::path, std::time_t>> entries;
+    boost::system::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; ! ec && it != end; it.increment(ec))
+        if (it->path().extension() == MESH_CACHE_EXTENSION && fs::is_regular_file(it->status())) {
+            boost::system::error_code ec_time;
+            entries.emplace_back(it->path(), fs::last_write_time(it->path(), ec_time));
+        }
+    std::stable_sort(entries.begin(), entries.end(), [](const auto &l, const auto &r) { return l.second < r.second; });
+    std::vector<std::pair<fs::path, uintmax_t>> out;
+    out.reserve(entries.size());
+    for (const auto &entry : entries) {
+        uintmax_t size = fs::file_size(entry.first, ec);
+        if (! ec)
+            out.emplace_back(entry.first, size);
+    }
+    return out;
+}
+
+// Remove the least recently used entries until the remaining ones take at most max_size bytes.
+static void trim_mesh_cache(const std::string &dir, size_t max_size)
+{
+    auto      entries = mesh_cache_entries(dir);
+    uintmax_t total   = 0;
+    for (const auto &entry : entries)
+        total += entry.second;
+    boost::system::error_code ec;
+    for (auto it = entries.begin(); it != entries.end() && total > max_size; ++ it) {
+        // The entry may have been removed by another thread or another instance already.
+        boost::filesystem::remove(it->first, ec);
+        total -= it->second;
+        BOOST_LOG_TRIVIAL(debug) << "Evicted the mesh cache entry " << it->first.string();
+    }
+}
+
+void clear_mesh_cache(const std::string &dir)
+{
+    boost::system::error_code ec;
+    for (const auto &entry : mesh_cache_entries(dir))
+        boost::filesystem::remove(entry.first, ec);
+}
+
+std::string mesh_cache_key(const char *source_file, const char *loader)
+{
+    const MeshCacheSettings settings = mesh_cache_settings();
+    if (settings.dir.empty())
+        return std::string();
+
+    MeshCacheFile file;
+    if (! file.open(source_file) || file.size() == 0 || file.size() < settings.min_source_size)
+        return std::string();
+
+    // The blocks are hashed in parallel, the key is the hash of the loader, the file size and the digests of the blocks.
+    using boost::uuids::detail::md5;
+    struct Digest { md5::digest_type value; };
+    const char  *data       = file.data();
+    const size_t size       = file.size();
+    const size_t num_blocks = (size + MESH_CACHE_HASH_BLOCK - 1) / MESH_CACHE_HASH_BLOCK;
+    std::vector<Digest> digests(num_blocks);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1),
+        [data, size, &digests](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                size_t begin = i * MESH_CACHE_HASH_BLOCK;
+                md5    hash;
+                hash.process_bytes(data + begin, std::min(MESH_CACHE_HASH_BLOCK, size - begin));
+                hash.get_digest(digests[i].value);
+            }
+        });
+
+    md5      hash;
+    uint64_t size64 = size;
+    hash.process_bytes(loader, ::strlen(loader));
+    hash.process_bytes(&size64, sizeof(size64));
+    hash.process_bytes(digests.data(), digests.size() * sizeof(Digest));
+    md5::digest_type digest{};
+    hash.get_digest(digest);
+    std::string key;
+    boost::algorithm::hex(digest, digest + std::size(digest), std::back_inserter(key));
+    return key;
+}
+
+bool load_mesh_cache(const std::string &key, TriangleMesh &mesh)
+{
+    const std::string dir = mesh_cache_dir();
+    if (key.empty() || dir.empty())
+        return false;
+
+    const std::string path = mesh_cache_entry_path(dir, key);
+    boost::system::error_code ec;
+    if (! boost::filesystem::exists(path, ec))
+        return false;
+    MeshCacheFile file;
+    if (! file.open(path))
+        return false;
+
+    const char *data = file.data();
+    const size_t size = file.size();
+    MeshCacheHeader header;
+    if (size < sizeof(header))
+        return false;
+    ::memcpy(&header, data, sizeof(header));
+    auto array_valid = [size](uint64_t offset, uint64_t count, uint64_t elem_size) {
+        return offset % MESH_CACHE_ALIGNMENT == 0 && offset <= size && count <= (size - offset) / elem_size;
+    };
+    if (::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+        header.version            != MESH_CACHE_VERSION ||
+        header.byte_order         != MESH_CACHE_BYTE_ORDER ||
+        header.sizeof_facet       != sizeof(stl_facet) ||
+        header.sizeof_neighbors   != sizeof(stl_neighbors) ||
+        header.sizeof_stats       != sizeof(stl_stats) ||
+        header.sizeof_its_indices != sizeof(stl_triangle_vertex_indices) ||
+        header.sizeof_its_vertex  != sizeof(stl_vertex) ||
+        header.file_size          != size ||
+        ! array_valid(header.offset_facets,       header.num_facets,       sizeof(stl_facet)) ||
+        ! array_valid(header.offset_neighbors,    header.num_facets,       sizeof(stl_neighbors)) ||
+        ! array_valid(header.offset_stats,        1,                       sizeof(stl_stats)) ||
+        ! array_valid(header.offset_its_indices,  header.num_its_indices,  sizeof(stl_triangle_vertex_indices)) ||
+        ! array_valid(header.offset_its_vertices, header.num_its_vertices, sizeof(stl_vertex))) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring invalid mesh cache entry " << path;
+        return false;
+    }
+
+    stl_stats stats;
+    ::memcpy((void*)&stats, data + header.offset_stats, sizeof(stl_stats));
+    if (stats.number_of_facets != header.num_facets) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring invalid mesh cache entry " << path;
+        return false;
+    }
+
+    mesh.clear();
+    mesh.stl.stats = stats;
+    auto assign = [data](auto &dst, uint64_t offset, uint64_t count) {
+        dst.resize(count);
+        if (count > 0)
+            ::memcpy((void*)dst.data(), data + offset, count * sizeof(dst.front()));
+    };
+    assign(mesh.stl.facet_start,     header.offset_facets,       header.num_facets);
+    assign(mesh.stl.neighbors_start, header.offset_neighbors,    header.num_facets);
+    assign(mesh.its.indices,         header.offset_its_indices,  header.num_its_indices);
+    assign(mesh.its.vertices,        header.offset_its_vertices, header.num_its_vertices);
+    mesh.repaired = true;
+    // Mark the entry as the most recently used one for the eviction.
+    file.close();
+    boost::filesystem::last_write_time(path, std::time(nullptr), ec);
+    BOOST_LOG_TRIVIAL(debug) << "Loaded mesh of " << header.num_facets << " facets from the mesh cache " << path;
+    return true;
+}
+
+void store_mesh_cache(const std::string &key, const TriangleMesh &mesh)
+{
+    const MeshCacheSettings settings = mesh_cache_settings();
+    if (key.empty() || settings.dir.empty() || ! mesh.repaired)
+        return;
+
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(settings.dir, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to create the mesh cache directory " << settings.dir << ": " << ec.message();
+        return;
+    }
+
+    auto align = [](uint64_t offset) { return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT; };
+    MeshCacheHeader header;
+    ::memset(&header, 0, sizeof(header));
+    ::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version             = MESH_CACHE_VERSION;
+    header.byte_order          = MESH_CACHE_BYTE_ORDER;
+    header.sizeof_facet        = sizeof(stl_facet);
+    header.sizeof_neighbors    = sizeof(stl_neighbors);
+    header.sizeof_stats        = sizeof(stl_stats);
+    header.sizeof_its_indices  = sizeof(stl_triangle_vertex_indices);
+    header.sizeof_its_vertex   = sizeof(stl_vertex);
+    header.num_facets          = mesh.stl.facet_start.size();
+    header.num_its_indices     = mesh.its.indices.size();
+    header.num_its_vertices    = mesh.its.vertices.size();
+    header.offset_stats        = align(sizeof(header));
+    header.offset_facets       = align(header.offset_stats + sizeof(stl_stats));
+    header.offset_neighbors    = align(header.offset_facets + header.num_facets * sizeof(stl_facet));
+    header.offset_its_indices  = align(header.offset_neighbors + header.num_facets * sizeof(stl_neighbors));
+    header.offset_its_vertices = align(header.offset_its_indices + header.num_its_indices * sizeof(stl_triangle_vertex_indices));
+    header.file_size           = header.offset_its_vertices + header.num_its_vertices * sizeof(stl_vertex);
+    if (mesh.stl.neighbors_start.size() != header.num_facets || mesh.stl.stats.number_of_facets != header.num_facets)
+        return;
+
+    // Written to a temporary file first, so that a concurrently running instance never maps a partial entry.
+    // The temporary name is unique, as two instances may store the same mesh at the same time.
+    const std::string path     = mesh_cache_entry_path(settings.dir, key);
+    const std::string path_tmp = boost::filesystem::unique_path(path + ".%%%%-%%%%-%%%%.tmp").string();
+    FILE *file = boost::nowide::fopen(path_tmp.c_str(), "wb");
+    if (file == nullptr) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to create the mesh cache entry " << path_tmp;
+        return;
+    }
+    uint64_t written = 0;
+    bool     ok      = true;
+    auto write = [file, &written, &ok](uint64_t offset, const void *data, size_t size) {
+        static const char zeros[MESH_CACHE_ALIGNMENT] = {};
+        if (ok && offset > written)
+            ok = ::fwrite(zeros, 1, size_t(offset - written), file) == offset - written;
+        if (ok && size > 0)
+            ok = ::fwrite(data, 1, size, file) == size;
+        written = offset + size;
+    };
+    write(0,                          &header,                          sizeof(header));
+    write(header.offset_stats,        &mesh.stl.stats,                  sizeof(stl_stats));
+    write(header.offset_facets,       mesh.stl.facet_start.data(),      header.num_facets * sizeof(stl_facet));
+    write(header.offset_neighbors,    mesh.stl.neighbors_start.data(),  header.num_facets * sizeof(stl_neighbors));
+    write(header.offset_its_indices,  mesh.its.indices.data(),          header.num_its_indices * sizeof(stl_triangle_vertex_indices));
+    write(header.offset_its_vertices, mesh.its.vertices.data(),         header.num_its_vertices * sizeof(stl_vertex));
+    ok &= ::fclose(file) == 0;
+    if (ok)
+        ok = ! rename_file(path_tmp, path);
+    if (! ok) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write the mesh cache entry " << path;
+        boost::filesystem::remove(path_tmp, ec);
+        return;
+    }
+    trim_mesh_cache(settings.dir, settings.max_size);
+}
+
+} // namespace Slic3r
@@ -0,0 +1,35 @@
+#ifndef slic3r_MeshCache_hpp_
+#define slic3r_MeshCache_hpp_
+
+#include <cstddef>
+#include <string>
+
+namespace Slic3r {
+
+class TriangleMesh;
+
+// Opt-in on-disk cache of the repaired meshes loaded from STL and OBJ files.
+// An entry is keyed by a hash of the source file content. It stores the repaired TriangleMesh (facets, neighbors,
+// statistics and the indexed triangle set) as flat arrays, which are mapped back without any parsing or repair.
+
+// Set the directory of the cache entries. An empty directory disables the cache, which is the default.
+// Source files smaller than min_source_size load faster than they are hashed, they are not cached.
+// After an entry is stored, the least recently used entries are removed until the entries take at most max_size bytes.
+// May be called while meshes are being loaded from other threads.
+void set_mesh_cache_dir(const std::string &dir, size_t min_source_size = 1 << 20, size_t max_size = size_t(1) << 30);
+// Return the directory of the cache entries, empty if the cache is disabled.
+std::string mesh_cache_dir();
+// Remove all the entries from a cache directory, independently of whether the cache is enabled.
+void clear_mesh_cache(const std::string &dir);
+
+// Return the cache key of a source file read by the loader ("stl", "obj").
+// Returns an empty string if the cache is disabled, the file is not worth caching or it could not be read.
+std::string mesh_cache_key(const char *source_file, const char *loader);
+// Load the repaired mesh stored under the key. Returns false and leaves the mesh untouched if there is no valid entry.
+bool load_mesh_cache(const std::string &key, TriangleMesh &mesh);
+// Store a repaired mesh under the key. Does nothing for an empty key, failures are only logged.
+void store_mesh_cache(const std::string &key, const TriangleMesh &mesh);
+
+} // namespace Slic3r
+
+#endif // slic3r_MeshCache_hpp_
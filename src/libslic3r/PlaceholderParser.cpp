@@ -1,6 +1,8 @@
 #include "PlaceholderParser.hpp"
 #include "Exception.hpp"
 #include "Flow.hpp"
+#include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
@@ -1471,6 +1473,188 @@ static std::string process_macro(const std::string &templ, client::MyContext &co
     return output;
 }
 
+// Returns the number of bytes of the UTF-8 character at it, or zero if it would not be accepted by client::utf8_char_skipper_parser.
+static size_t utf8_char_length(std::string::const_iterator it, std::string::const_iterator end)
+{
+    unsigned char c = static_cast<unsigned char>(*it);
+    if ((c & 0xC0) == 0x80)
+        return 0;
+    size_t cnt = 0;
+    for (unsigned char mask = 0x80u; c & mask; mask >>= 1)
+        ++ cnt;
+    cnt = (cnt == 0) ? 1 : std::min<size_t>(cnt, 4);
+    for (size_t i = 1; i < cnt; ++ i) {
+        if (it + i == end)
+            return 0;
+        // Only the inner continuation bytes are validated, the same as utf8_char_skipper_parser does.
+        if (i + 1 < cnt && (static_cast<unsigned char>(*(it + i)) & 0xC0) != 0x80)
+            return 0;
+    }
+    return cnt;
+}
+
+static bool is_identifier_start(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+static bool is_identifier_char(char c)  { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+// Is the string an identifier accepted by the legacy variable expansion, thus not a keyword?
+static bool is_legacy_identifier(const std::string &str)
+{
+    static const char *keywords[] = { "and", "if", "int", "else", "elsif", "endif", "false", "min", "max", "random", "not", "or", "true" };
+    if (str.empty() || ! is_identifier_start(str.front()) || ! std::all_of(str.begin(), str.end(), is_identifier_char))
+        return false;
+    return std::find_if(std::begin(keywords), std::end(keywords), [&str](const char *kw) { return str == kw; }) == std::end(keywords);
+}
+
+// Find the closing brace of a macro starting at it (just after its opening brace), skipping string literals and regular expressions.
+// Returns end if not found.
+static std::string::const_iterator find_macro_end(std::string::const_iterator it, std::string::const_iterator end)
+{
+    // Last two non-white space characters, to detect the regular expression after the =~ and !~ operators.
+    char prev = 0, prev2 = 0;
+    for (; it != end; ++ it) {
+        char c = *it;
+        if (c == '}')
+            return it;
+        if (c == '"' || (c == '/' && prev == '~' && (prev2 == '=' || prev2 == '!'))) {
+            // Skip a string literal or a regular expression, possibly containing braces.
+            for (++ it; it != end && *it != c; ++ it)
+                if (*it == '\\' && ++ it == end)
+                    return end;
+            if (it == end)
+                return end;
+        } else if (c == '{')
+            // Braces are not allowed inside a macro, let the grammar report it.
+            return end;
+        if (! std::isspace(static_cast<unsigned char>(c))) {
+            prev2 = prev;
+            prev  = c;
+        }
+    }
+    return end;
+}
+
+// Keyword the macro starting at it (just after its opening brace) starts with, if any of the {if} block keywords.
+static std::string macro_keyword(std::string::const_iterator it, std::string::const_iterator end)
+{
+    while (it != end && std::isspace(static_cast<unsigned char>(*it)))
+        ++ it;
+    auto begin = it;
+    while (it != end && is_identifier_char(*it))
+        ++ it;
+    std::string kw(begin, it);
+    return (kw == "if" || kw == "elsif" || kw == "else" || kw == "endif") ? kw : std::string();
+}
+
+// Split the template into the literal text and the macros, the macros being either legacy variable expansions
+// or anything enclosed in the outer most braces, including whole {if}...{endif} blocks.
+// If the template cannot be split reliably, the returned template is not valid and the template is processed as a whole.
+static PlaceholderParser::CompiledTemplate compile_template(const std::string &templ)
+{
+    using Segment = PlaceholderParser::CompiledTemplate::Segment;
+    PlaceholderParser::CompiledTemplate out;
+    auto it  = templ.cbegin();
+    auto end = templ.cend();
+    // The grammar skips the white spaces at the start of the template.
+    while (it != end && boost::spirit::char_encoding::iso8859_1::isspace(static_cast<unsigned char>(*it)))
+        ++ it;
+    while (it != end) {
+        if (*it == '[') {
+            auto it_end = std::find(it + 1, end, ']');
+            std::string key(it + 1, it_end);
+            size_t      idx_index = key.find('[');
+            if (idx_index != std::string::npos && it_end != end)
+                // Legacy vector variable expansion [variable[index_variable]].
+                it_end = std::find(it_end + 1, end, ']');
+            if (it_end == end)
+                return PlaceholderParser::CompiledTemplate();
+            ++ it_end;
+            if (idx_index == std::string::npos && is_legacy_identifier(key))
+                out.segments.push_back({ Segment::LegacyVariable, std::move(key), std::string() });
+            else if (idx_index != std::string::npos && key.size() + 3 == size_t(it_end - it) &&
+                     is_legacy_identifier(key.substr(0, idx_index)) && is_legacy_identifier(key.substr(idx_index + 1)))
+                out.segments.push_back({ Segment::LegacyVectorVariable, key.substr(0, idx_index), key.substr(idx_index + 1) });
+            else
+                out.segments.push_back({ Segment::Macro, std::string(it, it_end), std::string() });
+            it = it_end;
+        } else if (*it == '{') {
+            std::string kw = macro_keyword(it + 1, end);
+            if (! kw.empty() && kw != "if")
+                // {elsif}, {else} or {endif} without an {if}, let the grammar report it.
+                return PlaceholderParser::CompiledTemplate();
+            auto it_end = it;
+            for (int depth = 0;;) {
+                // it_end points to an opening brace of a macro.
+                auto it_macro_end = find_macro_end(it_end + 1, end);
+                if (it_macro_end == end)
+                    return PlaceholderParser::CompiledTemplate();
+                kw = macro_keyword(it_end + 1, end);
+                if (kw == "if")
+                    ++ depth;
+                else if (kw == "endif")
+                    -- depth;
+                it_end = it_macro_end + 1;
+                if (depth == 0)
+                    break;
+                // Skip the text up to the next macro of this {if} block.
+                it_end = std::find(it_end, end, '{');
+                if (it_end == end)
+                    return PlaceholderParser::CompiledTemplate();
+            }
+            out.segments.push_back({ Segment::Macro, std::string(it, it_end), std::string() });
+            it = it_end;
+        } else {
+            auto it_end = it;
+            while (it_end != end && *it_end != '[' && *it_end != '{') {
+                size_t len = utf8_char_length(it_end, end);
+                if (len == 0)
+                    // Invalid UTF-8, let the grammar report it.
+                    return PlaceholderParser::CompiledTemplate();
+                it_end += len;
+            }
+            out.segments.push_back({ Segment::Text, std::string(it, it_end), std::string() });
+            it = it_end;
+        }
+    }
+    out.valid = true;
+    return out;
+}
+
+// Process a template split by compile_template(): copy the text, evaluate the legacy variable expansions directly
+// and process the other macros with the grammar.
+static std::string process_compiled(const PlaceholderParser::CompiledTemplate &compiled, client::MyContext &context)
+{
+    using Segment = PlaceholderParser::CompiledTemplate::Segment;
+    using Range   = boost::iterator_range<std::string::const_iterator>;
+    std::string output;
+    std::string expansion;
+    for (const Segment &segment : compiled.segments) {
+        switch (segment.type) {
+        case Segment::Text:
+            output += segment.text;
+            break;
+        case Segment::LegacyVariable:
+        {
+            Range opt_key(segment.text.begin(), segment.text.end());
+            client::MyContext::legacy_variable_expansion(&context, opt_key, expansion);
+            output += expansion;
+            break;
+        }
+        case Segment::LegacyVectorVariable:
+        {
+            Range opt_key(segment.text.begin(), segment.text.end());
+            Range opt_vector_index(segment.index.begin(), segment.index.end());
+            client::MyContext::legacy_variable_expansion2(&context, opt_key, opt_vector_index, expansion);
+            output += expansion;
+            break;
+        }
+        case Segment::Macro:
+            output += process_macro(segment.text, context);
+            break;
+        }
+    }
+    return output;
+}
+
 std::string PlaceholderParser::process(const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override, ContextData *context_data) const
 {
     client::MyContext context;
@@ -1479,6 +1663,24 @@ std::string PlaceholderParser::process(const std::string &templ, unsigned int cu
     context.config_override     = config_override;
     context.current_extruder_id = current_extruder_id;
     context.context_data        = context_data;
+    if (context_data != nullptr) {
+        // The same templates are processed over and over (for each layer, each tool change), split them just once.
+        auto it = context_data->compiled_templates.find(templ);
+        if (it == context_data->compiled_templates.end()) {
+            // Don't let templates generated on the fly (the wipe tower G-code) pile up.
+            if (context_data->compiled_templates.size() >= 256)
+                context_data->compiled_templates.clear();
+            it = context_data->compiled_templates.emplace(templ, compile_template(templ)).first;
+        }
+        if (it->second.valid) {
+            try {
+                return process_compiled(it->second, context);
+            } catch (std::exception &) {
+                // Process the template as a whole, so that the error is reported relative to the complete template.
+                context.error_message.clear();
+            }
+        }
+    }
     return process_macro(templ, context);
 }
 
@@ -5,6 +5,7 @@
 #include <map>
 #include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "PrintConfig.hpp"
 
@@ -13,6 +14,30 @@ namespace Slic3r {
 class PlaceholderParser
 {
 public:
+    // A template split into the literal text, which is copied to the output, and the macros, which are evaluated
+    // each time the template is processed. Only the macros are passed to the grammar.
+    struct CompiledTemplate {
+        struct Segment {
+            enum Type : unsigned char {
+                // Literal text, copied to the output.
+                Text,
+                // Legacy [variable] expansion, text is the variable name.
+                LegacyVariable,
+                // Legacy [variable[index_variable]] expansion, text is the variable name.
+                LegacyVectorVariable,
+                // Anything else in [] or {}, including the whole {if}...{endif} blocks, processed by the grammar.
+                Macro,
+            };
+            Type        type;
+            std::string text;
+            // Name of the index variable of LegacyVectorVariable.
+            std::string index;
+        };
+        std::vector<Segment> segments;
+        // False if the template could not be split, then it is processed as a whole.
+        bool                 valid { false };
+    };
+
     // Context to be shared during multiple executions of the PlaceholderParser.
     // The context is kept external to the PlaceholderParser, so that the same PlaceholderParser
     // may be called safely from multiple threads.
@@ -20,6 +45,8 @@ public:
     // and shared between the PlaceholderParser::process() invocations.
     struct ContextData {
         std::mt19937 rng;
+        // Templates already split by process() into their literal text and macros, keyed by the template text.
+        std::unordered_map<std::string, CompiledTemplate> compiled_templates;
     };
 
     PlaceholderParser(const DynamicConfig *external_config = nullptr);
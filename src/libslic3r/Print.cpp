@@ -22,11 +22,13 @@
 
 #include <algorithm>
 #include <limits>
-#include <unordered_set>
+#include <mutex>
 #include <boost/filesystem/path.hpp>
 #include <boost/format.hpp>
 #include <boost/log/trivial.hpp>
 
+#include <tbb/parallel_for.h>
+
 // Mark string for localization and translate.
 #define L(s) Slic3r::I18N::translate(s)
 
@@ -61,6 +63,228 @@ PrintRegion* Print::add_region(const PrintRegionConfig &config)
     return m_regions.back();
 }
 
+// Maps the PrintConfig options to the steps their change invalidates. The table is built once, on first use.
+const PrintStepsInvalidationTable& Print::steps_invalidation_table()
+{
+    static const PrintStepsInvalidationTable table = []() {
+        PrintStepsInvalidationTable table;
+        // Cache the plenty of parameters, which influence the G-code generator only,
+        // or they are only notes not influencing the generated G-code.
+        table.add({
+            "avoid_crossing_perimeters",
+            "avoid_crossing_perimeters_max_detour",
+            "avoid_crossing_not_first_layer",
+            "bed_shape",
+            "bed_temperature",
+            "chamber_temperature",
+            "before_layer_gcode",
+            "between_objects_gcode",
+            "bridge_acceleration",
+            "bridge_fan_speed",
+            "bridge_internal_fan_speed",
+            "colorprint_heights",
+            "complete_objects_sort",
+            "cooling",
+            "default_acceleration",
+            "deretract_speed",
+            "disable_fan_first_layers",
+            "duplicate_distance",
+            "end_gcode",
+            "end_filament_gcode",
+            "external_perimeter_cut_corners",
+            "external_perimeter_fan_speed",
+            "extrusion_axis",
+            "extruder_clearance_height",
+            "extruder_clearance_radius",
+            "extruder_colour",
+            "extruder_offset",
+            "extruder_fan_offset",
+            "extruder_temperature_offset",
+            "extrusion_multiplier",
+            "fan_always_on",
+            "fan_below_layer_time",
+            "fan_kickstart",
+            "fan_speedup_overhangs",
+            "fan_speedup_time",
+            "fan_percentage",
+            "filament_colour",
+            "filament_custom_variables",
+            "filament_diameter",
+            "filament_density",
+            "filament_notes",
+            "filament_cost",
+            "filament_spool_weight",
+            "first_layer_acceleration",
+            "first_layer_bed_temperature",
+            "first_layer_flow_ratio",
+            "first_layer_speed",
+            "first_layer_infill_speed",
+            "first_layer_min_speed",
+            "full_fan_speed_layer",
+            "gap_fill_speed",
+            "gcode_comments",
+            "gcode_filename_illegal_char",
+            "gcode_label_objects",
+            "gcode_precision_xyz",
+            "gcode_precision_e",
+            "infill_acceleration",
+            "layer_gcode",
+            "max_fan_speed",
+            "max_gcode_per_second",
+            "max_print_height",
+            "max_print_speed",
+            "max_volumetric_speed",
+            "min_fan_speed",
+            "min_length",
+            "min_print_speed",
+            "milling_toolchange_end_gcode",
+            "milling_toolchange_start_gcode",
+            "milling_offset",
+            "milling_z_offset",
+            "milling_z_lift",
+#ifdef HAS_PRESSURE_EQUALIZER
+            "max_volumetric_extrusion_rate_slope_positive",
+            "max_volumetric_extrusion_rate_slope_negative",
+#endif /* HAS_PRESSURE_EQUALIZER */
+            "notes",
+            "only_retract_when_crossing_perimeters",
+            "output_filename_format",
+            "perimeter_acceleration",
+            "post_process",
+            "printer_notes",
+            "retract_before_travel",
+            "retract_before_wipe",
+            "retract_layer_change",
+            "retract_length",
+            "retract_length_toolchange",
+            "retract_lift",
+            "retract_lift_above",
+            "retract_lift_below",
+            "retract_lift_first_layer",
+            "retract_lift_top",
+            "retract_restart_extra",
+            "retract_restart_extra_toolchange",
+            "retract_speed",
+            "single_extruder_multi_material_priming",
+            "slowdown_below_layer_time",
+            "standby_temperature_delta",
+            "start_gcode",
+            "start_gcode_manual",
+            "start_filament_gcode",
+            "thin_walls_speed",
+            "time_estimation_compensation",
+            "tool_name",
+            "toolchange_gcode",
+            "top_fan_speed",
+            "threads",
+            "travel_acceleration",
+            "travel_speed",
+            "travel_speed_z",
+            "use_firmware_retraction",
+            "use_relative_e_distances",
+            "use_volumetric_e",
+            "variable_layer_height",
+            "wipe",
+            "wipe_speed",
+            "wipe_extra_perimeter"
+        }, { { psGCodeExport }, {} });
+        table.add({
+            "skirts",
+            "skirt_height",
+            "draft_shield",
+            "skirt_brim",
+            "skirt_distance",
+            "skirt_distance_from_brim",
+            "min_skirt_length",
+            "complete_objects_one_skirt",
+            "complete_objects_one_brim",
+            "ooze_prevention",
+            "wipe_tower_x",
+            "wipe_tower_y",
+            "wipe_tower_rotation_angle"
+        }, { { psSkirt }, {} });
+        table.add({ "complete_objects" }, { { psBrim, psSkirt, psWipeTower }, {} });
+        table.add({
+            "brim_inside_holes",
+            "brim_width",
+            "brim_width_interior",
+            "brim_offset",
+            "brim_ears",
+            "brim_ears_detection_length",
+            "brim_ears_max_angle",
+            "brim_ears_pattern"
+        }, { { psBrim, psSkirt }, {} });
+        // Spiral Vase forces different kind of slicing than the normal model:
+        // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
+        // Therefore toggling the Spiral Vase on / off requires complete reslicing.
+        table.add({
+            "nozzle_diameter",
+            "resolution",
+            "filament_shrink",
+            "spiral_vase",
+            "z_step"
+        }, { {}, { posSlice } });
+        table.add({
+            "filament_type",
+            "filament_soluble",
+            "first_layer_temperature",
+            "filament_loading_speed",
+            "filament_loading_speed_start",
+            "filament_unloading_speed",
+            "filament_unloading_speed_start",
+            "filament_toolchange_delay",
+            "filament_cooling_moves",
+            "filament_minimal_purge_on_wipe_tower",
+            "filament_cooling_initial_speed",
+            "filament_cooling_final_speed",
+            "filament_ramming_parameters",
+            "filament_max_speed",
+            "filament_max_volumetric_speed",
+            "filament_use_skinnydip", // skinnydip params start
+            "filament_use_fast_skinnydip",
+            "filament_skinnydip_distance",
+            "filament_melt_zone_pause",
+            "filament_cooling_zone_pause",
+            "filament_toolchange_temp",
+            "filament_enable_toolchange_temp",
+            "filament_enable_toolchange_part_fan",
+            "filament_toolchange_part_fan_speed",
+            "filament_dip_insertion_speed",
+            "filament_dip_extraction_speed", //skinnydip params end
+            "gcode_flavor",
+            "high_current_on_filament_swap",
+            "infill_first",
+            "single_extruder_multi_material",
+            "temperature",
+            "wipe_tower",
+            "wipe_tower_width",
+            "wipe_tower_bridging",
+            "wipe_tower_no_sparse_layers",
+            "wiping_volumes_matrix",
+            "parking_pos_retraction",
+            "cooling_tube_retraction",
+            "cooling_tube_length",
+            "extra_loading_move",
+            "z_offset",
+            "wipe_tower_brim"
+        }, { { psWipeTower, psSkirt }, {} });
+        table.add({
+            "first_layer_extrusion_width",
+            "min_layer_height",
+            "max_layer_height",
+            "filament_max_overlap"
+        }, { { psSkirt, psBrim }, { posPerimeters, posInfill, posSupportMaterial } });
+        table.add({ "posSlice" },           { {}, { posSlice } });
+        table.add({ "posPerimeters" },      { {}, { posPerimeters } });
+        table.add({ "posPrepareInfill" },   { {}, { posPrepareInfill } });
+        table.add({ "posInfill" },          { {}, { posInfill } });
+        table.add({ "posSupportMaterial" }, { {}, { posSupportMaterial } });
+        table.add({ "posCount" },           { {}, { posSlice, posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial } });
+        return table;
+    }();
+    return table;
+}
+
 // Called by Print::apply().
 // This method only accepts PrintConfig option keys.
 bool Print::invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys)
@@ -68,251 +292,18 @@ bool Print::invalidate_state_by_config_options(const std::vector<t_config_option
     if (opt_keys.empty())
         return false;
 
-    // Cache the plenty of parameters, which influence the G-code generator only,
-    // or they are only notes not influencing the generated G-code.
-    static std::unordered_set<std::string> steps_gcode = {
-        "avoid_crossing_perimeters",
-        "avoid_crossing_perimeters_max_detour",
-        "avoid_crossing_not_first_layer",
-        "bed_shape",
-        "bed_temperature",
-        "chamber_temperature",
-        "before_layer_gcode",
-        "between_objects_gcode",
-        "bridge_acceleration",
-        "bridge_fan_speed",
-        "bridge_internal_fan_speed",
-        "colorprint_heights",
-        "complete_objects_sort",
-        "cooling",
-        "default_acceleration",
-        "deretract_speed",
-        "disable_fan_first_layers",
-        "duplicate_distance",
-        "end_gcode",
-        "end_filament_gcode",
-        "external_perimeter_cut_corners",
-        "external_perimeter_fan_speed",
-        "extrusion_axis",
-        "extruder_clearance_height",
-        "extruder_clearance_radius",
-        "extruder_colour",
-        "extruder_offset",
-        "extruder_fan_offset"
-        "extruder_temperature_offset",
-        "extrusion_multiplier",
-        "fan_always_on",
-        "fan_below_layer_time",
-        "fan_kickstart",
-        "fan_speedup_overhangs",
-        "fan_speedup_time",
-        "fan_percentage",
-        "filament_colour",
-        "filament_custom_variables",
-        "filament_diameter",
-        "filament_density",
-        "filament_notes",
-        "filament_cost",
-        "filament_spool_weight",
-        "first_layer_acceleration",
-        "first_layer_bed_temperature",
-        "first_layer_flow_ratio",
-        "first_layer_speed",
-        "first_layer_infill_speed",
-        "first_layer_min_speed",
-        "full_fan_speed_layer",
-        "gap_fill_speed",
-        "gcode_comments",
-        "gcode_filename_illegal_char",
-        "gcode_label_objects",
-        "gcode_precision_xyz",
-        "gcode_precision_e",
-        "infill_acceleration",
-        "layer_gcode",
-        "max_fan_speed",
-        "max_gcode_per_second",
-        "max_print_height",
-        "max_print_speed",
-        "max_volumetric_speed",
-        "min_fan_speed",
-        "min_length",
-        "min_print_speed",
-        "milling_toolchange_end_gcode",
-        "milling_toolchange_start_gcode",
-        "milling_offset",
-        "milling_z_offset",
-        "milling_z_lift",
-#ifdef HAS_PRESSURE_EQUALIZER
-        "max_volumetric_extrusion_rate_slope_positive",
-        "max_volumetric_extrusion_rate_slope_negative",
-#endif /* HAS_PRESSURE_EQUALIZER */
-        "notes",
-        "only_retract_when_crossing_perimeters",
-        "output_filename_format",
-        "perimeter_acceleration",
-        "post_process",
-        "printer_notes",
-        "retract_before_travel",
-        "retract_before_wipe",
-        "retract_layer_change",
-        "retract_length",
-        "retract_length_toolchange",
-        "retract_lift",
-        "retract_lift_above",
-        "retract_lift_below",
-        "retract_lift_first_layer",
-        "retract_lift_top",
-        "retract_restart_extra",
-        "retract_restart_extra_toolchange",
-        "retract_speed",
-        "single_extruder_multi_material_priming",
-        "slowdown_below_layer_time",
-        "standby_temperature_delta",
-        "start_gcode",
-        "start_gcode_manual",
-        "start_filament_gcode",
-        "thin_walls_speed",
-        "time_estimation_compensation",
-        "tool_name",
-        "toolchange_gcode",
-        "top_fan_speed",
-        "threads",
-        "travel_acceleration",
-        "travel_speed",
-        "travel_speed_z",
-        "use_firmware_retraction",
-        "use_relative_e_distances",
-        "use_volumetric_e",
-        "variable_layer_height",
-        "wipe",
-        "wipe_speed",
-        "wipe_extra_perimeter"
-    };
-
-    static std::unordered_set<std::string> steps_ignore;
+    const PrintStepsInvalidationTable &table = Print::steps_invalidation_table();
 
-    std::vector<PrintStep> steps;
-    std::vector<PrintObjectStep> osteps;
+    uint32_t steps  = 0;
+    uint32_t osteps = 0;
     bool invalidated = false;
 
     for (const t_config_option_key &opt_key : opt_keys) {
-        if (steps_gcode.find(opt_key) != steps_gcode.end()) {
-            // These options only affect G-code export or they are just notes without influence on the generated G-code,
-            // so there is nothing to invalidate.
-            steps.emplace_back(psGCodeExport);
-        } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
-            // These steps have no influence on the G-code whatsoever. Just ignore them.
-        } else if (
-               opt_key == "skirts"
-            || opt_key == "skirt_height"
-            || opt_key == "draft_shield"
-            || opt_key == "skirt_brim"
-            || opt_key == "skirt_distance"
-            || opt_key == "skirt_distance_from_brim"
-            || opt_key == "min_skirt_length"
-            || opt_key == "complete_objects_one_skirt"
-            || opt_key == "complete_objects_one_brim"
-            || opt_key == "ooze_prevention"
-            || opt_key == "wipe_tower_x"
-            || opt_key == "wipe_tower_y"
-            || opt_key == "wipe_tower_rotation_angle") {
-            steps.emplace_back(psSkirt);
-        } else if (
-            opt_key == "complete_objects") {
-            steps.emplace_back(psBrim);
-            steps.emplace_back(psSkirt);
-            steps.emplace_back(psWipeTower);
-        } else if (
-            opt_key == "brim_inside_holes"
-            || opt_key == "brim_width"
-            || opt_key == "brim_width_interior"
-            || opt_key == "brim_offset"
-            || opt_key == "brim_ears"
-            || opt_key == "brim_ears_detection_length"
-            || opt_key == "brim_ears_max_angle"
-            || opt_key == "brim_ears_pattern") {
-            steps.emplace_back(psBrim);
-            steps.emplace_back(psSkirt);
-        } else if (
-               opt_key == "nozzle_diameter"
-            || opt_key == "resolution"
-            || opt_key == "filament_shrink"
-            // Spiral Vase forces different kind of slicing than the normal model:
-            // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
-            // Therefore toggling the Spiral Vase on / off requires complete reslicing.
-            || opt_key == "spiral_vase"
-            || opt_key == "z_step") {
-            osteps.emplace_back(posSlice);
-        } else if (
-               opt_key == "filament_type"
-            || opt_key == "filament_soluble"
-            || opt_key == "first_layer_temperature"
-            || opt_key == "filament_loading_speed"
-            || opt_key == "filament_loading_speed_start"
-            || opt_key == "filament_unloading_speed"
-            || opt_key == "filament_unloading_speed_start"
-            || opt_key == "filament_toolchange_delay"
-            || opt_key == "filament_cooling_moves"
-            || opt_key == "filament_minimal_purge_on_wipe_tower"
-            || opt_key == "filament_cooling_initial_speed"
-            || opt_key == "filament_cooling_final_speed"
-            || opt_key == "filament_ramming_parameters"
-            || opt_key == "filament_max_speed"
-            || opt_key == "filament_max_volumetric_speed"
-            || opt_key == "filament_use_skinnydip"        // skinnydip params start
-            || opt_key == "filament_use_fast_skinnydip"
-            || opt_key == "filament_skinnydip_distance"
-            || opt_key == "filament_melt_zone_pause"
-            || opt_key == "filament_cooling_zone_pause"
-            || opt_key == "filament_toolchange_temp"
-            || opt_key == "filament_enable_toolchange_temp"
-            || opt_key == "filament_enable_toolchange_part_fan"
-            || opt_key == "filament_toolchange_part_fan_speed"
-            || opt_key == "filament_dip_insertion_speed"
-            || opt_key == "filament_dip_extraction_speed"    //skinnydip params end	
-            || opt_key == "gcode_flavor"
-            || opt_key == "high_current_on_filament_swap"
-            || opt_key == "infill_first"
-            || opt_key == "single_extruder_multi_material"
-            || opt_key == "temperature"
-            || opt_key == "wipe_tower"
-            || opt_key == "wipe_tower_width"
-            || opt_key == "wipe_tower_bridging"
-            || opt_key == "wipe_tower_no_sparse_layers"
-            || opt_key == "wiping_volumes_matrix"
-            || opt_key == "parking_pos_retraction"
-            || opt_key == "cooling_tube_retraction"
-            || opt_key == "cooling_tube_length"
-            || opt_key == "extra_loading_move"
-            || opt_key == "z_offset"
-            || opt_key == "wipe_tower_brim") {
-            steps.emplace_back(psWipeTower);
-            steps.emplace_back(psSkirt);
-        }
-        else if (
-            opt_key == "first_layer_extrusion_width"
-            || opt_key == "min_layer_height"
-            || opt_key == "max_layer_height"
-            || opt_key == "filament_max_overlap") {
-            osteps.emplace_back(posPerimeters);
-            osteps.emplace_back(posInfill);
-            osteps.emplace_back(posSupportMaterial);
-            steps.emplace_back(psSkirt);
-            steps.emplace_back(psBrim);
-        }
-        else if (opt_key == "posSlice")
-            osteps.emplace_back(posSlice);
-        else if (opt_key == "posPerimeters")
-            osteps.emplace_back(posPerimeters);
-        else if (opt_key == "posPrepareInfill")
-            osteps.emplace_back(posPrepareInfill);
-        else if (opt_key == "posInfill")
-            osteps.emplace_back(posInfill);
-        else if (opt_key == "posSupportMaterial")
-            osteps.emplace_back(posSupportMaterial);
-        else if (opt_key == "posCount")
-            osteps.emplace_back(posCount);
-        else {
+        const PrintStepsInvalidation *invalidation = table.find(opt_key);
+        if (invalidation != nullptr) {
+            steps  |= invalidation->print;
+            osteps |= invalidation->object;
+        } else {
             // for legacy, if we can't handle this option let's invalidate all steps
             //FIXME invalidate all steps of all objects as well?
             invalidated |= this->invalidate_all_steps();
@@ -320,13 +311,13 @@ bool Print::invalidate_state_by_config_options(const std::vector<t_config_option
         }
     }
 
-    sort_remove_duplicates(steps);
-    for (PrintStep step : steps)
-        invalidated |= this->invalidate_step(step);
-    sort_remove_duplicates(osteps);
-    for (PrintObjectStep ostep : osteps)
-        for (PrintObject *object : m_objects)
-            invalidated |= object->invalidate_step(ostep);
+    for (int step = 0; step < psCount; ++ step)
+        if (steps & (1u << step))
+            invalidated |= this->invalidate_step(PrintStep(step));
+    for (int ostep = 0; ostep < posCount; ++ ostep)
+        if (osteps & (1u << ostep))
+            for (PrintObject *object : m_objects)
+                invalidated |= object->invalidate_step(PrintObjectStep(ostep));
     return invalidated;
 }
 
@@ -629,8 +620,10 @@ void Print::config_diffs(
     {
 	    const std::vector<std::string> &extruder_retract_keys = print_config_def.extruder_retract_keys();
 	    const std::string               filament_prefix       = "filament_";
-	    for (const t_config_option_key &opt_key : m_config.keys()) {
-	        const ConfigOption *opt_old = m_config.option(opt_key);
+	    const t_config_option_keys     &print_keys            = m_config.keys_ref();
+	    for (size_t idx = 0; idx < print_keys.size(); ++ idx) {
+	        const t_config_option_key &opt_key = print_keys[idx];
+	        const ConfigOption *opt_old = m_config.option_by_index(idx);
 	        assert(opt_old != nullptr);
 	        const ConfigOption *opt_new = new_full_config.option(opt_key);
 			// assert(opt_new != nullptr);
@@ -1183,10 +1176,19 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
         if (this_region_config_set) {
             t_config_option_keys diff = region.config().diff(this_region_config);
             if (! diff.empty()) {
-                region.config_apply_only(this_region_config, diff, false);
+                // The neighbor layers are affected as far as reached by either the old or the new region configs.
+                std::vector<coordf_t> z_margins;
+                z_margins.reserve(m_objects.size());
                 for (PrintObject *print_object : m_objects)
+                    z_margins.emplace_back(print_object->neighbor_layers_z_margin());
+                region.config_apply_only(this_region_config, diff, false);
+                for (size_t idx_object = 0; idx_object < m_objects.size(); ++ idx_object) {
+                    PrintObject *print_object = m_objects[idx_object];
                     if (region_id < print_object->region_volumes.size() && ! print_object->region_volumes[region_id].empty())
-                        update_apply_status(print_object->invalidate_state_by_config_options(diff));
+                        // A region of a layer range modifier invalidates just the layers of its layer ranges.
+                        update_apply_status(print_object->invalidate_state_by_config_options(diff, print_object->region_z_range(region_id),
+                            std::max(z_margins[idx_object], print_object->neighbor_layers_z_margin())));
+                }
             }
         }
     }
@@ -1799,17 +1801,38 @@ void Print::process()
     name_tbb_thread_pool_threads();
     bool something_done = !is_step_done_unguarded(psBrim);
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
-    for (PrintObject *obj : m_objects)
-        obj->make_perimeters();
-    this->set_status(70, L("Infilling layers"));
-    //note: as object seems to be sliced independantly, it's maybe possible to add a tbb parallel_loop with simple partitioner on infill,
-    //  as prepare_infill has some function not // 
-    for (PrintObject *obj : m_objects)
-        obj->infill();
-    for (PrintObject *obj : m_objects)
-        obj->ironing();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_material();
+    // The objects are sliced independently, thus each object runs its own chain of steps
+    // (posSlice -> posPerimeters -> posPrepareInfill -> posInfill -> posIroning -> posSupportMaterial)
+    // and an object may be infilled while another one is still generating its perimeters.
+    // The steps of a single object are kept serial, as PrintState tracks a single active step per object.
+    // An exception must not leave its task: TBB would cancel the other objects' nested parallel loops silently
+    // and their steps would be marked as done while incomplete. The exceptions are collected instead
+    // and the one of the first failing object is rethrown, as if the objects were processed in sequence.
+    {
+        std::vector<std::exception_ptr> object_exceptions(m_objects.size());
+        // Reported once, by the first object done with its perimeters.
+        std::once_flag                  infill_status;
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_objects.size(), 1),
+            [this, &object_exceptions, &infill_status](const tbb::blocked_range<size_t>& range) {
+                for (size_t object_idx = range.begin(); object_idx < range.end(); ++ object_idx) {
+                    PrintObject *obj = m_objects[object_idx];
+                    try {
+                        obj->make_perimeters();
+                        std::call_once(infill_status, [this]() { this->set_status(70, L("Infilling layers")); });
+                        obj->infill();
+                        obj->ironing();
+                        obj->generate_support_material();
+                    } catch (...) {
+                        object_exceptions[object_idx] = std::current_exception();
+                    }
+                }
+            },
+            tbb::simple_partitioner());
+        for (std::exception_ptr &ex : object_exceptions)
+            if (ex)
+                std::rethrow_exception(ex);
+    }
     if (this->set_started(psWipeTower)) {
         m_wipe_tower_data.clear();
         m_tool_ordering.clear();
@@ -16,6 +16,8 @@
 
 #include "libslic3r.h"
 
+#include <unordered_map>
+
 namespace Slic3r {
 
 class Print;
@@ -54,6 +56,46 @@ enum PrintObjectStep {
     posInfill, posIroning, posSupportMaterial, posCount,
 };
 
+// Steps of a Print and of its PrintObjects invalidated by a change of a configuration option,
+// as bit masks indexed by PrintStep resp. PrintObjectStep.
+struct PrintStepsInvalidation
+{
+    PrintStepsInvalidation(std::initializer_list<PrintStep> psteps, std::initializer_list<PrintObjectStep> osteps)
+    {
+        for (PrintStep step : psteps)
+            print |= 1u << step;
+        for (PrintObjectStep step : osteps)
+            object |= 1u << step;
+    }
+
+    uint32_t print  { 0 };
+    uint32_t object { 0 };
+};
+
+// Maps the keys of configuration options to the steps their change invalidates.
+class PrintStepsInvalidationTable
+{
+public:
+    // Each option is added once, with all the steps its change invalidates.
+    void add(std::initializer_list<const char*> opt_keys, const PrintStepsInvalidation &steps)
+    {
+        for (const char *opt_key : opt_keys) {
+            assert(m_map.find(opt_key) == m_map.end());
+            m_map.emplace(opt_key, steps);
+        }
+    }
+
+    // Returns nullptr for an unknown option.
+    const PrintStepsInvalidation* find(const t_config_option_key &opt_key) const
+    {
+        auto it = m_map.find(opt_key);
+        return it == m_map.end() ? nullptr : &it->second;
+    }
+
+private:
+    std::unordered_map<t_config_option_key, PrintStepsInvalidation> m_map;
+};
+
 // A PrintRegion object represents a group of volumes to print
 // sharing the same config (including the same assigned extruder(s))
 class PrintRegion
@@ -193,6 +235,9 @@ public:
 
     // Called by make_perimeters()
     void slice();
+    // Called by the G-code export, creates Layer::lslices_grid of the layers missing it in parallel.
+    // The grids are kept with the layers, therefore they are created again only after posSlice was invalidated.
+    void make_lslices_grids();
 
     // Helpers to slice support enforcer / blocker meshes by the support generator.
     std::vector<ExPolygons>     slice_support_volumes(const ModelVolumeType &model_volume_type) const;
@@ -207,6 +252,9 @@ public:
     const ExtrusionEntityCollection& skirt() const { return m_skirt; }
     const ExtrusionEntityCollection& brim() const { return m_brim; }
 
+    // Steps invalidated by a change of the PrintObjectConfig and PrintRegionConfig options.
+    static const PrintStepsInvalidationTable& steps_invalidation_table();
+
 protected:
     // to be called from Print only.
     friend class Print;
@@ -219,10 +267,20 @@ protected:
     PrintBase::ApplyStatus  set_instances(PrintInstances &&instances);
     // Invalidates the step, and its depending steps in PrintObject and Print.
     bool                    invalidate_step(PrintObjectStep step);
+    // Invalidates the layers of the step inside z_range, and the layers of its depending steps inside z_range extended by z_margin.
+    bool                    invalidate_step(PrintObjectStep step, const t_layer_height_range &z_range, coordf_t z_margin);
     // Invalidates all PrintObject and Print steps.
     bool                    invalidate_all_steps();
     // Invalidate steps based on a set of parameters changed.
-    bool                    invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys);
+    bool                    invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys)
+        { return this->invalidate_state_by_config_options(opt_keys, PrintStateBase::full_z_range(), 0.); }
+    // Invalidate steps based on a set of parameters changed for the layers inside z_range only.
+    bool                    invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys, const t_layer_height_range &z_range, coordf_t z_margin);
+    // Z span of the layers covered by the volumes of a region, limited by the layer ranges of the volumes.
+    t_layer_height_range    region_z_range(size_t region_id) const;
+    // Z distance, over which the passes of prepare_infill() looking at the neighbor layers propagate a change of a region,
+    // calculated over all the regions of this object.
+    coordf_t                neighbor_layers_z_margin() const;
     // If ! m_slicing_params.valid, recalculate.
     void                    update_slicing_parameters();
 
@@ -254,6 +312,10 @@ private:
     void discover_horizontal_shells();
     void combine_infill();
     void _generate_support_material();
+    // Indices [begin, end) of the layers to be recomputed by an invalidated step.
+    std::pair<size_t, size_t> invalid_layers(PrintObjectStep step) const;
+    // Indices [begin, end) of the layers to be filled by infill() or ironed by ironing().
+    std::pair<size_t, size_t> invalid_fill_layers(PrintObjectStep step) const;
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> prepare_adaptive_infill_data();
 
     // XYZ in scaled coordinates
@@ -491,6 +553,8 @@ public:
 
     //put this in public to be accessible for tests, it was in private before.
     bool                invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys);
+    // Steps invalidated by a change of the PrintConfig options.
+    static const PrintStepsInvalidationTable& steps_invalidation_table();
 protected:
     // methods for handling regions
     PrintRegion*        get_region(size_t idx)        { return m_regions[idx]; }
@@ -2,6 +2,7 @@
 #define slic3r_PrintBase_hpp_
 
 #include "libslic3r.h"
+#include <cfloat>
 #include <set>
 #include <vector>
 #include <string>
@@ -33,6 +34,9 @@ public:
         DONE,
     };
 
+    // Z span of all the layers of an object, to be recomputed by a step invalidated as a whole.
+    static t_layer_height_range full_z_range() { return t_layer_height_range(- DBL_MAX, DBL_MAX); }
+
     enum class WarningLevel {
         NON_CRITICAL,
         CRITICAL
@@ -82,7 +86,7 @@ template <class StepType, size_t COUNT>
 class PrintState : public PrintStateBase
 {
 public:
-    PrintState() {}
+    PrintState() { std::fill(m_invalid_z_range, m_invalid_z_range + COUNT, full_z_range()); }
 
     StateWithTimeStamp state_with_timestamp(StepType step, tbb::mutex &mtx) const {
         tbb::mutex::scoped_lock lock(mtx);
@@ -116,6 +120,13 @@ public:
         return this->state_with_timestamp_unguarded(step).state == DONE;
     }
 
+    // Z span of the layers to be recomputed by a step, which is not DONE.
+    // The layers of a step outside of this span are valid and they may be kept by the step.
+    t_layer_height_range invalid_z_range(StepType step, tbb::mutex &mtx) const {
+        tbb::mutex::scoped_lock lock(mtx);
+        return m_invalid_z_range[step];
+    }
+
     // Set the step as started. Block on mutex while the Print / PrintObject / PrintRegion objects are being
     // modified by the UI thread.
     // This is necessary to block until the Print::apply() updates its state, which may
@@ -180,6 +191,7 @@ public:
     // processing by calling the cancel callback.
     template<typename CancelationCallback>
     bool invalidate(StepType step, CancelationCallback cancel) {
+        m_invalid_z_range[step] = full_z_range();
         bool invalidated = m_state[step].state != INVALID;
         if (invalidated) {
 #if 0
@@ -203,10 +215,26 @@ public:
         return invalidated;
     }
 
+    // Make the layers of the step inside z_range invalid, the layers outside of z_range stay valid.
+    // If the step is not DONE, the span of its layers already waiting to be recomputed is extended by z_range.
+    // PrintBase::m_state_mutex should be locked at this point, guarding access to m_state.
+    template<typename CancelationCallback>
+    bool invalidate_z_range(StepType step, const t_layer_height_range &z_range, CancelationCallback cancel) {
+        t_layer_height_range invalid_z_range = z_range;
+        if (m_state[step].state != DONE) {
+            invalid_z_range.first  = std::min(invalid_z_range.first,  m_invalid_z_range[step].first);
+            invalid_z_range.second = std::max(invalid_z_range.second, m_invalid_z_range[step].second);
+        }
+        bool invalidated = this->invalidate(step, cancel);
+        m_invalid_z_range[step] = invalid_z_range;
+        return invalidated;
+    }
+
     template<typename CancelationCallback, typename StepTypeIterator>
     bool invalidate_multiple(StepTypeIterator step_begin, StepTypeIterator step_end, CancelationCallback cancel) {
         bool invalidated = false;
         for (StepTypeIterator it = step_begin; it != step_end; ++ it) {
+            m_invalid_z_range[*it] = full_z_range();
             StateWithTimeStamp &state = m_state[*it];
             if (state.state != INVALID) {
                 invalidated = true;
@@ -242,6 +270,7 @@ public:
     bool invalidate_all(CancelationCallback cancel) {
         bool invalidated = false;
         for (size_t i = 0; i < COUNT; ++ i) {
+            m_invalid_z_range[i] = full_z_range();
             StateWithTimeStamp &state = m_state[i];
             if (state.state != INVALID) {
                 invalidated = true;
@@ -296,6 +325,9 @@ public:
 
 private:
     StateWithWarnings   m_state[COUNT];
+    // Z span of the layers to be recomputed by a step, see invalidate_z_range().
+    // Only valid if the step is not DONE.
+    t_layer_height_range m_invalid_z_range[COUNT];
     // Active class StepType or -1 if none is active.
     // If the background processing is canceled, m_step_active may not be resetted
     // to -1, see the comment in this->set_started().
@@ -562,6 +594,8 @@ public:
     bool            is_step_done(PrintObjectStepEnum step) const { return m_state.is_done(step, PrintObjectBase::state_mutex(m_print)); }
     PrintStateBase::StateWithTimeStamp step_state_with_timestamp(PrintObjectStepEnum step) const { return m_state.state_with_timestamp(step, PrintObjectBase::state_mutex(m_print)); }
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintObjectStepEnum step) const { return m_state.state_with_warnings(step, PrintObjectBase::state_mutex(m_print)); }
+    // Z span of the layers to be recomputed by a step, which is not DONE.
+    t_layer_height_range step_invalid_z_range(PrintObjectStepEnum step) const { return m_state.invalid_z_range(step, PrintObjectBase::state_mutex(m_print)); }
 
 protected:
 	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) {}
@@ -577,6 +611,9 @@ protected:
 
     bool            invalidate_step(PrintObjectStepEnum step)
         { return m_state.invalidate(step, PrintObjectBase::cancel_callback(m_print)); }
+    // Invalidate just the layers of the step inside z_range.
+    bool            invalidate_step_z_range(PrintObjectStepEnum step, const t_layer_height_range &z_range)
+        { return m_state.invalidate_z_range(step, z_range, PrintObjectBase::cancel_callback(m_print)); }
     template<typename StepTypeIterator>
     bool            invalidate_steps(StepTypeIterator step_begin, StepTypeIterator step_end) 
         { return m_state.invalidate_multiple(step_begin, step_end, PrintObjectBase::cancel_callback(m_print)); }
@@ -556,12 +556,39 @@ protected:
             return (it == m_map_name_to_offset.end()) ? nullptr : reinterpret_cast<const ConfigOption*>((const char*)owner + it->second);
         }
 
+        // Find a ConfigOption by its dense index, which is the index of its name in keys().
+        const ConfigOption* optptr(size_t idx, const T *owner) const
+        {
+            assert(idx < m_offsets.size());
+            return reinterpret_cast<const ConfigOption*>((const char*)owner + m_offsets[idx]);
+        }
+
         const std::vector<std::string>& keys()      const { return m_keys; }
         const T&                        defaults()  const { return *m_defaults; }
 
+        // Same as ConfigBase::diff(other), but both the keys of this cache and the options of a DynamicConfig
+        // are sorted, thus they are merged in a single pass and the options of the owner are addressed by their index.
+        t_config_option_keys diff(const T *owner, const DynamicConfig &other) const
+        {
+            t_config_option_keys diff;
+            auto it_other = other.cbegin();
+            for (size_t idx = 0; idx < m_keys.size(); ++ idx) {
+                const std::string &opt_key = m_keys[idx];
+                while (it_other != other.cend() && it_other->first < opt_key)
+                    ++ it_other;
+                // Fall back to the lookup by name, which resolves the parent of a DynamicConfig.
+                const ConfigOption *other_opt = it_other != other.cend() && it_other->first == opt_key ?
+                    it_other->second.get() : other.option(opt_key);
+                const ConfigOption *this_opt  = this->optptr(idx, owner);
+                if (other_opt != nullptr && (*this_opt != *other_opt || this_opt->is_phony() != other_opt->is_phony()))
+                    diff.emplace_back(opt_key);
+            }
+            return diff;
+        }
+
     private:
         // To be called during the StaticCache setup.
-        // Collect option keys from m_map_name_to_offset,
+        // Collect option keys from m_map_name_to_offset and their offsets indexed the same way,
         // assign default values to m_defaults.
         void                finalize(T* defaults)
         {
@@ -571,6 +598,8 @@ protected:
             m_defaults = defaults;
             m_keys.clear();
             m_keys.reserve(m_map_name_to_offset.size());
+            m_offsets.clear();
+            m_offsets.reserve(m_map_name_to_offset.size());
             for (const auto& kvp : defs->options) {
                 // Find the option given the option name kvp.first by an offset from (char*)m_defaults.
                 ConfigOption* opt = this->optptr(kvp.first, m_defaults);
@@ -578,6 +607,7 @@ protected:
                     // This option is not defined by the ConfigBase of type T.
                     continue;
                 m_keys.emplace_back(kvp.first);
+                m_offsets.emplace_back(m_map_name_to_offset.find(kvp.first)->second);
                 const ConfigOptionDef* def = defs->get(kvp.first);
                 assert(def != nullptr);
                 if (def->default_value)
@@ -587,6 +617,8 @@ protected:
 
         T                                  *m_defaults;
         std::vector<std::string>            m_keys;
+        // Offsets of the options from the owner, indexed the same as m_keys.
+        std::vector<ptrdiff_t>              m_offsets;
     };
 };
 
@@ -606,6 +638,11 @@ public: \
     /* Overrides ConfigBase::keys(). Collect names of all configuration values maintained by this configuration store. */ \
     t_config_option_keys     keys() const override { return config_cache().keys(); } \
     const t_config_option_keys& keys_ref() const override { return config_cache().keys(); } \
+    /* Find a ConfigOption by its dense index, which is the index of its name in keys(). */ \
+    const ConfigOption*      option_by_index(size_t idx) const { return config_cache().optptr(idx, this); } \
+    /* Diff against a DynamicConfig in a single pass over the sorted keys of both configs. */ \
+    using                    ConfigBase::diff; \
+    t_config_option_keys     diff(const DynamicConfig &other) const { return config_cache().diff(this, other); } \
     static const CLASS_NAME& defaults() { return config_cache().defaults(); } \
 private: \
     static const StaticPrintConfig::StaticCache<CLASS_NAME>& config_cache() \
@@ -12,6 +12,7 @@
 #include "Tesselate.hpp"
 #include "Utils.hpp"
 #include "Fill/FillAdaptive.hpp"
+#include "Fill/FillPlanePath.hpp"
 #include "Format/STL.hpp"
 
 #include <utility>
@@ -142,6 +143,8 @@ namespace Slic3r {
                 layer.lslices_bboxes.reserve(layer.lslices.size());
                 for (const ExPolygon& expoly : layer.lslices)
                     layer.lslices_bboxes.emplace_back(get_extents(expoly));
+                // The grid points to the lslices, it is created again by make_lslices_grids().
+                layer.lslices_grid.reset();
                 layer.backup_untyped_slices();
             }
         });
@@ -150,6 +153,30 @@ namespace Slic3r {
         this->set_done(posSlice);
     }
 
+    void PrintObject::make_lslices_grids()
+    {
+        BOOST_LOG_TRIVIAL(debug) << "Creating the edge grids of the slices in parallel - begin";
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_layers.size()),
+            [this](const tbb::blocked_range<size_t>& range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+                Layer& layer = *m_layers[layer_idx];
+                if (layer.lslices_grid)
+                    continue;
+                m_print->throw_if_canceled();
+                // Same bounding box as used by AvoidCrossingPerimeters, same resolution as used for the seam placement.
+                BoundingBox bbox_slice(get_extents(layer.lslices));
+                bbox_slice.offset(SCALED_EPSILON);
+                auto grid = std::make_unique<EdgeGrid::Grid>();
+                grid->set_bbox(bbox_slice);
+                grid->create(layer.lslices, coord_t(scale_(1.) + 0.5));
+                grid->calculate_sdf();
+                layer.lslices_grid = std::move(grid);
+            }
+        });
+        BOOST_LOG_TRIVIAL(debug) << "Creating the edge grids of the slices in parallel - end";
+    }
+
 
 
     Polygons create_polyholes(const Point center, const coord_t radius, const coord_t nozzle_diameter, bool multiple)
@@ -306,6 +333,7 @@ namespace Slic3r {
         BOOST_LOG_TRIVIAL(info) << "Generating perimeters..." << log_memory_info();
 
         // Revert the typed slices into untyped slices.
+        // All layers are reverted, as prepare_infill() classifies the slices of the whole object again.
         if (m_typed_slices) {
             for (Layer* layer : m_layers) {
                 layer->restore_untyped_slices();
@@ -314,9 +342,13 @@ namespace Slic3r {
             m_typed_slices = false;
         }
 
+        // Only the layers invalidated by a layer range modifier are recomputed, the perimeters of the other layers are kept.
+        const std::pair<size_t, size_t> layers_range = this->invalid_layers(posPerimeters);
+        const size_t nb_layers = layers_range.second - layers_range.first;
+
         // atomic counter for gui progress
         std::atomic<int> atomic_count{ 0 };
-        int nb_layers_update = std::max(1, (int)m_layers.size() / 20);
+        int nb_layers_update = std::max(1, (int)nb_layers / 20);
         std::chrono::time_point<std::chrono::system_clock> last_update = std::chrono::system_clock::now();
 
         // compare each layer to the one below, and mark those slices needing
@@ -333,7 +365,7 @@ namespace Slic3r {
 
             BOOST_LOG_TRIVIAL(debug) << "Generating extra perimeters for region " << region_id << " in parallel - start";
             tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, m_layers.size() - 1),
+                tbb::blocked_range<size_t>(layers_range.first, std::max(layers_range.first, std::min(layers_range.second, m_layers.size() - 1))),
                 [this, &region, region_id](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                     m_print->throw_if_canceled();
@@ -391,8 +423,8 @@ namespace Slic3r {
 
         BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
         tbb::parallel_for(
-            tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this, &atomic_count, &last_update, nb_layers_update](const tbb::blocked_range<size_t>& range) {
+            tbb::blocked_range<size_t>(layers_range.first, layers_range.second),
+            [this, &atomic_count, &last_update, nb_layers_update, nb_layers](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                 std::chrono::time_point<std::chrono::system_clock> start_make_perimeter = std::chrono::system_clock::now();
                 m_print->throw_if_canceled();
@@ -405,7 +437,7 @@ namespace Slic3r {
                     if ((static_cast<std::chrono::duration<double>>(end_make_perimeter - last_update)).count() > 0.2) {
                         // note: i don't care if a thread erase last_update in-between here
                         last_update = std::chrono::system_clock::now();
-                        m_print->set_status( int((nb_layers_done * 100) / m_layers.size()), L("Generating perimeters: layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(m_layers.size()) });
+                        m_print->set_status( int((nb_layers_done * 100) / nb_layers), L("Generating perimeters: layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(nb_layers) });
                     }
                 }
             }
@@ -417,7 +449,7 @@ namespace Slic3r {
         if (print()->config().milling_diameter.size() > 0) {
             BOOST_LOG_TRIVIAL(debug) << "Generating milling post-process in parallel - start";
             tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, m_layers.size()),
+                tbb::blocked_range<size_t>(layers_range.first, layers_range.second),
                 [this](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                     m_print->throw_if_canceled();
@@ -577,20 +609,26 @@ namespace Slic3r {
 
         if (this->set_started(posInfill)) {
             auto [adaptive_fill_octree, support_fill_octree] = this->prepare_adaptive_infill_data();
+            // The curves of the plane path patterns are shared by the layers of this object and released once they are filled.
+            PlanePathCurveCache plane_path_curves;
+
+            // Only the layers invalidated by a layer range modifier are filled again, the fills of the other layers are kept.
+            std::pair<size_t, size_t> layers_range = this->invalid_fill_layers(posInfill);
+            const size_t nb_layers = layers_range.second - layers_range.first;
 
             // atomic counter for gui progress
             std::atomic<int> atomic_count{ 0 };
-            int nb_layers_update = std::max(1, (int)m_layers.size() / 20);
+            int nb_layers_update = std::max(1, (int)nb_layers / 20);
             std::chrono::time_point<std::chrono::system_clock> last_update = std::chrono::system_clock::now();
 
             BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start";
             tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, m_layers.size()),
-                [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree, &atomic_count , &last_update, nb_layers_update](const tbb::blocked_range<size_t>& range) {
+                tbb::blocked_range<size_t>(layers_range.first, layers_range.second),
+                [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree, &plane_path_curves, &atomic_count , &last_update, nb_layers_update, nb_layers](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                     std::chrono::time_point<std::chrono::system_clock> start_make_fill = std::chrono::system_clock::now();
                     m_print->throw_if_canceled();
-                    m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get());
+                    m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), &plane_path_curves);
 
                     // updating progress
                     int nb_layers_done = (++atomic_count);
@@ -599,7 +637,7 @@ namespace Slic3r {
                         if ((static_cast<std::chrono::duration<double>>(end_make_fill - last_update)).count() > 0.2) {
                             // note: i don't care if a thread erase last_update in-between here
                             last_update = std::chrono::system_clock::now();
-                            m_print->set_status( int((nb_layers_done * 100) / m_layers.size()), L("Infilling layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(m_layers.size()) });
+                            m_print->set_status( int((nb_layers_done * 100) / nb_layers), L("Infilling layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(nb_layers) });
                         }
                     }
                 }
@@ -621,9 +659,11 @@ namespace Slic3r {
     void PrintObject::ironing()
     {
         if (this->set_started(posIroning)) {
+            // make_fills() clears the ironing, thus ironing() goes over the same layers as infill().
+            std::pair<size_t, size_t> layers_range = this->invalid_fill_layers(posIroning);
             BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
             tbb::parallel_for(
-                tbb::blocked_range<size_t>(1, m_layers.size()),
+                tbb::blocked_range<size_t>(std::max(size_t(1), layers_range.first), std::max(size_t(1), layers_range.second)),
                 [this](const tbb::blocked_range<size_t>& range) {
                     for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                         m_print->throw_if_canceled();
@@ -730,222 +770,241 @@ namespace Slic3r {
         return m_support_layers.insert(pos, new SupportLayer(id, this, height, print_z, slice_z));
     }
 
+    // Maps the PrintObjectConfig and PrintRegionConfig options to the steps their change invalidates.
+    // The options depending on the current configuration are not in the table. The table is built once, on first use.
+    const PrintStepsInvalidationTable& PrintObject::steps_invalidation_table()
+    {
+        static const PrintStepsInvalidationTable table = []() {
+            PrintStepsInvalidationTable table;
+            table.add({
+                "gap_fill",
+                "gap_fill_last",
+                "gap_fill_min_area",
+                "only_one_perimeter_first_layer",
+                "only_one_perimeter_top",
+                "only_one_perimeter_top_other_algo",
+                "overhangs_width_speed",
+                "overhangs_width",
+                "overhangs_reverse",
+                "overhangs_reverse_threshold",
+                "perimeter_extrusion_spacing",
+                "perimeter_extrusion_width",
+                "infill_overlap",
+                "thin_perimeters",
+                "thin_perimeters_all",
+                "thin_walls",
+                "thin_walls_min_width",
+                "thin_walls_overlap",
+                "external_perimeters_first",
+                "external_perimeters_hole",
+                "external_perimeters_nothole",
+                "external_perimeter_extrusion_spacing",
+                "external_perimeters_vase",
+                "perimeter_loop",
+                "perimeter_loop_seam"
+            }, { {}, { posPerimeters } });
+            table.add({
+                "layer_height",
+                "first_layer_height",
+                "exact_last_layer_height",
+                "raft_layers",
+                "slice_closing_radius",
+                "clip_multipart_objects",
+                "first_layer_size_compensation",
+                "first_layer_size_compensation_layers",
+                "elephant_foot_min_width",
+                "dont_support_bridges",
+                "support_material_contact_distance_type",
+                "support_material_contact_distance_top",
+                "support_material_contact_distance_bottom",
+                "xy_size_compensation",
+                "hole_size_compensation",
+                "hole_size_threshold",
+                "hole_to_polyhole",
+                "hole_to_polyhole_threshold"
+            }, { {}, { posSlice } });
+            table.add({
+                "support_material_auto",
+                "support_material_angle",
+                "support_material_buildplate_only",
+                "support_material_enforce_layers",
+                "support_material_extruder",
+                "support_material_extrusion_width",
+                "support_material_interface_layers",
+                "support_material_interface_contact_loops",
+                "support_material_interface_extruder",
+                "support_material_interface_spacing",
+                "support_material_pattern",
+                "support_material_interface_pattern",
+                "support_material_xy_spacing",
+                "support_material_spacing",
+                "support_material_synchronize_layers",
+                "support_material_threshold",
+                "support_material_with_sheath",
+                "support_material_solid_first_layer"
+            }, { {}, { posSupportMaterial } });
+            table.add({
+                "bottom_solid_min_thickness",
+                "ensure_vertical_shell_thickness",
+                "fill_density",
+                "interface_shells",
+                "infill_extruder",
+                "infill_extrusion_spacing",
+                "infill_extrusion_width",
+                "infill_every_layers",
+                "infill_dense",
+                "infill_dense_algo",
+                "infill_not_connected",
+                "infill_only_where_needed",
+                "ironing_type",
+                "solid_infill_below_area",
+                "solid_infill_extruder",
+                "solid_infill_every_layers",
+                "solid_over_perimeters",
+                "top_solid_layers",
+                "top_solid_min_thickness"
+            }, { {}, { posPrepareInfill } });
+            table.add({
+                "top_fill_pattern",
+                "bottom_fill_pattern",
+                "solid_fill_pattern",
+                "enforce_full_fill_volume",
+                "fill_angle",
+                "fill_angle_increment",
+                "fill_pattern",
+                "fill_top_flow_ratio",
+                "fill_smooth_width",
+                "fill_smooth_distribution",
+                "infill_anchor",
+                "infill_anchor_max",
+                "infill_connection",
+                "infill_connection_solid",
+                "infill_connection_top",
+                "infill_connection_bottom",
+                "seam_gap",
+                "top_infill_extrusion_spacing",
+                "top_infill_extrusion_width"
+            }, { {}, { posInfill } });
+            table.add({
+                "bridge_angle",
+                "bridged_infill_margin",
+                "extra_perimeters",
+                "extra_perimeters_odd_layers",
+                "external_infill_margin",
+                "external_perimeter_overlap",
+                "gap_fill_overlap",
+                "no_perimeter_unsupported_algo",
+                "filament_max_overlap",
+                "perimeters",
+                "perimeter_overlap",
+                "solid_infill_extrusion_spacing",
+                "solid_infill_extrusion_width"
+            }, { {}, { posPerimeters, posPrepareInfill } });
+            // The support XY spacing may be given in percents of the external perimeter width.
+            table.add({
+                "external_perimeter_extrusion_width",
+                "perimeter_extruder"
+            }, { {}, { posPerimeters, posSupportMaterial } });
+            // Invalidated even if bridging is disabled, as the table does not depend on the configuration.
+            // If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
+            table.add({
+                "bridge_flow_ratio",
+                "first_layer_extrusion_spacing",
+                "first_layer_extrusion_width"
+            }, { {}, { posPerimeters, posInfill, posSupportMaterial } });
+            table.add({
+                "bridge_speed",
+                "bridge_speed_internal",
+                "external_perimeter_speed",
+                "gap_fill_speed",
+                "infill_speed",
+                "overhangs_speed",
+                "perimeter_speed",
+                "seam_position",
+                "seam_preferred_direction",
+                "seam_preferred_direction_jitter",
+                "seam_angle_cost",
+                "seam_travel_cost",
+                "small_perimeter_speed",
+                "small_perimeter_min_length",
+                "small_perimeter_max_length",
+                "solid_infill_speed",
+                "support_material_interface_speed",
+                "support_material_speed",
+                "thin_walls_speed",
+                "top_solid_infill_speed"
+            }, { { psGCodeExport }, {} });
+            table.add({
+                "wipe_into_infill",
+                "wipe_into_objects"
+            }, { { psWipeTower, psGCodeExport }, {} });
+            table.add({
+                "brim_inside_holes",
+                "brim_width",
+                "brim_width_interior",
+                "brim_offset",
+                "brim_ears",
+                "brim_ears_detection_length",
+                "brim_ears_max_angle",
+                "brim_ears_pattern"
+            }, { { psBrim }, {} });
+            return table;
+        }();
+        return table;
+    }
+
     // Called by Print::apply().
     // This method only accepts PrintObjectConfig and PrintRegionConfig option keys.
-    bool PrintObject::invalidate_state_by_config_options(const std::vector<t_config_option_key>& opt_keys)
+    bool PrintObject::invalidate_state_by_config_options(const std::vector<t_config_option_key>& opt_keys, const t_layer_height_range& z_range, coordf_t z_margin)
     {
         if (opt_keys.empty())
             return false;
 
-        std::vector<PrintObjectStep> steps;
+        // Options depending on the current configuration are handled separately below.
+        const PrintStepsInvalidationTable &table = PrintObject::steps_invalidation_table();
+
+        uint32_t steps  = 0;
+        uint32_t osteps = 0;
         bool invalidated = false;
         for (const t_config_option_key& opt_key : opt_keys) {
-            if (
-                opt_key == "gap_fill"
-                || opt_key == "gap_fill_last"
-                || opt_key == "gap_fill_min_area"
-                || opt_key == "only_one_perimeter_first_layer"
-                || opt_key == "only_one_perimeter_top"
-                || opt_key == "only_one_perimeter_top_other_algo"
-                || opt_key == "overhangs_width_speed"
-                || opt_key == "overhangs_width"
-                || opt_key == "overhangs_reverse"
-                || opt_key == "overhangs_reverse_threshold"
-                || opt_key == "perimeter_extrusion_spacing"
-                || opt_key == "perimeter_extrusion_width"
-                || opt_key == "infill_overlap"
-                || opt_key == "thin_perimeters"
-                || opt_key == "thin_perimeters_all"
-                || opt_key == "thin_walls"
-                || opt_key == "thin_walls_min_width"
-                || opt_key == "thin_walls_overlap"
-                || opt_key == "external_perimeters_first"
-                || opt_key == "external_perimeters_hole"
-                || opt_key == "external_perimeters_nothole"
-                || opt_key == "external_perimeter_extrusion_spacing"
-                || opt_key == "external_perimeter_extrusion_width"
-                || opt_key == "external_perimeters_vase"
-                || opt_key == "perimeter_loop"
-                || opt_key == "perimeter_loop_seam") {
-                steps.emplace_back(posPerimeters);
-            } else if (
-                opt_key == "layer_height"
-                || opt_key == "first_layer_height"
-                || opt_key == "exact_last_layer_height"
-                || opt_key == "raft_layers"
-                || opt_key == "slice_closing_radius"
-                || opt_key == "clip_multipart_objects"
-                || opt_key == "first_layer_size_compensation"
-                || opt_key == "first_layer_size_compensation_layers"
-                || opt_key == "elephant_foot_min_width"
-                || opt_key == "dont_support_bridges"
-                || opt_key == "support_material_contact_distance_type"
-                || opt_key == "support_material_contact_distance_top"
-                || opt_key == "support_material_contact_distance_bottom"
-                || opt_key == "xy_size_compensation"
-                || opt_key == "hole_size_compensation"
-                || opt_key == "hole_size_threshold"
-                || opt_key == "hole_to_polyhole"
-                || opt_key == "hole_to_polyhole_threshold") {
-                steps.emplace_back(posSlice);
-            } else if (opt_key == "support_material") {
-                steps.emplace_back(posSupportMaterial);
+            if (opt_key == "support_material") {
+                osteps |= 1u << posSupportMaterial;
                 if (m_config.support_material_contact_distance_top.value == 0. || m_config.support_material_contact_distance_bottom.value == 0.) {
                     // Enabling / disabling supports while soluble support interface is enabled.
                     // This changes the bridging logic (bridging enabled without supports, disabled with supports).
                     // Reset everything.
                     // See GH #1482 for details.
-                    steps.emplace_back(posSlice);
+                    osteps |= 1u << posSlice;
                 }
-            } else if (
-                opt_key == "support_material_auto"
-                || opt_key == "support_material_angle"
-                || opt_key == "support_material_buildplate_only"
-                || opt_key == "support_material_enforce_layers"
-                || opt_key == "support_material_extruder"
-                || opt_key == "support_material_extrusion_width"
-                || opt_key == "support_material_interface_layers"
-                || opt_key == "support_material_interface_contact_loops"
-                || opt_key == "support_material_interface_extruder"
-                || opt_key == "support_material_interface_spacing"
-                || opt_key == "support_material_pattern"
-                || opt_key == "support_material_interface_pattern"
-                || opt_key == "support_material_xy_spacing"
-                || opt_key == "support_material_spacing"
-                || opt_key == "support_material_synchronize_layers"
-                || opt_key == "support_material_threshold"
-                || opt_key == "support_material_with_sheath"
-                || opt_key == "support_material_solid_first_layer") {
-                steps.emplace_back(posSupportMaterial);
             } else if (opt_key == "bottom_solid_layers") {
-                steps.emplace_back(posPrepareInfill);
-                if (m_print->config().spiral_vase
-                || opt_key == "z_step") {
+                osteps |= 1u << posPrepareInfill;
+                if (m_print->config().spiral_vase) {
                     // Changing the number of bottom layers when a spiral vase is enabled requires re-slicing the object again.
                     // Otherwise, holes in the bottom layers could be filled, as is reported in GH #5528.
-                    steps.emplace_back(posSlice);
+                    osteps |= 1u << posSlice;
                 }
-            } else if (
-                opt_key == "bottom_solid_min_thickness"
-                || opt_key == "ensure_vertical_shell_thickness"
-                || opt_key == "fill_density"
-                || opt_key == "interface_shells"
-                || opt_key == "infill_extruder"
-                || opt_key == "infill_extrusion_spacing"
-                || opt_key == "infill_extrusion_width"
-                || opt_key == "infill_every_layers"
-                || opt_key == "infill_dense"
-                || opt_key == "infill_dense_algo"
-                || opt_key == "infill_not_connected"
-                || opt_key == "infill_only_where_needed"
-                || opt_key == "ironing_type"
-                || opt_key == "solid_infill_below_area"
-                || opt_key == "solid_infill_extruder"
-                || opt_key == "solid_infill_every_layers"
-                || opt_key == "solid_over_perimeters"
-                || opt_key == "top_solid_layers"
-                || opt_key == "top_solid_min_thickness") {
-                steps.emplace_back(posPrepareInfill);
-            } else if (
-                opt_key == "top_fill_pattern"
-                || opt_key == "bottom_fill_pattern"
-                || opt_key == "solid_fill_pattern"
-                || opt_key == "enforce_full_fill_volume"
-                || opt_key == "fill_angle"
-                || opt_key == "fill_angle_increment"
-                || opt_key == "fill_pattern"
-                || opt_key == "fill_top_flow_ratio"
-                || opt_key == "fill_smooth_width"
-                || opt_key == "fill_smooth_distribution"
-                || opt_key == "infill_anchor"
-                || opt_key == "infill_anchor_max"
-                || opt_key == "infill_connection"
-                || opt_key == "infill_connection_solid"
-                || opt_key == "infill_connection_top"
-                || opt_key == "infill_connection_bottom"
-                || opt_key == "seam_gap"
-                || opt_key == "top_infill_extrusion_spacing"
-                || opt_key == "top_infill_extrusion_width" ) {
-                steps.emplace_back(posInfill);
-            } else if (
-                opt_key == "bridge_angle"
-                || opt_key == "bridged_infill_margin"
-                || opt_key == "extra_perimeters"
-                || opt_key == "extra_perimeters_odd_layers"
-                || opt_key == "external_infill_margin"
-                || opt_key == "external_perimeter_overlap"
-                || opt_key == "gap_fill_overlap"
-                || opt_key == "no_perimeter_unsupported_algo"
-                || opt_key == "filament_max_overlap"
-                || opt_key == "perimeters"
-                || opt_key == "perimeter_overlap"
-                || opt_key == "solid_infill_extrusion_spacing"
-                || opt_key == "solid_infill_extrusion_width") {
-                steps.emplace_back(posPerimeters);
-                steps.emplace_back(posPrepareInfill);
-            } else if (
-                opt_key == "external_perimeter_extrusion_width"
-                || opt_key == "perimeter_extruder") {
-                steps.emplace_back(posPerimeters);
-                steps.emplace_back(posSupportMaterial);
-            } else if (opt_key == "bridge_flow_ratio"
-                || opt_key == "first_layer_extrusion_spacing"
-                || opt_key == "first_layer_extrusion_width") {
-                //if (m_config.support_material_contact_distance > 0.) {
-                    // Only invalidate due to bridging if bridging is enabled.
-                    // If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
-                steps.emplace_back(posPerimeters);
-                steps.emplace_back(posInfill);
-                steps.emplace_back(posSupportMaterial);
-                //}
-            } else if (
-                opt_key == "bridge_speed"
-                || opt_key == "bridge_speed_internal"
-                || opt_key == "external_perimeter_speed"
-                || opt_key == "external_perimeters_vase"
-                || opt_key == "gap_fill_speed"
-                || opt_key == "infill_speed"
-                || opt_key == "overhangs_speed"
-                || opt_key == "perimeter_speed"
-                || opt_key == "seam_position"
-                || opt_key == "seam_preferred_direction"
-                || opt_key == "seam_preferred_direction_jitter"
-                || opt_key == "seam_angle_cost"
-                || opt_key == "seam_travel_cost"
-                || opt_key == "small_perimeter_speed"
-                || opt_key == "small_perimeter_min_length"
-                || opt_key == "small_perimeter_max_length"
-                || opt_key == "solid_infill_speed"
-                || opt_key == "support_material_interface_speed"
-                || opt_key == "support_material_speed"
-                || opt_key == "thin_walls_speed"
-                || opt_key == "top_solid_infill_speed") {
-                invalidated |= m_print->invalidate_step(psGCodeExport);
-            } else if (
-                opt_key == "wipe_into_infill"
-                || opt_key == "wipe_into_objects") {
-                invalidated |= m_print->invalidate_step(psWipeTower);
-                invalidated |= m_print->invalidate_step(psGCodeExport);
-            } else if (
-                opt_key == "brim_inside_holes"
-                || opt_key == "brim_width"
-                || opt_key == "brim_width_interior"
-                || opt_key == "brim_offset"
-                || opt_key == "brim_ears"
-                || opt_key == "brim_ears_detection_length"
-                || opt_key == "brim_ears_max_angle"
-                || opt_key == "brim_ears_pattern") {
-                invalidated |= m_print->invalidate_step(psBrim);
             } else {
-                // for legacy, if we can't handle this option let's invalidate all steps
-                this->invalidate_all_steps();
-                invalidated = true;
+                const PrintStepsInvalidation *invalidation = table.find(opt_key);
+                if (invalidation != nullptr) {
+                    steps  |= invalidation->print;
+                    osteps |= invalidation->object;
+                } else {
+                    // for legacy, if we can't handle this option let's invalidate all steps
+                    this->invalidate_all_steps();
+                    invalidated = true;
+                }
             }
         }
 
-        sort_remove_duplicates(steps);
-        for (PrintObjectStep step : steps)
-            invalidated |= this->invalidate_step(step);
+        for (int step = 0; step < psCount; ++ step)
+            if (steps & (1u << step))
+                invalidated |= m_print->invalidate_step(PrintStep(step));
+        bool all_layers = z_range == PrintStateBase::full_z_range();
+        for (int ostep = 0; ostep < posCount; ++ ostep)
+            if (osteps & (1u << ostep))
+                invalidated |= all_layers ?
+                    this->invalidate_step(PrintObjectStep(ostep)) :
+                    this->invalidate_step(PrintObjectStep(ostep), z_range, z_margin);
         return invalidated;
     }
 
@@ -980,6 +1039,98 @@ namespace Slic3r {
         return invalidated;
     }
 
+    bool PrintObject::invalidate_step(PrintObjectStep step, const t_layer_height_range& z_range, coordf_t z_margin)
+    {
+        // Slicing and the support generator process the object as a whole.
+        if (step == posSlice || step == posSupportMaterial)
+            return this->invalidate_step(step);
+
+        // prepare_infill() is a sequence of passes over the whole object, it is always recalculated completely.
+        // Some of its passes (discover_vertical_shells, discover_horizontal_shells, bridge_over_infill, combine_infill)
+        // look at the neighbor layers, therefore the fill surfaces may change up to z_margin outside of z_range.
+        t_layer_height_range z_range_fill(z_range.first - z_margin, z_range.second + z_margin);
+        bool invalidated = false;
+        if (step == posPerimeters) {
+            invalidated |= Inherited::invalidate_step_z_range(posPerimeters, z_range);
+            invalidated |= Inherited::invalidate_step(posPrepareInfill);
+            invalidated |= Inherited::invalidate_step_z_range(posInfill, z_range_fill);
+            invalidated |= Inherited::invalidate_step_z_range(posIroning, z_range_fill);
+            invalidated |= m_print->invalidate_steps({ psSkirt, psBrim });
+        } else if (step == posPrepareInfill) {
+            invalidated |= Inherited::invalidate_step(posPrepareInfill);
+            invalidated |= Inherited::invalidate_step_z_range(posInfill, z_range_fill);
+            invalidated |= Inherited::invalidate_step_z_range(posIroning, z_range_fill);
+        } else if (step == posInfill) {
+            invalidated |= Inherited::invalidate_step_z_range(posInfill, z_range);
+            invalidated |= Inherited::invalidate_step_z_range(posIroning, z_range);
+            invalidated |= m_print->invalidate_steps({ psSkirt, psBrim });
+        } else if (step == posIroning) {
+            invalidated |= Inherited::invalidate_step_z_range(posIroning, z_range);
+        }
+
+        invalidated |= m_print->invalidate_step(psWipeTower);
+        invalidated |= m_print->invalidate_step(psGCodeExport);
+        return invalidated;
+    }
+
+    t_layer_height_range PrintObject::region_z_range(size_t region_id) const
+    {
+        t_layer_height_range z_range(DBL_MAX, - DBL_MAX);
+        if (region_id < this->region_volumes.size())
+            for (const std::pair<t_layer_height_range, int>& volume_and_range : this->region_volumes[region_id]) {
+                z_range.first  = std::min(z_range.first,  volume_and_range.first.first);
+                z_range.second = std::max(z_range.second, volume_and_range.first.second);
+            }
+        return z_range;
+    }
+
+    coordf_t PrintObject::neighbor_layers_z_margin() const
+    {
+        if (! m_slicing_params.valid)
+            return DBL_MAX;
+        // discover_vertical_shells() and discover_horizontal_shells() extend the shells of a layer by the config of the neighbor regions,
+        // therefore all the regions of the object are considered, not just the modified one.
+        // Solid shells, solid infill over perimeters and combined infill span a number of layers,
+        // bridges over sparse infill look down by the bridge height.
+        int      num_layers      = 0;
+        coordf_t shell_thickness = 0.;
+        for (size_t region_id = 0; region_id < this->region_volumes.size(); ++ region_id)
+            if (! this->region_volumes[region_id].empty()) {
+                const PrintRegionConfig &region_config = m_print->get_region(region_id)->config();
+                num_layers      = std::max({ num_layers, region_config.top_solid_layers.value, region_config.bottom_solid_layers.value,
+                                             region_config.solid_over_perimeters.value,
+                                             region_config.infill_every_layers.value, region_config.solid_infill_every_layers.value });
+                shell_thickness = std::max({ shell_thickness, region_config.top_solid_min_thickness.value, region_config.bottom_solid_min_thickness.value });
+            }
+        coordf_t nozzle_diameter = 0.;
+        for (double dmr : m_print->config().nozzle_diameter.values)
+            nozzle_diameter = std::max(nozzle_diameter, dmr);
+        // The layers are counted with the thickest layer of the object, which may exceed the configured max_layer_height.
+        coordf_t max_layer_height = m_slicing_params.max_layer_height;
+        for (const Layer *layer : m_layers)
+            max_layer_height = std::max(max_layer_height, layer->height);
+        return (num_layers + 1) * max_layer_height + shell_thickness + 2. * nozzle_diameter;
+    }
+
+    std::pair<size_t, size_t> PrintObject::invalid_layers(PrintObjectStep step) const
+    {
+        t_layer_height_range z_range = this->step_invalid_z_range(step);
+        auto layer_below = [](const Layer* layer, coordf_t z) { return layer->slice_z < z; };
+        size_t begin = std::lower_bound(m_layers.begin(), m_layers.end(), z_range.first, layer_below) - m_layers.begin();
+        size_t end   = std::lower_bound(m_layers.begin() + begin, m_layers.end(), z_range.second, layer_below) - m_layers.begin();
+        return std::make_pair(begin, end);
+    }
+
+    std::pair<size_t, size_t> PrintObject::invalid_fill_layers(PrintObjectStep step) const
+    {
+        // The adaptive infill octrees are built over the whole object, all the layers are filled again if any of them is in use.
+        // clip_fill_surfaces() carries the internal surfaces from the top layer down to the bottom layer with infill_only_where_needed,
+        // therefore a change of any layer may change the sparse infill of all the layers below it.
+        auto [adaptive_line_spacing, support_line_spacing] = FillAdaptive::adaptive_fill_line_spacing(*this);
+        return (adaptive_line_spacing == 0. && support_line_spacing == 0. && ! m_config.infill_only_where_needed.value) ?
+            this->invalid_layers(step) : std::make_pair(size_t(0), m_layers.size());
+    }
+
     bool PrintObject::invalidate_all_steps()
     {
         // First call the "invalidate" functions, which may cancel background processing.
@@ -61,6 +61,7 @@ protected:
     Renderer<agg::renderer_base<PixelRenderer>> m_renderer;
     
     Trafo m_trafo;
+    TColor m_background;
     Scanline m_scanlines;
     Rasterizer m_rasterizer;
     
@@ -146,6 +147,7 @@ public:
         , m_raw_renderer(m_pixrenderer)
         , m_renderer(m_raw_renderer)
         , m_trafo(trafo)
+        , m_background(background)
     {
         m_renderer.color(foreground);
         clear(background);
@@ -170,6 +172,7 @@ public:
     }
     
     void clear(const TColor color) { m_raw_renderer.clear(color); }
+    void clear() override { clear(m_background); }
 };
 
 /*
@@ -204,8 +207,6 @@ public:
         Base::m_buf[row * Base::resolution().width_px + col].get(px);
         return px;
     }
-    
-    void clear() { Base::clear(Colors<TColor>::Black); }
 };
 
 class RasterGrayscaleAAGammaPower: public RasterGrayscaleAA {
@@ -94,6 +94,9 @@ public:
     virtual void draw(const ExPolygon& poly) = 0;
     virtual void draw(const ClipperLib::Polygon& poly) = 0;
     
+    /// Erase the drawn polygons, so that the raster may be reused.
+    virtual void clear() = 0;
+    
     /// Get the resolution of the raster.
     virtual Resolution resolution() const = 0;
     virtual PixelDim   pixel_dimensions() const = 0;
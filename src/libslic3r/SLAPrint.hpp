@@ -11,6 +11,8 @@
 #include "Zipper.hpp"
 #include <libnest2d/backends/clipper/clipper_polygon.hpp>
 
+#include <tbb/pipeline.h>
+
 namespace Slic3r {
 
 enum SLAPrintStep : unsigned int {
@@ -375,18 +377,90 @@ struct SLAPrintStatistics
 class SLAPrinter {
 protected:
     std::vector<sla::EncodedRaster> m_layers;
+    // If set, the layers are not rasterized by draw_layers(), but streamed
+    // into the output while exporting (see stream_layers()).
+    bool m_streaming = false;
     
     virtual uqptr<sla::RasterBase> create_raster() const = 0;
     virtual sla::RasterEncoder get_encoder() const = 0;
     
+    // Rasterize and encode the layers in parallel and pass them to writefn
+    // in the order of the layers. Only a bounded number of layers is kept in
+    // memory at a time and the rasters are reused, thus the memory
+    // consumption does not depend on the number of layers.
+    // DrawFn have to be thread safe: void(sla::RasterBase& raster, size_t lyrid);
+    // WriteFn is called serially: void(const sla::EncodedRaster& rst, size_t lyrid);
+    template<class DrawFn, class WriteFn>
+    void stream_layers(size_t layer_num, DrawFn &&drawfn, WriteFn &&writefn)
+    {
+        struct EncodedLayer {
+            size_t             idx = 0;
+            sla::EncodedRaster raster;
+        };
+        
+        // Rasters released by the layers already encoded.
+        std::vector<uqptr<sla::RasterBase>> pool;
+        sla::ccr::SpinningMutex             pool_mutex;
+        using Lock = std::lock_guard<sla::ccr::SpinningMutex>;
+        
+        size_t next_idx = 0;
+        tbb::parallel_pipeline(max_streamed_layers,
+            tbb::make_filter<void, size_t>(tbb::filter::serial_in_order,
+                [&next_idx, layer_num](tbb::flow_control &fc) -> size_t {
+                    if (next_idx == layer_num)
+                        fc.stop();
+                    return next_idx ++;
+                }) &
+            tbb::make_filter<size_t, EncodedLayer>(tbb::filter::parallel,
+                [this, &drawfn, &pool, &pool_mutex](size_t idx) -> EncodedLayer {
+                    uqptr<sla::RasterBase> rst;
+                    {
+                        Lock lck(pool_mutex);
+                        if (! pool.empty()) {
+                            rst = std::move(pool.back());
+                            pool.pop_back();
+                        }
+                    }
+                    if (rst)
+                        rst->clear();
+                    else
+                        rst = create_raster();
+                    drawfn(*rst, idx);
+                    EncodedLayer out { idx, rst->encode(get_encoder()) };
+                    Lock lck(pool_mutex);
+                    pool.emplace_back(std::move(rst));
+                    return out;
+                }) &
+            tbb::make_filter<EncodedLayer, void>(tbb::filter::serial_in_order,
+                [&writefn](const EncodedLayer &layer) { writefn(layer.raster, layer.idx); }));
+    }
+    
 public:
+    // Maximum number of layers being rasterized, encoded or waiting to be
+    // written at a time when streaming.
+    static constexpr size_t max_streamed_layers = 32;
+    
     virtual ~SLAPrinter() = default;
     
     virtual void apply(const SLAPrinterConfig &cfg) = 0;
     
+    // In the streaming mode the rasterization is postponed to the export,
+    // which writes the layers as soon as they are encoded instead of holding
+    // all of them in memory.
+    bool streaming() const { return m_streaming; }
+    void set_streaming(bool streaming)
+    {
+        m_streaming = streaming;
+        m_layers    = {};
+    }
+    
     // Fn have to be thread safe: void(sla::RasterBase& raster, size_t lyrid);
     template<class Fn> void draw_layers(size_t layer_num, Fn &&drawfn)
     {
+        if (m_streaming) {
+            m_layers = {};
+            return;
+        }
         m_layers.resize(layer_num);
         sla::ccr::for_each(size_t(0), m_layers.size(),
                            [this, &drawfn] (size_t idx) {
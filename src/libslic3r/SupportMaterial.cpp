@@ -1096,9 +1096,12 @@ PrintObjectSupportMaterial::MyLayersPtr PrintObjectSupportMaterial::top_contact_
     	                            // Offset the support regions back to a full overhang, restrict them to the full overhang.
     	                            // This is done to increase size of the supporting columns below, as they are calculated by 
     	                            // propagating these contact surfaces downwards.
-    	                            diff_polygons = diff(
-    	                                intersection(offset(diff_polygons, lower_layer_offset, SUPPORT_SURFACES_OFFSET_PARAMETERS), layerm_polygons), 
-    	                                lower_layer_polygons);
+    	                            // The intermediate results stay in Clipper space.
+    	                            diff_polygons = ClipperPaths_to_Slic3rPolygons(_clipper_paths(ClipperLib::ctDifference,
+    	                                _clipper_paths(ClipperLib::ctIntersection,
+    	                                    _offset(Slic3rMultiPoints_to_ClipperPaths(diff_polygons), ClipperLib::etClosedPolygon, lower_layer_offset, SUPPORT_SURFACES_OFFSET_PARAMETERS),
+    	                                    layerm_polygons),
+    	                                lower_layer_polygons));
     							}
                             }
                             if (! enforcers.empty()) {
@@ -3038,6 +3041,7 @@ void PrintObjectSupportMaterial::generate_toolpaths(
             assert(support_layer_id < raft_layers.size());
             SupportLayer &support_layer = *object.support_layers()[support_layer_id];
             assert(support_layer.support_fills.entities.empty());
+            ExtrusionEntityArena::Scope arena_scope(support_layer.extrusion_arena());
             MyLayer      &raft_layer    = *raft_layers[support_layer_id];
 
             std::unique_ptr<Fill> filler_interface = std::unique_ptr<Fill>(Fill::new_from_type(interface_pattern));
@@ -3160,6 +3164,7 @@ void PrintObjectSupportMaterial::generate_toolpaths(
         {
             SupportLayer &support_layer = *object.support_layers()[support_layer_id];
             LayerCache   &layer_cache   = layer_caches[support_layer_id];
+            ExtrusionEntityArena::Scope arena_scope(support_layer.extrusion_arena());
 
             // Find polygons with the same print_z.
             MyLayerExtruded &bottom_contact_layer = layer_cache.bottom_contact_layer;
@@ -3383,6 +3388,7 @@ void PrintObjectSupportMaterial::generate_toolpaths(
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id) {
             SupportLayer &support_layer = *object.support_layers()[support_layer_id];
             LayerCache   &layer_cache   = layer_caches[support_layer_id];
+            ExtrusionEntityArena::Scope arena_scope(support_layer.extrusion_arena());
             for (LayerCacheItem &layer_cache_item : layer_cache.overlaps) {
                 modulate_extrusion_by_overlapping_layers(layer_cache_item.layer_extruded->extrusions, *layer_cache_item.layer_extruded->layer, layer_cache_item.overlapping);
                 support_layer.support_fills.append(std::move(layer_cache_item.layer_extruded->extrusions));
@@ -116,6 +116,8 @@
 
 #define ENABLE_SPLITTED_VERTEX_BUFFER (1 && ENABLE_2_3_1_ALPHA1)
 #define ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS (1 && ENABLE_SPLITTED_VERTEX_BUFFER)
+// Store the G-code moves column by column, with the columns used only for coloring as half floats
+#define ENABLE_GCODE_MOVES_HALF_PRECISION (1 && ENABLE_2_3_1_ALPHA1)
 
 
 #endif // _prusaslicer_technologies_h_
@@ -20,6 +20,7 @@
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
 
 #include <Eigen/Core>
 #include <Eigen/Dense>
@@ -810,66 +811,36 @@ void TriangleMeshSlicer::slice(
         type is float.
     */
     
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_slice_do";
-    std::vector<IntersectionLines> lines(z.size());
-    {
-        boost::mutex lines_mutex;
+    layers->resize(z.size());
+    std::vector<IntersectionLines> lines;
+    if (this->engine == SlicingEngine::SweepLine) {
+        // Lines of a layer are turned into loops as soon as the layer is swept, they are never stored for all the layers.
+        BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_slice_sweep";
+        this->_slice_sweep(z, mode, alternate_mode_first_n_layers, alternate_mode, *layers, throw_on_cancel);
+    } else {
+        BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_slice_do";
+        lines.assign(z.size(), IntersectionLines());
+        if (this->engine == SlicingEngine::Locked)
+            this->_slice_lines_locked(z, lines, throw_on_cancel);
+        else
+            this->_slice_lines_buckets(z, lines, throw_on_cancel);
+        throw_on_cancel();
+
+        // v_scaled_shared could be freed here
+    
+        // build loops
+        BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_make_loops_do";
         tbb::parallel_for(
-            tbb::blocked_range<int>(0,this->mesh->stl.stats.number_of_facets),
-            [&lines, &lines_mutex, &z, throw_on_cancel, this](const tbb::blocked_range<int>& range) {
-                for (int facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
-                    if ((facet_idx & 0x0ffff) == 0)
+            tbb::blocked_range<size_t>(0, z.size()),
+            [&lines, &layers, mode, alternate_mode_first_n_layers, alternate_mode, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+                for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
+                    if ((line_idx & 0x0ffff) == 0)
                         throw_on_cancel();
-                    this->_slice_do(facet_idx, &lines, &lines_mutex, z);
+                    this->_make_loops_do(lines[line_idx], line_idx < alternate_mode_first_n_layers ? alternate_mode : mode, (*layers)[line_idx]);
                 }
             }
         );
     }
-    throw_on_cancel();
-
-    // v_scaled_shared could be freed here
-    
-    // build loops
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_make_loops_do";
-    layers->resize(z.size());
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, z.size()),
-        [&lines, &layers, mode, alternate_mode_first_n_layers, alternate_mode, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
-            for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
-                if ((line_idx & 0x0ffff) == 0)
-                    throw_on_cancel();
-
-                Polygons &polygons = (*layers)[line_idx];
-                this->make_loops(lines[line_idx], &polygons);
-
-                auto this_mode = line_idx < alternate_mode_first_n_layers ? alternate_mode : mode;
-                if (! polygons.empty()) {
-                    if (this_mode == SlicingMode::Positive) {
-                        // Reorient all loops to be CCW.
-                        for (Polygon& p : polygons)
-                            p.make_counter_clockwise();
-                    } else if (this_mode == SlicingMode::PositiveLargestContour) {
-                        // Keep just the largest polygon, make it CCW.
-                        double   max_area = 0.;
-                        Polygon* max_area_polygon = nullptr;
-                        for (Polygon& p : polygons) {
-                            double a = p.area();
-                            if (std::abs(a) > std::abs(max_area)) {
-                                max_area = a;
-                                max_area_polygon = &p;
-                            }
-                        }
-                        assert(max_area_polygon != nullptr);
-                        if (max_area < 0.)
-                            max_area_polygon->reverse();
-                        Polygon p(std::move(*max_area_polygon));
-                        polygons.clear();
-                        polygons.emplace_back(std::move(p));
-                    }
-                }
-            }
-        }
-    );
     BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice finished";
 
 #ifdef SLIC3R_DEBUG
@@ -881,14 +852,18 @@ void TriangleMeshSlicer::slice(
             SVG::export_expolygons(debug_out_path("slice_%d_%d.svg", iRun, i).c_str(), expolygons);
             {
                 BoundingBox bbox;
-                for (const IntersectionLine &l : lines[i]) {
-                    bbox.merge(l.a);
-                    bbox.merge(l.b);
-                }
+                if (lines.empty())
+                    bbox = get_extents(polygons);
+                else
+                    for (const IntersectionLine &l : lines[i]) {
+                        bbox.merge(l.a);
+                        bbox.merge(l.b);
+                    }
                 SVG svg(debug_out_path("slice_loops_%d_%d.svg", iRun, i).c_str(), bbox);
                 svg.draw(expolygons);
-                for (const IntersectionLine &l : lines[i])
-                    svg.draw(l, "red", 0);
+                if (! lines.empty())
+                    for (const IntersectionLine &l : lines[i])
+                        svg.draw(l, "red", 0);
                 svg.draw_outline(expolygons, "black", "blue", 0);
                 svg.Close();
             }
@@ -906,8 +881,8 @@ void TriangleMeshSlicer::slice(
 #endif
 }
 
-void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, 
-    const std::vector<float> &z) const
+template<typename LineOut>
+void TriangleMeshSlicer::_slice_do(size_t facet_idx, const std::vector<float> &z, LineOut &&line_out) const
 {
     const stl_facet &facet = m_use_quaternion ? (this->mesh->stl.facet_start.data() + facet_idx)->rotated(m_quaternion) : *(this->mesh->stl.facet_start.data() + facet_idx);
     
@@ -935,11 +910,180 @@ void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLin
         std::vector<float>::size_type layer_idx = it - z.begin();
         IntersectionLine il;
         if (this->slice_facet(*it / SCALING_FACTOR, facet, facet_idx, min_z, max_z, &il) == TriangleMeshSlicer::Slicing) {
-            boost::lock_guard<boost::mutex> l(*lines_mutex);
             if (il.edge_type == feHorizontal) {
                 // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
             } else
-                (*lines)[layer_idx].emplace_back(il);
+                line_out(layer_idx, il);
+        }
+    }
+}
+
+void TriangleMeshSlicer::_slice_lines_locked(const std::vector<float> &z, std::vector<IntersectionLines> &lines, throw_on_cancel_callback_type throw_on_cancel) const
+{
+    boost::mutex lines_mutex;
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0,this->mesh->stl.stats.number_of_facets),
+        [&lines, &lines_mutex, &z, throw_on_cancel, this](const tbb::blocked_range<int>& range) {
+            for (int facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
+                if ((facet_idx & 0x0ffff) == 0)
+                    throw_on_cancel();
+                this->_slice_do(facet_idx, z, [&lines, &lines_mutex](size_t layer_idx, const IntersectionLine &il) {
+                    boost::lock_guard<boost::mutex> l(lines_mutex);
+                    lines[layer_idx].emplace_back(il);
+                });
+            }
+        }
+    );
+}
+
+void TriangleMeshSlicer::_slice_lines_buckets(const std::vector<float> &z, std::vector<IntersectionLines> &lines, throw_on_cancel_callback_type throw_on_cancel) const
+{
+    // The facets are split into fixed size chunks. Each chunk is sliced by a single thread into its own bucket
+    // of (layer index, line) pairs, which is then sorted by the layer index, keeping the facet order.
+    static constexpr size_t facets_per_chunk = 0x01000;
+    typedef std::pair<uint32_t, IntersectionLine> LayerLine;
+    typedef std::vector<LayerLine>                Bucket;
+    const size_t        num_facets = this->mesh->stl.stats.number_of_facets;
+    std::vector<Bucket> buckets((num_facets + facets_per_chunk - 1) / facets_per_chunk);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, buckets.size()),
+        [&buckets, &z, num_facets, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+            for (size_t chunk_idx = range.begin(); chunk_idx < range.end(); ++ chunk_idx) {
+                Bucket &bucket = buckets[chunk_idx];
+                size_t  facet_end = std::min(num_facets, (chunk_idx + 1) * facets_per_chunk);
+                for (size_t facet_idx = chunk_idx * facets_per_chunk; facet_idx < facet_end; ++ facet_idx) {
+                    if ((facet_idx & 0x0ffff) == 0)
+                        throw_on_cancel();
+                    this->_slice_do(facet_idx, z, [&bucket](size_t layer_idx, const IntersectionLine &il) {
+                        bucket.emplace_back(uint32_t(layer_idx), il);
+                    });
+                }
+                std::stable_sort(bucket.begin(), bucket.end(), [](const LayerLine &l, const LayerLine &r) { return l.first < r.first; });
+            }
+        }
+    );
+    throw_on_cancel();
+
+    // Merge the buckets per layer. Each layer is written by a single thread only, the buckets are read only.
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, z.size()),
+        [&buckets, &lines](const tbb::blocked_range<size_t>& range) {
+            auto layer_lower = [](const LayerLine &l, uint32_t layer_idx) { return l.first < layer_idx; };
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                IntersectionLines &layer_lines = lines[layer_idx];
+                size_t             num_lines   = 0;
+                for (const Bucket &bucket : buckets) {
+                    auto it_begin = std::lower_bound(bucket.begin(), bucket.end(), uint32_t(layer_idx), layer_lower);
+                    auto it_end   = std::lower_bound(it_begin, bucket.end(), uint32_t(layer_idx + 1), layer_lower);
+                    num_lines += it_end - it_begin;
+                }
+                layer_lines.reserve(num_lines);
+                for (const Bucket &bucket : buckets)
+                    for (auto it = std::lower_bound(bucket.begin(), bucket.end(), uint32_t(layer_idx), layer_lower); it != bucket.end() && it->first == layer_idx; ++ it)
+                        layer_lines.emplace_back(it->second);
+            }
+        }
+    );
+}
+
+void TriangleMeshSlicer::_slice_sweep(
+    const std::vector<float> &z, SlicingMode mode, size_t alternate_mode_first_n_layers, SlicingMode alternate_mode,
+    std::vector<Polygons> &layers, throw_on_cancel_callback_type throw_on_cancel) const
+{
+    // Z span of a facet in unscaled coordinates, after the optional rotation.
+    struct FacetZSpan {
+        float    min_z;
+        float    max_z;
+        uint32_t facet_idx;
+    };
+    const size_t            num_facets = this->mesh->stl.stats.number_of_facets;
+    std::vector<FacetZSpan> spans(num_facets);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_facets),
+        [&spans, this](const tbb::blocked_range<size_t>& range) {
+            for (size_t facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
+                const stl_facet &facet = m_use_quaternion ? this->mesh->stl.facet_start[facet_idx].rotated(m_quaternion) : this->mesh->stl.facet_start[facet_idx];
+                FacetZSpan      &span  = spans[facet_idx];
+                span.min_z     = fminf(facet.vertex[0](2), fminf(facet.vertex[1](2), facet.vertex[2](2)));
+                span.max_z     = fmaxf(facet.vertex[0](2), fmaxf(facet.vertex[1](2), facet.vertex[2](2)));
+                span.facet_idx = uint32_t(facet_idx);
+            }
+        });
+    throw_on_cancel();
+    tbb::parallel_sort(spans.begin(), spans.end(), [](const FacetZSpan &l, const FacetZSpan &r) { return l.min_z < r.min_z || (l.min_z == r.min_z && l.facet_idx < r.facet_idx); });
+    // The tallest facet limits how far below a plane the sweep of a range of planes has to start.
+    float max_facet_height = 0.f;
+    for (const FacetZSpan &span : spans)
+        max_facet_height = std::max(max_facet_height, span.max_z - span.min_z);
+    throw_on_cancel();
+
+    // The planes are split into contiguous ranges, each range is swept independently by a single thread.
+    // A layer is finished and turned into loops as soon as the sweep passes its plane.
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, z.size()),
+        [&spans, &layers, &z, max_facet_height, mode, alternate_mode_first_n_layers, alternate_mode, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+            // Facets spanning the current plane, indices into spans.
+            std::vector<size_t>                                active;
+            std::vector<std::pair<uint32_t, IntersectionLine>> facet_lines;
+            IntersectionLines                                  lines;
+            // Only facets starting at most max_facet_height below the first plane may span it.
+            // The margin is slightly enlarged to be safe against rounding of max_facet_height.
+            size_t next_span = std::lower_bound(spans.begin(), spans.end(), z[range.begin()] - 1.01f * max_facet_height - float(EPSILON),
+                [](const FacetZSpan &span, float min_z) { return span.min_z < min_z; }) - spans.begin();
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                throw_on_cancel();
+                const float slice_z = z[layer_idx];
+                // Retire the facets below the plane, activate the facets starting below or at the plane.
+                active.erase(std::remove_if(active.begin(), active.end(), [&spans, slice_z](size_t i) { return spans[i].max_z < slice_z; }), active.end());
+                for (; next_span < spans.size() && spans[next_span].min_z <= slice_z; ++ next_span)
+                    if (spans[next_span].max_z >= slice_z)
+                        active.emplace_back(next_span);
+                facet_lines.clear();
+                for (size_t i : active) {
+                    const FacetZSpan &span  = spans[i];
+                    const stl_facet  &facet = m_use_quaternion ? this->mesh->stl.facet_start[span.facet_idx].rotated(m_quaternion) : this->mesh->stl.facet_start[span.facet_idx];
+                    IntersectionLine  il;
+                    if (this->slice_facet(slice_z / SCALING_FACTOR, facet, span.facet_idx, span.min_z, span.max_z, &il) == TriangleMeshSlicer::Slicing &&
+                        // Ignore horizontal triangles, see _slice_do().
+                        il.edge_type != feHorizontal)
+                        facet_lines.emplace_back(span.facet_idx, il);
+                }
+                // Order the lines by the facet index to produce the same loops as the other engines.
+                std::sort(facet_lines.begin(), facet_lines.end(), [](const auto &l, const auto &r) { return l.first < r.first; });
+                lines.clear();
+                lines.reserve(facet_lines.size());
+                for (const auto &fl : facet_lines)
+                    lines.emplace_back(fl.second);
+                this->_make_loops_do(lines, layer_idx < alternate_mode_first_n_layers ? alternate_mode : mode, layers[layer_idx]);
+            }
+        });
+}
+
+void TriangleMeshSlicer::_make_loops_do(IntersectionLines &lines, SlicingMode mode, Polygons &polygons) const
+{
+    this->make_loops(lines, &polygons);
+    if (! polygons.empty()) {
+        if (mode == SlicingMode::Positive) {
+            // Reorient all loops to be CCW.
+            for (Polygon& p : polygons)
+                p.make_counter_clockwise();
+        } else if (mode == SlicingMode::PositiveLargestContour) {
+            // Keep just the largest polygon, make it CCW.
+            double   max_area = 0.;
+            Polygon* max_area_polygon = nullptr;
+            for (Polygon& p : polygons) {
+                double a = p.area();
+                if (std::abs(a) > std::abs(max_area)) {
+                    max_area = a;
+                    max_area_polygon = &p;
+                }
+            }
+            assert(max_area_polygon != nullptr);
+            if (max_area < 0.)
+                max_area_polygon->reverse();
+            Polygon p(std::move(*max_area_polygon));
+            polygons.clear();
+            polygons.emplace_back(std::move(p));
         }
     }
 }
@@ -175,11 +175,26 @@ enum class SlicingMode : uint32_t {
 	PositiveLargestContour,
 };
 
+enum class SlicingEngine : uint32_t {
+    // Each facet is sliced independently, the intersection lines are pushed into the per layer vectors shared by all
+    // the slicing threads, guarded by a single mutex. The order of lines in a layer is not deterministic.
+    Locked,
+    // Facets are sliced in chunks, each chunk collects its intersection lines into its own bucket without any locking.
+    // The buckets are merged per layer in the order of facets.
+    Buckets,
+    // Facets are sorted by their minimum Z once, then the planes are swept bottom up while maintaining the set of
+    // facets spanning the current plane. Each layer is turned into loops as soon as it is swept, thus the intersection
+    // lines are never held for all the layers at once.
+    SweepLine,
+};
+
 class TriangleMeshSlicer
 {
 public:
     float closing_radius;
     float model_precision;
+    // Algorithm used to collect the intersection lines of the facets with the slicing planes.
+    SlicingEngine engine = SlicingEngine::Buckets;
 
     typedef std::function<void()> throw_on_cancel_callback_type;
     TriangleMeshSlicer(float closing_radius, float model_precision) : mesh(nullptr), closing_radius(closing_radius), model_precision(model_precision) {}
@@ -217,7 +232,15 @@ private:
     // Whether or not the above quaterion should be used
     bool                     m_use_quaternion = false;
 
-    void _slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, const std::vector<float> &z) const;
+    // Slice a single facet with all the planes it spans, pass the resulting lines to line_out(layer_idx, line).
+    template<typename LineOut>
+    void _slice_do(size_t facet_idx, const std::vector<float> &z, LineOut &&line_out) const;
+    void _slice_lines_locked(const std::vector<float> &z, std::vector<IntersectionLines> &lines, throw_on_cancel_callback_type throw_on_cancel) const;
+    void _slice_lines_buckets(const std::vector<float> &z, std::vector<IntersectionLines> &lines, throw_on_cancel_callback_type throw_on_cancel) const;
+    void _slice_sweep(const std::vector<float> &z, SlicingMode mode, size_t alternate_mode_first_n_layers, SlicingMode alternate_mode,
+        std::vector<Polygons> &layers, throw_on_cancel_callback_type throw_on_cancel) const;
+    // Chain the lines of a single layer into loops, apply the slicing mode.
+    void _make_loops_do(IntersectionLines &lines, SlicingMode mode, Polygons &polygons) const;
     void make_loops(std::vector<IntersectionLine> &lines, Polygons* loops) const;
     void make_expolygons(const Polygons &loops, ExPolygons* slices) const;
     void make_expolygons_simple(std::vector<IntersectionLine> &lines, ExPolygons* slices) const;
@@ -1,9 +1,11 @@
+#include <deque>
 #include <exception>
 
 #include "Exception.hpp"
 #include "Zipper.hpp"
 #include "miniz_extension.hpp"
 #include <boost/log/trivial.hpp>
+#include <tbb/task_group.h>
 #include "I18N.hpp"
 
 //! macro used to mark string used at localization,
@@ -37,8 +39,92 @@ public:
     {
         return arch.m_zip_mode != MZ_ZIP_MODE_WRITING_HAS_BEEN_FINALIZED;
     }
+
+    // The compression tasks access the pending entries.
+    ~Impl() { m_compress_tasks.wait(); }
+
+    // Queue an entry to be compressed on a worker thread. It will be written
+    // by write_pending(), called once enough entries are waiting.
+    void add_pending(const std::string &name, std::string &&data, mz_uint level);
+
+    // Wait for the queued entries to be compressed and write them in order.
+    void write_pending();
+
+private:
+    // Entry with its raw deflate stream, as stored in the zip file.
+    struct PendingEntry {
+        std::string name;
+        std::string data;
+        void       *compressed      = nullptr;
+        size_t      compressed_size = 0;
+        mz_uint32   crc32           = 0;
+
+        ~PendingEntry() { mz_free(compressed); }
+    };
+
+    // Bounds of the memory held by the entries waiting to be written.
+    static constexpr size_t max_pending_entries = 64;
+    static constexpr size_t max_pending_bytes   = 64 * 1024 * 1024;
+
+    tbb::task_group                           m_compress_tasks;
+    std::deque<std::unique_ptr<PendingEntry>> m_pending;
+    size_t                                    m_pending_bytes = 0;
 };
 
+void Zipper::Impl::add_pending(const std::string &name, std::string &&data, mz_uint level)
+{
+    m_pending.emplace_back(new PendingEntry{ name, std::move(data) });
+    PendingEntry *entry = m_pending.back().get();
+    m_pending_bytes += entry->data.size();
+
+    m_compress_tasks.run([entry, level]() {
+        auto *src = reinterpret_cast<const mz_uint8*>(entry->data.data());
+        entry->crc32 = mz_uint32(mz_crc32(MZ_CRC32_INIT, src, entry->data.size()));
+        // Negative window bits for a raw deflate stream, the same as miniz
+        // produces when compressing the entry while writing it.
+        entry->compressed = tdefl_compress_mem_to_heap(src, entry->data.size(), &entry->compressed_size,
+            tdefl_create_comp_flags_from_zip_params(int(level), -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+    });
+
+    if (m_pending.size() >= max_pending_entries || m_pending_bytes >= max_pending_bytes)
+        write_pending();
+}
+
+void Zipper::Impl::write_pending()
+{
+    m_compress_tasks.wait();
+
+    std::deque<std::unique_ptr<PendingEntry>> pending;
+    pending.swap(m_pending);
+    m_pending_bytes = 0;
+
+    for (const std::unique_ptr<PendingEntry> &entry : pending) {
+        bool written;
+        if (entry->compressed != nullptr && entry->compressed_size < entry->data.size())
+            written = mz_zip_writer_add_mem_ex(&arch, entry->name.c_str(),
+                                               entry->compressed, entry->compressed_size,
+                                               nullptr, 0, MZ_ZIP_FLAG_COMPRESSED_DATA,
+                                               entry->data.size(), entry->crc32);
+        else
+            // Out of memory or incompressible, store the data.
+            written = mz_zip_writer_add_mem(&arch, entry->name.c_str(),
+                                            entry->data.data(), entry->data.size(),
+                                            MZ_NO_COMPRESSION);
+        if (!written)
+            blow_up();
+    }
+}
+
+static mz_uint compression_level(Zipper::e_compression compression)
+{
+    switch (compression) {
+    case Zipper::NO_COMPRESSION: return MZ_NO_COMPRESSION;
+    case Zipper::FAST_COMPRESSION: return MZ_BEST_SPEED;
+    case Zipper::TIGHT_COMPRESSION: return MZ_BEST_COMPRESSION;
+    }
+    return MZ_NO_COMPRESSION;
+}
+
 Zipper::Zipper(const std::string &zipfname, e_compression compression)
 {
     m_impl.reset(new Impl());
@@ -57,7 +143,7 @@ Zipper::~Zipper()
 {
     if(m_impl->is_alive()) {
         // Flush the current entry if not finished yet.
-        try { finish_entry(); } catch(...) {
+        try { finish_entry(); m_impl->write_pending(); } catch(...) {
             BOOST_LOG_TRIVIAL(error) << m_impl->formatted_errorstr();
         }
 
@@ -97,16 +183,17 @@ void Zipper::add_entry(const std::string &name, const void *data, size_t l)
     if(!m_impl->is_alive()) return;
 
     finish_entry();
-    mz_uint cmpr = MZ_NO_COMPRESSION;
-    switch (m_compression) {
-    case NO_COMPRESSION: cmpr = MZ_NO_COMPRESSION; break;
-    case FAST_COMPRESSION: cmpr = MZ_BEST_SPEED; break;
-    case TIGHT_COMPRESSION: cmpr = MZ_BEST_COMPRESSION; break;
+    mz_uint cmpr = compression_level(m_compression);
+
+    if (cmpr != MZ_NO_COMPRESSION && l > 0) {
+        m_impl->add_pending(name, std::string(static_cast<const char*>(data), l), cmpr);
+    } else {
+        // Keep the order of the entries.
+        m_impl->write_pending();
+        if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, cmpr))
+            m_impl->blow_up();
     }
 
-    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, cmpr))
-        m_impl->blow_up();
-
     m_entry.clear();
     m_data.clear();
 }
@@ -116,18 +203,14 @@ void Zipper::finish_entry()
     if(!m_impl->is_alive()) return;
 
     if(!m_data.empty() && !m_entry.empty()) {
-        mz_uint compression = MZ_NO_COMPRESSION;
-
-        switch (m_compression) {
-        case NO_COMPRESSION: compression = MZ_NO_COMPRESSION; break;
-        case FAST_COMPRESSION: compression = MZ_BEST_SPEED; break;
-        case TIGHT_COMPRESSION: compression = MZ_BEST_COMPRESSION; break;
-        }
-
-        if(!mz_zip_writer_add_mem(&m_impl->arch, m_entry.c_str(),
-                                  m_data.c_str(),
-                                  m_data.size(),
-                                  compression)) m_impl->blow_up();
+        mz_uint compression = compression_level(m_compression);
+
+        if (compression != MZ_NO_COMPRESSION) {
+            m_impl->add_pending(m_entry, std::move(m_data), compression);
+        } else if(!mz_zip_writer_add_mem(&m_impl->arch, m_entry.c_str(),
+                                         m_data.c_str(),
+                                         m_data.size(),
+                                         compression)) m_impl->blow_up();
     }
 
     m_data.clear();
@@ -138,8 +221,11 @@ void Zipper::finalize()
 {
     finish_entry();
 
-    if(m_impl->is_alive()) if(!mz_zip_writer_finalize_archive(&m_impl->arch))
-        m_impl->blow_up();
+    if(m_impl->is_alive()) {
+        m_impl->write_pending();
+        if(!mz_zip_writer_finalize_archive(&m_impl->arch))
+            m_impl->blow_up();
+    }
 }
 
 const std::string &Zipper::get_filename() const
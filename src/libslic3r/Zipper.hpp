@@ -12,6 +12,7 @@ class Zipper {
 public:
     // Three compression levels supported
     enum e_compression {
+        // The entries are stored only. Fastest, suitable for temporary or backup files.
         NO_COMPRESSION,
         FAST_COMPRESSION,
         TIGHT_COMPRESSION
@@ -48,6 +49,7 @@ public:
     void add_entry(const std::string& name);
 
     /// Add a new binary file entry with an instantly given byte buffer.
+    /// The buffer is copied, so it may be released right after the call.
     /// This method throws exactly like finish_entry() does.
     void add_entry(const std::string& name, const void* data, size_t bytes);
 
@@ -77,11 +79,18 @@ public:
     /// If the buffer was written, but no entry was added, the buffer will be
     /// cleared after this call.
     ///
+    /// Unless the archive is NO_COMPRESSION, the finished entries are
+    /// compressed in parallel on worker threads, each into an independent
+    /// deflate stream, and written to the archive in the order they were
+    /// added. A write error may thus be reported by a later call, at the
+    /// latest by finalize().
+    ///
     /// This method will throw a runtime exception if an error occures. The
     /// entry will still be open (with the data intact) but the state of the
     /// file is up to minz after the erroneous write.
     void finish_entry();
 
+    /// Write the pending entries and the central directory.
     void finalize();
 
     const std::string & get_filename() const;
@@ -70,19 +70,6 @@ static std::vector<std::array<float, 3>> decode_colors(const std::vector<std::st
     return output;
 }
 
-static float round_to_nearest(float value, unsigned int decimals)
-{
-    float res = 0.0f;
-    if (decimals == 0)
-        res = std::round(value);
-    else {
-        char buf[64];
-        sprintf(buf, "%.*g", decimals, value);
-        res = std::stof(buf);
-    }
-    return res;
-}
-
 #if ENABLE_SPLITTED_VERTEX_BUFFER
 void GCodeViewer::VBuffer::reset()
 {
@@ -129,7 +116,7 @@ void GCodeViewer::IBuffer::reset()
     count = 0;
 }
 
-bool GCodeViewer::Path::matches(const GCodeProcessor::MoveVertex& move) const
+bool GCodeViewer::Path::matches(const GCodeProcessor::MoveVertices& moves, size_t move_id) const
 {
 #if ENABLE_TOOLPATHS_WIDTH_HEIGHT_FROM_GCODE
     auto matches_percent = [](float value1, float value2, float max_percent) {
@@ -137,7 +124,7 @@ bool GCodeViewer::Path::matches(const GCodeProcessor::MoveVertex& move) const
     };
 #endif // ENABLE_TOOLPATHS_WIDTH_HEIGHT_FROM_GCODE
 
-    switch (move.type)
+    switch (moves.type(move_id))
     {
     case EMoveType::Tool_change:
     case EMoveType::Color_change:
@@ -149,36 +136,36 @@ bool GCodeViewer::Path::matches(const GCodeProcessor::MoveVertex& move) const
         // use rounding to reduce the number of generated paths
 #if ENABLE_SPLITTED_VERTEX_BUFFER
 #if ENABLE_TOOLPATHS_WIDTH_HEIGHT_FROM_GCODE
-        return type == move.type && extruder_id == move.extruder_id && cp_color_id == move.cp_color_id && role == move.extrusion_role &&
-            move.position[2] <= sub_paths.front().first.position[2] && feedrate == move.feedrate && fan_speed == move.fan_speed &&
-            layer_time == move.layer_duration && elapsed_time == move.time && extruder_temp == move.temperature &&
-            height == round_to_nearest(move.height, 2) && width == round_to_nearest(move.width, 2) &&
-            matches_percent(volumetric_rate, move.volumetric_rate(), 0.05f);
+        return type == moves.type(move_id) && extruder_id == moves.extruder_id(move_id) && cp_color_id == moves.cp_color_id(move_id) && role == moves.extrusion_role(move_id) &&
+            moves.position(move_id)[2] <= sub_paths.front().first.position[2] && feedrate == moves.feedrate(move_id) && fan_speed == moves.fan_speed(move_id) &&
+            layer_time == moves.layer_duration(move_id) && elapsed_time == moves.time(move_id) && extruder_temp == moves.temperature(move_id) &&
+            height == round_to_nearest(moves.height(move_id), 2) && width == round_to_nearest(moves.width(move_id), 2) &&
+            matches_percent(volumetric_rate, moves.volumetric_rate(move_id), 0.05f);
 #else
-        return type == move.type && move.position[2] <= sub_paths.front().position[2] && role == move.extrusion_role && height == round_to_nearest(move.height, 2) &&
-            width == round_to_nearest(move.width, 2) && feedrate == move.feedrate && fan_speed == move.fan_speed &&
-            layer_time == move.layer_duration && elapsed_time == move.time && extruder_temp == move.temperature &&
-            volumetric_rate == round_to_nearest(move.volumetric_rate(), 2) && extruder_id == move.extruder_id &&
-            cp_color_id == move.cp_color_id;
+        return type == moves.type(move_id) && moves.position(move_id)[2] <= sub_paths.front().position[2] && role == moves.extrusion_role(move_id) && height == round_to_nearest(moves.height(move_id), 2) &&
+            width == round_to_nearest(moves.width(move_id), 2) && feedrate == moves.feedrate(move_id) && fan_speed == moves.fan_speed(move_id) &&
+            layer_time == moves.layer_duration(move_id) && elapsed_time == moves.time(move_id) && extruder_temp == moves.temperature(move_id) &&
+            volumetric_rate == round_to_nearest(moves.volumetric_rate(move_id), 2) && extruder_id == moves.extruder_id(move_id) &&
+            cp_color_id == moves.cp_color_id(move_id);
 #endif // ENABLE_TOOLPATHS_WIDTH_HEIGHT_FROM_GCODE
 #else
 #if ENABLE_TOOLPATHS_WIDTH_HEIGHT_FROM_GCODE
-        return type == move.type && extruder_id == move.extruder_id && cp_color_id == move.cp_color_id && role == move.extrusion_role &&
-            move.position[2] <= first.position[2] && feedrate == move.feedrate && fan_speed == move.fan_speed &&
-            layer_time == move.layer_duration && elapsed_time == move.time && extruder_temp == move.temperature &&
-            height == round_to_nearest(move.height, 2) && width == round_to_nearest(move.width, 2) &&
-            matches_percent(volumetric_rate, move.volumetric_rate(), 0.05f);
+        return type == moves.type(move_id) && extruder_id == moves.extruder_id(move_id) && cp_color_id == moves.cp_color_id(move_id) && role == moves.extrusion_role(move_id) &&
+            moves.position(move_id)[2] <= first.position[2] && feedrate == moves.feedrate(move_id) && fan_speed == moves.fan_speed(move_id) &&
+            layer_time == moves.layer_duration(move_id) && elapsed_time == moves.time(move_id) && extruder_temp == moves.temperature(move_id) &&
+            height == round_to_nearest(moves.height(move_id), 2) && width == round_to_nearest(moves.width(move_id), 2) &&
+            matches_percent(volumetric_rate, moves.volumetric_rate(move_id), 0.05f);
 #else
-        return type == move.type && move.position[2] <= first.position[2] && role == move.extrusion_role && height == round_to_nearest(move.height, 2) &&
-            width == round_to_nearest(move.width, 2) && feedrate == move.feedrate && fan_speed == move.fan_speed &&
-            layer_time == move.layer_duration && elapsed_time == move.time && extruder_temp == move.temperature &&
-            volumetric_rate == round_to_nearest(move.volumetric_rate(), 2) && extruder_id == move.extruder_id &&
-            cp_color_id == move.cp_color_id;
+        return type == moves.type(move_id) && moves.position(move_id)[2] <= first.position[2] && role == moves.extrusion_role(move_id) && height == round_to_nearest(moves.height(move_id), 2) &&
+            width == round_to_nearest(moves.width(move_id), 2) && feedrate == moves.feedrate(move_id) && fan_speed == moves.fan_speed(move_id) &&
+            layer_time == moves.layer_duration(move_id) && elapsed_time == moves.time(move_id) && extruder_temp == moves.temperature(move_id) &&
+            volumetric_rate == round_to_nearest(moves.volumetric_rate(move_id), 2) && extruder_id == moves.extruder_id(move_id) &&
+            cp_color_id == moves.cp_color_id(move_id);
 #endif // ENABLE_TOOLPATHS_WIDTH_HEIGHT_FROM_GCODE
 #endif // ENABLE_SPLITTED_VERTEX_BUFFER
     }
     case EMoveType::Travel: {
-        return type == move.type && feedrate == move.feedrate && extruder_id == move.extruder_id && cp_color_id == move.cp_color_id;
+        return type == moves.type(move_id) && feedrate == moves.feedrate(move_id) && extruder_id == moves.extruder_id(move_id) && cp_color_id == moves.cp_color_id(move_id);
     }
     default: { return false; }
     }
@@ -198,8 +185,10 @@ void GCodeViewer::TBuffer::reset()
     render_paths.clear();
 }
 
-void GCodeViewer::TBuffer::add_path(const GCodeProcessor::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id)
+void GCodeViewer::TBuffer::add_path(const GCodeProcessor::MoveVertices& moves, size_t move_id, unsigned int b_id, size_t i_id, size_t s_id)
 {
+    // a new path is started much less often than a move is added, gather all the columns once here
+    const GCodeProcessor::MoveVertex move = moves[move_id];
     Path::Endpoint endpoint = { b_id, i_id, s_id, move.position };
     // use rounding to reduce the number of generated paths
 #if ENABLE_SPLITTED_VERTEX_BUFFER
@@ -574,35 +563,32 @@ void GCodeViewer::refresh(const GCodeProcessor::Result& gcode_result, const std:
 
     // update ranges for coloring / legend
     m_extrusions.reset_ranges();
+    // the ranges of the quantized values are accumulated in full precision by the processor
+    const GCodeProcessor::MoveVertices::ValueRanges& value_ranges = gcode_result.moves.value_ranges();
+    m_extrusions.ranges.height.set_from(value_ranges.height);
+    m_extrusions.ranges.width.set_from(value_ranges.width);
+    m_extrusions.ranges.fan_speed.set_from(value_ranges.fan_speed);
+    m_extrusions.ranges.volumetric_rate.set_from(value_ranges.volumetric_rate);
+    m_extrusions.ranges.extruder_temp.set_from(value_ranges.temperature);
+    const bool extrude_visible = m_buffers[buffer_id(EMoveType::Extrude)].visible;
+    const bool travel_visible = m_buffers[buffer_id(EMoveType::Travel)].visible;
+    if (extrude_visible && travel_visible)
+        m_extrusions.ranges.feedrate.set_from(value_ranges.feedrate);
+    else if (extrude_visible)
+        m_extrusions.ranges.feedrate.set_from(value_ranges.extrude_feedrate);
+    else if (travel_visible)
+        m_extrusions.ranges.feedrate.set_from(value_ranges.travel_feedrate);
+
     for (size_t i = 0; i < m_moves_count; ++i) {
         // skip first vertex
         if (i == 0)
             continue;
 
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
-
-        switch (curr.type)
-        {
-        case EMoveType::Extrude:
-        {
-            m_extrusions.ranges.height.update_from(round_to_nearest(curr.height, 2));
-            m_extrusions.ranges.width.update_from(round_to_nearest(curr.width, 2));
-            m_extrusions.ranges.fan_speed.update_from(curr.fan_speed);
-            if(curr.layer_duration > 0.f)
-                m_extrusions.ranges.layer_duration.update_from(curr.layer_duration);
-            m_extrusions.ranges.elapsed_time.update_from(curr.time);
-            m_extrusions.ranges.volumetric_rate.update_from(round_to_nearest(curr.volumetric_rate(), 2));
-            m_extrusions.ranges.extruder_temp.update_from(curr.temperature);
-            [[fallthrough]];
-        }
-        case EMoveType::Travel:
-        {
-            if (m_buffers[buffer_id(curr.type)].visible)
-                m_extrusions.ranges.feedrate.update_from(curr.feedrate);
-
-            break;
-        }
-        default: { break; }
+        if (gcode_result.moves.type(i) == EMoveType::Extrude) {
+            const float layer_duration = gcode_result.moves.layer_duration(i);
+            if (layer_duration > 0.f)
+                m_extrusions.ranges.layer_duration.update_from(layer_duration);
+            m_extrusions.ranges.elapsed_time.update_from(gcode_result.moves.time(i));
         }
     }
 
@@ -1263,43 +1249,43 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     };
 
     // format data into the buffers to be rendered as points
-    auto add_vertices_as_point = [](const GCodeProcessor::MoveVertex& curr, VertexBuffer& vertices) {
-        vertices.push_back(curr.position[0]);
-        vertices.push_back(curr.position[1]);
-        vertices.push_back(curr.position[2]);
+    auto add_vertices_as_point = [](const Vec3f& position, VertexBuffer& vertices) {
+        vertices.push_back(position[0]);
+        vertices.push_back(position[1]);
+        vertices.push_back(position[2]);
     };
-    auto add_indices_as_point = [](const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_point = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
         unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            buffer.add_path(curr, ibuffer_id, indices.size(), move_id);
+            buffer.add_path(moves, move_id, ibuffer_id, indices.size(), move_id);
             indices.push_back(static_cast<IBufferType>(indices.size()));
     };
 
     // format data into the buffers to be rendered as lines
-    auto add_vertices_as_line = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, VertexBuffer& vertices) {
+    auto add_vertices_as_line = [](const Vec3f& prev_position, const Vec3f& curr_position, VertexBuffer& vertices) {
         // x component of the normal to the current segment (the normal is parallel to the XY plane)
-        float normal_x = (curr.position - prev.position).normalized()[1];
+        float normal_x = (curr_position - prev_position).normalized()[1];
 
-        auto add_vertex = [&vertices, normal_x](const GCodeProcessor::MoveVertex& vertex) {
+        auto add_vertex = [&vertices, normal_x](const Vec3f& position) {
             // add position
-            vertices.push_back(vertex.position[0]);
-            vertices.push_back(vertex.position[1]);
-            vertices.push_back(vertex.position[2]);
+            vertices.push_back(position[0]);
+            vertices.push_back(position[1]);
+            vertices.push_back(position[2]);
             // add normal x component
             vertices.push_back(normal_x);
         };
 
         // add previous vertex
-        add_vertex(prev);
+        add_vertex(prev_position);
         // add current vertex
-        add_vertex(curr);
+        add_vertex(curr_position);
     };
-    auto add_indices_as_line = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_line = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
         unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            if (prev.type != curr.type || !buffer.paths.back().matches(curr)) {
+            if (moves.type(move_id - 1) != moves.type(move_id) || !buffer.paths.back().matches(moves, move_id)) {
                 // add starting index
                 indices.push_back(static_cast<unsigned int>(indices.size()));
-                buffer.add_path(curr, ibuffer_id, indices.size() - 1, move_id - 1);
-                buffer.paths.back().sub_paths.front().first.position = prev.position;
+                buffer.add_path(moves, move_id, ibuffer_id, indices.size() - 1, move_id - 1);
+                buffer.paths.back().sub_paths.front().first.position = moves.position(move_id - 1);
             }
 
             Path& last_path = buffer.paths.back();
@@ -1310,11 +1296,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 
             // add current index
             indices.push_back(static_cast<unsigned int>(indices.size()));
-            last_path.sub_paths.back().last = { ibuffer_id, indices.size() - 1, move_id, curr.position };
+            last_path.sub_paths.back().last = { ibuffer_id, indices.size() - 1, move_id, moves.position(move_id) };
     };
 
     // format data into the buffers to be rendered as solid
-    auto add_vertices_as_solid = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, TBuffer& buffer, unsigned int vbuffer_id, VertexBuffer& vertices, size_t move_id) {
+    auto add_vertices_as_solid = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer, unsigned int vbuffer_id, VertexBuffer& vertices, size_t move_id) {
         auto store_vertex = [](VertexBuffer& vertices, const Vec3f& position, const Vec3f& normal) {
             // append position
             vertices.push_back(position[0]);
@@ -1326,22 +1312,22 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             vertices.push_back(normal[2]);
         };
 
-        if (prev.type != curr.type || !buffer.paths.back().matches(curr)) {
-            buffer.add_path(curr, vbuffer_id, vertices.size(), move_id - 1);
-            buffer.paths.back().sub_paths.back().first.position = prev.position;
+        if (moves.type(move_id - 1) != moves.type(move_id) || !buffer.paths.back().matches(moves, move_id)) {
+            buffer.add_path(moves, move_id, vbuffer_id, vertices.size(), move_id - 1);
+            buffer.paths.back().sub_paths.back().first.position = moves.position(move_id - 1);
         }
 
         Path& last_path = buffer.paths.back();
 
-        Vec3f dir = (curr.position - prev.position).normalized();
+        Vec3f dir = (moves.position(move_id) - moves.position(move_id - 1)).normalized();
         Vec3f right = Vec3f(dir[1], -dir[0], 0.0f).normalized();
         Vec3f left = -right;
         Vec3f up = right.cross(dir);
         Vec3f down = -up;
         float half_width = 0.5f * last_path.width;
         float half_height = 0.5f * last_path.height;
-        Vec3f prev_pos = prev.position - half_height * up;
-        Vec3f curr_pos = curr.position - half_height * up;
+        Vec3f prev_pos = moves.position(move_id - 1) - half_height * up;
+        Vec3f curr_pos = moves.position(move_id) - half_height * up;
         Vec3f d_up = half_height * up;
         Vec3f d_down = -half_height * up;
         Vec3f d_right = half_width * right;
@@ -1369,13 +1355,13 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
         store_vertex(vertices, curr_pos + d_down, down);
         store_vertex(vertices, curr_pos + d_left, left);
 
-        last_path.sub_paths.back().last = { vbuffer_id, vertices.size(), move_id, curr.position };
+        last_path.sub_paths.back().last = { vbuffer_id, vertices.size(), move_id, moves.position(move_id) };
     };
 #if ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
-    auto add_indices_as_solid = [&](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, const GCodeProcessor::MoveVertex* next,
+    auto add_indices_as_solid = [&](const GCodeProcessor::MoveVertices& moves,
         TBuffer& buffer, size_t& vbuffer_size, unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
 #else
-    auto add_indices_as_solid = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_solid = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
         size_t& vbuffer_size, unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
 #endif // ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
             static Vec3f prev_dir;
@@ -1449,17 +1435,17 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             };
 #endif // ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
 
-            if (prev.type != curr.type || !buffer.paths.back().matches(curr)) {
-                buffer.add_path(curr, ibuffer_id, indices.size(), move_id - 1);
-                buffer.paths.back().sub_paths.back().first.position = prev.position;
+            if (moves.type(move_id - 1) != moves.type(move_id) || !buffer.paths.back().matches(moves, move_id)) {
+                buffer.add_path(moves, move_id, ibuffer_id, indices.size(), move_id - 1);
+                buffer.paths.back().sub_paths.back().first.position = moves.position(move_id - 1);
             }
 
             Path& last_path = buffer.paths.back();
 
-            Vec3f dir = (curr.position - prev.position).normalized();
+            Vec3f dir = (moves.position(move_id) - moves.position(move_id - 1)).normalized();
             Vec3f right = Vec3f(dir[1], -dir[0], 0.0f).normalized();
             Vec3f up = right.cross(dir);
-            float sq_length = (curr.position - prev.position).squaredNorm();
+            float sq_length = (moves.position(move_id) - moves.position(move_id - 1)).squaredNorm();
 
 #if ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
             const std::array<IBufferType, 8> first_seg_v_offsets = convert_vertices_offset(vbuffer_size, { 0, 1, 2, 3, 4, 5, 6, 7 });
@@ -1546,12 +1532,12 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             }
 
 #if ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
-            if (next != nullptr && (curr.type != next->type || !last_path.matches(*next)))
+            if (move_id + 1 < moves.size() && (moves.type(move_id) != moves.type(move_id + 1) || !last_path.matches(moves, move_id + 1)))
                 // ending cap triangles
                 append_ending_cap_triangles(indices, non_first_seg_v_offsets);
 #endif // ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
 
-            last_path.sub_paths.back().last = { ibuffer_id, indices.size() - 1, move_id, curr.position };
+            last_path.sub_paths.back().last = { ibuffer_id, indices.size() - 1, move_id, moves.position(move_id) };
             prev_dir = dir;
             prev_up = up;
             sq_prev_length = sq_length;
@@ -1559,7 +1545,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto start_time = std::chrono::high_resolution_clock::now();
-    m_statistics.results_size = SLIC3R_STDVEC_MEMSIZE(gcode_result.moves, GCodeProcessor::MoveVertex);
+    m_statistics.results_size = gcode_result.moves.memsize();
     m_statistics.results_time = gcode_result.time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
@@ -1576,13 +1562,14 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     wxBusyCursor busy;
 
     // extract approximate paths bounding box from result
-    for (const GCodeProcessor::MoveVertex& move : gcode_result.moves) {
+    for (size_t i = 0; i < m_moves_count; ++i) {
+        const Vec3f& position = gcode_result.moves.position(i);
         if (wxGetApp().is_gcode_viewer())
             // for the gcode viewer we need to take in account all moves to correctly size the printbed
-            m_paths_bounding_box.merge(move.position.cast<double>());
+            m_paths_bounding_box.merge(position.cast<double>());
         else {
-            if (move.type == EMoveType::Extrude && move.width != 0.0f && move.height != 0.0f)
-                m_paths_bounding_box.merge(move.position.cast<double>());
+            if (gcode_result.moves.type(i) == EMoveType::Extrude && gcode_result.moves.width(i) != 0.0f && gcode_result.moves.height(i) != 0.0f)
+                m_paths_bounding_box.merge(position.cast<double>());
         }
     }
 
@@ -1595,14 +1582,13 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     std::vector<float> options_zs;
 
     // toolpaths data -> extract vertices from result
+    const GCodeProcessor::MoveVertices& moves = gcode_result.moves;
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
-
         // skip first vertex
         if (i == 0)
             continue;
 
-        const GCodeProcessor::MoveVertex& prev = gcode_result.moves[i - 1];
+        const EMoveType curr_type = moves.type(i);
 
         // update progress dialog
         ++progress_count;
@@ -1613,7 +1599,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             progress_count = 0;
         }
 
-        unsigned char id = buffer_id(curr.type);
+        unsigned char id = buffer_id(curr_type);
         TBuffer& t_buffer = m_buffers[id];
         MultiVertexBuffer& v_multibuffer = vertices[id];
 
@@ -1627,8 +1613,8 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             v_multibuffer.push_back(VertexBuffer());
             if (t_buffer.render_primitive_type == TBuffer::ERenderPrimitiveType::Triangle) {
                 Path& last_path = t_buffer.paths.back();
-                if (prev.type == curr.type && last_path.matches(curr))
-                    last_path.add_sub_path(prev, static_cast<unsigned int>(v_multibuffer.size()) - 1, 0, i - 1);
+                if (moves.type(i - 1) == curr_type && last_path.matches(moves, i))
+                    last_path.add_sub_path(moves.position(i - 1), static_cast<unsigned int>(v_multibuffer.size()) - 1, 0, i - 1);
             }
         }
 
@@ -1636,16 +1622,17 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 
         switch (t_buffer.render_primitive_type)
         {
-        case TBuffer::ERenderPrimitiveType::Point:    { add_vertices_as_point(curr, v_buffer); break; }
-        case TBuffer::ERenderPrimitiveType::Line:     { add_vertices_as_line(prev, curr, v_buffer); break; }
-        case TBuffer::ERenderPrimitiveType::Triangle: { add_vertices_as_solid(prev, curr, t_buffer, static_cast<unsigned int>(v_multibuffer.size()) - 1, v_buffer, i); break; }
+        case TBuffer::ERenderPrimitiveType::Point:    { add_vertices_as_point(moves.position(i), v_buffer); break; }
+        case TBuffer::ERenderPrimitiveType::Line:     { add_vertices_as_line(moves.position(i - 1), moves.position(i), v_buffer); break; }
+        case TBuffer::ERenderPrimitiveType::Triangle: { add_vertices_as_solid(moves, t_buffer, static_cast<unsigned int>(v_multibuffer.size()) - 1, v_buffer, i); break; }
         }
 
         // collect options zs for later use
-        if (curr.type == EMoveType::Pause_Print || curr.type == EMoveType::Custom_GCode) {
+        if (curr_type == EMoveType::Pause_Print || curr_type == EMoveType::Custom_GCode) {
             const float* const last_z = options_zs.empty() ? nullptr : &options_zs.back();
-            if (last_z == nullptr || curr.position[2] < *last_z - EPSILON || *last_z + EPSILON < curr.position[2])
-                options_zs.emplace_back(curr.position[2]);
+            const float z = moves.position(i)[2];
+            if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z)
+                options_zs.emplace_back(z);
         }
     }
 
@@ -1734,9 +1721,9 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             float half_width = 0.5f * path.width;
             for (size_t j = 1; j < path_vertices_count - 1; ++j) {
                 size_t curr_s_id = path.sub_paths.front().first.s_id + j;
-                const Vec3f& prev = gcode_result.moves[curr_s_id - 1].position;
-                const Vec3f& curr = gcode_result.moves[curr_s_id].position;
-                const Vec3f& next = gcode_result.moves[curr_s_id + 1].position;
+                const Vec3f& prev = gcode_result.moves.position(curr_s_id - 1);
+                const Vec3f& curr = gcode_result.moves.position(curr_s_id);
+                const Vec3f& next = gcode_result.moves.position(curr_s_id + 1);
 
                 // select the subpaths which contains the previous/next segments
                 if (!path.sub_paths[prev_sub_path_id].contains(curr_s_id))
@@ -1869,19 +1856,10 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     std::vector<VboIndexList> vbo_indices(m_buffers.size());
 
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
-
         // skip first vertex
         if (i == 0)
             continue;
 
-        const GCodeProcessor::MoveVertex& prev = gcode_result.moves[i - 1];
-#if ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
-        const GCodeProcessor::MoveVertex* next = nullptr;
-        if (i < m_moves_count - 1)
-            next = &gcode_result.moves[i + 1];
-#endif // ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
-
         ++progress_count;
         if (progress_dialog != nullptr && progress_count % progress_threshold == 0) {
             progress_dialog->Update(int(100.0f * float(m_moves_count + i) / (2.0f * float(m_moves_count))),
@@ -1890,7 +1868,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             progress_count = 0;
         }
 
-        unsigned char id = buffer_id(curr.type);
+        unsigned char id = buffer_id(moves.type(i));
         TBuffer& t_buffer = m_buffers[id];
         MultiIndexBuffer& i_multibuffer = indices[id];
         CurrVertexBuffer& curr_vertex_buffer = curr_vertex_buffers[id];
@@ -1913,7 +1891,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             vbo_index_list.push_back(t_buffer.vertices.vbos[curr_vertex_buffer.first]);
             if (t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Point) {
                 Path& last_path = t_buffer.paths.back();
-                last_path.add_sub_path(prev, static_cast<unsigned int>(i_multibuffer.size()) - 1, 0, i - 1);
+                last_path.add_sub_path(moves.position(i - 1), static_cast<unsigned int>(i_multibuffer.size()) - 1, 0, i - 1);
             }
         }
 
@@ -1928,7 +1906,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 
             if (t_buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Point) {
                 Path& last_path = t_buffer.paths.back();
-                last_path.add_sub_path(prev, static_cast<unsigned int>(i_multibuffer.size()) - 1, 0, i - 1);
+                last_path.add_sub_path(moves.position(i - 1), static_cast<unsigned int>(i_multibuffer.size()) - 1, 0, i - 1);
             }
         }
 
@@ -1937,20 +1915,20 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
         switch (t_buffer.render_primitive_type)
         {
         case TBuffer::ERenderPrimitiveType::Point: {
-            add_indices_as_point(curr, t_buffer, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
+            add_indices_as_point(moves, t_buffer, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
             curr_vertex_buffer.second += t_buffer.max_vertices_per_segment();
             break;
         }
         case TBuffer::ERenderPrimitiveType::Line: {
-            add_indices_as_line(prev, curr, t_buffer, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
+            add_indices_as_line(moves, t_buffer, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
             curr_vertex_buffer.second += t_buffer.max_vertices_per_segment();
             break;
         }
         case TBuffer::ERenderPrimitiveType::Triangle: {
 #if ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
-            add_indices_as_solid(prev, curr, next, t_buffer, curr_vertex_buffer.second, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
+            add_indices_as_solid(moves, t_buffer, curr_vertex_buffer.second, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
 #else
-            add_indices_as_solid(prev, curr, t_buffer, curr_vertex_buffer.second, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
+            add_indices_as_solid(moves, t_buffer, curr_vertex_buffer.second, static_cast<unsigned int>(i_multibuffer.size()) - 1, i_buffer, i);
 #endif // ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS
             break;
         }
@@ -2033,24 +2011,25 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     std::vector<MultiIndexBuffer>().swap(indices);
 
     // layers zs / roles / extruder ids -> extract from result
+    const GCodeProcessor::MoveVertices& moves = gcode_result.moves;
     size_t last_travel_s_id = 0;
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessor::MoveVertex& move = gcode_result.moves[i];
-        if (move.type == EMoveType::Extrude) {
+        const EMoveType type = moves.type(i);
+        if (type == EMoveType::Extrude) {
             // layers zs
             const double* const last_z = m_layers.empty() ? nullptr : &m_layers.get_zs().back();
-            double z = static_cast<double>(move.position[2]);
+            double z = static_cast<double>(moves.position(i)[2]);
             if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z)
                 m_layers.append(z, { last_travel_s_id, i });
             else
                 m_layers.get_endpoints().back().last = i;
             // extruder ids
-            m_extruder_ids.emplace_back(move.extruder_id);
+            m_extruder_ids.emplace_back(moves.extruder_id(i));
             // roles
             if (i > 0)
-                m_roles.emplace_back(move.extrusion_role);
+                m_roles.emplace_back(moves.extrusion_role(i));
         }
-        else if (move.type == EMoveType::Travel) {
+        else if (type == EMoveType::Travel) {
             if (i - last_travel_s_id > 1 && !m_layers.empty())
                 m_layers.get_endpoints().back().last = i;
 
@@ -2094,7 +2073,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 {
 #if ENABLE_GCODE_VIEWER_STATISTICS
     auto start_time = std::chrono::high_resolution_clock::now();
-    m_statistics.results_size = SLIC3R_STDVEC_MEMSIZE(gcode_result.moves, GCodeProcessor::MoveVertex);
+    m_statistics.results_size = gcode_result.moves.memsize();
     m_statistics.results_time = gcode_result.time;
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
@@ -2112,13 +2091,13 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     m_extruders_count = gcode_result.extruders_count;
 
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessor::MoveVertex& move = gcode_result.moves[i];
+        const Vec3f& position = gcode_result.moves.position(i);
         if (wxGetApp().is_gcode_viewer())
             // for the gcode viewer we need all moves to correctly size the printbed
-            m_paths_bounding_box.merge(move.position.cast<double>());
+            m_paths_bounding_box.merge(position.cast<double>());
         else {
-            if (move.type == EMoveType::Extrude && move.width != 0.0f && move.height != 0.0f)
-                m_paths_bounding_box.merge(move.position.cast<double>());
+            if (gcode_result.moves.type(i) == EMoveType::Extrude && gcode_result.moves.width(i) != 0.0f && gcode_result.moves.height(i) != 0.0f)
+                m_paths_bounding_box.merge(position.cast<double>());
         }
     }
 
@@ -2141,44 +2120,44 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     };
 
     // format data into the buffers to be rendered as points
-    auto add_vertices_as_point = [](const GCodeProcessor::MoveVertex& curr, VertexBuffer& vertices) {
-        vertices.push_back(curr.position[0]);
-        vertices.push_back(curr.position[1]);
-        vertices.push_back(curr.position[2]);
+    auto add_vertices_as_point = [](const Vec3f& position, VertexBuffer& vertices) {
+        vertices.push_back(position[0]);
+        vertices.push_back(position[1]);
+        vertices.push_back(position[2]);
     };
-    auto add_indices_as_point = [](const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_point = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
             unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            buffer.add_path(curr, ibuffer_id, indices.size(), move_id);
+            buffer.add_path(moves, move_id, ibuffer_id, indices.size(), move_id);
             indices.push_back(static_cast<unsigned int>(indices.size()));
     };
 
     // format data into the buffers to be rendered as lines
-    auto add_vertices_as_line = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr,
+    auto add_vertices_as_line = [](const Vec3f& prev_position, const Vec3f& curr_position,
         VertexBuffer& vertices) {
             // x component of the normal to the current segment (the normal is parallel to the XY plane)
-            float normal_x = (curr.position - prev.position).normalized()[1];
+            float normal_x = (curr_position - prev_position).normalized()[1];
 
-            auto add_vertex = [&vertices, normal_x](const GCodeProcessor::MoveVertex& vertex) {
+            auto add_vertex = [&vertices, normal_x](const Vec3f& position) {
                 // add position
-                vertices.push_back(vertex.position[0]);
-                vertices.push_back(vertex.position[1]);
-                vertices.push_back(vertex.position[2]);
+                vertices.push_back(position[0]);
+                vertices.push_back(position[1]);
+                vertices.push_back(position[2]);
                 // add normal x component
                 vertices.push_back(normal_x);
             };
 
             // add previous vertex
-            add_vertex(prev);
+            add_vertex(prev_position);
             // add current vertex
-            add_vertex(curr);
+            add_vertex(curr_position);
     };
-    auto add_indices_as_line = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_line = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
         unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
-            if (prev.type != curr.type || !buffer.paths.back().matches(curr)) {
+            if (moves.type(move_id - 1) != moves.type(move_id) || !buffer.paths.back().matches(moves, move_id)) {
                 // add starting index
                 indices.push_back(static_cast<unsigned int>(indices.size()));
-                buffer.add_path(curr, ibuffer_id, indices.size() - 1, move_id - 1);
-                buffer.paths.back().first.position = prev.position;
+                buffer.add_path(moves, move_id, ibuffer_id, indices.size() - 1, move_id - 1);
+                buffer.paths.back().first.position = moves.position(move_id - 1);
             }
 
             Path& last_path = buffer.paths.back();
@@ -2189,11 +2168,11 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
 
             // add current index
             indices.push_back(static_cast<unsigned int>(indices.size()));
-            last_path.last = { ibuffer_id, indices.size() - 1, move_id, curr.position };
+            last_path.last = { ibuffer_id, indices.size() - 1, move_id, moves.position(move_id) };
     };
 
     // format data into the buffers to be rendered as solid
-    auto add_vertices_as_solid = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_vertices_as_solid = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
         VertexBuffer& vertices, size_t move_id) {
             static Vec3f prev_dir;
             static Vec3f prev_up;
@@ -2217,14 +2196,14 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
                 vertices[id + 2] = position[2];
             };
 
-            if (prev.type != curr.type || !buffer.paths.back().matches(curr)) {
-                buffer.add_path(curr, 0, 0, move_id - 1);
-                buffer.paths.back().first.position = prev.position;
+            if (moves.type(move_id - 1) != moves.type(move_id) || !buffer.paths.back().matches(moves, move_id)) {
+                buffer.add_path(moves, move_id, 0, 0, move_id - 1);
+                buffer.paths.back().first.position = moves.position(move_id - 1);
             }
 
             unsigned int starting_vertices_size = static_cast<unsigned int>(vertices.size() / buffer.vertices.vertex_size_floats());
 
-            Vec3f dir = (curr.position - prev.position).normalized();
+            Vec3f dir = (moves.position(move_id) - moves.position(move_id - 1)).normalized();
             Vec3f right = (std::abs(std::abs(dir.dot(Vec3f::UnitZ())) - 1.0f) < EPSILON) ? -Vec3f::UnitY() : Vec3f(dir[1], -dir[0], 0.0f).normalized();
             Vec3f left = -right;
             Vec3f up = right.cross(dir);
@@ -2235,8 +2214,8 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             float half_width = 0.5f * last_path.width;
             float half_height = 0.5f * last_path.height;
 
-            Vec3f prev_pos = prev.position - half_height * up;
-            Vec3f curr_pos = curr.position - half_height * up;
+            Vec3f prev_pos = moves.position(move_id - 1) - half_height * up;
+            Vec3f curr_pos = moves.position(move_id) - half_height * up;
 
             float length = (curr_pos - prev_pos).norm();
             if (last_path.vertices_count() == 1) {
@@ -2333,12 +2312,12 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
                 store_vertex(vertices, curr_pos + half_width * left, left);
             }
 
-            last_path.last = { 0, 0, move_id, curr.position };
+            last_path.last = { 0, 0, move_id, moves.position(move_id) };
             prev_dir = dir;
             prev_up = up;
             prev_length = length;
     };
-    auto add_indices_as_solid = [](const GCodeProcessor::MoveVertex& prev, const GCodeProcessor::MoveVertex& curr, TBuffer& buffer,
+    auto add_indices_as_solid = [](const GCodeProcessor::MoveVertices& moves, TBuffer& buffer,
         size_t& buffer_vertices_size, unsigned int ibuffer_id, IndexBuffer& indices, size_t move_id) {
             static Vec3f prev_dir;
             static Vec3f prev_up;
@@ -2353,12 +2332,12 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
                 store_triangle(indices, id, id, id);
             };
 
-            if (prev.type != curr.type || !buffer.paths.back().matches(curr)) {
-                buffer.add_path(curr, ibuffer_id, indices.size(), move_id - 1);
-                buffer.paths.back().first.position = prev.position;
+            if (moves.type(move_id - 1) != moves.type(move_id) || !buffer.paths.back().matches(moves, move_id)) {
+                buffer.add_path(moves, move_id, ibuffer_id, indices.size(), move_id - 1);
+                buffer.paths.back().first.position = moves.position(move_id - 1);
             }
 
-            Vec3f dir = (curr.position - prev.position).normalized();
+            Vec3f dir = (moves.position(move_id) - moves.position(move_id - 1)).normalized();
             Vec3f right = (std::abs(std::abs(dir.dot(Vec3f::UnitZ())) - 1.0f) < EPSILON) ? -Vec3f::UnitY() : Vec3f(dir[1], -dir[0], 0.0f).normalized();
             Vec3f up = right.cross(dir);
 
@@ -2367,8 +2346,8 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             float half_width = 0.5f * last_path.width;
             float half_height = 0.5f * last_path.height;
 
-            Vec3f prev_pos = prev.position - half_height * up;
-            Vec3f curr_pos = curr.position - half_height * up;
+            Vec3f prev_pos = moves.position(move_id - 1) - half_height * up;
+            Vec3f curr_pos = moves.position(move_id) - half_height * up;
 
             float length = (curr_pos - prev_pos).norm();
             if (last_path.vertices_count() == 1) {
@@ -2467,7 +2446,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
                 buffer_vertices_size += 6;
             }
 
-            last_path.last = { ibuffer_id, indices.size() - 1, move_id, curr.position };
+            last_path.last = { ibuffer_id, indices.size() - 1, move_id, moves.position(move_id) };
             prev_dir = dir;
             prev_up = up;
             prev_length = length;
@@ -2482,6 +2461,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     std::vector<float> options_zs;
 
     // toolpaths data -> extract vertices from result
+    const GCodeProcessor::MoveVertices& moves = gcode_result.moves;
     for (size_t i = 0; i < m_moves_count; ++i) {
         // skip first vertex
         if (i == 0)
@@ -2495,33 +2475,33 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             progress_count = 0;
         }
 
-        const GCodeProcessor::MoveVertex& prev = gcode_result.moves[i - 1];
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
+        const EMoveType curr_type = moves.type(i);
 
-        unsigned char id = buffer_id(curr.type);
+        unsigned char id = buffer_id(curr_type);
         TBuffer& buffer = m_buffers[id];
         VertexBuffer& buffer_vertices = vertices[id];
 
         switch (buffer.render_primitive_type)
         {
         case TBuffer::ERenderPrimitiveType::Point: {
-            add_vertices_as_point(curr, buffer_vertices);
+            add_vertices_as_point(moves.position(i), buffer_vertices);
             break;
         }
         case TBuffer::ERenderPrimitiveType::Line: {
-            add_vertices_as_line(prev, curr, buffer_vertices);
+            add_vertices_as_line(moves.position(i - 1), moves.position(i), buffer_vertices);
             break;
         }
         case TBuffer::ERenderPrimitiveType::Triangle: {
-            add_vertices_as_solid(prev, curr, buffer, buffer_vertices, i);
+            add_vertices_as_solid(moves, buffer, buffer_vertices, i);
             break;
         }
         }
 
-        if (curr.type == EMoveType::Pause_Print || curr.type == EMoveType::Custom_GCode) {
+        if (curr_type == EMoveType::Pause_Print || curr_type == EMoveType::Custom_GCode) {
             const float* const last_z = options_zs.empty() ? nullptr : &options_zs.back();
-            if (last_z == nullptr || curr.position[2] < *last_z - EPSILON || *last_z + EPSILON < curr.position[2])
-                options_zs.emplace_back(curr.position[2]);
+            const float z = moves.position(i)[2];
+            if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z)
+                options_zs.emplace_back(z);
     }
     }
 
@@ -2583,10 +2563,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
             progress_count = 0;
         }
 
-        const GCodeProcessor::MoveVertex& prev = gcode_result.moves[i - 1];
-        const GCodeProcessor::MoveVertex& curr = gcode_result.moves[i];
-
-        unsigned char id = buffer_id(curr.type);
+        unsigned char id = buffer_id(moves.type(i));
         TBuffer& buffer = m_buffers[id];
         MultiIndexBuffer& buffer_indices = indices[id];
         if (buffer_indices.empty())
@@ -2597,7 +2574,7 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
         if (buffer_indices.back().size() >= IBUFFER_THRESHOLD - static_cast<size_t>(buffer.indices_per_segment())) {
             buffer_indices.push_back(IndexBuffer());
             if (buffer.render_primitive_type != TBuffer::ERenderPrimitiveType::Point) {
-                if (!(prev.type != curr.type || !buffer.paths.back().matches(curr))) {
+                if (!(moves.type(i - 1) != moves.type(i) || !buffer.paths.back().matches(moves, i))) {
                     Path& last_path = buffer.paths.back();
                     size_t delta_id = last_path.last.i_id - last_path.first.i_id;
 
@@ -2619,15 +2596,15 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
         switch (buffer.render_primitive_type)
         {
         case TBuffer::ERenderPrimitiveType::Point: {
-            add_indices_as_point(curr, buffer, static_cast<unsigned int>(buffer_indices.size()) - 1, buffer_indices.back(), i);
+            add_indices_as_point(moves, buffer, static_cast<unsigned int>(buffer_indices.size()) - 1, buffer_indices.back(), i);
             break;
         }
         case TBuffer::ERenderPrimitiveType::Line: {
-            add_indices_as_line(prev, curr, buffer, static_cast<unsigned int>(buffer_indices.size()) - 1, buffer_indices.back(), i);
+            add_indices_as_line(moves, buffer, static_cast<unsigned int>(buffer_indices.size()) - 1, buffer_indices.back(), i);
             break;
         }
         case TBuffer::ERenderPrimitiveType::Triangle: {
-            add_indices_as_solid(prev, curr, buffer, curr_buffer_vertices_size[id], static_cast<unsigned int>(buffer_indices.size()) - 1, buffer_indices.back(), i);
+            add_indices_as_solid(moves, buffer, curr_buffer_vertices_size[id], static_cast<unsigned int>(buffer_indices.size()) - 1, buffer_indices.back(), i);
             break;
         }
         }
@@ -2691,24 +2668,25 @@ void GCodeViewer::load_toolpaths(const GCodeProcessor::Result& gcode_result)
     std::vector<MultiIndexBuffer>().swap(indices);
 
     // layers zs / roles / extruder ids / cp color ids -> extract from result
+    const GCodeProcessor::MoveVertices& moves = gcode_result.moves;
     size_t last_travel_s_id = 0;
     for (size_t i = 0; i < m_moves_count; ++i) {
-        const GCodeProcessor::MoveVertex& move = gcode_result.moves[i];
-        if (move.type == EMoveType::Extrude) {
+        const EMoveType type = moves.type(i);
+        if (type == EMoveType::Extrude) {
             // layers zs
             const double* const last_z = m_layers.empty() ? nullptr : &m_layers.get_zs().back();
-            double z = static_cast<double>(move.position[2]);
+            double z = static_cast<double>(moves.position(i)[2]);
             if (last_z == nullptr || z < *last_z - EPSILON || *last_z + EPSILON < z)
                 m_layers.append(z, { last_travel_s_id, i });
             else
                 m_layers.get_endpoints().back().last = i;
             // extruder ids
-        m_extruder_ids.emplace_back(move.extruder_id);
+        m_extruder_ids.emplace_back(moves.extruder_id(i));
             // roles
         if (i > 0)
-            m_roles.emplace_back(move.extrusion_role);
+            m_roles.emplace_back(moves.extrusion_role(i));
     }
-        else if (move.type == EMoveType::Travel) {
+        else if (type == EMoveType::Travel) {
             if (i - last_travel_s_id > 1 && !m_layers.empty())
                 m_layers.get_endpoints().back().last = i;
 
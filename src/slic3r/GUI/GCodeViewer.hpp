@@ -189,7 +189,7 @@ class GCodeViewer
         float elapsed_time{ 0.0f };
         float extruder_temp{ 0.0f };
 
-        bool matches(const GCodeProcessor::MoveVertex& move) const;
+        bool matches(const GCodeProcessor::MoveVertices& moves, size_t move_id) const;
 #if ENABLE_SPLITTED_VERTEX_BUFFER
         size_t vertices_count() const {
             return sub_paths.empty() ? 0 : sub_paths.back().last.s_id - sub_paths.front().first.s_id + 1;
@@ -208,8 +208,8 @@ class GCodeViewer
                 return -1;
             }
         }
-        void add_sub_path(const GCodeProcessor::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id) {
-            Endpoint endpoint = { b_id, i_id, s_id, move.position };
+        void add_sub_path(const Vec3f& position, unsigned int b_id, size_t i_id, size_t s_id) {
+            Endpoint endpoint = { b_id, i_id, s_id, position };
             sub_paths.push_back({ endpoint , endpoint });
         }
 #else
@@ -303,7 +303,7 @@ class GCodeViewer
         // b_id index of buffer contained in this->indices
         // i_id index of first index contained in this->indices[b_id]
         // s_id index of first vertex contained in this->vertices
-        void add_path(const GCodeProcessor::MoveVertex& move, unsigned int b_id, size_t i_id, size_t s_id);
+        void add_path(const GCodeProcessor::MoveVertices& moves, size_t move_id, unsigned int b_id, size_t i_id, size_t s_id);
 
 #if ENABLE_SPLITTED_VERTEX_BUFFER
         unsigned int max_vertices_per_segment() const {
@@ -378,21 +378,9 @@ class GCodeViewer
     // helper to render extrusion paths
     struct Extrusions
     {
-        struct Range
+        struct Range : public ValueRange
         {
-            float min;
-            float max;
-            unsigned int count;
-
-            Range() { reset(); }
-
-            void update_from(const float value) {
-                if (value != max && value != min)
-                    ++count;
-                min = std::min(min, value);
-                max = std::max(max, value);
-            }
-            void reset() { min = FLT_MAX; max = -FLT_MAX; count = 0; }
+            void set_from(const ValueRange& range) { ValueRange::operator=(range); }
 
             float step_size(bool log = false) const;
             Color get_color_at(float value, bool log = false) const;
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <regex>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem/path.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/log/trivial.hpp>
@@ -40,6 +41,7 @@
 #include "exif.h"
 
 #include "libslic3r/Utils.hpp"
+#include "libslic3r/MeshCache.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/I18N.hpp"
 #include "libslic3r/PresetBundle.hpp"
@@ -950,6 +952,7 @@ bool GUI_App::on_init_inner()
 
     // Suppress the '- default -' presets.
     preset_bundle->set_default_suppressed(app_config->get("no_defaults") == "1");
+    update_mesh_cache_dir();
     try {
         // Enable all substitutions (in both user and system profiles), but log the substitutions in user profiles only.
         // If there are substitutions in system profiles, then a "reconfigure" event shall be triggered, which will force
@@ -1384,10 +1387,26 @@ void fatal_error(wxWindow* parent)
 // Update the UI based on the current preferences.
 void GUI_App::update_ui_from_settings(bool apply_free_camera_correction)
 {
+    update_mesh_cache_dir();
     if(mainframe)
         mainframe->update_ui_from_settings(apply_free_camera_correction);
 }
 
+static std::string mesh_cache_folder()
+{
+    return (boost::filesystem::path(data_dir()) / "cache" / "meshes").string();
+}
+
+void GUI_App::update_mesh_cache_dir()
+{
+    set_mesh_cache_dir(app_config->get("mesh_cache") == "1" ? mesh_cache_folder() : std::string());
+}
+
+void GUI_App::clear_mesh_cache()
+{
+    Slic3r::clear_mesh_cache(mesh_cache_folder());
+}
+
 void GUI_App::persist_window_geometry(wxTopLevelWindow *window, bool default_maximized)
 {
     const std::string name = into_u8(window->GetName());
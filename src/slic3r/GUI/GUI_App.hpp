@@ -214,6 +214,8 @@ public:
 
     void            persist_window_geometry(wxTopLevelWindow *window, bool default_maximized = false);
     void            update_ui_from_settings(bool apply_free_camera_correction = true);
+    // Remove the cached meshes of the loaded STL / OBJ files, even if the mesh cache is disabled.
+    void            clear_mesh_cache();
 
     bool            switch_language();
     bool            load_language(wxString language, bool initial);
@@ -312,6 +314,8 @@ private:
     void            window_pos_save(wxTopLevelWindow* window, const std::string &name);
     void            window_pos_restore(wxTopLevelWindow* window, const std::string &name, bool default_maximized = false);
     void            window_pos_sanitize(wxTopLevelWindow* window);
+    // Enable or disable the mesh cache of libslic3r according to the preferences.
+    void            update_mesh_cache_dir();
     bool            select_language();
 
     bool            config_wizard_startup();
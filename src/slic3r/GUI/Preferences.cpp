@@ -126,6 +126,26 @@ void PreferencesDialog::build()
         option = Option(def, "background_processing");
         m_optgroups_general.back()->append_single_option_line(option);
 
+        def.label = L("Cache loaded meshes");
+        def.type = coBool;
+        def.tooltip = L("If this is enabled, the repaired meshes of large STL and OBJ files are stored in the cache folder "
+            "of the configuration directory, so that the same files load without being parsed and repaired again.");
+        def.set_default_value(new ConfigOptionBool{ app_config->get("mesh_cache") == "1" });
+        option = Option(def, "mesh_cache");
+        m_optgroups_general.back()->append_single_option_line(option);
+
+        Line line { "", "" };
+        line.full_width = 1;
+        line.widget = [this](wxWindow* parent) {
+            wxButton* btn = new wxButton(parent, wxID_ANY, _L("Clear mesh cache"));
+            btn->SetToolTip(_L("Remove the cached meshes from the cache folder of the configuration directory."));
+            btn->Bind(wxEVT_BUTTON, [](wxCommandEvent&) { wxGetApp().clear_mesh_cache(); });
+            wxSizer* sizer = new wxBoxSizer(wxHORIZONTAL);
+            sizer->Add(btn);
+            return sizer;
+        };
+        m_optgroups_general.back()->append_line(line);
+
 		def_combobox_auto_switch_preview.label = L("Switch to Preview when sliced");
 		def_combobox_auto_switch_preview.type = coStrings;
 		def_combobox_auto_switch_preview.tooltip = L("When an object is sliced, it will switch your view from the curent view to the "
@@ -1,6 +1,8 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <cstdlib>
+#include <thread>
 
 #include "libslic3r/ExtrusionEntityCollection.hpp"
 #include "libslic3r/ExtrusionEntity.hpp"
@@ -83,3 +85,85 @@ SCENARIO("ExtrusionEntityCollection: Polygon flattening", "[ExtrusionEntity]") {
         }
     }
 }
+
+SCENARIO("ExtrusionEntityArena: entities outlive the arena owner", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF);
+    Slic3r::ExtrusionPaths paths = random_paths();
+
+    GIVEN("A collection of paths cloned while an arena is current") {
+        ExtrusionEntityArena *arena = ExtrusionEntityArena::create();
+        Slic3r::ExtrusionEntityCollection collection;
+        {
+            ExtrusionEntityArena::Scope arena_scope(arena);
+            collection.append(paths);
+            // Slots of deleted entities are reused.
+            collection.remove(0);
+            collection.append(paths.front());
+        }
+        WHEN("The arena is released by its owner") {
+            arena->release();
+            THEN("The entities are still valid") {
+                REQUIRE(collection.entities.size() == paths.size());
+                CHECK(collection.entities.back()->first_point() == paths.front().first_point());
+                for (size_t i = 1; i < paths.size(); ++ i)
+                    CHECK(collection.entities[i - 1]->last_point() == paths[i].last_point());
+            }
+            AND_WHEN("The entities are deleted, releasing the arena") {
+                collection.clear();
+                THEN("The collection is empty") {
+                    CHECK(collection.empty());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("ExtrusionEntityArena: entities freed by another thread", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF);
+    Slic3r::ExtrusionPaths paths = random_paths();
+
+    GIVEN("A collection of paths created while an arena is current") {
+        ExtrusionEntityArena *arena = ExtrusionEntityArena::create();
+        ExtrusionEntityArena::Scope arena_scope(arena);
+        Slic3r::ExtrusionEntityCollection collection;
+        collection.append(paths);
+        const ExtrusionEntity *first = collection.entities.front();
+        WHEN("The entities are deleted by another thread and new entities are created") {
+            std::thread([&collection]() { collection.clear(); }).join();
+            collection.append(paths);
+            arena->release();
+            THEN("The slots freed by the other thread are reused") {
+                REQUIRE(collection.entities.size() == paths.size());
+                CHECK(std::find(collection.entities.begin(), collection.entities.end(), first) != collection.entities.end());
+                for (size_t i = 0; i < paths.size(); ++ i)
+                    CHECK(collection.entities[i]->first_point() == paths[i].first_point());
+            }
+        }
+    }
+}
+
+SCENARIO("ExtrusionEntityArena: entities created again are laid out in order", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF);
+    Slic3r::ExtrusionPaths paths = random_paths();
+
+    GIVEN("A collection of paths created while an arena is current") {
+        ExtrusionEntityArena *arena = ExtrusionEntityArena::create();
+        ExtrusionEntityArena::Scope arena_scope(arena);
+        Slic3r::ExtrusionEntityCollection collection;
+        collection.append(paths);
+        std::vector<const ExtrusionEntity*> entities(collection.entities.begin(), collection.entities.end());
+        WHEN("All the entities are deleted and the paths are created again in reverse order") {
+            collection.clear();
+            Slic3r::ExtrusionPaths reversed(paths.rbegin(), paths.rend());
+            collection.append(reversed);
+            arena->release();
+            THEN("The entities take the slots from the start of the arena in the order of their creation") {
+                REQUIRE(collection.entities.size() == entities.size());
+                for (size_t i = 0; i < entities.size(); ++ i) {
+                    CHECK(collection.entities[i] == entities[i]);
+                    CHECK(collection.entities[i]->first_point() == reversed[i].first_point());
+                }
+            }
+        }
+    }
+}
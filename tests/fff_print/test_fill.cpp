@@ -1,10 +1,14 @@
 #include <catch2/catch.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <numeric>
 #include <sstream>
+#include <thread>
 
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillPlanePath.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Print.hpp"
@@ -429,6 +433,53 @@ for my $pattern (qw(rectilinear honeycomb hilbertcurve concentric)) {
 }
 */
 
+TEST_CASE("Fill: plane path curves shared by the layers of an object", "[Fill]") {
+    // Two islands of the same object, filled with the curve of the object bounding box.
+    ExPolygons islands { ExPolygon(Polygon::new_scale({ { 0, 0 }, { 20, 0 }, { 20, 20 }, { 0, 20 } })),
+                         ExPolygon(Polygon::new_scale({ { 30, 0 }, { 50, 0 }, { 50, 20 }, { 30, 20 } })) };
+    auto fill_islands = [&islands](PlanePathCurveCache *plane_path_curves) {
+        Polylines out;
+        for (const char *pattern : { "hilbertcurve", "archimedeanchords", "octagramspiral" }) {
+            std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(pattern));
+            filler->bounding_box = get_extents(islands);
+            filler->plane_path_curves = plane_path_curves;
+            FillParams fill_params;
+            fill_params.density = 0.2f;
+            filler->init_spacing(0.5, fill_params);
+            for (const ExPolygon &island : islands) {
+                Surface surface(SurfaceType::stPosInternal | SurfaceType::stDensSparse, island);
+                append(out, filler->fill_surface(&surface, fill_params));
+            }
+        }
+        return out;
+    };
+
+    PlanePathCurveCache plane_path_curves;
+    Polylines uncached = fill_islands(nullptr);
+    REQUIRE(! uncached.empty());
+    REQUIRE(fill_islands(&plane_path_curves) == uncached);
+    // The second fill only reads the curves generated by the first one.
+    REQUIRE(fill_islands(&plane_path_curves) == uncached);
+
+    SECTION("a curve is generated once when asked by several threads") {
+        PlanePathCurveCache cache;
+        PlanePathCurveKey   key { std::type_index(typeid(int)), 1, 0, 0, 10, 10 };
+        std::atomic<int>    num_generated { 0 };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++ i)
+            threads.emplace_back([&cache, &key, &num_generated]() {
+                cache.curve(key, [&num_generated]() {
+                    ++ num_generated;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    return std::shared_ptr<const PlanePathCurve>();
+                });
+            });
+        for (std::thread &thread : threads)
+            thread.join();
+        REQUIRE(num_generated == 1);
+    }
+}
+
 bool test_if_solid_surface_filled(const ExPolygon& expolygon, double flow_spacing, double angle, double density)
 {
     std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type("rectilinear"));
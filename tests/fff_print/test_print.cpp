@@ -102,6 +102,123 @@ SCENARIO("Print: Changing number of solid surfaces does not cause all surfaces t
     }
 }
 
+SCENARIO("Print: Changing the config of a layer range invalidates just the layers of the range.", "[Print]") {
+    GIVEN("sliced 20mm cube with 2 perimeters and 3 perimeters from 15mm to 20mm") {
+        Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+		config.set_deserialize_strict({
+			{ "perimeters",				2 },
+			{ "only_one_perimeter_top",	0 },
+			{ "layer_height",			0.5 }, // get a known number of layers
+			{ "first_layer_height",		0.5 }
+			});
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        model.objects.front()->layer_config_ranges[t_layer_height_range(15., 20.)].set("perimeters", 3);
+        print.apply(model, config);
+        print.process();
+        WHEN("the layer range is changed to 4 perimeters") {
+            model.objects.front()->layer_config_ranges[t_layer_height_range(15., 20.)].set("perimeters", 4);
+            print.apply(model, config);
+            const PrintObject &object = *print.objects().front();
+            THEN("Only the perimeters of the layer range are invalidated") {
+                REQUIRE(! object.is_step_done(posPerimeters));
+                REQUIRE(object.step_invalid_z_range(posPerimeters) == t_layer_height_range(15., 20.));
+            }
+            AND_THEN("The infill is invalidated down to the solid shells below the layer range") {
+                REQUIRE(! object.is_step_done(posInfill));
+                t_layer_height_range z_range = object.step_invalid_z_range(posInfill);
+                REQUIRE(z_range.first < 15.);
+                REQUIRE(z_range.first > 0.);
+            }
+            AND_THEN("The layers of the range are regenerated with 4 perimeters") {
+                print.process();
+                for (const Layer *layer : object.layers())
+                    for (const LayerRegion *layerm : layer->regions())
+                        if (! layerm->perimeters.empty())
+                            REQUIRE(layerm->perimeters.items_count() == (layer->slice_z > 15. ? 4 : 2));
+            }
+        }
+    }
+}
+
+// Processes a 20mm cube with a layer range from 10mm to 11mm, changes the perimeters of the layer range and processes it again.
+// The fill surfaces and the fills of all the layers have to match a print processed from scratch.
+static void check_layer_range_refill(const Slic3r::DynamicPrintConfig &config)
+{
+    auto set_range_config = [](Slic3r::Model &model, int perimeters) {
+        ModelConfig &range_config = model.objects.front()->layer_config_ranges[t_layer_height_range(10., 11.)];
+        range_config.set("perimeters", perimeters);
+        range_config.set("top_solid_layers", 1);
+        range_config.set("bottom_solid_layers", 1);
+    };
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+    set_range_config(model, 3);
+    print.apply(model, config);
+    print.process();
+    set_range_config(model, 5);
+    print.apply(model, config);
+    print.process();
+
+    Slic3r::Print print_full;
+    Slic3r::Model model_full;
+    Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print_full, model_full, config);
+    set_range_config(model_full, 5);
+    print_full.apply(model_full, config);
+    print_full.process();
+    const PrintObject &object      = *print.objects().front();
+    const PrintObject &object_full = *print_full.objects().front();
+    REQUIRE(object.layers().size() == object_full.layers().size());
+    auto layer_fill = [](const Layer &layer) {
+        std::map<SurfaceType, double> areas;
+        double volume = 0.;
+        for (const LayerRegion *layerm : layer.regions()) {
+            for (const Surface &surface : layerm->fill_surfaces.surfaces)
+                areas[surface.surface_type] += surface.area();
+            volume += layerm->fills.total_volume();
+        }
+        return std::make_pair(areas, volume);
+    };
+    for (size_t idx_layer = 0; idx_layer < object.layers().size(); ++ idx_layer) {
+        std::pair<std::map<SurfaceType, double>, double> fill      = layer_fill(*object.get_layer(int(idx_layer)));
+        std::pair<std::map<SurfaceType, double>, double> fill_full = layer_fill(*object_full.get_layer(int(idx_layer)));
+        REQUIRE(fill.first.size() == fill_full.first.size());
+        for (const auto &type_area : fill_full.first)
+            REQUIRE(fill.first[type_area.first] == Approx(type_area.second));
+        REQUIRE(fill.second == Approx(fill_full.second));
+    }
+}
+
+SCENARIO("Print: Changing the config of a layer range keeps the infill of the other layers valid.", "[Print]") {
+    Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "perimeters",             2 },
+        { "top_solid_layers",       8 },
+        { "bottom_solid_layers",    8 },
+        { "fill_density",           "20%" },
+        { "layer_height",           0.5 }, // get a known number of layers
+        { "first_layer_height",     0.5 }
+        });
+    GIVEN("20mm cube with 8 solid layers and a layer range from 10mm to 11mm") {
+        WHEN("the layer range is changed from 3 to 5 perimeters and the print is processed again") {
+            THEN("The fill surfaces and the fills of all the layers match a print processed from scratch") {
+                check_layer_range_refill(config);
+            }
+        }
+    }
+    GIVEN("20mm cube with 8 solid layers, infill only where needed and a layer range from 10mm to 11mm") {
+        // The sparse infill of all the layers below the layer range depends on the layer range.
+        config.set_deserialize_strict({ { "infill_only_where_needed", 1 } });
+        WHEN("the layer range is changed from 3 to 5 perimeters and the print is processed again") {
+            THEN("The fill surfaces and the fills of all the layers match a print processed from scratch") {
+                check_layer_range_refill(config);
+            }
+        }
+    }
+}
+
 SCENARIO("Print: Brim generation", "[Print]") {
     GIVEN("20mm cube and default config, 1mm first layer width") {
         WHEN("Brim is set to 3mm")  {
@@ -138,3 +255,38 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: Options are mapped to the steps they invalidate.", "[Print]") {
+    auto masks = [](const PrintStepsInvalidation *invalidation) {
+        REQUIRE(invalidation != nullptr);
+        return std::make_pair(invalidation->print, invalidation->object);
+    };
+    auto expected = [](std::initializer_list<PrintStep> psteps, std::initializer_list<PrintObjectStep> osteps) {
+        PrintStepsInvalidation invalidation(psteps, osteps);
+        return std::make_pair(invalidation.print, invalidation.object);
+    };
+    GIVEN("the table of the print options") {
+        const PrintStepsInvalidationTable &table = Print::steps_invalidation_table();
+        THEN("extruder_temperature_offset invalidates the G-code export only") {
+            REQUIRE(masks(table.find("extruder_temperature_offset")) == expected({ psGCodeExport }, {}));
+        }
+        THEN("an unknown option is not found") {
+            REQUIRE(table.find("perimeters") == nullptr);
+        }
+    }
+    GIVEN("the table of the object and region options") {
+        const PrintStepsInvalidationTable &table = PrintObject::steps_invalidation_table();
+        THEN("perimeters invalidates the perimeters and the infill preparation") {
+            REQUIRE(masks(table.find("perimeters")) == expected({}, { posPerimeters, posPrepareInfill }));
+        }
+        THEN("brim_width invalidates the brim only") {
+            REQUIRE(masks(table.find("brim_width")) == expected({ psBrim }, {}));
+        }
+        THEN("external_perimeter_extrusion_width invalidates the perimeters and the supports") {
+            REQUIRE(masks(table.find("external_perimeter_extrusion_width")) == expected({}, { posPerimeters, posSupportMaterial }));
+        }
+        THEN("external_perimeters_vase invalidates the perimeters") {
+            REQUIRE(masks(table.find("external_perimeters_vase")) == expected({}, { posPerimeters }));
+        }
+    }
+}
@@ -2,6 +2,8 @@
 
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/Layer.hpp"
+#include "libslic3r/Print.hpp"
 
 #include "test_data.hpp"
 
@@ -268,3 +270,57 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+SCENARIO("PrintGCode edge grids of the slices", "[PrintGCode]") {
+    auto init = [](Slic3r::Print &print, Slic3r::Model &model, const char *seam_position, bool avoid_crossing_perimeters) {
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20 }, print, model, {
+            { "layer_height",               0.5 },
+            { "first_layer_height",         0.5 },
+            { "seam_position",              seam_position },
+            { "avoid_crossing_perimeters",  avoid_crossing_perimeters }
+            });
+    };
+    GIVEN("20mm cube with aligned seams") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        init(print, model, "aligned", false);
+        std::string gcode = Slic3r::Test::gcode(print);
+        const PrintObject &object = *print.objects().front();
+        THEN("The export creates the edge grids of all the layers") {
+            for (const Layer *layer : object.layers())
+                REQUIRE(layer->lslices_grid);
+        }
+        WHEN("The G-code is exported again") {
+            std::vector<const EdgeGrid::Grid*> grids;
+            for (const Layer *layer : object.layers())
+                grids.emplace_back(layer->lslices_grid.get());
+            std::string gcode2 = Slic3r::Test::gcode(print);
+            THEN("The edge grids are reused and the G-code is the same") {
+                for (size_t i = 0; i < grids.size(); ++ i)
+                    REQUIRE(object.get_layer(int(i))->lslices_grid.get() == grids[i]);
+                // Skip the header line with the time stamp.
+                REQUIRE(gcode2.substr(gcode2.find('\n')) == gcode.substr(gcode.find('\n')));
+            }
+        }
+    }
+    GIVEN("20mm cube with random seams and without avoid crossing perimeters") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        init(print, model, "random", false);
+        Slic3r::Test::gcode(print);
+        THEN("No edge grid is created") {
+            for (const Layer *layer : print.objects().front()->layers())
+                REQUIRE(! layer->lslices_grid);
+        }
+    }
+    GIVEN("20mm cube with random seams and avoid crossing perimeters") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        init(print, model, "random", true);
+        Slic3r::Test::gcode(print);
+        THEN("The export creates the edge grids of all the layers") {
+            for (const Layer *layer : print.objects().front()->layers())
+                REQUIRE(layer->lslices_grid);
+        }
+    }
+}
@@ -228,6 +228,36 @@ SCENARIO( "TriangleMesh: slice behavior.") {
     }
 }
 
+SCENARIO( "TriangleMeshSlicer: slicing engines produce the same loops.") {
+    GIVEN( "A sphere with 10mm radius") {
+        TriangleMesh sphere = make_sphere(10., PI / 90.);
+        std::vector<float> z;
+        for (float slice_z = -9.95f; slice_z < 10.f; slice_z += 0.1f)
+            z.emplace_back(slice_z);
+        TriangleMeshSlicer slicer(&sphere);
+        WHEN( "The sphere is sliced by the Locked, Buckets and SweepLine engines") {
+            std::vector<Polygons> locked, buckets, sweep;
+            slicer.engine = SlicingEngine::Locked;
+            slicer.slice(z, SlicingMode::Regular, &locked, [](){});
+            slicer.engine = SlicingEngine::Buckets;
+            slicer.slice(z, SlicingMode::Regular, &buckets, [](){});
+            slicer.engine = SlicingEngine::SweepLine;
+            slicer.slice(z, SlicingMode::Regular, &sweep, [](){});
+            THEN( "Buckets and SweepLine produce identical loops.") {
+                REQUIRE(buckets == sweep);
+            }
+            THEN( "Locked produces loops of the same number and area.") {
+                REQUIRE(locked.size() == buckets.size());
+                auto area = [](const Polygons &polygons) { double a = 0.; for (const Polygon &p : polygons) a += p.area(); return a; };
+                for (size_t i = 0; i < locked.size(); ++ i) {
+                    REQUIRE(locked[i].size() == buckets[i].size());
+                    REQUIRE(area(locked[i]) == Approx(area(buckets[i])));
+                }
+            }
+        }
+    }
+}
+
 SCENARIO( "make_xxx functions produce meshes.") {
     GIVEN("make_cube() function") {
         WHEN("make_cube() is called with arguments 20,20,20") {
@@ -7,6 +7,7 @@
 #include "printer_parts.hpp"
 //#include <libnest2d/geometry_traits_nfp.hpp>
 #include "../tools/svgtools.hpp"
+#include "../tools/benchmark.h"
 #include <libnest2d/utils/rotcalipers.hpp>
 
 #if defined(_MSC_VER) && defined(__clang__)
@@ -1189,3 +1190,95 @@ TEST_CASE("Test for biggest bounding box area", "[Nesting], [NestKernels]")
     REQUIRE(pile.size() == N);
     REQUIRE(bb.area() == N * N * W * W);
 }
+
+namespace {
+
+// Copies of two printer parts, optionally marked as copies for the nfp
+// cache and the lattice placement
+std::vector<Item> part_copies(size_t n, size_t m, bool shape_ids)
+{
+    std::vector<Item> ret;
+    ret.reserve(n + m);
+    for (size_t i = 0; i < n + m; ++i) {
+        size_t part = i < n ? 0 : 11;
+        ret.emplace_back(PRINTER_PART_POLYGONS[part]);
+        if (shape_ids) ret.back().shapeId(int(part));
+    }
+    return ret;
+}
+
+void check_packing(const std::vector<Item> &items, const Box &bin, size_t bins)
+{
+    REQUIRE(bins > 0u);
+    for (const Item &itm : items) REQUIRE(itm.binId() != BIN_ID_UNSET);
+
+    for (size_t b = 0; b < bins; ++b) {
+        std::vector<std::reference_wrapper<const Item>> pile;
+        for (const Item &itm : items)
+            if (size_t(itm.binId()) == b) pile.emplace_back(itm);
+
+        MultiPolygon shapes;
+        for (const Item &itm : pile) shapes.emplace_back(itm.transformedShape());
+        REQUIRE(sl::isInside(sl::boundingBox(shapes), bin));
+
+        for (size_t i = 0; i < pile.size(); ++i)
+            for (size_t j = i + 1; j < pile.size(); ++j)
+                REQUIRE(!Item::intersects(pile[i], pile[j]));
+    }
+}
+
+}
+
+TEST_CASE("Copies of parts should be packed without overlaps", "[Nesting], [Copies]")
+{
+    static const constexpr size_t N = 12, M = 4;
+    static const constexpr Coord D = 6000000;
+
+    // Smaller than the bed, so that the copies take more than one bin
+    auto bin = Box(60000000, 60000000);
+
+    std::vector<Item> items = part_copies(N, M, true);
+    size_t bins = nest(items, bin, D);
+    check_packing(items, bin, bins);
+
+    // All the copies are packed, each with the shape of its part
+    REQUIRE(items.size() == N + M);
+    auto num_copies = [&items](int part) {
+        return size_t(std::count_if(items.begin(), items.end(), [part](const Item &itm) {
+            return itm.shapeId() == part && itm.binId() != BIN_ID_UNSET;
+        }));
+    };
+    REQUIRE(num_copies(0) == N);
+    REQUIRE(num_copies(11) == M);
+}
+
+TEST_CASE("Packing copies of parts with shape ids", "[.][Benchmark]")
+{
+    // Small parts, most of them fit into the first bin
+    static const constexpr size_t N = 100, M = 40;
+    static const constexpr Coord D = 6000000;
+
+    auto bin = Box(250000000, 210000000);
+
+    Benchmark bench;
+
+    std::vector<Item> plain = part_copies(N, M, false);
+    bench.start();
+    size_t plain_bins = nest(plain, bin, D);
+    bench.stop();
+    double plain_time = bench.getElapsedSec();
+    check_packing(plain, bin, plain_bins);
+
+    std::vector<Item> marked = part_copies(N, M, true);
+    bench.start();
+    size_t marked_bins = nest(marked, bin, D);
+    bench.stop();
+    double marked_time = bench.getElapsedSec();
+    check_packing(marked, bin, marked_bins);
+
+    WARN("Packing " << N + M << " copies: " << plain_time << " s, "
+         << plain_bins << " bins without shape ids; " << marked_time
+         << " s, " << marked_bins << " bins with shape ids");
+
+    REQUIRE(marked_bins <= plain_bins);
+}
@@ -3,7 +3,9 @@
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/3mf.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/miniz_extension.hpp"
 
+#include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem/operations.hpp>
 
 using namespace Slic3r;
@@ -89,3 +91,80 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
         }
     }
 }
+
+// Copy a 3mf file, inserting a comment into each <vertices> element of the model.
+// The parallel mesh decoder does not accept comments inside the meshes, so the copy is read by expat only.
+static bool copy_3mf_for_expat(const std::string &src_file, const std::string &dst_file)
+{
+    mz_zip_archive src;
+    mz_zip_zero_struct(&src);
+    if (! open_zip_reader(&src, src_file))
+        return false;
+    mz_zip_archive dst;
+    mz_zip_zero_struct(&dst);
+    if (! open_zip_writer(&dst, dst_file)) {
+        close_zip_reader(&src);
+        return false;
+    }
+    bool ok = true;
+    for (mz_uint i = 0; ok && i < mz_zip_reader_get_num_files(&src); ++ i) {
+        mz_zip_archive_file_stat stat;
+        if (! (ok = mz_zip_reader_file_stat(&src, i, &stat)))
+            break;
+        std::string content(size_t(stat.m_uncomp_size), 0);
+        if (! content.empty())
+            ok = mz_zip_reader_extract_to_mem(&src, i, (void*)content.data(), content.size(), 0);
+        if (std::string(stat.m_filename) == "3D/3dmodel.model")
+            boost::replace_all(content, "<vertices>", "<vertices><!-- read by expat -->");
+        ok = ok && mz_zip_writer_add_mem(&dst, stat.m_filename, content.data(), content.size(), MZ_DEFAULT_COMPRESSION);
+    }
+    ok = ok && mz_zip_writer_finalize_archive(&dst);
+    close_zip_writer(&dst);
+    close_zip_reader(&src);
+    return ok;
+}
+
+SCENARIO("Decoding the meshes of a 3mf file in parallel matches expat", "[3mf]") {
+    GIVEN("a 3mf file with several objects") {
+        Model src_model;
+        src_model.add_object("cube", "", make_cube(10., 20., 30.));
+        src_model.add_object("cylinder", "", make_cylinder(7.5, 12.));
+        src_model.add_object("sphere", "", make_sphere(9., 2. * PI / 60.));
+        src_model.objects[1]->add_volume(make_cube(3., 3., 3.));
+        src_model.add_default_instances();
+        const boost::filesystem::path temp_dir = boost::filesystem::temp_directory_path();
+        const std::string src_file   = (temp_dir / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+        const std::string expat_file = (temp_dir / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+        REQUIRE(store_3mf(src_file.c_str(), &src_model, nullptr, false));
+        REQUIRE(copy_3mf_for_expat(src_file, expat_file));
+
+        WHEN("the file is read with and without the parallel mesh decoder") {
+            auto load = [](const std::string &path, Model &model) {
+                DynamicPrintConfig config;
+                ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                return load_3mf(path.c_str(), config, ctxt, &model, false);
+            };
+            Model model, model_expat;
+            bool loaded       = load(src_file, model);
+            bool loaded_expat = load(expat_file, model_expat);
+            boost::filesystem::remove(src_file);
+            boost::filesystem::remove(expat_file);
+            THEN("the objects and their meshes are equal") {
+                REQUIRE(loaded);
+                REQUIRE(loaded_expat);
+                REQUIRE(model.objects.size() == src_model.objects.size());
+                REQUIRE(model_expat.objects.size() == model.objects.size());
+                for (size_t i = 0; i < model.objects.size(); ++ i) {
+                    REQUIRE(model.objects[i]->volumes.size() == model_expat.objects[i]->volumes.size());
+                    for (size_t j = 0; j < model.objects[i]->volumes.size(); ++ j) {
+                        const indexed_triangle_set &its       = model.objects[i]->volumes[j]->mesh().its;
+                        const indexed_triangle_set &its_expat = model_expat.objects[i]->volumes[j]->mesh().its;
+                        REQUIRE(! its.indices.empty());
+                        REQUIRE(its.vertices == its_expat.vertices);
+                        REQUIRE(its.indices == its_expat.indices);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -59,3 +59,41 @@ TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndi
     REQUIRE(closest_point.y() == Approx(0.5));
     REQUIRE(closest_point.z() == Approx(1.));
 }
+
+TEST_CASE("Ray packets hit the same triangles as single rays", "[AABBIndirect]")
+{
+    TriangleMesh tmesh = make_sphere(1., 2. * PI / 180.);
+    tmesh.repair();
+
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(tmesh.its.vertices, tmesh.its.indices);
+    REQUIRE(! tree.empty());
+
+    // Rays from a few points inside and outside of the sphere, some of them parallel to the axes.
+    // The origins are off the planes of the sphere vertices, thus the rays do not graze the bounding boxes.
+    std::vector<Vec3d> origins, dirs;
+    for (const Vec3d &origin : { Vec3d(0.02, 0.01, -0.03), Vec3d(0.3, -0.2, 0.5), Vec3d(0.01, 0.02, -5.), Vec3d(3., 0.4, 0.01) })
+        for (int i = 0; i < 31; ++ i) {
+            origins.emplace_back(origin);
+            if (i < 6)
+                dirs.emplace_back(Vec3d::Unit(i / 2) * (i % 2 ? 1. : -1.));
+            else
+                dirs.emplace_back(Vec3d(std::cos(i), std::sin(0.7 * i), std::cos(1.3 * i) - origin.z() - origin.x()).normalized());
+        }
+
+    std::vector<igl::Hit> hits;
+    size_t num_hits = AABBTreeIndirect::intersect_rays_first_hit(tmesh.its.vertices, tmesh.its.indices, tree, origins, dirs, hits);
+    REQUIRE(hits.size() == origins.size());
+
+    size_t num_hits_single = 0;
+    for (size_t i = 0; i < origins.size(); ++ i) {
+        igl::Hit hit;
+        if (AABBTreeIndirect::intersect_ray_first_hit(tmesh.its.vertices, tmesh.its.indices, tree, origins[i], dirs[i], hit)) {
+            ++ num_hits_single;
+            REQUIRE(hits[i].id == hit.id);
+            REQUIRE(hits[i].t == hit.t);
+        } else
+            REQUIRE(hits[i].id == -1);
+    }
+    REQUIRE(num_hits == num_hits_single);
+    REQUIRE(num_hits > origins.size() / 2);
+}
@@ -220,3 +220,29 @@ SCENARIO("Config parameter conversion from old/related configurations.", "[Confi
         }
     }
 }
+
+SCENARIO("Static config diff against a dynamic config.", "[Config]") {
+    GIVEN("A default object config and a full print config") {
+        PrintObjectConfig           object_config;
+        Slic3r::DynamicPrintConfig  config = Slic3r::DynamicPrintConfig::full_print_config();
+        WHEN("A few object options and a print option are changed") {
+            config.set("layer_height", 0.1);
+            config.set("support_material", true);
+            config.set("wipe_tower", true);
+            THEN("The changed object options are reported in the order of the generic diff") {
+                t_config_option_keys diff = object_config.diff(config);
+                REQUIRE(diff == object_config.ConfigBase::diff(config));
+                REQUIRE(std::find(diff.begin(), diff.end(), "layer_height") != diff.end());
+                REQUIRE(std::find(diff.begin(), diff.end(), "support_material") != diff.end());
+                REQUIRE(std::find(diff.begin(), diff.end(), "wipe_tower") == diff.end());
+            }
+        }
+        WHEN("The dynamic config only holds some of the object options") {
+            Slic3r::DynamicPrintConfig partial;
+            partial.set_key_value("layer_height", new ConfigOptionFloat(0.1));
+            THEN("Only the options present in both configs are compared") {
+                REQUIRE(object_config.diff(partial) == t_config_option_keys{ "layer_height" });
+            }
+        }
+    }
+}
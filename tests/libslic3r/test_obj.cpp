@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/Format/objparser.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <sstream>
+#include <string>
+
+// Writes an OBJ file of a strip of quads, the faces mixing absolute and relative (negative) indices.
+static std::string obj_strip(size_t num_quads)
+{
+	std::ostringstream out;
+	out << "mtllib strip.mtl\n";
+	out << "o strip\n";
+	out << "v 0 0 0\nv 0 1 0\nvt 0 0\nvt 0 1\nvn 0 0 1\n";
+	for (size_t i = 1; i <= num_quads; ++ i) {
+		if (i % 3 == 0)
+			out << "g group" << i << "\nusemtl material" << i << "\ns " << (i % 2) << "\n";
+		out << "v " << i << " 0 0\r\nv " << i << " 1 0\n";
+		out << "vt " << i << " 0\nvt " << i << " 1\n";
+		out << "vn 0 0 1\n";
+		// The two vertices of the previous column are 3 and 4 records back, the ones of this column 1 and 2 back.
+		if (i % 2 == 0)
+			out << "f -4/-4/-2 -2/-2/-1 -1/-1/-1 -3/-3/-2\n";
+		else
+			out << "f " << 2 * i - 1 << "/" << 2 * i - 1 << " " << 2 * i + 1 << "/-2 -1/" << 2 * i + 2 << " " << 2 * i << "/-3\n";
+		out << "f -4//-2 -2//-1 -1//-1\n";
+	}
+	return out.str();
+}
+
+SCENARIO("Reading an OBJ file in chunks", "[obj]") {
+	GIVEN("an OBJ file with relative indices") {
+		boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.obj");
+		const std::string content = obj_strip(200);
+		{
+			boost::nowide::ofstream file(path.string(), std::ios::binary);
+			file << content;
+		}
+		// The line by line parser of a stream is the reference.
+		ObjParser::ObjData reference;
+		std::istringstream stream(content);
+		REQUIRE(ObjParser::objparse(stream, reference));
+		REQUIRE(! reference.vertices.empty());
+		WHEN("the file is parsed as a single chunk") {
+			ObjParser::ObjData data;
+			REQUIRE(ObjParser::objparse(path.string().c_str(), data));
+			THEN("the data matches the line by line parser") {
+				REQUIRE(ObjParser::objequal(data, reference));
+			}
+		}
+		WHEN("the file is parsed in chunks of a few lines or less than a line") {
+			THEN("the data matches the line by line parser") {
+				for (size_t chunk_size : { size_t(1), size_t(7), size_t(64), size_t(1000) }) {
+					INFO("chunk size " << chunk_size);
+					ObjParser::ObjData data;
+					REQUIRE(ObjParser::objparse(path.string().c_str(), data, chunk_size));
+					REQUIRE(ObjParser::objequal(data, reference));
+				}
+			}
+		}
+		boost::filesystem::remove(path);
+	}
+}
@@ -102,4 +102,16 @@ SCENARIO("Placeholder parser scripting", "[PlaceholderParser]") {
     SECTION("complex expression") { REQUIRE(boolean_expression("printer_notes=~/.*PRINTER_VENDOR_PRUSA3D.*/ and printer_notes=~/.*PRINTER_MODEL_MK2.*/ and nozzle_diameter[0]==0.6 and num_extruders>1")); }
     SECTION("complex expression2") { REQUIRE(boolean_expression("printer_notes=~/.*PRINTER_VEwerfNDOR_PRUSA3D.*/ or printer_notes=~/.*PRINTertER_MODEL_MK2.*/ or (nozzle_diameter[0]==0.6 and num_extruders>1)")); }
     SECTION("complex expression3") { REQUIRE(! boolean_expression("printer_notes=~/.*PRINTER_VEwerfNDOR_PRUSA3D.*/ or printer_notes=~/.*PRINTertER_MODEL_MK2.*/ or (nozzle_diameter[0]==0.3 and num_extruders>1)")); }
+
+    SECTION("templates split into a context produce the same output") {
+        PlaceholderParser::ContextData context;
+        for (const std::string templ : {
+                " \n leading white spaces [temperature_[foo]] ", "test [ temperature_ [foo] ] \n hu", "M104 S{temperature[foo]} ; [temperature[bar]]\n",
+                "{if bar == 2}two {\"}\"}{elsif foo == 0}zero{else}{2*3}{endif} [bar]", "{if \"PRUSA\" =~ /.*P{1}RUSA.*/}match{endif} and {2*3/6}" })
+            // Process twice, the second time the template split by the first call is used.
+            for (int i = 0; i < 2; ++ i)
+                REQUIRE(parser.process(templ, 0, nullptr, &context) == parser.process(templ));
+        REQUIRE_THROWS(parser.process("{first_layer_speed} [temperature]", 0, nullptr, &context));
+        REQUIRE_THROWS(parser.process("[temperature] {if true}", 0, nullptr, &context));
+    }
 }
@@ -1,7 +1,18 @@
 #include <catch2/catch.hpp>
 
+#include "libslic3r/MeshCache.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <array>
+#include <cmath>
+#include <ctime>
+#include <random>
+#include <utility>
 
 using namespace Slic3r;
 
@@ -55,3 +66,274 @@ SCENARIO("Reading an STL file", "[stl]") {
 		}
 	}
 }
+
+// ASCII STL of the sphere, formatted in various ways. The first facet has a subnormal vertex coordinate and an overflowing normal.
+static std::string sphere_ascii_stl(std::vector<stl_facet> &facets)
+{
+	const TriangleMesh sphere = make_sphere(10., 2. * PI / 48.);
+	facets = sphere.stl.facet_start;
+	std::string out = "solid sphere facet\n";
+	char buf[256];
+	for (size_t i = 0; i < facets.size(); ++ i) {
+		stl_facet &facet = facets[i];
+		const char *sign = (i % 3 == 0) ? "+" : "";
+		const char *eol  = (i % 2 == 0) ? "\r\n" : "\n";
+		if (i == 0) {
+			facet.vertex[0](0) = 1e-42f;
+			out += std::string("  facet normal 1e39 0 0") + eol;
+		} else {
+			sprintf(buf, "facet normal %.9g %.9g %.9g%s", facet.normal(0), facet.normal(1), facet.normal(2), eol);
+			out += buf;
+		}
+		out += std::string("\touter loop") + eol;
+		for (const stl_vertex &v : facet.vertex) {
+			sprintf(buf, "    vertex %s%.9g %s%.9g %s%.9g%s", v(0) >= 0 ? sign : "", v(0), v(1) >= 0 ? sign : "", v(1), v(2) >= 0 ? sign : "", v(2), eol);
+			out += buf;
+		}
+		out += (i % 5 == 0) ? std::string("endloop some text") + eol : std::string("  endloop") + eol;
+		out += std::string("endfacet") + eol;
+		if (i == facets.size() / 2)
+			out += "endsolid sphere\nsolid sphere\n";
+	}
+	out += "endsolid sphere\n";
+	return out;
+}
+
+SCENARIO("Reading an ASCII STL file in chunks", "[stl]") {
+	GIVEN("an ASCII STL file larger than a chunk") {
+		std::vector<stl_facet> facets;
+		const std::string content = sphere_ascii_stl(facets);
+		boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.stl");
+		{
+			boost::nowide::ofstream file(path.string(), std::ios::binary);
+			file << content;
+		}
+		WHEN("the file is parsed in chunks smaller than a facet or spanning a few facets") {
+			std::vector<stl_file> results;
+			for (size_t chunk_size : { size_t(1), size_t(97), size_t(1000), STL_ASCII_CHUNK_SIZE }) {
+				results.emplace_back();
+				REQUIRE(stl_open(&results.back(), path.string().c_str(), chunk_size));
+			}
+			boost::filesystem::remove(path);
+			THEN("all the facets are read in order") {
+				for (const stl_file &stl : results) {
+					REQUIRE(stl.stats.number_of_facets == facets.size());
+					size_t num_different = 0;
+					for (size_t i = 0; i < facets.size(); ++ i)
+						for (int j = 0; j < 3; ++ j)
+							if (stl.facet_start[i].vertex[j] != facets[i].vertex[j])
+								++ num_different;
+					REQUIRE(num_different == 0);
+				}
+			}
+			THEN("the subnormal and overflowing numbers are accepted") {
+				for (const stl_file &stl : results) {
+					REQUIRE(stl.facet_start.front().vertex[0](0) == 1e-42f);
+					REQUIRE(std::isinf(stl.facet_start.front().normal(0)));
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Loading an STL file through the mesh cache", "[stl]") {
+	GIVEN("mesh cache enabled for all file sizes") {
+		boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+		Slic3r::set_mesh_cache_dir(cache_dir.string(), 0);
+		const std::string path = stl_path("ASCII/20mmbox-LF.stl");
+		const std::string key  = Slic3r::mesh_cache_key(path.c_str(), "stl");
+		WHEN("STL file is read") {
+			Slic3r::Model model_parsed;
+			bool parsed = Slic3r::load_stl(path.c_str(), &model_parsed);
+			bool cached = boost::filesystem::exists(cache_dir / (key + ".mesh"));
+			TriangleMesh mesh_cached;
+			bool loaded = Slic3r::load_mesh_cache(key, mesh_cached);
+			// Replace the entry with another mesh: reading the file again has to return the replaced mesh.
+			TriangleMesh sphere = make_sphere(10., 2. * PI / 24.);
+			sphere.repair();
+			Slic3r::store_mesh_cache(key, sphere);
+			Slic3r::Model model_hit;
+			bool hit_loaded = Slic3r::load_stl(path.c_str(), &model_hit);
+			Slic3r::set_mesh_cache_dir(std::string());
+			boost::filesystem::remove_all(cache_dir);
+			THEN("the stored entry matches the parsed mesh") {
+				REQUIRE(parsed);
+				REQUIRE(cached);
+				REQUIRE(loaded);
+				const TriangleMesh &mesh_parsed = model_parsed.objects.front()->volumes.front()->mesh();
+				REQUIRE(mesh_cached.repaired);
+				REQUIRE(mesh_cached.facets_count() == mesh_parsed.facets_count());
+				REQUIRE(mesh_cached.stl.stats.volume == mesh_parsed.stl.stats.volume);
+				REQUIRE(mesh_cached.its.vertices == mesh_parsed.its.vertices);
+				REQUIRE(mesh_cached.its.indices == mesh_parsed.its.indices);
+				for (size_t i = 0; i < mesh_parsed.stl.neighbors_start.size(); ++ i)
+					for (int j = 0; j < 3; ++ j)
+						REQUIRE(mesh_cached.stl.neighbors_start[i].neighbor[j] == mesh_parsed.stl.neighbors_start[i].neighbor[j]);
+			}
+			THEN("the second read is served from the cache") {
+				REQUIRE(hit_loaded);
+				REQUIRE(model_hit.objects.front()->volumes.front()->mesh().facets_count() == sphere.facets_count());
+				REQUIRE(sphere.facets_count() != model_parsed.objects.front()->volumes.front()->mesh().facets_count());
+			}
+		}
+		WHEN("the cache grows over its maximum size") {
+			TriangleMesh mesh = make_cube(10., 10., 10.);
+			mesh.repair();
+			Slic3r::store_mesh_cache("A", mesh);
+			const boost::filesystem::path path_a = cache_dir / "A.mesh";
+			const boost::filesystem::path path_b = cache_dir / "B.mesh";
+			const boost::filesystem::path path_c = cache_dir / "C.mesh";
+			const uintmax_t entry_size = boost::filesystem::file_size(path_a);
+			Slic3r::store_mesh_cache("B", mesh);
+			// A is older than B, but it is used last.
+			const std::time_t now = std::time(nullptr);
+			boost::filesystem::last_write_time(path_a, now - 200);
+			boost::filesystem::last_write_time(path_b, now - 100);
+			TriangleMesh mesh_a;
+			bool loaded_a = Slic3r::load_mesh_cache("A", mesh_a);
+			Slic3r::set_mesh_cache_dir(cache_dir.string(), 0, size_t(2 * entry_size));
+			Slic3r::store_mesh_cache("C", mesh);
+			bool exists_a = boost::filesystem::exists(path_a);
+			bool exists_b = boost::filesystem::exists(path_b);
+			bool exists_c = boost::filesystem::exists(path_c);
+			Slic3r::clear_mesh_cache(cache_dir.string());
+			bool cleared = ! boost::filesystem::exists(path_a) && ! boost::filesystem::exists(path_c);
+			Slic3r::set_mesh_cache_dir(std::string());
+			boost::filesystem::remove_all(cache_dir);
+			THEN("the least recently used entry is removed") {
+				REQUIRE(loaded_a);
+				REQUIRE(exists_a);
+				REQUIRE(! exists_b);
+				REQUIRE(exists_c);
+			}
+			THEN("clearing the cache removes all the entries") {
+				REQUIRE(cleared);
+			}
+		}
+	}
+}
+
+// Mesh with a separate copy of the vertices for each facet, so that the vertices of the facets may be moved independently.
+static stl_file stl_from_facets(const std::vector<std::array<Vec3d, 3>> &facets)
+{
+	Pointf3s 			 points;
+	std::vector<Vec3i32> indices;
+	for (const std::array<Vec3d, 3> &facet : facets) {
+		int idx = int(points.size());
+		points.insert(points.end(), facet.begin(), facet.end());
+		indices.emplace_back(idx, idx + 1, idx + 2);
+	}
+	return TriangleMesh(points, indices).stl;
+}
+
+static std::vector<std::array<Vec3d, 3>> sphere_facets()
+{
+	const TriangleMesh sphere = make_sphere(10., 2. * PI / 48.);
+	std::vector<std::array<Vec3d, 3>> facets;
+	for (const stl_facet &facet : sphere.stl.facet_start)
+		facets.push_back({ facet.vertex[0].cast<double>(), facet.vertex[1].cast<double>(), facet.vertex[2].cast<double>() });
+	return facets;
+}
+
+static void require_same_connectivity(const stl_file &stl, const stl_file &reference)
+{
+	REQUIRE(stl.stats.number_of_facets == reference.stats.number_of_facets);
+	REQUIRE(stl.stats.connected_edges == reference.stats.connected_edges);
+	REQUIRE(stl.stats.connected_facets_1_edge == reference.stats.connected_facets_1_edge);
+	REQUIRE(stl.stats.connected_facets_2_edge == reference.stats.connected_facets_2_edge);
+	REQUIRE(stl.stats.connected_facets_3_edge == reference.stats.connected_facets_3_edge);
+	REQUIRE(stl.stats.degenerate_facets == reference.stats.degenerate_facets);
+	REQUIRE(stl.stats.edges_fixed == reference.stats.edges_fixed);
+	REQUIRE(stl.stats.shortest_edge == reference.stats.shortest_edge);
+	size_t num_different = 0;
+	for (size_t i = 0; i < reference.stats.number_of_facets; ++ i)
+		for (int j = 0; j < 3; ++ j)
+			if (stl.neighbors_start[i].neighbor[j] != reference.neighbors_start[i].neighbor[j] ||
+				stl.neighbors_start[i].which_vertex_not[j] != reference.neighbors_start[i].which_vertex_not[j] ||
+				stl.facet_start[i].vertex[j] != reference.facet_start[i].vertex[j])
+				++ num_different;
+	REQUIRE(num_different == 0);
+}
+
+SCENARIO("Connecting the facets matches the hash table", "[stl]") {
+	GIVEN("closed sphere") {
+		stl_file stl = stl_from_facets(sphere_facets());
+		WHEN("the facets are connected exactly") {
+			stl_file reference = stl;
+			stl_check_facets_exact(&stl);
+			stl_check_facets_exact_hash_table(&reference);
+			THEN("all the edges are connected as by the hash table") {
+				REQUIRE(stl.stats.connected_facets_3_edge == int(stl.stats.number_of_facets));
+				require_same_connectivity(stl, reference);
+			}
+		}
+	}
+	GIVEN("sphere with duplicated, flipped and degenerate facets") {
+		std::vector<std::array<Vec3d, 3>> facets = sphere_facets();
+		const size_t num_facets = facets.size();
+		for (size_t i = 0; i < num_facets; i += 7) {
+			// Duplicated facet, its edges are shared by more than two facets.
+			facets.push_back(facets[i]);
+			// Flipped copy of the neighbor facet.
+			std::array<Vec3d, 3> flipped = facets[i + 1];
+			std::swap(flipped[0], flipped[1]);
+			facets.push_back(flipped);
+			// Degenerate facet sharing an edge.
+			std::array<Vec3d, 3> degenerate = facets[i + 2];
+			degenerate[2] = degenerate[0];
+			facets.push_back(degenerate);
+		}
+		stl_file stl = stl_from_facets(facets);
+		WHEN("the facets are connected exactly") {
+			stl_file reference = stl;
+			stl_check_facets_exact(&stl);
+			stl_check_facets_exact_hash_table(&reference);
+			THEN("the same edges are connected as by the hash table") {
+				REQUIRE(stl.stats.degenerate_facets > 0);
+				REQUIRE(stl.stats.connected_facets_3_edge < int(stl.stats.number_of_facets));
+				require_same_connectivity(stl, reference);
+			}
+		}
+	}
+	GIVEN("sphere with its facets moved apart randomly") {
+		std::vector<std::array<Vec3d, 3>> facets = sphere_facets();
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<double> dist(-0.05, 0.05);
+		for (std::array<Vec3d, 3> &facet : facets) {
+			for (Vec3d &v : facet)
+				if (rng() % 3 == 0)
+					v += Vec3d(dist(rng), dist(rng), dist(rng));
+			if (rng() % 5 == 0)
+				std::swap(facet[0], facet[1]);
+		}
+		stl_file stl = stl_from_facets(facets);
+		stl_check_facets_exact(&stl);
+		stl_file reference = stl;
+		stl_check_facets_exact_hash_table(&reference);
+		require_same_connectivity(stl, reference);
+		WHEN("the facets are connected with increasing tolerances") {
+			for (int iteration = 0; iteration < 3; ++ iteration) {
+				float tolerance = stl.stats.shortest_edge + 0.1f * float(iteration + 1);
+				stl_check_facets_nearby(&stl, tolerance);
+				stl_check_facets_nearby_hash_table(&reference, tolerance);
+			}
+			THEN("the same edges are connected and the same vertices are moved as by the hash table") {
+				REQUIRE(stl.stats.edges_fixed > 0);
+				require_same_connectivity(stl, reference);
+			}
+		}
+		WHEN("the facets are connected switching to the hash table midway") {
+			const float tolerance = stl.stats.shortest_edge + 0.1f;
+			std::vector<std::pair<stl_file, stl_file>> results;
+			for (uint32_t from_facet : { uint32_t(0), stl.stats.number_of_facets / 3, stl.stats.number_of_facets - 1 }) {
+				results.emplace_back(stl, reference);
+				stl_check_facets_nearby(&results.back().first, tolerance, from_facet);
+				stl_check_facets_nearby_hash_table(&results.back().second, tolerance);
+			}
+			THEN("the same edges are connected as by the hash table from the start") {
+				for (const std::pair<stl_file, stl_file> &result : results)
+					require_same_connectivity(result.first, result.second);
+			}
+		}
+	}
+}
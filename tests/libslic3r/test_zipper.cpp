@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "libslic3r/Zipper.hpp"
+#include "libslic3r/miniz_extension.hpp"
+
+using namespace Slic3r;
+
+static std::string make_entry_data(size_t idx)
+{
+    std::string data;
+    for (size_t i = 0; i < 5000 * (idx % 5 + 1); ++ i)
+        data += char('a' + (i * idx) % 17);
+    return data;
+}
+
+TEST_CASE("Zipper writes the entries intact in the order they were added", "[Zipper]") {
+    // More entries than are compressed at a time.
+    const size_t num_entries = 150;
+    for (Zipper::e_compression compression : { Zipper::NO_COMPRESSION, Zipper::FAST_COMPRESSION, Zipper::TIGHT_COMPRESSION }) {
+        std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("zipper_%%%%-%%%%.zip")).string();
+        {
+            Zipper zipper(test_file, compression);
+            zipper.add_entry("config.ini");
+            zipper << "layers = " + std::to_string(num_entries);
+            zipper.add_entry("layers/", nullptr, 0);
+            for (size_t i = 0; i < num_entries; ++ i) {
+                std::string name = "layers/" + std::to_string(i);
+                std::string data = make_entry_data(i);
+                if (i % 2) {
+                    zipper.add_entry(name, data.data(), data.size());
+                } else {
+                    zipper.add_entry(name);
+                    zipper << data;
+                }
+            }
+            zipper.finalize();
+        }
+
+        mz_zip_archive archive;
+        mz_zip_zero_struct(&archive);
+        REQUIRE(open_zip_reader(&archive, test_file));
+        REQUIRE(mz_zip_reader_get_num_files(&archive) == num_entries + 2);
+        for (mz_uint i = 0; i < num_entries; ++ i) {
+            mz_zip_archive_file_stat stat;
+            REQUIRE(mz_zip_reader_file_stat(&archive, i + 2, &stat));
+            REQUIRE(std::string(stat.m_filename) == "layers/" + std::to_string(i));
+            std::string data = make_entry_data(i);
+            REQUIRE(stat.m_uncomp_size == data.size());
+            std::string extracted(size_t(stat.m_uncomp_size), '\0');
+            REQUIRE(mz_zip_reader_extract_to_mem(&archive, i + 2, extracted.data(), extracted.size(), 0));
+            REQUIRE(extracted == data);
+        }
+        close_zip_reader(&archive);
+        boost::filesystem::remove(test_file);
+    }
+}
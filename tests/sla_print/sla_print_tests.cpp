@@ -2,6 +2,7 @@
 #include <unordered_map>
 #include <random>
 #include <cstdint>
+#include <cstring>
 
 #include "sla_test_utils.hpp"
 
@@ -224,6 +225,60 @@ TEST_CASE("RasterizedPolygonAreaShouldMatch", "[SLARasterOutput]") {
     REQUIRE(raster_pxsum(raster0) == 0);
 }
 
+namespace {
+
+// Printer rasterizing into a small display, exposing the streaming interface.
+class TestLayerPrinter: public SLAPrinter {
+    uqptr<sla::RasterBase> create_raster() const override
+    {
+        sla::RasterBase::Resolution res{200, 100};
+        return sla::create_raster_grayscale_aa(res, {20. / res.width_px, 10. / res.height_px});
+    }
+    sla::RasterEncoder get_encoder() const override { return sla::PNGRasterEncoder{}; }
+    
+public:
+    void apply(const SLAPrinterConfig &) override {}
+    
+    const std::vector<sla::EncodedRaster>& layers() const { return m_layers; }
+    
+    template<class Fn, class WriteFn> void stream(size_t layer_num, Fn &&drawfn, WriteFn &&writefn)
+    {
+        stream_layers(layer_num, std::forward<Fn>(drawfn), std::forward<WriteFn>(writefn));
+    }
+};
+
+} // namespace
+
+TEST_CASE("StreamedLayersShouldMatchRasterizedLayers", "[SLARasterOutput]") {
+    // More layers than are streamed at a time, so that the rasters get reused.
+    const size_t layer_num = 3 * SLAPrinter::max_streamed_layers + 1;
+    auto drawfn = [](sla::RasterBase &raster, size_t idx) {
+        ExPolygon poly = square_with_hole(1. + double(idx % 9));
+        poly.translate(scaled(10.), scaled(5.));
+        raster.draw(poly);
+    };
+    
+    TestLayerPrinter printer;
+    printer.draw_layers(layer_num, drawfn);
+    REQUIRE(printer.layers().size() == layer_num);
+    
+    // The write callback may run on a worker thread, the results are only checked once streaming is done.
+    std::vector<size_t> indices;
+    std::vector<bool>   matches;
+    printer.stream(layer_num, drawfn, [&printer, &indices, &matches](const sla::EncodedRaster &rst, size_t idx) {
+        indices.emplace_back(idx);
+        const sla::EncodedRaster *ref = idx < printer.layers().size() ? &printer.layers()[idx] : nullptr;
+        matches.emplace_back(ref != nullptr && rst.size() == ref->size() && std::memcmp(rst.data(), ref->data(), rst.size()) == 0);
+    });
+
+    REQUIRE(indices.size() == layer_num);
+    for (size_t i = 0; i < indices.size(); ++ i) {
+        INFO("Streamed layer " << i);
+        REQUIRE(indices[i] == i);
+        REQUIRE(matches[i]);
+    }
+}
+
 TEST_CASE("Triangle mesh conversions should be correct", "[SLAConversions]")
 {
     sla::Contour3D cntr;